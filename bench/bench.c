@@ -0,0 +1,397 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Kernel microbenchmark.
+ *
+ * Each case builds an rt_function_t directly, without network or runtime,
+ * and runs it for every data type variant:
+ *   float   float data with the implementation selected by allocate
+ *   generic float data with the accessor based implementation
+ *   int8    fixed point data with the implementation selected by allocate
+ *   int16   same as int8
+ * Compute bound cases report GFLOP/s (a multiply-accumulate counts as two
+ * operations), the others GB/s of input and output bytes.
+ *
+ * Usage: nnablart_bench [FILTER] [SECONDS]
+ *   FILTER  Run cases whose name contains FILTER.
+ *   SECONDS Minimum measurement time of each variant (default 0.2).
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nnablart/config.h>
+#include <nnablart/functions.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Implementations selected by allocate functions for non float data.
+rt_function_error_t exec_affine_generic(rt_function_t *f);
+rt_function_error_t exec_convolution_generic(rt_function_t *f);
+rt_function_error_t exec_softmax_generic(rt_function_t *f);
+rt_function_error_t exec_batch_normalization_generic(rt_function_t *f);
+rt_function_error_t exec_add2_generic(rt_function_t *f);
+rt_function_error_t exec_transpose_generic(rt_function_t *f);
+rt_function_error_t exec_concatenate_generic(rt_function_t *f);
+
+#define MAX_VARIABLES (6)
+#define MAX_DIMS (4)
+
+typedef struct {
+  const char *name;
+  int num_of_inputs;
+  int input_shapes[MAX_VARIABLES][MAX_DIMS + 1]; // {ndim, dims...}
+  int output_shape[MAX_DIMS + 1];
+  // Fill local context, shapes are already set.
+  void (*setup)(void *local_context);
+  size_t local_context_size;
+  rt_function_error_t (*allocate)(rt_function_t *f);
+  rt_function_error_t (*free)(rt_function_t *f);
+  rt_function_error_t (*generic)(rt_function_t *f);
+  double flops; // 0 for memory bound cases
+} bench_case_t;
+
+static int pad0[] = {0, 0};
+static int pad1[] = {1, 1};
+static int one2[] = {1, 1};
+static int two2[] = {2, 2};
+static int axis1[] = {1};
+static int nhwc[] = {0, 2, 3, 1};
+
+static void setup_conv_1x1(void *p) {
+  convolution_local_context_t *c = p;
+  c->base_axis = 1;
+  c->pad = (rt_list_t){2, pad0};
+  c->stride = (rt_list_t){2, one2};
+  c->dilation = (rt_list_t){2, one2};
+  c->group = 1;
+  c->channel_last = 0;
+}
+
+static void setup_conv_3x3(void *p) {
+  convolution_local_context_t *c = p;
+  setup_conv_1x1(p);
+  c->pad = (rt_list_t){2, pad1};
+}
+
+static void setup_conv_3x3_s2(void *p) {
+  convolution_local_context_t *c = p;
+  setup_conv_3x3(p);
+  c->stride = (rt_list_t){2, two2};
+}
+
+static void setup_depthwise(void *p) {
+  depthwise_convolution_local_context_t *c = p;
+  c->base_axis = 1;
+  c->pad = (rt_list_t){2, pad1};
+  c->stride = (rt_list_t){2, one2};
+  c->dilation = (rt_list_t){2, one2};
+  c->multiplier = 1;
+}
+
+static void setup_affine(void *p) {
+  ((affine_local_context_t *)p)->base_axis = 1;
+}
+
+static void setup_max_pooling(void *p) {
+  max_pooling_local_context_t *c = p;
+  c->kernel = (rt_list_t){2, two2};
+  c->stride = (rt_list_t){2, two2};
+  c->ignore_border = 1;
+  c->pad = (rt_list_t){2, pad0};
+  c->channel_last = 0;
+}
+
+static void setup_softmax(void *p) { ((softmax_local_context_t *)p)->axis = 1; }
+
+static void setup_batch_normalization(void *p) {
+  batch_normalization_local_context_t *c = p;
+  c->axes = (rt_list_t){1, axis1};
+  c->decay_rate = 0.9f;
+  c->eps = 1e-5f;
+  c->batch_stat = 0;
+}
+
+static void setup_add2(void *p) { ((add2_local_context_t *)p)->inplace = 0; }
+
+static void setup_transpose(void *p) {
+  ((transpose_local_context_t *)p)->axes = (rt_list_t){4, nhwc};
+}
+
+static void setup_concatenate(void *p) {
+  ((concatenate_local_context_t *)p)->axis = 1;
+}
+
+static const bench_case_t cases[] = {
+    {"conv_1x1", 3, {{4, 1, 64, 56, 56}, {4, 64, 64, 1, 1}, {1, 64}},
+     {4, 1, 64, 56, 56}, setup_conv_1x1,
+     sizeof(convolution_local_context_t), allocate_convolution_local_context,
+     free_convolution_local_context, exec_convolution_generic,
+     2.0 * 64 * 64 * 56 * 56},
+    {"conv_3x3", 3, {{4, 1, 64, 56, 56}, {4, 64, 64, 3, 3}, {1, 64}},
+     {4, 1, 64, 56, 56}, setup_conv_3x3,
+     sizeof(convolution_local_context_t), allocate_convolution_local_context,
+     free_convolution_local_context, exec_convolution_generic,
+     2.0 * 64 * 64 * 9 * 56 * 56},
+    {"conv_3x3_s2", 3, {{4, 1, 64, 56, 56}, {4, 64, 64, 3, 3}, {1, 64}},
+     {4, 1, 64, 28, 28}, setup_conv_3x3_s2,
+     sizeof(convolution_local_context_t), allocate_convolution_local_context,
+     free_convolution_local_context, exec_convolution_generic,
+     2.0 * 64 * 64 * 9 * 28 * 28},
+    {"depthwise_3x3", 3, {{4, 1, 64, 56, 56}, {3, 64, 3, 3}, {1, 64}},
+     {4, 1, 64, 56, 56}, setup_depthwise,
+     sizeof(depthwise_convolution_local_context_t),
+     allocate_depthwise_convolution_local_context,
+     free_depthwise_convolution_local_context, exec_convolution_generic,
+     2.0 * 64 * 9 * 56 * 56},
+    {"affine", 3, {{2, 16, 1024}, {2, 1024, 1000}, {1, 1000}}, {2, 16, 1000},
+     setup_affine, sizeof(affine_local_context_t),
+     allocate_affine_local_context, free_affine_local_context,
+     exec_affine_generic, 2.0 * 16 * 1024 * 1000},
+    {"max_pooling_2x2", 1, {{4, 1, 64, 56, 56}}, {4, 1, 64, 28, 28},
+     setup_max_pooling, sizeof(max_pooling_local_context_t),
+     allocate_max_pooling_local_context, free_max_pooling_local_context, 0,
+     0},
+    {"softmax", 1, {{2, 64, 1000}}, {2, 64, 1000}, setup_softmax,
+     sizeof(softmax_local_context_t), allocate_softmax_local_context,
+     free_softmax_local_context, exec_softmax_generic, 0},
+    {"batch_normalization",
+     5,
+     {{4, 1, 64, 56, 56},
+      {4, 1, 64, 1, 1},
+      {4, 1, 64, 1, 1},
+      {4, 1, 64, 1, 1},
+      {4, 1, 64, 1, 1}},
+     {4, 1, 64, 56, 56},
+     setup_batch_normalization,
+     sizeof(batch_normalization_local_context_t),
+     allocate_batch_normalization_local_context,
+     free_batch_normalization_local_context,
+     exec_batch_normalization_generic,
+     0},
+    {"add2_broadcast", 2, {{4, 1, 64, 56, 56}, {4, 1, 64, 1, 1}},
+     {4, 1, 64, 56, 56}, setup_add2, sizeof(add2_local_context_t),
+     allocate_add2_local_context, free_add2_local_context, exec_add2_generic,
+     0},
+    {"transpose_nchw_nhwc", 1, {{4, 1, 64, 56, 56}}, {4, 1, 56, 56, 64},
+     setup_transpose, sizeof(transpose_local_context_t),
+     allocate_transpose_local_context, free_transpose_local_context,
+     exec_transpose_generic, 0},
+    {"concatenate", 2, {{4, 1, 64, 56, 56}, {4, 1, 64, 56, 56}},
+     {4, 1, 128, 56, 56}, setup_concatenate,
+     sizeof(concatenate_local_context_t), allocate_concatenate_local_context,
+     free_concatenate_local_context, exec_concatenate_generic, 0},
+};
+
+typedef struct {
+  const char *name;
+  nn_data_type_t type;
+  int fp_pos;
+  int generic;
+} bench_variant_t;
+
+static const bench_variant_t variants[] = {
+    {"float", NN_DATA_TYPE_FLOAT, 0, 0},
+    {"generic", NN_DATA_TYPE_FLOAT, 0, 1},
+    {"int8", NN_DATA_TYPE_INT8, 4, 0},
+    {"int16", NN_DATA_TYPE_INT16, 8, 0},
+};
+
+static double now(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static size_t type_size(nn_data_type_t type) {
+  switch (type) {
+  case NN_DATA_TYPE_INT8:
+    return sizeof(int8_t);
+  case NN_DATA_TYPE_INT16:
+    return sizeof(int16_t);
+  default:
+    return sizeof(float);
+  }
+}
+
+static size_t variable_bytes(const rt_variable_t *v) {
+  size_t size = type_size(v->type);
+  int i;
+  for (i = 0; i < v->shape.size; i++) {
+    size *= v->shape.data[i];
+  }
+  return size;
+}
+
+// Variable with random positive values, so that e.g. variance is valid.
+static int init_variable(rt_variable_t *v, const int *shape,
+                         const bench_variant_t *variant) {
+  size_t i, n;
+  v->shape.size = shape[0];
+  v->shape.data = (int *)shape + 1;
+  v->type = variant->type;
+  v->fp_pos = variant->fp_pos;
+  v->coefficient = variant->type == NN_DATA_TYPE_FLOAT
+                       ? 0
+                       : 1.0f / (1 << variant->fp_pos);
+  n = variable_bytes(v) / type_size(v->type);
+  v->data = rt_variable_malloc_func(variable_bytes(v));
+  if (v->data == 0) {
+    return -1;
+  }
+  for (i = 0; i < n; i++) {
+    float value = 0.1f + 0.9f * rand() / RAND_MAX;
+    switch (v->type) {
+    case NN_DATA_TYPE_INT8:
+      ((int8_t *)v->data)[i] = (int8_t)(value * (1 << v->fp_pos));
+      break;
+    case NN_DATA_TYPE_INT16:
+      ((int16_t *)v->data)[i] = (int16_t)(value * (1 << v->fp_pos));
+      break;
+    default:
+      ((float *)v->data)[i] = value;
+      break;
+    }
+  }
+  return 0;
+}
+
+// Run variant of case, and return seconds per execution or negative value.
+static double run_case(const bench_case_t *bc, const bench_variant_t *variant,
+                       double min_seconds, size_t *bytes) {
+  rt_variable_t variables[MAX_VARIABLES + 1];
+  rt_variable_t *inputs[MAX_VARIABLES];
+  rt_variable_t *outputs[1];
+  rt_function_t f;
+  void *workspace = 0;
+  double begin, elapsed = -1;
+  int i, iterations;
+
+  memset(variables, 0, sizeof(variables));
+  for (i = 0; i < bc->num_of_inputs; i++) {
+    inputs[i] = variables + i;
+    if (init_variable(inputs[i], bc->input_shapes[i], variant) < 0) {
+      goto end;
+    }
+  }
+  outputs[0] = variables + bc->num_of_inputs;
+  if (init_variable(outputs[0], bc->output_shape, variant) < 0) {
+    goto end;
+  }
+  *bytes = variable_bytes(outputs[0]);
+  for (i = 0; i < bc->num_of_inputs; i++) {
+    *bytes += variable_bytes(inputs[i]);
+  }
+
+  memset(&f, 0, sizeof(f));
+  f.num_of_inputs = bc->num_of_inputs;
+  f.inputs = inputs;
+  f.num_of_outputs = 1;
+  f.outputs = outputs;
+  f.cpu_features = rt_detect_cpu_features();
+  f.local_context = calloc(1, bc->local_context_size);
+  if (f.local_context == 0) {
+    goto end;
+  }
+  bc->setup(f.local_context);
+  if (bc->allocate(&f) != RT_FUNCTION_ERROR_NOERROR || f.exec_func == 0) {
+    free(f.local_context);
+    goto end;
+  }
+  if (variant->generic) {
+    f.exec_func = bc->generic;
+  }
+  // Scratch memory the runtime would share between functions.
+  if (f.workspace_size > 0) {
+    workspace = malloc(f.workspace_size + 63);
+    if (workspace == 0) {
+      f.exec_func = 0;
+    }
+    f.workspace = (void *)(((uintptr_t)workspace + 63) & ~(uintptr_t)63);
+  }
+
+  if (f.exec_func && f.exec_func(&f) == RT_FUNCTION_ERROR_NOERROR) {
+    iterations = 0;
+    begin = now();
+    do {
+      f.exec_func(&f);
+      iterations++;
+      elapsed = now() - begin;
+    } while (elapsed < min_seconds || iterations < 3);
+    elapsed /= iterations;
+  }
+
+  bc->free(&f);
+  free(f.local_context);
+  free(workspace);
+
+end:
+  for (i = 0; i <= bc->num_of_inputs; i++) {
+    if (variables[i].data) {
+      rt_variable_free_func(variables[i].data);
+    }
+  }
+  return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+  const char *filter = argc > 1 ? argv[1] : "";
+  double min_seconds = argc > 2 ? atof(argv[2]) : 0.2;
+  size_t c, v;
+
+  printf("%-22s %-8s %12s %12s\n", "Case", "Variant", "Time[ms]", "Rate");
+  for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    const bench_case_t *bc = cases + c;
+    if (strstr(bc->name, filter) == 0) {
+      continue;
+    }
+    for (v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+      size_t bytes = 0;
+      double t;
+      if (variants[v].generic && bc->generic == 0) {
+        continue;
+      }
+      t = run_case(bc, variants + v, min_seconds, &bytes);
+      if (t < 0) {
+        printf("%-22s %-8s %12s %12s\n", bc->name, variants[v].name, "-",
+               "unsupported");
+      } else if (bc->flops > 0) {
+        printf("%-22s %-8s %12.4f %7.3f GFLOP/s\n", bc->name, variants[v].name,
+               t * 1e3, bc->flops / t * 1e-9);
+      } else {
+        printf("%-22s %-8s %12.4f %8.3f GB/s\n", bc->name, variants[v].name,
+               t * 1e3, bytes / t * 1e-9);
+      }
+    }
+  }
+  return 0;
+}
@@ -16,6 +16,7 @@
 def generate(filename, info):
     funcid = 0
     printname = []
+    names = []
     dump = []
     for cn, cat in info.items():
         for fn, func in cat.items():
@@ -24,6 +25,9 @@ def generate(filename, info):
             printname.append(
                 '        printf("NNB: Function type:    {}({})\\n");'.format(fn, func['id']))
             printname.append('        } break;')
+            names.append(
+                '    case NN_FUNCTION_{}: // {}'.format(func['snake_name'].upper(), fn))
+            names.append('        return "{}";'.format(fn))
             dump.append(
                 '    case NN_FUNCTION_{}: {{ // {}'.format(func['snake_name'].upper(), fn))
             if 'arguments' in func and len(func['arguments']) > 0:
@@ -61,7 +65,7 @@ def generate(filename, info):
     try:
         tmpl = Template(filename=filename)
         output = tmpl.render(printname='\n'.join(
-            printname), dump='\n'.join(dump))
+            printname), names='\n'.join(names), dump='\n'.join(dump))
         return output
     except:
         print(exceptions.text_error_template().render())
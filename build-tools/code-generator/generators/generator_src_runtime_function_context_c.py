@@ -35,7 +35,7 @@ def _generate_context_code(fn, func, fid_num, arg_fmt, fid):
         l.append(
             '      nn_function_{0}_t *f = (nn_function_{0}_t*)function;'.format(func['snake_name']))
         l.append(
-            '      {0}_local_context_t *ctx = rt_malloc_func(sizeof({0}_local_context_t));'.format(func['snake_name']))
+            '      {0}_local_context_t *ctx = rt_function_malloc(&function_context->func, sizeof({0}_local_context_t));'.format(func['snake_name']))
 
         n = 0
         for an, arg in func['arguments'].items():
@@ -0,0 +1,325 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "network_builder.h"
+
+pointer_index_t add_data(builder_t *b, const void *data, size_t size) {
+  b->data_size = (b->data_size + DATA_ALIGN - 1) & ~(size_t)(DATA_ALIGN - 1);
+  if (b->num_of_data >= MAX_DATA || b->data_size + size > MAX_DATA_SIZE) {
+    fprintf(stderr, "Network does not fit in builder.\n");
+    exit(1);
+  }
+  b->index[b->num_of_data] = b->data_size;
+  memcpy(b->data + b->data_size, data, size);
+  b->data_size += size;
+  return b->num_of_data++;
+}
+
+nn_list_t add_list(builder_t *b, const int32_t *values, int size) {
+  nn_list_t list;
+  list.size = size;
+  list.list = add_data(b, values, sizeof(int32_t) * size);
+  return list;
+}
+
+nn_list_t add_pair(builder_t *b, int32_t value) {
+  int32_t values[] = {value, value};
+  return add_list(b, values, 2);
+}
+
+int shape_size(const int32_t *shape, int dims) {
+  int size = 1;
+  int i;
+  for (i = 0; i < dims; i++) {
+    size *= shape[i];
+  }
+  return size;
+}
+
+int type_size(nn_data_type_t type) {
+  switch (type) {
+  case NN_DATA_TYPE_INT16:
+    return sizeof(int16_t);
+  case NN_DATA_TYPE_INT8:
+    return sizeof(int8_t);
+  default:
+    return sizeof(float);
+  }
+}
+
+void set_value(void *data, nn_data_type_t type, int index, int value) {
+  switch (type) {
+  case NN_DATA_TYPE_INT16:
+    ((int16_t *)data)[index] = value;
+    break;
+  case NN_DATA_TYPE_INT8:
+    ((int8_t *)data)[index] = value;
+    break;
+  default:
+    ((float *)data)[index] = value / 8.0f;
+    break;
+  }
+}
+
+int32_t add_variable(builder_t *b, const int32_t *shape, int dims,
+                     nn_data_type_t type, int fp_pos) {
+  nn_variable_t v;
+  if (b->num_of_variables >= MAX_LIST || b->num_of_buffers >= MAX_LIST) {
+    fprintf(stderr, "Network does not fit in builder.\n");
+    exit(1);
+  }
+  memset(&v, 0, sizeof(v));
+  v.id = b->num_of_variables;
+  v.shape = add_list(b, shape, dims);
+  v.type = type;
+  v.fp_pos = fp_pos;
+  v.data_index = -1 - b->num_of_buffers;
+  b->buffers[b->num_of_buffers++] =
+      shape_size(shape, dims) * type_size(type);
+  b->variables[b->num_of_variables] = add_data(b, &v, sizeof(v));
+  return b->num_of_variables++;
+}
+
+int32_t add_parameter_data(builder_t *b, const int32_t *shape, int dims,
+                           nn_data_type_t type, int fp_pos,
+                           const void *values) {
+  nn_variable_t v;
+  if (b->num_of_variables >= MAX_LIST) {
+    fprintf(stderr, "Network does not fit in builder.\n");
+    exit(1);
+  }
+  memset(&v, 0, sizeof(v));
+  v.id = b->num_of_variables;
+  v.shape = add_list(b, shape, dims);
+  v.type = type;
+  v.fp_pos = fp_pos;
+  v.data_index = add_data(b, values, shape_size(shape, dims) * type_size(type));
+  b->variables[b->num_of_variables] = add_data(b, &v, sizeof(v));
+  return b->num_of_variables++;
+}
+
+int32_t add_parameter(builder_t *b, const int32_t *shape, int dims,
+                      nn_data_type_t type, int fp_pos) {
+  static uint8_t values[MAX_DATA_SIZE / 4];
+  const int size = shape_size(shape, dims);
+  int i;
+
+  for (i = 0; i < size; i++) {
+    set_value(values, type, i, rand() % 15 - 7);
+  }
+  return add_parameter_data(b, shape, dims, type, fp_pos, values);
+}
+
+void set_io(builder_t *b, nn_function_t *f, const int32_t *inputs,
+            int num_of_inputs, int32_t output) {
+  f->impl = NN_FUNCTION_IMPLEMENT_AUTO;
+  f->inputs = add_list(b, inputs, num_of_inputs);
+  f->outputs = add_list(b, &output, 1);
+}
+
+void add_function(builder_t *b, const void *f, size_t size) {
+  if (b->num_of_functions >= MAX_LIST) {
+    fprintf(stderr, "Network does not fit in builder.\n");
+    exit(1);
+  }
+  b->functions[b->num_of_functions++] = add_data(b, f, size);
+}
+
+void add_convolution(builder_t *b, int32_t x, int32_t w, int32_t bias,
+                     int32_t y, int pad) {
+  const int32_t inputs[] = {x, w, bias};
+  nn_function_convolution_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_CONVOLUTION;
+  set_io(b, (nn_function_t *)&f, inputs, 3, y);
+  f.base_axis = 1;
+  f.pad = add_pair(b, pad);
+  f.stride = add_pair(b, 1);
+  f.dilation = add_pair(b, 1);
+  f.group = 1;
+  add_function(b, &f, sizeof(f));
+}
+
+void add_batch_matmul(builder_t *b, int32_t a, int32_t m, int32_t y,
+                      int transpose_a, int transpose_b) {
+  const int32_t inputs[] = {a, m};
+  nn_function_batch_matmul_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_BATCH_MATMUL;
+  set_io(b, (nn_function_t *)&f, inputs, 2, y);
+  f.transpose_a = transpose_a;
+  f.transpose_b = transpose_b;
+  add_function(b, &f, sizeof(f));
+}
+
+void add_batch_normalization(builder_t *b, const int32_t *inputs, int32_t y,
+                             int batch_stat) {
+  const int32_t axes[] = {1};
+  nn_function_batch_normalization_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_BATCH_NORMALIZATION;
+  set_io(b, (nn_function_t *)&f, inputs, 5, y);
+  f.axes = add_list(b, axes, 1);
+  f.decay_rate = 0.9f;
+  f.eps = 1e-5f;
+  f.batch_stat = batch_stat;
+  add_function(b, &f, sizeof(f));
+}
+
+void add_affine(builder_t *b, int32_t x, int32_t w, int32_t bias,
+                int32_t y) {
+  const int32_t inputs[] = {x, w, bias};
+  nn_function_affine_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_AFFINE;
+  set_io(b, (nn_function_t *)&f, inputs, 3, y);
+  f.base_axis = 1;
+  add_function(b, &f, sizeof(f));
+}
+
+void add_unary(builder_t *b, nn_function_type_t type, int32_t x, int32_t y) {
+  // Arguments such as inplace of ReLU are left 0.
+  nn_function_relu_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = type;
+  set_io(b, (nn_function_t *)&f, &x, 1, y);
+  add_function(b, &f, sizeof(f));
+}
+
+void add_max_pooling(builder_t *b, int32_t x, int32_t y, int kernel) {
+  nn_function_max_pooling_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_MAX_POOLING;
+  set_io(b, (nn_function_t *)&f, &x, 1, y);
+  f.kernel = add_pair(b, kernel);
+  f.stride = add_pair(b, kernel);
+  f.ignore_border = 1;
+  f.pad = add_pair(b, 0);
+  add_function(b, &f, sizeof(f));
+}
+
+void add_reshape(builder_t *b, int32_t x, int32_t y, const int32_t *shape,
+                 int dims) {
+  nn_function_reshape_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_RESHAPE;
+  set_io(b, (nn_function_t *)&f, &x, 1, y);
+  f.shape = add_list(b, shape, dims);
+  add_function(b, &f, sizeof(f));
+}
+
+void add_dropout(builder_t *b, int32_t x, int32_t y, float p) {
+  nn_function_dropout_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_DROPOUT;
+  set_io(b, (nn_function_t *)&f, &x, 1, y);
+  f.p = p;
+  f.seed = -1;
+  add_function(b, &f, sizeof(f));
+}
+
+void add_slice(builder_t *b, int32_t x, int32_t y, const int32_t *start,
+               const int32_t *stop, int dims) {
+  int32_t step[MAX_LIST];
+  nn_function_slice_t f;
+  int i;
+  for (i = 0; i < dims; i++) {
+    step[i] = 1;
+  }
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_SLICE;
+  set_io(b, (nn_function_t *)&f, &x, 1, y);
+  f.start = add_list(b, start, dims);
+  f.stop = add_list(b, stop, dims);
+  f.step = add_list(b, step, dims);
+  add_function(b, &f, sizeof(f));
+}
+
+void add_concatenate(builder_t *b, const int32_t *inputs, int num_of_inputs,
+                     int32_t y, int axis) {
+  nn_function_concatenate_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_CONCATENATE;
+  set_io(b, (nn_function_t *)&f, inputs, num_of_inputs, y);
+  f.axis = axis;
+  add_function(b, &f, sizeof(f));
+}
+
+void add_split(builder_t *b, int32_t x, const int32_t *outputs,
+               int num_of_outputs, int axis) {
+  nn_function_split_t f;
+  memset(&f, 0, sizeof(f));
+  f.type = NN_FUNCTION_SPLIT;
+  f.impl = NN_FUNCTION_IMPLEMENT_AUTO;
+  f.inputs = add_list(b, &x, 1);
+  f.outputs = add_list(b, outputs, num_of_outputs);
+  f.axis = axis;
+  add_function(b, &f, sizeof(f));
+}
+
+nn_network_t *finish_network(builder_t *b) {
+  nn_network_t n;
+  size_t index_size;
+  uint8_t *memory;
+
+  memset(&n, 0, sizeof(n));
+  n.version = NN_BINARY_FORMAT_VERSION;
+  n.api_level = NN_API_LEVEL;
+  n.buffers = add_list(b, b->buffers, b->num_of_buffers);
+  n.variables = add_list(b, b->variables, b->num_of_variables);
+  n.functions = add_list(b, b->functions, b->num_of_functions);
+  n.inputs = add_list(b, &b->input, 1);
+  n.outputs = add_list(b, &b->output, 1);
+  n.memory.num_of_data = b->num_of_data;
+  n.memory.data_size = b->data_size;
+
+  index_size = sizeof(pointer_index_t) * b->num_of_data;
+  memory = malloc(sizeof(n) + index_size + b->data_size);
+  if (memory == 0) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  memcpy(memory, &n, sizeof(n));
+  memcpy(memory + sizeof(n), b->index, index_size);
+  memcpy(memory + sizeof(n) + index_size, b->data, b->data_size);
+  return (nn_network_t *)memory;
+}
+
+size_t network_bytes(const nn_network_t *n) {
+  return sizeof(nn_network_t) +
+         sizeof(pointer_index_t) * n->memory.num_of_data +
+         n->memory.data_size;
+}
+
+void *network_data(const nn_network_t *n, pointer_index_t index) {
+  const pointer_index_t *indices = (const pointer_index_t *)(n + 1);
+  const uint8_t *data = (const uint8_t *)(indices + n->memory.num_of_data);
+  return (void *)(data + indices[index]);
+}
+
+int write_network_file(const nn_network_t *n, const char *filename) {
+  FILE *fp = fopen(filename, "wb");
+  size_t size = network_bytes(n);
+  int ok;
+
+  if (fp == 0) {
+    return 0;
+  }
+  ok = fwrite(n, 1, size, fp) == size;
+  return fclose(fp) == 0 && ok;
+}
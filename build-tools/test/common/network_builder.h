@@ -0,0 +1,107 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_NETWORK_BUILDER_H_181016120000_
+#define H_NETWORK_BUILDER_H_181016120000_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <nnablart/network.h>
+
+#define MAX_DATA (128)
+#define MAX_DATA_SIZE (262144)
+#define MAX_LIST (32)
+#define DATA_ALIGN (16)
+
+// Network under construction, laid out as the index and data area of NNB.
+typedef struct {
+  int num_of_data;
+  pointer_index_t index[MAX_DATA];
+  size_t data_size;
+  uint8_t data[MAX_DATA_SIZE];
+
+  int num_of_buffers;
+  int32_t buffers[MAX_LIST];
+  int num_of_variables;
+  int32_t variables[MAX_LIST];
+  int num_of_functions;
+  int32_t functions[MAX_LIST];
+  int32_t input;
+  int32_t output;
+} builder_t;
+
+pointer_index_t add_data(builder_t *b, const void *data, size_t size);
+nn_list_t add_list(builder_t *b, const int32_t *values, int size);
+nn_list_t add_pair(builder_t *b, int32_t value);
+
+int shape_size(const int32_t *shape, int dims);
+int type_size(nn_data_type_t type);
+
+// Store value / 8 as float, or value as integer of type.
+void set_value(void *data, nn_data_type_t type, int index, int value);
+
+// Variable in a buffer of its own.
+int32_t add_variable(builder_t *b, const int32_t *shape, int dims,
+                     nn_data_type_t type, int fp_pos);
+
+// Parameter holding values, laid out as a variable of type.
+int32_t add_parameter_data(builder_t *b, const int32_t *shape, int dims,
+                           nn_data_type_t type, int fp_pos,
+                           const void *values);
+
+// Parameter filled with pseudo random values from -7 to 7 given to
+// set_value(), small enough for fixed point sums not to saturate.
+int32_t add_parameter(builder_t *b, const int32_t *shape, int dims,
+                      nn_data_type_t type, int fp_pos);
+
+// Common part of function f. The function itself is added by add_function.
+void set_io(builder_t *b, nn_function_t *f, const int32_t *inputs,
+            int num_of_inputs, int32_t output);
+void add_function(builder_t *b, const void *f, size_t size);
+
+void add_convolution(builder_t *b, int32_t x, int32_t w, int32_t bias,
+                     int32_t y, int pad);
+void add_batch_matmul(builder_t *b, int32_t a, int32_t m, int32_t y,
+                      int transpose_a, int transpose_b);
+// Inputs are x, beta, gamma, mean and variance, normalized over axis 1.
+void add_batch_normalization(builder_t *b, const int32_t *inputs, int32_t y,
+                             int batch_stat);
+void add_affine(builder_t *b, int32_t x, int32_t w, int32_t bias, int32_t y);
+// Function of type taking x alone, e.g. ReLU, Tanh or Identity.
+void add_unary(builder_t *b, nn_function_type_t type, int32_t x, int32_t y);
+void add_max_pooling(builder_t *b, int32_t x, int32_t y, int kernel);
+void add_reshape(builder_t *b, int32_t x, int32_t y, const int32_t *shape,
+                 int dims);
+void add_dropout(builder_t *b, int32_t x, int32_t y, float p);
+void add_slice(builder_t *b, int32_t x, int32_t y, const int32_t *start,
+               const int32_t *stop, int dims);
+void add_concatenate(builder_t *b, const int32_t *inputs, int num_of_inputs,
+                     int32_t y, int axis);
+void add_split(builder_t *b, int32_t x, const int32_t *outputs,
+               int num_of_outputs, int axis);
+
+// Network of b allocated with malloc.
+nn_network_t *finish_network(builder_t *b);
+
+// Bytes of network as stored in NNB.
+size_t network_bytes(const nn_network_t *n);
+
+// Data at index of network, as NN_GET() of the runtime.
+void *network_data(const nn_network_t *n, pointer_index_t index);
+
+// Write network as NNB file, returns 0 on failure.
+int write_network_file(const nn_network_t *n, const char *filename);
+
+#endif // H_NETWORK_BUILDER_H_181016120000_
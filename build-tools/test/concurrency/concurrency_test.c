@@ -0,0 +1,296 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Concurrent inference test.
+ *
+ * Each case builds a network in memory, runs it once with a single context
+ * for the expected output, then initializes NUM_OF_CONTEXTS contexts from
+ * the same network and calls rt_forward() on each of them from its own
+ * thread for NUM_OF_ITERATIONS iterations. Contexts are initialized either
+ * on the main thread or by the workers themselves, concurrently, and in the
+ * last round every other worker carves its context from a memory block
+ * while the others allocate theirs from the heap. The test fails unless
+ * every output is bit-identical to the expected one and the network bytes
+ * are unchanged afterwards.
+ *
+ * Cases cover functions which used to write shared memory while executing:
+ *   conv_int8   Convolution with int8 data and a bias rescaled to the output
+ *   conv_int16  same as conv_int8 with int16 data
+ *   batch_matmul BatchMatmul with every combination of transposes
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "../common/network_builder.h"
+
+#define NUM_OF_CONTEXTS (4)
+#define NUM_OF_ITERATIONS (8)
+
+typedef struct {
+  const char *name;
+  void (*build)(builder_t *b);
+} test_case_t;
+
+// How contexts of a round are initialized.
+typedef enum {
+  INIT_ON_MAIN_THREAD,   // serially, before the workers start
+  INIT_ON_WORKERS,       // by each worker, concurrently with the others
+  INIT_BLOCK_ON_WORKERS, // same, every other one with rt_use_memory_block()
+  END_OF_INIT
+} init_mode_t;
+
+static const char *const init_mode_names[] = {"main thread", "workers",
+                                              "workers with memory blocks"};
+
+typedef struct {
+  nn_network_t *network;
+  rt_context_pointer context;
+  int use_memory_block;
+  int initialized;
+  const void *input;
+  size_t input_bytes;
+  const void *expected;
+  size_t output_bytes;
+  int mismatches;
+} worker_t;
+
+// 3x3 and pointwise Convolutions. Biases have more precision bits than the
+// outputs, so that they are rescaled while they are added.
+static void build_convolution(builder_t *b, nn_data_type_t type) {
+  const int32_t x_shape[] = {2, 8, 10, 10};
+  const int32_t y_shape[] = {2, 16, 10, 10};
+  const int32_t z_shape[] = {2, 12, 10, 10};
+  const int32_t w0_shape[] = {16, 8, 3, 3};
+  const int32_t w1_shape[] = {12, 16, 1, 1};
+  const int32_t b0_shape[] = {16};
+  const int32_t b1_shape[] = {12};
+  int32_t x, w0, b0, y, w1, b1, z;
+
+  x = add_variable(b, x_shape, 4, type, 4);
+  w0 = add_parameter(b, w0_shape, 4, type, 4);
+  b0 = add_parameter(b, b0_shape, 1, type, 5);
+  y = add_variable(b, y_shape, 4, type, 3);
+  w1 = add_parameter(b, w1_shape, 4, type, 4);
+  b1 = add_parameter(b, b1_shape, 1, type, 4);
+  z = add_variable(b, z_shape, 4, type, 2);
+  add_convolution(b, x, w0, b0, y, 1);
+  add_convolution(b, y, w1, b1, z, 0);
+  b->input = x;
+  b->output = z;
+}
+
+static void build_convolution_int8(builder_t *b) {
+  build_convolution(b, NN_DATA_TYPE_INT8);
+}
+
+static void build_convolution_int16(builder_t *b) {
+  build_convolution(b, NN_DATA_TYPE_INT16);
+}
+
+// Chain of BatchMatmul with parameters as the transposed operands:
+//   y = a^T * m0^T, z = y * m1^T, o = z^T * m2
+static void build_batch_matmul(builder_t *b) {
+  const int32_t a_shape[] = {3, 6, 5};
+  const int32_t m0_shape[] = {3, 4, 6};
+  const int32_t y_shape[] = {3, 5, 4};
+  const int32_t m1_shape[] = {3, 7, 4};
+  const int32_t z_shape[] = {3, 5, 7};
+  const int32_t m2_shape[] = {3, 5, 2};
+  const int32_t o_shape[] = {3, 7, 2};
+  int32_t a, m0, y, m1, z, m2, o;
+
+  a = add_variable(b, a_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  m0 = add_parameter(b, m0_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  y = add_variable(b, y_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  m1 = add_parameter(b, m1_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  z = add_variable(b, z_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  m2 = add_parameter(b, m2_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  o = add_variable(b, o_shape, 3, NN_DATA_TYPE_FLOAT, 0);
+  add_batch_matmul(b, a, m0, y, 1, 1);
+  add_batch_matmul(b, y, m1, z, 0, 1);
+  add_batch_matmul(b, z, m2, o, 1, 0);
+  b->input = a;
+  b->output = o;
+}
+
+static const test_case_t test_cases[] = {
+    {"conv_int8", build_convolution_int8},
+    {"conv_int16", build_convolution_int16},
+    {"batch_matmul", build_batch_matmul},
+};
+
+static size_t input_bytes(rt_context_pointer context) {
+  return rt_input_size(context, 0) *
+         type_size(rt_input_variable(context, 0)->type);
+}
+
+static size_t output_bytes(rt_context_pointer context) {
+  return rt_output_size(context, 0) *
+         type_size(rt_output_variable(context, 0)->type);
+}
+
+static void *run_worker(void *arg) {
+  worker_t *w = (worker_t *)arg;
+  int i;
+
+  if (!w->initialized) {
+    if (rt_allocate_context(&w->context) != RT_RET_NOERROR) {
+      return 0;
+    }
+    if (w->use_memory_block) {
+      rt_use_memory_block(w->context, 1);
+    }
+    if (rt_initialize_context(w->context, w->network) != RT_RET_NOERROR) {
+      rt_free_context(&w->context);
+      w->context = 0;
+      return 0;
+    }
+    w->initialized = 1;
+  }
+  for (i = 0; i < NUM_OF_ITERATIONS; i++) {
+    memcpy(rt_input_buffer(w->context, 0), w->input, w->input_bytes);
+    if (rt_forward(w->context) != RT_RET_NOERROR ||
+        memcmp(rt_output_buffer(w->context, 0), w->expected,
+               w->output_bytes) != 0) {
+      w->mismatches++;
+    }
+  }
+  return 0;
+}
+
+// Number of failures of NUM_OF_CONTEXTS contexts running concurrently.
+static int run_round(const char *name, init_mode_t mode, nn_network_t *network,
+                     const void *input, size_t in_bytes,
+                     const void *expected, size_t out_bytes) {
+  pthread_t threads[NUM_OF_CONTEXTS];
+  worker_t workers[NUM_OF_CONTEXTS];
+  int failures = 0;
+  int i;
+
+  for (i = 0; i < NUM_OF_CONTEXTS; i++) {
+    worker_t *w = &workers[i];
+    memset(w, 0, sizeof(*w));
+    w->network = network;
+    w->input = input;
+    w->input_bytes = in_bytes;
+    w->expected = expected;
+    w->output_bytes = out_bytes;
+    w->use_memory_block = mode == INIT_BLOCK_ON_WORKERS && i % 2 == 1;
+    if (mode == INIT_ON_MAIN_THREAD) {
+      rt_allocate_context(&w->context);
+      w->initialized =
+          rt_initialize_context(w->context, network) == RT_RET_NOERROR;
+    }
+  }
+  for (i = 0; i < NUM_OF_CONTEXTS; i++) {
+    pthread_create(&threads[i], 0, run_worker, &workers[i]);
+  }
+  for (i = 0; i < NUM_OF_CONTEXTS; i++) {
+    pthread_join(threads[i], 0);
+  }
+
+  for (i = 0; i < NUM_OF_CONTEXTS; i++) {
+    worker_t *w = &workers[i];
+    if (!w->initialized) {
+      printf("%s: context %d failed to initialize on %s\n", name, i,
+             init_mode_names[mode]);
+      failures++;
+    } else if (w->mismatches) {
+      printf("%s: context %d initialized on %s differs from single context "
+             "in %d of %d iterations\n",
+             name, i, init_mode_names[mode], w->mismatches,
+             NUM_OF_ITERATIONS);
+      failures++;
+    }
+    if (w->context) {
+      rt_free_context(&w->context);
+    }
+  }
+  return failures;
+}
+
+// Number of failures of test case.
+static int run_test_case(const test_case_t *t) {
+  static builder_t builder;
+  rt_context_pointer reference;
+  nn_network_t *network;
+  uint8_t *pristine;
+  void *input;
+  void *expected;
+  size_t network_size;
+  int mode;
+  int i;
+  int failures = 0;
+
+  memset(&builder, 0, sizeof(builder));
+  srand(1);
+  t->build(&builder);
+  network = finish_network(&builder);
+  network_size = network_bytes(network);
+  pristine = malloc(network_size);
+  memcpy(pristine, network, network_size);
+
+  // Expected output of a single context.
+  rt_allocate_context(&reference);
+  if (rt_initialize_context(reference, network) != RT_RET_NOERROR) {
+    printf("%s: failed to initialize context\n", t->name);
+    return 1;
+  }
+  input = malloc(input_bytes(reference));
+  for (i = 0; i < rt_input_size(reference, 0); i++) {
+    set_value(input, rt_input_variable(reference, 0)->type, i,
+              i * 7 % 13 - 6);
+  }
+  memcpy(rt_input_buffer(reference, 0), input, input_bytes(reference));
+  rt_forward(reference);
+  expected = malloc(output_bytes(reference));
+  memcpy(expected, rt_output_buffer(reference, 0), output_bytes(reference));
+
+  for (mode = 0; mode < END_OF_INIT; mode++) {
+    failures += run_round(t->name, mode, network, input,
+                          input_bytes(reference), expected,
+                          output_bytes(reference));
+  }
+  if (memcmp(network, pristine, network_size) != 0) {
+    printf("%s: network was modified\n", t->name);
+    failures++;
+  }
+
+  rt_free_context(&reference);
+  free(expected);
+  free(input);
+  free(pristine);
+  free(network);
+  if (failures == 0) {
+    printf("%s: OK\n", t->name);
+  }
+  return failures;
+}
+
+int main(void) {
+  size_t i;
+  int failures = 0;
+
+  for (i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+    failures += run_test_case(&test_cases[i]);
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Network file loading test.
+ *
+ * Writes a network with BatchNormalization computing batch statistics to
+ * an NNB file, loads it with rt_load_network_file() and calls rt_forward()
+ * NUM_OF_ITERATIONS times. BatchNormalization updates the running mean and
+ * variance stored in the network while it executes, so the loaded network
+ * must be writable. The test fails unless outputs and updated statistics
+ * are bit-identical to those of the same network built in memory, and the
+ * file is unchanged afterwards.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "../common/network_builder.h"
+
+#define NUM_OF_ITERATIONS (3)
+#define NETWORK_FILE "loader_test.nnb"
+
+static const int32_t x_shape[] = {4, 3, 5, 5};
+
+// x -> BatchNormalization with batch_stat -> y
+static void build_batch_normalization(builder_t *b) {
+  const int32_t stat_shape[] = {1, 3, 1, 1};
+  const float variance[] = {1.0f, 0.5f, 2.0f};
+  int32_t inputs[5];
+
+  inputs[0] = add_variable(b, x_shape, 4, NN_DATA_TYPE_FLOAT, 0);
+  inputs[1] = add_parameter(b, stat_shape, 4, NN_DATA_TYPE_FLOAT, 0);
+  inputs[2] = add_parameter(b, stat_shape, 4, NN_DATA_TYPE_FLOAT, 0);
+  inputs[3] = add_parameter(b, stat_shape, 4, NN_DATA_TYPE_FLOAT, 0);
+  inputs[4] = add_parameter_data(b, stat_shape, 4, NN_DATA_TYPE_FLOAT, 0,
+                                 variance);
+  b->input = inputs[0];
+  b->output = add_variable(b, x_shape, 4, NN_DATA_TYPE_FLOAT, 0);
+  add_batch_normalization(b, inputs, b->output, 1);
+}
+
+// Run network NUM_OF_ITERATIONS times and keep the outputs in outputs.
+// Returns 0 on failure.
+static int run_network(nn_network_t *network, float *outputs) {
+  rt_context_pointer context;
+  int i, j;
+
+  if (rt_allocate_context(&context) != RT_RET_NOERROR) {
+    return 0;
+  }
+  if (rt_initialize_context(context, network) != RT_RET_NOERROR) {
+    rt_free_context(&context);
+    return 0;
+  }
+  const int size = rt_output_size(context, 0);
+  for (i = 0; i < NUM_OF_ITERATIONS; i++) {
+    float *x = rt_input_buffer(context, 0);
+    for (j = 0; j < rt_input_size(context, 0); j++) {
+      set_value(x, NN_DATA_TYPE_FLOAT, j, (i + j * 7) % 13 - 6);
+    }
+    rt_forward(context);
+    memcpy(outputs + i * size, rt_output_buffer(context, 0),
+           sizeof(float) * size);
+  }
+  rt_free_context(&context);
+  return 1;
+}
+
+// File content, 0 if it cannot be read.
+static uint8_t *read_file(const char *filename, size_t size) {
+  FILE *fp = fopen(filename, "rb");
+  uint8_t *data = malloc(size + 1);
+  size_t read_size = 0;
+
+  if (fp != 0 && data != 0) {
+    read_size = fread(data, 1, size + 1, fp);
+  }
+  if (fp != 0) {
+    fclose(fp);
+  }
+  if (read_size != size) {
+    free(data);
+    return 0;
+  }
+  return data;
+}
+
+int main(void) {
+  static builder_t builder;
+  nn_network_t *expected;
+  nn_network_t *loaded;
+  uint8_t *pristine;
+  uint8_t *file;
+  float *expected_outputs;
+  float *outputs;
+  size_t size;
+  int failures = 0;
+
+  memset(&builder, 0, sizeof(builder));
+  srand(1);
+  build_batch_normalization(&builder);
+  expected = finish_network(&builder);
+  size = network_bytes(expected);
+  pristine = malloc(size);
+  memcpy(pristine, expected, size);
+  if (!write_network_file(expected, NETWORK_FILE)) {
+    printf("failed to write %s\n", NETWORK_FILE);
+    return 1;
+  }
+
+  const size_t outputs_size =
+      sizeof(float) * NUM_OF_ITERATIONS * shape_size(x_shape, 4);
+  expected_outputs = malloc(outputs_size);
+  outputs = malloc(outputs_size);
+  if (!run_network(expected, expected_outputs)) {
+    printf("failed to run network built in memory\n");
+    return 1;
+  }
+  if (memcmp(expected, pristine, size) == 0) {
+    printf("running statistics were not updated\n");
+    failures++;
+  }
+
+  if (rt_load_network_file(NETWORK_FILE, &loaded) != RT_RET_NOERROR) {
+    printf("failed to load %s\n", NETWORK_FILE);
+    return 1;
+  }
+  if (!run_network(loaded, outputs)) {
+    printf("failed to run loaded network\n");
+    failures++;
+  } else if (memcmp(outputs, expected_outputs, outputs_size) != 0) {
+    printf("outputs of loaded network differ\n");
+    failures++;
+  } else if (memcmp(loaded, expected, size) != 0) {
+    printf("running statistics of loaded network differ\n");
+    failures++;
+  }
+  rt_unload_network_file(loaded);
+
+  file = read_file(NETWORK_FILE, size);
+  if (file == 0 || memcmp(file, pristine, size) != 0) {
+    printf("%s was modified\n", NETWORK_FILE);
+    failures++;
+  }
+  remove(NETWORK_FILE);
+
+  free(file);
+  free(outputs);
+  free(expected_outputs);
+  free(pristine);
+  free(expected);
+  if (failures == 0) {
+    printf("batch_normalization: OK\n");
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,511 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Regression test of graph passes, memory plans, memory blocks and bound
+ * inputs and outputs.
+ *
+ * Each case builds a network and runs it NUM_OF_ITERATIONS times with a new
+ * context for every configuration in configs, each time from a pristine
+ * copy of the network. The first configuration executes functions as given,
+ * with the network plan, the heap and inputs and outputs copied. Outputs
+ * and parameters of the network afterwards are compared with
+ *   - those of the first configuration with the same optimization flags,
+ *     bit for bit, since plans, blocks and bindings only move data,
+ *   - those of the first configuration within TOLERANCE, since folding and
+ *     fusing change the rounding.
+ * Cases with views also check that RT_OPTIMIZATION_ALIAS_VARIABLES elided
+ * the functions making them.
+ *
+ * Cases:
+ *   conv_bn     Convolution, BatchNormalization, ReLU, Convolution, Tanh and
+ *               MaxPooling, for folding, fusing and channel last
+ *   affine_bn   Affine, BatchNormalization, Sigmoid and Affine
+ *   views       Slice, Reshape, Identity, Concatenate, Dropout and Split
+ *   batch_stat  Convolution, BatchNormalization computing batch statistics,
+ *               ReLU and Convolution loaded from an NNB file, which must not
+ *               be folded and update running statistics in the network
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "../common/network_builder.h"
+
+#define NUM_OF_ITERATIONS (3)
+#define TOLERANCE (1e-4f)
+#define NETWORK_FILE "regression_test.nnb"
+
+// Where a context allocates its memory.
+typedef enum {
+  HEAP,             // each part separately
+  MEMORY_BLOCK,     // rt_use_memory_block()
+  USER_MEMORY_BLOCK // rt_set_memory_block() with rt_memory_block_size()
+} memory_t;
+
+typedef struct {
+  const char *name;
+  int optimization;
+  rt_memory_plan_t plan;
+  memory_t memory;
+  int bind;
+} config_t;
+
+static const config_t configs[] = {
+    {"none", RT_OPTIMIZATION_NONE, RT_MEMORY_PLAN_NETWORK, HEAP, 0},
+    {"fold_batch_normalization", RT_OPTIMIZATION_FOLD_BATCH_NORMALIZATION,
+     RT_MEMORY_PLAN_NETWORK, HEAP, 0},
+    {"fuse_activation", RT_OPTIMIZATION_FUSE_ACTIVATION,
+     RT_MEMORY_PLAN_NETWORK, HEAP, 0},
+    {"alias_variables", RT_OPTIMIZATION_ALIAS_VARIABLES,
+     RT_MEMORY_PLAN_NETWORK, HEAP, 0},
+    {"channel_last", RT_OPTIMIZATION_CHANNEL_LAST, RT_MEMORY_PLAN_NETWORK,
+     HEAP, 0},
+    {"all", RT_OPTIMIZATION_ALL, RT_MEMORY_PLAN_NETWORK, HEAP, 0},
+    {"liveness", RT_OPTIMIZATION_NONE, RT_MEMORY_PLAN_LIVENESS, HEAP, 0},
+    {"memory_block", RT_OPTIMIZATION_NONE, RT_MEMORY_PLAN_NETWORK,
+     MEMORY_BLOCK, 0},
+    {"user_memory_block", RT_OPTIMIZATION_NONE, RT_MEMORY_PLAN_NETWORK,
+     USER_MEMORY_BLOCK, 0},
+    {"bind", RT_OPTIMIZATION_NONE, RT_MEMORY_PLAN_NETWORK, HEAP, 1},
+    {"all_liveness", RT_OPTIMIZATION_ALL, RT_MEMORY_PLAN_LIVENESS, HEAP, 0},
+    {"all_memory_block", RT_OPTIMIZATION_ALL, RT_MEMORY_PLAN_NETWORK,
+     MEMORY_BLOCK, 0},
+    {"all_liveness_user_memory_block", RT_OPTIMIZATION_ALL,
+     RT_MEMORY_PLAN_LIVENESS, USER_MEMORY_BLOCK, 0},
+    {"all_bind", RT_OPTIMIZATION_ALL, RT_MEMORY_PLAN_NETWORK, HEAP, 1},
+    {"all_liveness_memory_block_bind", RT_OPTIMIZATION_ALL,
+     RT_MEMORY_PLAN_LIVENESS, MEMORY_BLOCK, 1},
+};
+
+#define NUM_OF_CONFIGS ((int)(sizeof(configs) / sizeof(configs[0])))
+
+typedef struct {
+  const char *name;
+  void (*build)(builder_t *b);
+  int from_file;      // loaded with rt_load_network_file()
+  int num_of_aliased; // elided by RT_OPTIMIZATION_ALIAS_VARIABLES
+} test_case_t;
+
+// Outputs of every iteration and the network after running.
+typedef struct {
+  float *outputs;
+  nn_network_t *network;
+  int num_of_aliased;
+} result_t;
+
+// Parameters of BatchNormalization over axis 1 of size channels, with
+// positive variance.
+static void add_statistics(builder_t *b, int32_t *inputs,
+                           const int32_t *shape, int dims, int channels) {
+  float variance[MAX_LIST];
+  int i;
+
+  for (i = 0; i < channels; i++) {
+    variance[i] = 0.25f + (rand() % 8) / 4.0f;
+  }
+  inputs[1] = add_parameter(b, shape, dims, NN_DATA_TYPE_FLOAT, 0);
+  inputs[2] = add_parameter(b, shape, dims, NN_DATA_TYPE_FLOAT, 0);
+  inputs[3] = add_parameter(b, shape, dims, NN_DATA_TYPE_FLOAT, 0);
+  inputs[4] =
+      add_parameter_data(b, shape, dims, NN_DATA_TYPE_FLOAT, 0, variance);
+}
+
+// x -> Convolution -> BatchNormalization -> ReLU -> Convolution -> Tanh
+//   -> MaxPooling -> y
+static void build_convolution(builder_t *b, int batch_stat) {
+  const int32_t x_shape[] = {2, 4, 8, 8};
+  const int32_t w0_shape[] = {8, 4, 3, 3};
+  const int32_t b0_shape[] = {8};
+  const int32_t h_shape[] = {2, 8, 8, 8};
+  const int32_t stat_shape[] = {1, 8, 1, 1};
+  const int32_t w1_shape[] = {6, 8, 1, 1};
+  const int32_t b1_shape[] = {6};
+  const int32_t z_shape[] = {2, 6, 8, 8};
+  const int32_t y_shape[] = {2, 6, 4, 4};
+  const nn_data_type_t t = NN_DATA_TYPE_FLOAT;
+  int32_t x, w0, b0, h0, h1, h2, w1, b1, z0, z1;
+  int32_t inputs[5];
+
+  x = add_variable(b, x_shape, 4, t, 0);
+  w0 = add_parameter(b, w0_shape, 4, t, 0);
+  b0 = add_parameter(b, b0_shape, 1, t, 0);
+  h0 = add_variable(b, h_shape, 4, t, 0);
+  add_convolution(b, x, w0, b0, h0, 1);
+  inputs[0] = h0;
+  add_statistics(b, inputs, stat_shape, 4, 8);
+  h1 = add_variable(b, h_shape, 4, t, 0);
+  add_batch_normalization(b, inputs, h1, batch_stat);
+  h2 = add_variable(b, h_shape, 4, t, 0);
+  add_unary(b, NN_FUNCTION_RELU, h1, h2);
+  w1 = add_parameter(b, w1_shape, 4, t, 0);
+  b1 = add_parameter(b, b1_shape, 1, t, 0);
+  z0 = add_variable(b, z_shape, 4, t, 0);
+  add_convolution(b, h2, w1, b1, z0, 0);
+  z1 = add_variable(b, z_shape, 4, t, 0);
+  add_unary(b, NN_FUNCTION_TANH, z0, z1);
+  b->input = x;
+  b->output = add_variable(b, y_shape, 4, t, 0);
+  add_max_pooling(b, z1, b->output, 2);
+}
+
+static void build_convolution_inference(builder_t *b) {
+  build_convolution(b, 0);
+}
+
+static void build_convolution_batch_stat(builder_t *b) {
+  build_convolution(b, 1);
+}
+
+// x -> Affine -> BatchNormalization -> Sigmoid -> Affine -> y
+static void build_affine(builder_t *b) {
+  const int32_t x_shape[] = {4, 12};
+  const int32_t w0_shape[] = {12, 16};
+  const int32_t b0_shape[] = {16};
+  const int32_t h_shape[] = {4, 16};
+  const int32_t stat_shape[] = {1, 16};
+  const int32_t w1_shape[] = {16, 5};
+  const int32_t b1_shape[] = {5};
+  const int32_t y_shape[] = {4, 5};
+  const nn_data_type_t t = NN_DATA_TYPE_FLOAT;
+  int32_t x, w0, b0, h0, h1, h2, w1, b1;
+  int32_t inputs[5];
+
+  x = add_variable(b, x_shape, 2, t, 0);
+  w0 = add_parameter(b, w0_shape, 2, t, 0);
+  b0 = add_parameter(b, b0_shape, 1, t, 0);
+  h0 = add_variable(b, h_shape, 2, t, 0);
+  add_affine(b, x, w0, b0, h0);
+  inputs[0] = h0;
+  add_statistics(b, inputs, stat_shape, 2, 16);
+  h1 = add_variable(b, h_shape, 2, t, 0);
+  add_batch_normalization(b, inputs, h1, 0);
+  h2 = add_variable(b, h_shape, 2, t, 0);
+  add_unary(b, NN_FUNCTION_SIGMOID, h1, h2);
+  w1 = add_parameter(b, w1_shape, 2, t, 0);
+  b1 = add_parameter(b, b1_shape, 1, t, 0);
+  b->input = x;
+  b->output = add_variable(b, y_shape, 2, t, 0);
+  add_affine(b, h2, w1, b1, b->output);
+}
+
+// x -> Slice -> Reshape -> Identity -> Tanh ---> Concatenate -> Dropout
+//                       \-> Sigmoid ----------/
+//   -> Affine -> Split -> ReLU -> y
+static void build_views(builder_t *b) {
+  const int32_t x_shape[] = {4, 6, 5};
+  const int32_t start[] = {1, 0, 0};
+  const int32_t stop[] = {3, 6, 5};
+  const int32_t s_shape[] = {2, 6, 5};
+  const int32_t r_shape[] = {2, 30};
+  const int32_t c_shape[] = {4, 30};
+  const int32_t w_shape[] = {30, 7};
+  const int32_t bias_shape[] = {7};
+  const int32_t a_shape[] = {4, 7};
+  const nn_data_type_t t = NN_DATA_TYPE_FLOAT;
+  int32_t x, s, r, i, h[2], c, d, w, bias, a, parts[4];
+  int k;
+
+  x = add_variable(b, x_shape, 3, t, 0);
+  s = add_variable(b, s_shape, 3, t, 0);
+  add_slice(b, x, s, start, stop, 3);
+  r = add_variable(b, r_shape, 2, t, 0);
+  add_reshape(b, s, r, r_shape, 2);
+  i = add_variable(b, r_shape, 2, t, 0);
+  add_unary(b, NN_FUNCTION_IDENTITY, r, i);
+  h[0] = add_variable(b, r_shape, 2, t, 0);
+  add_unary(b, NN_FUNCTION_TANH, i, h[0]);
+  h[1] = add_variable(b, r_shape, 2, t, 0);
+  add_unary(b, NN_FUNCTION_SIGMOID, r, h[1]);
+  c = add_variable(b, c_shape, 2, t, 0);
+  add_concatenate(b, h, 2, c, 0);
+  d = add_variable(b, c_shape, 2, t, 0);
+  add_dropout(b, c, d, 0.25f);
+  w = add_parameter(b, w_shape, 2, t, 0);
+  bias = add_parameter(b, bias_shape, 1, t, 0);
+  a = add_variable(b, a_shape, 2, t, 0);
+  add_affine(b, d, w, bias, a);
+  for (k = 0; k < 4; k++) {
+    parts[k] = add_variable(b, bias_shape, 1, t, 0);
+  }
+  add_split(b, a, parts, 4, 0);
+  b->input = x;
+  b->output = add_variable(b, bias_shape, 1, t, 0);
+  add_unary(b, NN_FUNCTION_RELU, parts[1], b->output);
+}
+
+static const test_case_t test_cases[] = {
+    {"conv_bn", build_convolution_inference, 0, 0},
+    {"affine_bn", build_affine, 0, 0},
+    {"views", build_views, 0, 6},
+    {"batch_stat", build_convolution_batch_stat, 1, 0},
+};
+
+// Copy of pristine, or pristine loaded from NETWORK_FILE.
+static nn_network_t *open_network(const test_case_t *t,
+                                  const nn_network_t *pristine) {
+  nn_network_t *network = 0;
+  size_t size = network_bytes(pristine);
+
+  if (t->from_file) {
+    rt_load_network_file(NETWORK_FILE, &network);
+    return network;
+  }
+  network = malloc(size);
+  if (network != 0) {
+    memcpy(network, pristine, size);
+  }
+  return network;
+}
+
+static void close_network(const test_case_t *t, nn_network_t *network) {
+  if (t->from_file) {
+    rt_unload_network_file(network);
+  } else {
+    free(network);
+  }
+}
+
+// Initialize context for network under config, 0 on failure. *block gets
+// the block of USER_MEMORY_BLOCK.
+static int initialize(rt_context_pointer *context, const config_t *config,
+                      nn_network_t *network, void **block) {
+  size_t size;
+
+  *block = 0;
+  if (rt_allocate_context(context) != RT_RET_NOERROR) {
+    return 0;
+  }
+  rt_set_optimization(*context, config->optimization);
+  rt_set_memory_plan(*context, config->plan);
+  if (config->memory != HEAP) {
+    rt_use_memory_block(*context, 1);
+  }
+  if (config->memory == USER_MEMORY_BLOCK) {
+    size = rt_memory_block_size(*context, network);
+    *block = size ? malloc(size) : 0;
+    if (*block == 0 ||
+        rt_set_memory_block(*context, *block, size) != RT_RET_NOERROR) {
+      return 0;
+    }
+  }
+  return rt_initialize_context(*context, network) == RT_RET_NOERROR;
+}
+
+// Run test case under config into result, 0 on failure.
+static int run_config(const test_case_t *t, const config_t *config,
+                      const nn_network_t *pristine, result_t *result) {
+  rt_context_pointer context = 0;
+  nn_network_t *network;
+  float *input = 0;
+  float *output = 0;
+  void *block = 0;
+  int ok = 0;
+  int i, j;
+
+  network = open_network(t, pristine);
+  if (network == 0) {
+    return 0;
+  }
+  if (initialize(&context, config, network, &block)) {
+    const int input_size = rt_input_size(context, 0);
+    const int output_size = rt_output_size(context, 0);
+    ok = 1;
+    if (config->bind) {
+      input = malloc(sizeof(float) * input_size);
+      output = malloc(sizeof(float) * output_size);
+      ok = input != 0 && output != 0 &&
+           rt_bind_input(context, 0, input) == RT_RET_NOERROR &&
+           rt_bind_output(context, 0, output) == RT_RET_NOERROR;
+    } else {
+      input = rt_input_buffer(context, 0);
+      output = rt_output_buffer(context, 0);
+    }
+    for (i = 0; ok && i < NUM_OF_ITERATIONS; i++) {
+      for (j = 0; j < input_size; j++) {
+        set_value(input, NN_DATA_TYPE_FLOAT, j, (i + j * 7) % 13 - 6);
+      }
+      ok = rt_forward(context) == RT_RET_NOERROR;
+      memcpy(result->outputs + i * output_size, output,
+             sizeof(float) * output_size);
+    }
+    result->num_of_aliased = rt_num_of_aliased_functions(context);
+    if (config->bind) {
+      free(input);
+      free(output);
+    }
+  }
+  if (context != 0) {
+    rt_free_context(&context);
+  }
+  free(block);
+  memcpy(result->network, network, network_bytes(pristine));
+  close_network(t, network);
+  return ok;
+}
+
+// Number of elements of variable of network.
+static int variable_size(const nn_network_t *n, int variable) {
+  const int32_t *list = network_data(n, n->variables.list);
+  const nn_variable_t *v = network_data(n, list[variable]);
+  return shape_size(network_data(n, v->shape.list), v->shape.size);
+}
+
+// Number of values of a and b further apart than tolerance.
+static int count_differences(const float *a, const float *b, int size,
+                             float tolerance) {
+  int count = 0;
+  int i;
+  for (i = 0; i < size; i++) {
+    if (!(fabsf(a[i] - b[i]) <= tolerance * (1.0f + fabsf(b[i])))) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Number of parameter values of networks a and b further apart than
+// tolerance.
+static int count_parameter_differences(const nn_network_t *a,
+                                       const nn_network_t *b,
+                                       float tolerance) {
+  const int32_t *list = network_data(a, a->variables.list);
+  int count = 0;
+  int i;
+
+  for (i = 0; i < a->variables.size; i++) {
+    const nn_variable_t *va = network_data(a, list[i]);
+    const nn_variable_t *vb = network_data(b, list[i]);
+    if (va->data_index < 0) {
+      continue;
+    }
+    count += count_differences(network_data(a, va->data_index),
+                               network_data(b, vb->data_index),
+                               variable_size(a, i), tolerance);
+  }
+  return count;
+}
+
+// Number of failures comparing result of config with expected.
+static int compare(const test_case_t *t, const config_t *config,
+                   const result_t *result, const result_t *expected,
+                   const char *expected_name, int outputs_size,
+                   float tolerance) {
+  int failures = 0;
+  int count;
+
+  count = count_differences(result->outputs, expected->outputs, outputs_size,
+                            tolerance);
+  if (count) {
+    printf("%s: %d of %d outputs of %s differ from %s\n", t->name, count,
+           outputs_size, config->name, expected_name);
+    failures++;
+  }
+  count = count_parameter_differences(result->network, expected->network,
+                                      tolerance);
+  if (count) {
+    printf("%s: %d parameters of network after %s differ from %s\n",
+           t->name, count, config->name, expected_name);
+    failures++;
+  }
+  return failures;
+}
+
+// First of configs with the optimization flags of configs[index].
+static int first_with_optimization(int index) {
+  int i = 0;
+  while (configs[i].optimization != configs[index].optimization) {
+    i++;
+  }
+  return i;
+}
+
+// Number of failures of test case.
+static int run_test_case(const test_case_t *t) {
+  static builder_t builder;
+  result_t results[NUM_OF_CONFIGS];
+  int ok[NUM_OF_CONFIGS];
+  nn_network_t *pristine;
+  size_t network_size;
+  int outputs_size;
+  int failures = 0;
+  int i, j;
+
+  memset(&builder, 0, sizeof(builder));
+  srand(1);
+  t->build(&builder);
+  pristine = finish_network(&builder);
+  network_size = network_bytes(pristine);
+  outputs_size = NUM_OF_ITERATIONS * variable_size(pristine, builder.output);
+  if (t->from_file && !write_network_file(pristine, NETWORK_FILE)) {
+    printf("%s: failed to write %s\n", t->name, NETWORK_FILE);
+    return 1;
+  }
+
+  for (i = 0; i < NUM_OF_CONFIGS; i++) {
+    const config_t *config = &configs[i];
+    result_t *result = &results[i];
+    result->outputs = malloc(sizeof(float) * outputs_size);
+    result->network = malloc(network_size);
+    ok[i] = run_config(t, config, pristine, result);
+    if (!ok[i]) {
+      printf("%s: failed to run %s\n", t->name, config->name);
+      failures++;
+      continue;
+    }
+    if ((config->optimization & RT_OPTIMIZATION_ALIAS_VARIABLES) &&
+        result->num_of_aliased < t->num_of_aliased) {
+      printf("%s: %s elided %d functions instead of %d\n", t->name,
+             config->name, result->num_of_aliased, t->num_of_aliased);
+      failures++;
+    }
+    j = first_with_optimization(i);
+    if (j < i) {
+      failures += ok[j] ? compare(t, config, result, &results[j],
+                                  configs[j].name, outputs_size, 0.0f)
+                        : 0;
+    } else if (i > 0 && ok[0]) {
+      failures += compare(t, config, result, &results[0], configs[0].name,
+                          outputs_size, TOLERANCE);
+    }
+  }
+  if (t->from_file) {
+    remove(NETWORK_FILE);
+  }
+
+  for (i = 0; i < NUM_OF_CONFIGS; i++) {
+    free(results[i].outputs);
+    free(results[i].network);
+  }
+  free(pristine);
+  if (failures == 0) {
+    printf("%s: OK\n", t->name);
+  }
+  return failures;
+}
+
+int main(void) {
+  size_t i;
+  int failures = 0;
+
+  for (i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+    failures += run_test_case(&test_cases[i]);
+  }
+  return failures ? 1 : 0;
+}
@@ -21,28 +21,33 @@ import sys
 def check_error(lines):
     diff_errors = 0
     memory_errors = 0
+    max_diff = 0.0
     for n, l in enumerate(lines):
         l = l.rstrip()
         match = re.search('ERROR SUMMARY: ([0-9]+) errors', l)
         if match:
             memory_errors += int(match.group(1))
+        match = re.search('MAX ABSOLUTE DIFF: (.+)$', l)
+        if match:
+            max_diff = max(max_diff, float(match.group(1)))
         if l == 'False':
             diff_errors += 1
-    return memory_errors, diff_errors
+    return memory_errors, diff_errors, max_diff
 
 
-print('Testname, Memleak(CSRC), Diff(CSRC), Memleak(NNB), Diff(NNB)')
+print('Testname, Memleak(CSRC), Diff(CSRC), Memleak(NNB), Diff(NNB), MaxDiff(NNB)')
 for csrclog in sorted(glob.glob('{}/nnablart/csrc/*.log'.format(os.environ['NNABLA_C_RUNTIME_TEST_DIRECTORY']))):
     nnblog = '{}/nnb/{}'.format(
         os.environ['NNABLA_C_RUNTIME_TEST_DIRECTORY'], os.path.basename(csrclog))
     with open(csrclog, 'r') as f:
-        csrc_memory_errors, csrc_diff_errors = check_error(f.readlines())
+        csrc_memory_errors, csrc_diff_errors, _ = check_error(f.readlines())
     with open(nnblog, 'r') as f:
-        nnb_memory_errors, nnb_diff_errors = check_error(f.readlines())
+        nnb_memory_errors, nnb_diff_errors, nnb_max_diff = check_error(
+            f.readlines())
     filename = os.path.basename(csrclog)
     name, ext = os.path.splitext(filename)
-    print('{}, {}, {}, {}, {}'.format(name, csrc_memory_errors,
-                                      csrc_diff_errors, nnb_memory_errors, nnb_diff_errors))
+    print('{}, {}, {}, {}, {}, {}'.format(name, csrc_memory_errors,
+                                          csrc_diff_errors, nnb_memory_errors, nnb_diff_errors, nnb_max_diff))
     if csrc_memory_errors != 0 or csrc_diff_errors != 0:
         sys.stderr.write(
             '\tCSRC has some error plese see {}\n'.format(csrclog))
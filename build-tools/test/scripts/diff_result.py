@@ -20,6 +20,10 @@ data2 = numpy.fromfile(sys.argv[2], numpy.float32)
 res = numpy.allclose(data1, data2, atol=1e-4)
 print(data1)
 print(data2)
+# Fast kernels (e.g. Winograd convolution) reorder the accumulation, so the
+# delta against the reference is reported along with the pass/fail result.
+if data1.shape == data2.shape and data1.size > 0:
+    print('MAX ABSOLUTE DIFF: {}'.format(numpy.max(numpy.abs(data1 - data2))))
 print(res)
 
 sys.exit(0)
@@ -65,6 +65,83 @@ typedef struct {
   void *data;              ///< Pointer to real data of variable
 } rt_variable_t;
 
+/// @brief Executor for parallel loops inside a function.
+typedef struct {
+  int num_of_threads; ///< Number of threads, 1 means serial execution
+  /// Run task(arg, index) for every index in [0, num_of_tasks) and return
+  /// after all of them finished.
+  void (*run_tasks)(void *executor, int num_of_tasks,
+                    void (*task)(void *arg, int index), void *arg);
+  void *executor; ///< Executor specific data passed to run_tasks
+} rt_parallel_t;
+
+/// @brief Data derived from a parameter, e.g. transformed weight.
+typedef struct st_rt_shared_blob_t {
+  const void *key;                  ///< Parameter data the blob derives from
+  int tag;                          ///< Kind of derived data
+  size_t size;                      ///< Size of data in bytes
+  void *data;                       ///< Allocation holding derived data
+  struct st_rt_shared_blob_t *next; ///< Next blob
+} rt_shared_blob_t;
+
+/// @brief Derived data shared by a context and its clones.
+/// Blobs outlive the context that creates them, so they are allocated with
+/// the functions the cache was created with rather than rt_malloc_func.
+typedef struct {
+  int ref_count;                     ///< Number of contexts using this cache
+  rt_shared_blob_t *blobs;           ///< List of blobs
+  void *(*malloc_func)(size_t size); ///< Allocates blobs
+  void (*free_func)(void *ptr);      ///< Frees blobs
+} rt_shared_cache_t;
+
+/// @brief Activation applied by a function to its own outputs.
+typedef enum {
+  RT_ACTIVATION_NONE = 0,   ///< Outputs are written as computed
+  RT_ACTIVATION_RELU,       ///< ReLU
+  RT_ACTIVATION_LEAKY_RELU, ///< LeakyReLU, alpha is the slope
+  RT_ACTIVATION_SIGMOID,    ///< Sigmoid
+  RT_ACTIVATION_TANH,       ///< Tanh
+  RT_ACTIVATION_SWISH,      ///< Swish
+  RT_ACTIVATION_ELU,        ///< ELU, alpha is the scale
+  RT_ACTIVATION_RELU6,      ///< ReLU clipped at 6
+  END_OF_RT_ACTIVATION
+} rt_activation_type_t;
+
+/// @brief Activation epilogue fused into a function by the runtime.
+typedef struct {
+  rt_activation_type_t type; ///< Type of activation
+  float alpha;               ///< Parameter of LeakyReLU and ELU
+} rt_activation_t;
+
+/// @brief Instruction set extensions kernels may use.
+typedef enum {
+  RT_CPU_FEATURE_SSE = 1 << 0,     ///< x86 SSE
+  RT_CPU_FEATURE_AVX2 = 1 << 1,    ///< x86 AVX2 together with FMA3
+  RT_CPU_FEATURE_AVX512F = 1 << 2, ///< x86 AVX-512 Foundation
+  RT_CPU_FEATURE_NEON = 1 << 3,    ///< ARM Advanced SIMD
+} rt_cpu_feature_t;
+
+/// @brief Features of the running CPU that kernels are compiled for.
+/// x86 extensions are detected at run time, NEON is known at compile time.
+/// @return OR of @ref rt_cpu_feature_t
+int rt_detect_cpu_features(void);
+
+/// @brief Activations of a function stored channel last, i.e. a variable
+/// of shape [N, C, H, W] stored as [N, H, W, C].
+typedef enum {
+  RT_CHANNEL_LAST_INPUT = 1 << 0,  ///< First input
+  RT_CHANNEL_LAST_OUTPUT = 1 << 1, ///< First output, and residual added to it
+} rt_channel_last_t;
+
+/// @brief Allocator for the data functions allocate for themselves.
+/// Lets a runtime place the data of each context where it wants without
+/// changing rt_malloc_func, which is shared by all contexts.
+typedef struct {
+  void *(*malloc_func)(void *user_data, size_t size); ///< Allocates data
+  void (*free_func)(void *user_data, void *ptr);      ///< Frees data
+  void *user_data;                                    ///< Passed to both
+} rt_allocator_t;
+
 /// @brief Function
 struct st_rt_function_t;
 typedef struct st_rt_function_t rt_function_t;
@@ -79,6 +156,33 @@ struct st_rt_function_t {
   rt_function_error_t (*free_local_context_func)(rt_function_t *f);
 
   void *local_context; ///< General purpose context
+
+  rt_parallel_t *parallel; ///< Executor for parallel loops (0 means serial)
+  rt_shared_cache_t *shared_cache; ///< Derived data cache (0 means none)
+  /// Applied to outputs before they are stored. Honored by Convolution,
+  /// FusedConvolution, Affine and Deconvolution, and RT_ACTIVATION_NONE for
+  /// the others.
+  rt_activation_t activation;
+  /// OR of rt_cpu_feature_t that kernels selected at allocation may use.
+  int cpu_features;
+  /// Name of the kernel selected at allocation, 0 if not reported.
+  const char *variant;
+  /// OR of rt_channel_last_t for activations the runtime stores channel
+  /// last whatever their shape says. Honored by Convolution,
+  /// FusedConvolution, DepthwiseConvolution, MaxPooling, AveragePooling,
+  /// SumPooling, BatchNormalization and FusedBatchNormalization, and 0 for
+  /// the others.
+  int channel_last;
+  /// Bytes of scratch memory exec_func needs, set at allocation.
+  size_t workspace_size;
+  /// Scratch memory of workspace_size bytes aligned to 64 bytes, set by the
+  /// runtime after allocation, or by the caller when functions are used
+  /// without it. Functions which never run concurrently share it, so its
+  /// contents do not survive from one call to the next.
+  void *workspace;
+  /// Allocates the local context data and everything else the function
+  /// owns, 0 means rt_malloc_func and rt_free_func.
+  rt_allocator_t *allocator;
 };
 
 extern void *(*rt_variable_malloc_func)(
@@ -89,6 +193,13 @@ extern void (*rt_variable_free_func)(
 extern void *(*rt_malloc_func)(size_t size); ///< malloc function pointer
 extern void (*rt_free_func)(void *ptr);      ///< free function pointer
 
+/// @brief Allocate size bytes with the allocator of f.
+/// @return Pointer, 0 on failure.
+void *rt_function_malloc(rt_function_t *f, size_t size);
+
+/// @brief Free data allocated by @ref rt_function_malloc() with the same f.
+void rt_function_free(rt_function_t *f, void *ptr);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @defgroup NeuralNetworkLayer Neural Network Layer
 /// @{
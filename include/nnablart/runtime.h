@@ -109,8 +109,11 @@ extern "C" {
 /// @enduml
 ///
 /// @ref Runtime provides following functions.
+/// - @ref rt_load_network_file()
+/// - @ref rt_unload_network_file()
 /// - @ref rt_allocate_context()
 /// - @ref rt_initialize_context()
+/// - @ref rt_clone_context()
 /// - @ref rt_free_context()
 /// - @ref rt_num_of_input()
 /// - @ref rt_input_size()
@@ -120,7 +123,30 @@ extern "C" {
 /// - @ref rt_output_size()
 /// - @ref rt_output_dimension()
 /// - @ref rt_output_shape()
+/// - @ref rt_bind_input()
+/// - @ref rt_bind_output()
 /// - @ref rt_forward()
+/// - @ref rt_set_num_threads()
+/// - @ref rt_set_task_runner()
+/// - @ref rt_set_inter_op_parallel()
+/// - @ref rt_set_memory_plan()
+/// - @ref rt_set_optimization()
+/// - @ref rt_set_cpu_features()
+/// - @ref rt_cpu_features()
+/// - @ref rt_activation_memory_size()
+/// - @ref rt_num_of_aliased_functions()
+/// - @ref rt_aliased_bytes()
+/// - @ref rt_use_memory_block()
+/// - @ref rt_memory_block_size()
+/// - @ref rt_set_memory_block()
+/// - @ref rt_set_function_hooks()
+/// - @ref rt_enable_profile()
+/// - @ref rt_reset_profile()
+/// - @ref rt_num_of_functions()
+/// - @ref rt_function_profile()
+/// - @ref rt_function_variant()
+/// - @ref rt_enable_trace()
+/// - @ref rt_write_trace()
 ///
 /// @{
 
@@ -131,22 +157,105 @@ extern "C" {
 
 /// @brief Return values in @ref Runtime.
 typedef enum {
-  RT_RET_ERROR_VERSION_UNMATCH = -899,   ///< 899
-  RT_RET_ERROR_ALLOCATE_CONTEXT,         ///< 898
-  RT_RET_ERROR_INITIALIZE_CONTEXT_TWICE, ///< 897
-  RT_RET_ERROR_ALLOCATE_CALLBACK_BUFFER, ///< 896
-  RT_RET_ERROR_INVALID_BUFFER_INDEX,     ///< 895
-  RT_RET_ERROR_INIT_VARIABLE,            ///< 894
-  RT_RET_ERROR_UNKNOWN_FUNCTION,         ///< 893
-  RT_RET_ERROR_NO_MATCHING_FUNCTION,     ///< 892
-  RT_RET_NOERROR = 0,                    ///< 0
-  RT_RET_FUNCTION_MATCH,                 ///< 1
-  RT_RET_FUNCTION_DONT_MATCH,            ///< 2
+  RT_RET_ERROR_VERSION_UNMATCH = -899,    ///< 899
+  RT_RET_ERROR_ALLOCATE_CONTEXT,          ///< 898
+  RT_RET_ERROR_INITIALIZE_CONTEXT_TWICE,  ///< 897
+  RT_RET_ERROR_ALLOCATE_CALLBACK_BUFFER,  ///< 896
+  RT_RET_ERROR_INVALID_BUFFER_INDEX,      ///< 895
+  RT_RET_ERROR_INIT_VARIABLE,             ///< 894
+  RT_RET_ERROR_UNKNOWN_FUNCTION,          ///< 893
+  RT_RET_ERROR_NO_MATCHING_FUNCTION,      ///< 892
+  RT_RET_ERROR_CREATE_THREAD,             ///< 891
+  RT_RET_ERROR_INSUFFICIENT_MEMORY_BLOCK, ///< 890
+  RT_RET_ERROR_LOAD_NETWORK,              ///< 889
+  RT_RET_ERROR_WRITE_TRACE,               ///< 888
+  RT_RET_NOERROR = 0,                     ///< 0
+  RT_RET_FUNCTION_MATCH,                  ///< 1
+  RT_RET_FUNCTION_DONT_MATCH,             ///< 2
   RT_RET_END_OF_VALUES
 } rt_return_value_t;
 
 typedef void *rt_context_pointer;
 
+/// @brief How memory of variables stored in buffers is allocated.
+typedef enum {
+  RT_MEMORY_PLAN_NETWORK = 0, ///< One block per buffer listed in network.
+  RT_MEMORY_PLAN_LIVENESS,    ///< One arena packed by variable lifetimes.
+  END_OF_RT_MEMORY_PLAN
+} rt_memory_plan_t;
+
+/// @brief Graph optimizations applied by @ref rt_initialize_context().
+typedef enum {
+  RT_OPTIMIZATION_NONE = 0,
+  /// BatchNormalization in inference mode following Convolution,
+  /// DepthwiseConvolution or Affine is merged into their weight and bias.
+  RT_OPTIMIZATION_FOLD_BATCH_NORMALIZATION = 1 << 0,
+  /// ReLU, LeakyReLU, Sigmoid, Tanh, Swish or ELU following Convolution,
+  /// DepthwiseConvolution, Deconvolution or Affine is applied by them while
+  /// storing their outputs.
+  RT_OPTIMIZATION_FUSE_ACTIVATION = 1 << 1,
+  /// Output of Reshape, Identity or Dropout in inference mode shares data
+  /// of its input instead of a copy, when neither is written again and the
+  /// output is not an output of network. The scale of Dropout is merged into
+  /// the weight of Convolution, DepthwiseConvolution, Deconvolution or Affine
+  /// reading its output, other Dropout with p > 0 is kept.
+  /// Outputs of Split and Slice become views into their input when they are
+  /// contiguous in it, and inputs of Concatenate are stored in place in its
+  /// output when the buffer of the output is not used by other variables
+  /// meanwhile. Slice with step other than 1 is kept.
+  RT_OPTIMIZATION_ALIAS_VARIABLES = 1 << 2,
+  /// Activations between Convolution, DepthwiseConvolution,
+  /// FusedConvolution, MaxPooling, AveragePooling and SumPooling are stored
+  /// channel last, i.e. [N, H, W, C], when every function reading or writing
+  /// them supports it. BatchNormalization, elementwise activations and
+  /// arithmetic between them keep the layout. Functions at the border of
+  /// such subgraphs convert the layout while reading or writing, so other
+  /// functions and outputs of network see the original layout.
+  RT_OPTIMIZATION_CHANNEL_LAST = 1 << 3,
+  RT_OPTIMIZATION_ALL = RT_OPTIMIZATION_FOLD_BATCH_NORMALIZATION |
+                        RT_OPTIMIZATION_FUSE_ACTIVATION |
+                        RT_OPTIMIZATION_ALIAS_VARIABLES |
+                        RT_OPTIMIZATION_CHANNEL_LAST
+} rt_optimization_t;
+
+/// @brief Hook called around execution of each function.
+/// @param[in] context Context executing the function.
+/// @param[in] index Index of function in network.
+/// @param[in] function Function in network.
+/// @param[in] user_data Given to @ref rt_set_function_hooks().
+typedef void (*rt_function_hook_t)(rt_context_pointer context, int index,
+                                   const nn_function_t *function,
+                                   void *user_data);
+
+/// @brief Statistics of one function collected by @ref rt_enable_profile().
+typedef struct {
+  nn_function_type_t type; ///< Type of function.
+  int num_of_calls;        ///< Number of executions since last reset.
+  double time;             ///< Total execution time in seconds.
+  size_t output_bytes;     ///< Bytes written to outputs per execution.
+  double flops;            ///< Estimated floating point operations per call.
+} rt_function_profile_t;
+
+/// @brief Load network from NNB file.
+/// Where mmap is available the file is mapped copy-on-write and used in
+/// place, so weights are not copied and processes loading the same file
+/// share their pages until they write them. Functions which update their
+/// parameters, such as BatchNormalization with batch_stat, write to private
+/// copies of the pages, and the file is never modified. Otherwise the file
+/// is read into memory allocated with the malloc function. Sizes in header
+/// are checked against the file.
+/// @param[in] filename
+/// @param[out] network Loaded network. It must be released by @ref
+/// rt_unload_network_file() after all contexts using it are freed.
+/// @return @ref rt_return_value_t, RT_RET_ERROR_LOAD_NETWORK if the file
+/// cannot be read or is not a valid NNB.
+rt_return_value_t rt_load_network_file(const char *filename,
+                                       nn_network_t **network);
+
+/// @brief Release network loaded by @ref rt_load_network_file().
+/// @param[in] network
+void rt_unload_network_file(nn_network_t *network);
+
 /// @brief Create runtime context.
 /// In this function only allocates runtime context.
 /// You must initialize context with @ref rt_initialize_context
@@ -168,6 +277,12 @@ rt_return_value_t rt_add_callback(
 /// @brief Initialize runtime context with parsing @ref nn_network_t.
 /// Initialize all functions in context and prepare forward calculation.
 ///
+/// The network is only read, so several contexts may be initialized from the
+/// same @ref nn_network_t and call @ref rt_forward() concurrently from
+/// different threads (e.g. one context per worker thread). A single context
+/// must not be used by two threads at the same time. Functions which update
+/// parameters, such as BatchNormalization with batch_stat, still write to
+/// the shared network.
 ///
 /// Callback selection rule.
 /// @startuml
@@ -201,6 +316,23 @@ rt_return_value_t rt_add_callback(
 rt_return_value_t rt_initialize_context(rt_context_pointer context,
                                         nn_network_t *network);
 
+/// @brief Create a context running the same network as src.
+/// The clone shares the network and data derived from weights at
+/// initialization (e.g. transformed convolution weights) with src, and has
+/// its own buffers, so src and the clone may run @ref rt_forward()
+/// concurrently. Callbacks, hooks of @ref rt_set_function_hooks() and
+/// @ref rt_set_inter_op_parallel() setting are inherited, while the clone
+/// starts with a single thread and without profile. Contexts sharing
+/// data may be freed in any order. Where the runtime is built with pthreads
+/// they may also be cloned and freed concurrently from different threads,
+/// otherwise these calls must not overlap.
+/// @param[in] src Initialized context.
+/// @param[out] context Pointer to created context. It must be freed by @ref
+/// rt_free_context(). On error it is freed already and set to 0.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_clone_context(rt_context_pointer src,
+                                   rt_context_pointer *context);
+
 /// @brief Free context.
 /// @param[in] context
 /// @return @ref rt_return_value_t
@@ -288,6 +420,255 @@ nn_variable_t *rt_input_variable(rt_context_pointer context, size_t index);
 /// @return pointer to variable description.
 nn_variable_t *rt_output_variable(rt_context_pointer context, size_t index);
 
+/// @brief Use memory of user as input at index.
+/// After this, @ref rt_forward() reads the input directly from ptr, and
+/// @ref rt_input_buffer() returns ptr. ptr must hold @ref rt_input_size()
+/// elements of the input type, must not overlap other memory bound to the
+/// context, and must stay valid until the context is freed or bound again.
+/// Bindings are not inherited by @ref rt_clone_context().
+/// @param[in] context Initialized context.
+/// @param[in] index
+/// @param[in] ptr
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_bind_input(rt_context_pointer context, size_t index,
+                                void *ptr);
+
+/// @brief Use memory of user as output at index.
+/// After this, @ref rt_forward() writes the output directly to ptr, and
+/// @ref rt_output_buffer() returns ptr. Same conditions as
+/// @ref rt_bind_input() apply to ptr.
+/// @param[in] context Initialized context.
+/// @param[in] index
+/// @param[in] ptr
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_bind_output(rt_context_pointer context, size_t index,
+                                 void *ptr);
+
+/// @brief Task runner used for parallel execution inside functions.
+/// It must call task(arg, index) once for every index in [0, num_of_tasks),
+/// on any thread and in any order, and return after all calls finished.
+typedef void (*rt_task_runner_t)(void *user_data, int num_of_tasks,
+                                 void (*task)(void *arg, int index),
+                                 void *arg);
+
+/// @brief Use built-in worker pool to run functions in parallel.
+/// Heavy functions (e.g. Convolution, Affine and Pooling) split their work
+/// into num_of_threads parts. The split only depends on the number of
+/// threads, so results are reproducible for a fixed num_of_threads.
+/// The thread calling @ref rt_forward() works as one of the threads.
+/// @param[in] context
+/// @param[in] num_of_threads 1 (default) disables parallel execution.
+/// @return @ref rt_return_value_t, RT_RET_ERROR_CREATE_THREAD if threads are
+/// not available on this platform.
+rt_return_value_t rt_set_num_threads(rt_context_pointer context,
+                                     int num_of_threads);
+
+/// @brief Use user defined task runner instead of built-in worker pool.
+/// @param[in] context
+/// @param[in] runner Task runner, 0 disables parallel execution.
+/// @param[in] user_data Passed to runner as is.
+/// @param[in] num_of_threads Number of parts the work is split into.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_set_task_runner(rt_context_pointer context,
+                                     rt_task_runner_t runner, void *user_data,
+                                     int num_of_threads);
+
+/// @brief Run independent functions concurrently.
+/// Functions are grouped into stages from the dataflow graph at
+/// @ref rt_initialize_context(), and functions in a stage, which neither
+/// depend on each other nor touch the same buffer, run on the threads given
+/// by @ref rt_set_num_threads() or @ref rt_set_task_runner(). A function
+/// running alongside others in its stage runs single-threaded, so this is
+/// useful for networks with many parallel branches of small functions.
+/// Enable it before @ref rt_initialize_context(), which then gives each
+/// function of a stage its own part of the scratch memory functions share;
+/// enabling it later has no effect.
+/// @param[in] context
+/// @param[in] enable 0 (default) executes functions one by one in network
+/// order.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_set_inter_op_parallel(rt_context_pointer context,
+                                           int enable);
+
+/// @brief Select how activation memory is allocated.
+/// Must be called before @ref rt_initialize_context().
+/// With RT_MEMORY_PLAN_LIVENESS the runtime computes the lifetime of every
+/// variable from the function order and packs them into one arena, instead
+/// of using the buffer assignment of the network. Variables are not shared
+/// with each other while they are alive, so functions never run in-place.
+/// @param[in] context
+/// @param[in] plan RT_MEMORY_PLAN_NETWORK (default) or
+/// RT_MEMORY_PLAN_LIVENESS.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_set_memory_plan(rt_context_pointer context,
+                                     rt_memory_plan_t plan);
+
+/// @brief Select graph optimizations.
+/// Must be called before @ref rt_initialize_context().
+/// Optimizations rewrite the functions of context, the network itself is
+/// not modified. A function merged into another one stays in the context
+/// with no inputs and outputs and does nothing, so function indices of hooks
+/// and profiles still match the network. Functions handled by callbacks of
+/// @ref rt_add_callback() are never merged.
+/// @param[in] context
+/// @param[in] flags OR of @ref rt_optimization_t, RT_OPTIMIZATION_ALL by
+/// default.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_set_optimization(rt_context_pointer context, int flags);
+
+/// @brief Restrict the instruction set extensions kernels may use.
+/// Must be called before @ref rt_initialize_context().
+/// Features of the CPU are detected by @ref rt_allocate_context(), and each
+/// function selects the fastest of its kernels they allow when it is
+/// initialized. Clearing features makes functions fall back to portable
+/// kernels, e.g. to compare results or speed.
+/// @param[in] context
+/// @param[in] features OR of @ref rt_cpu_feature_t, features the CPU does
+/// not have are ignored.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_set_cpu_features(rt_context_pointer context,
+                                      int features);
+
+/// @brief Instruction set extensions kernels of context may use.
+/// @param[in] context
+/// @return OR of @ref rt_cpu_feature_t
+int rt_cpu_features(rt_context_pointer context);
+
+/// @brief Bytes of memory allocated for variables stored in buffers.
+/// This is the peak activation memory of the arena with
+/// RT_MEMORY_PLAN_LIVENESS, or the sum of the network buffers otherwise.
+/// @param[in] context Initialized context.
+/// @return Size in bytes.
+size_t rt_activation_memory_size(rt_context_pointer context);
+
+/// @brief Number of functions elided by making their outputs views into
+/// their input, or their inputs views into their output.
+/// See RT_OPTIMIZATION_ALIAS_VARIABLES, these functions are not executed.
+/// @param[in] context Initialized context.
+/// @return Number of functions.
+int rt_num_of_aliased_functions(rt_context_pointer context);
+
+/// @brief Bytes functions of @ref rt_num_of_aliased_functions() would write
+/// in each @ref rt_forward().
+/// @param[in] context Initialized context.
+/// @return Size in bytes.
+size_t rt_aliased_bytes(rt_context_pointer context);
+
+/// @brief Allocate runtime data and activations as one block.
+/// Must be called before @ref rt_initialize_context().
+/// When enabled, @ref rt_initialize_context() computes the size needed by
+/// the network, allocates it at once with the variable malloc function and
+/// carves buffers, variables, function I/O lists, schedule, local contexts
+/// of functions and the data functions allocate out of it, each aligned to
+/// 64 bytes. Data derived from parameters and shared with clones, such as
+/// prepacked weights, is still allocated separately. Functions allocate
+/// through rt_function_t::allocator of this context, so other contexts may
+/// be initialized or freed at the same time. User defined functions added
+/// by @ref rt_add_callback() only use the block if they allocate with
+/// rt_function_malloc().
+/// @param[in] context
+/// @param[in] enable 0 (default) allocates each of them separately.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_use_memory_block(rt_context_pointer context, int enable);
+
+/// @brief Bytes of the block @ref rt_initialize_context() needs for network.
+/// The size depends on @ref rt_set_memory_plan(), and includes padding to
+/// align a block at any address. The data functions allocate is counted by
+/// initializing them once on a temporary context, which costs about as much
+/// as @ref rt_initialize_context() itself. The count is kept in context and
+/// copied to its clones, so that the next @ref rt_initialize_context() or
+/// @ref rt_clone_context() with the same network does not repeat it, until
+/// @ref rt_set_optimization(), @ref rt_set_cpu_features(),
+/// @ref rt_set_inter_op_parallel() or @ref rt_add_callback() is called.
+/// The network must not be freed in between.
+/// @param[in] context
+/// @param[in] network
+/// @return Size in bytes, 0 on failure.
+size_t rt_memory_block_size(rt_context_pointer context,
+                            nn_network_t *network);
+
+/// @brief Use memory given by user as the block of @ref rt_use_memory_block().
+/// Must be called before @ref rt_initialize_context(). The block must be at
+/// least @ref rt_memory_block_size() bytes and outlive the context, it is
+/// not freed by @ref rt_free_context(). A clone made by
+/// @ref rt_clone_context() allocates its own block.
+/// @param[in] context
+/// @param[in] block
+/// @param[in] size Size of block in bytes.
+/// @return @ref rt_return_value_t, and @ref rt_initialize_context() returns
+/// RT_RET_ERROR_INSUFFICIENT_MEMORY_BLOCK if block is too small.
+rt_return_value_t rt_set_memory_block(rt_context_pointer context, void *block,
+                                      size_t size);
+
+/// @brief Call hooks before and after each function in @ref rt_forward().
+/// With @ref rt_set_inter_op_parallel() hooks of functions in the same stage
+/// may be called concurrently from different threads.
+/// @param[in] context
+/// @param[in] pre_exec Called before function, 0 to disable.
+/// @param[in] post_exec Called after function, 0 to disable.
+/// @param[in] user_data Passed to hooks as is.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_set_function_hooks(rt_context_pointer context,
+                                        rt_function_hook_t pre_exec,
+                                        rt_function_hook_t post_exec,
+                                        void *user_data);
+
+/// @brief Measure execution time of each function in @ref rt_forward().
+/// Must be called after @ref rt_initialize_context(). Enabling resets
+/// collected statistics.
+/// @param[in] context
+/// @param[in] enable 0 (default) disables and releases statistics.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_enable_profile(rt_context_pointer context, int enable);
+
+/// @brief Clear number of calls and time collected by @ref rt_enable_profile().
+/// @param[in] context
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_reset_profile(rt_context_pointer context);
+
+/// @brief Number of functions in context.
+/// @param[in] context Initialized context.
+/// @return Number of functions.
+int rt_num_of_functions(rt_context_pointer context);
+
+/// @brief Statistics of function.
+/// @param[in] context
+/// @param[in] index Index of function in network.
+/// @return Statistics, 0 if profile is disabled or index is out of range.
+const rt_function_profile_t *rt_function_profile(rt_context_pointer context,
+                                                 size_t index);
+
+/// @brief Name of the kernel selected for function at initialization.
+/// Functions with several implementations report the one they run, e.g.
+/// the instruction set or the algorithm.
+/// @param[in] context Initialized context.
+/// @param[in] index Index of function in network.
+/// @return Name, 0 if the function reports none or index is out of range.
+const char *rt_function_variant(rt_context_pointer context, size_t index);
+
+/// @brief Record timeline of @ref rt_forward() for @ref rt_write_trace().
+/// Every execution of a function is recorded as a span with the thread it
+/// ran on, until the trace is disabled. Memory grows with the number of
+/// @ref rt_forward() calls. Enabling discards recorded spans.
+/// @param[in] context
+/// @param[in] enable 0 (default) disables and releases recorded spans.
+/// @return @ref rt_return_value_t
+rt_return_value_t rt_enable_trace(rt_context_pointer context, int enable);
+
+/// @brief Write spans recorded by @ref rt_enable_trace() to file.
+/// The file is in Chrome trace event JSON format, which can be opened with
+/// chrome://tracing or Perfetto. Each span carries the index of function
+/// and the shapes of its inputs and outputs as args.
+/// @param[in] context Initialized context.
+/// @param[in] filename
+/// @param[in] function_name Returns name of function type, 0 names spans by
+/// type number.
+/// @return @ref rt_return_value_t, RT_RET_ERROR_WRITE_TRACE if trace is not
+/// enabled or the file cannot be written.
+rt_return_value_t
+rt_write_trace(rt_context_pointer context, const char *filename,
+               const char *(*function_name)(nn_function_type_t type));
+
 /// @brief Execute feed forward calculation.
 /// @param[in] context
 /// @return @ref rt_return_value_t
@@ -43,7 +43,8 @@ rt_function_error_t allocate_celu_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
 
-  celu_private_t *p = (celu_private_t *)rt_malloc_func(sizeof(celu_private_t));
+  celu_private_t *p =
+      (celu_private_t *)rt_function_malloc(f, sizeof(celu_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -55,11 +56,11 @@ rt_function_error_t allocate_celu_local_context(rt_function_t *f) {
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
   p->output_size = calc_shape_size(f->outputs[0]->shape);
-  p->in_shape = clone_list(f->inputs[0]->shape);
+  p->in_shape = clone_list(f, f->inputs[0]->shape);
 
   if (p->input_size * 2 != p->output_size) {
-    free_list(p->in_shape);
-    rt_free_func(p);
+    free_list(f, p->in_shape);
+    rt_function_free(f, p);
     return RT_FUNCTION_ERROR_INVALID_SHAPE;
   }
   if (p->input->type == NN_DATA_TYPE_FLOAT &&
@@ -78,8 +79,8 @@ rt_function_error_t allocate_celu_local_context(rt_function_t *f) {
 rt_function_error_t free_celu_local_context(rt_function_t *f) {
   celu_local_context_t *c = (celu_local_context_t *)(f->local_context);
   celu_private_t *p = (celu_private_t *)(c->data);
-  free_list(p->in_shape);
-  rt_free_func(c->data);
+  free_list(f, p->in_shape);
+  rt_function_free(f, c->data);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
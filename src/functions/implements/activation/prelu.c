@@ -43,7 +43,7 @@ rt_function_error_t allocate_prelu_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
 
-  prelu_private_t *p = rt_malloc_func(sizeof(prelu_private_t));
+  prelu_private_t *p = rt_function_malloc(f, sizeof(prelu_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -56,8 +56,8 @@ rt_function_error_t allocate_prelu_local_context(rt_function_t *f) {
   p->weight_size = calc_shape_size(f->inputs[1]->shape);
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
-  p->in_shape = clone_list(f->inputs[0]->shape);
-  p->in_stride = calc_contiguous_strides(f->inputs[0]->shape);
+  p->in_shape = clone_list(f, f->inputs[0]->shape);
+  p->in_stride = calc_contiguous_strides(f, f->inputs[0]->shape);
   if (p->input->type == NN_DATA_TYPE_FLOAT &&
       p->weight->type == NN_DATA_TYPE_FLOAT &&
       p->output->type == NN_DATA_TYPE_FLOAT) {
@@ -75,9 +75,9 @@ rt_function_error_t allocate_prelu_local_context(rt_function_t *f) {
 rt_function_error_t free_prelu_local_context(rt_function_t *f) {
   prelu_local_context_t *context = (prelu_local_context_t *)(f->local_context);
   prelu_private_t *p = (prelu_private_t *)(context->data);
-  free_list(p->in_shape);
-  free_list(p->in_stride);
-  rt_free_func(p);
+  free_list(f, p->in_shape);
+  free_list(f, p->in_stride);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -42,7 +42,8 @@ rt_function_error_t allocate_sigmoid_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
 
-  sigmoid_local_context_t *c = rt_malloc_func(sizeof(sigmoid_local_context_t));
+  sigmoid_local_context_t *c =
+      rt_function_malloc(f, sizeof(sigmoid_local_context_t));
   if (c == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
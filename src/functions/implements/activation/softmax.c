@@ -34,7 +34,7 @@ rt_function_error_t exec_softmax_generic(rt_function_t *f);
 rt_function_error_t allocate_softmax_local_context(rt_function_t *f) {
   softmax_local_context_t *context =
       (softmax_local_context_t *)(f->local_context);
-  softmax_private_t *p = rt_malloc_func(sizeof(softmax_private_t));
+  softmax_private_t *p = rt_function_malloc(f, sizeof(softmax_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -46,7 +46,7 @@ rt_function_error_t allocate_softmax_local_context(rt_function_t *f) {
 
   // axis must be less than ndim of inputs[0].
   if (f->inputs[0]->shape.size <= axis) {
-    rt_free_func(p);
+    rt_function_free(f, p);
     return RT_FUNCTION_ERROR_INVALID_SHAPE;
   }
   p->batch_size = size / size_axis;
@@ -70,7 +70,7 @@ rt_function_error_t allocate_softmax_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_softmax_local_context(rt_function_t *f) {
-  rt_free_func(((softmax_local_context_t *)(f->local_context))->data);
+  rt_function_free(f, ((softmax_local_context_t *)(f->local_context))->data);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -55,16 +55,17 @@ rt_function_error_t allocate_concatenate_local_context(rt_function_t *f) {
 #endif /* CONFIG_CONCATENATE_GENERIC */
 
   concatenate_private_t *p =
-      (concatenate_private_t *)rt_malloc_func(sizeof(concatenate_private_t));
+      (concatenate_private_t *)rt_function_malloc(
+          f, sizeof(concatenate_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
 
   p->inner_total_size = 0;
   p->in_shape =
-      (rt_list_t *)rt_malloc_func(sizeof(rt_list_t) * f->num_of_inputs);
+      (rt_list_t *)rt_function_malloc(f, sizeof(rt_list_t) * f->num_of_inputs);
   for (int i = 0; i < f->num_of_inputs; i++) {
-    p->in_shape[i] = clone_list(f->inputs[i]->shape);
+    p->in_shape[i] = clone_list(f, f->inputs[i]->shape);
     const int inner_size = calc_size(p->in_shape[i], c->axis);
     p->inner_total_size += inner_size;
 
@@ -84,10 +85,10 @@ rt_function_error_t free_concatenate_local_context(rt_function_t *f) {
       (concatenate_private_t
            *)(((concatenate_local_context_t *)(f->local_context))->data);
   for (int i = 0; i < f->num_of_inputs; i++) {
-    free_list(p->in_shape[i]);
+    free_list(f, p->in_shape[i]);
   }
-  rt_free_func(p->in_shape);
-  rt_free_func(p);
+  rt_function_free(f, p->in_shape);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -125,7 +126,8 @@ rt_function_error_t exec_concatenate_generic(rt_function_t *f) {
   for (int i = 0; i < f->num_of_inputs; i++) {
     rt_variable_t *input = f->inputs[i];
     rt_variable_getter get_input = select_getter(input);
-    const int inner_size = calc_size(p->in_shape[i], c->axis);
+    // in_shape[0] holds the concatenated shape.
+    const int inner_size = calc_size(input->shape, c->axis);
     for (int j = 0; j < p->outer_size; ++j) {
       for (int k = 0; k < inner_size; k++) {
         const float x = get_input(input, j * inner_size + k);
@@ -25,8 +25,6 @@ typedef struct {
   rt_variable_getter get_input;
   rt_variable_t *output;
   rt_variable_setter set_output;
-  rt_list_t in_position;
-  rt_list_t out_position;
   uint8_t *flip;
   int output_size;
 } flip_private_t;
@@ -36,6 +34,9 @@ rt_function_error_t exec_flip_generic(rt_function_t *f);
 // Flip
 rt_function_error_t allocate_flip_local_context(rt_function_t *f) {
   flip_local_context_t *c = (flip_local_context_t *)(f->local_context);
+  if (f->inputs[0]->shape.size > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
   if (f->inputs[0]->type == NN_DATA_TYPE_FLOAT &&
       f->outputs[0]->type == NN_DATA_TYPE_FLOAT) {
 #ifdef CONFIG_FLIP_FLOAT32
@@ -47,19 +48,17 @@ rt_function_error_t allocate_flip_local_context(rt_function_t *f) {
 #endif /* CONFIG_FLIP_GENERIC */
   }
 
-  flip_private_t *p = rt_malloc_func(sizeof(flip_private_t));
+  flip_private_t *p = rt_function_malloc(f, sizeof(flip_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
   ((flip_local_context_t *)(f->local_context))->data = (void *)p;
-  p->flip = rt_malloc_func(sizeof(uint8_t) * (f->inputs[0]->shape.size));
+  p->flip = rt_function_malloc(f, sizeof(uint8_t) * (f->inputs[0]->shape.size));
   memset(p->flip, 0, sizeof(uint8_t) * (f->inputs[0]->shape.size));
   p->input = f->inputs[0];
   p->get_input = select_getter(p->input);
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
-  p->in_position = allocate_list(p->input->shape.size);
-  p->out_position = allocate_list(p->output->shape.size);
   p->output_size = calc_shape_size(p->output->shape);
 
   for (int i = 0; i < c->axes.size; i++) {
@@ -71,10 +70,8 @@ rt_function_error_t allocate_flip_local_context(rt_function_t *f) {
 rt_function_error_t free_flip_local_context(rt_function_t *f) {
   flip_private_t *p =
       (flip_private_t *)(((flip_local_context_t *)(f->local_context))->data);
-  free_list(p->in_position);
-  free_list(p->out_position);
-  rt_free_func(p->flip);
-  rt_free_func(p);
+  rt_function_free(f, p->flip);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -84,18 +81,20 @@ rt_function_error_t exec_flip(rt_function_t *f) {
   flip_private_t *p = (flip_private_t *)(c->data);
   const float *x = (float *)(p->input->data);
   float *y = (float *)(p->output->data);
+  STACK_LIST(in_position, p->input->shape.size);
+  STACK_LIST(out_position, p->output->shape.size);
 
   for (int o = 0; o < p->output_size; o++) {
-    pos_to_shape(p->out_position, p->output->shape, o);
+    pos_to_shape(out_position, p->output->shape, o);
     for (int i = 0; i < p->input->shape.size; i++) {
       if (p->flip[i]) {
-        p->in_position.data[i] =
-            p->input->shape.data[i] - p->out_position.data[i] - 1;
+        in_position.data[i] =
+            p->input->shape.data[i] - out_position.data[i] - 1;
       } else {
-        p->in_position.data[i] = p->out_position.data[i];
+        in_position.data[i] = out_position.data[i];
       }
     }
-    int index = shape_to_pos(p->input->shape, p->in_position);
+    int index = shape_to_pos(p->input->shape, in_position);
     y[o] = x[index];
   }
   return RT_FUNCTION_ERROR_NOERROR;
@@ -106,18 +105,20 @@ rt_function_error_t exec_flip(rt_function_t *f) {
 rt_function_error_t exec_flip_generic(rt_function_t *f) {
   flip_local_context_t *c = (flip_local_context_t *)(f->local_context);
   flip_private_t *p = (flip_private_t *)(c->data);
+  STACK_LIST(in_position, p->input->shape.size);
+  STACK_LIST(out_position, p->output->shape.size);
 
   for (int o = 0; o < p->output_size; o++) {
-    pos_to_shape(p->out_position, p->output->shape, o);
+    pos_to_shape(out_position, p->output->shape, o);
     for (int i = 0; i < p->input->shape.size; i++) {
       if (p->flip[i]) {
-        p->in_position.data[i] =
-            p->input->shape.data[i] - p->out_position.data[i] - 1;
+        in_position.data[i] =
+            p->input->shape.data[i] - out_position.data[i] - 1;
       } else {
-        p->in_position.data[i] = p->out_position.data[i];
+        in_position.data[i] = out_position.data[i];
       }
     }
-    int index = shape_to_pos(p->input->shape, p->in_position);
+    int index = shape_to_pos(p->input->shape, in_position);
     float x = p->get_input(p->input, index);
     p->set_output(p->output, o, x);
   }
@@ -41,7 +41,7 @@ rt_function_error_t allocate_matrix_diag_local_context(rt_function_t *f) {
   }
 
   matrix_diag_local_context_t *c =
-      rt_malloc_func(sizeof(matrix_diag_local_context_t));
+      rt_function_malloc(f, sizeof(matrix_diag_local_context_t));
   if (c == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
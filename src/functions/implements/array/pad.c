@@ -29,7 +29,6 @@ typedef struct {
   rt_variable_t *output;
   rt_variable_setter set_output;
   rt_list_t pad_width[2];
-  rt_list_t out_position;
   int output_size;
 } pad_private_t;
 
@@ -43,8 +42,11 @@ rt_function_error_t allocate_pad_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
+  if (f->outputs[0]->shape.size > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
 
-  pad_private_t *p = rt_malloc_func(sizeof(pad_private_t));
+  pad_private_t *p = rt_function_malloc(f, sizeof(pad_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -55,14 +57,13 @@ rt_function_error_t allocate_pad_local_context(rt_function_t *f) {
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
 
-  p->input_shape = clone_list(f->inputs[0]->shape);
-  p->output_shape = clone_list(f->outputs[0]->shape);
-  p->input_strides = calc_contiguous_strides(f->inputs[0]->shape);
-  p->output_strides = calc_contiguous_strides(f->outputs[0]->shape);
-  p->pad_width[0] = allocate_list(p->output_shape.size);
-  p->pad_width[1] = allocate_list(p->output_shape.size);
+  p->input_shape = clone_list(f, f->inputs[0]->shape);
+  p->output_shape = clone_list(f, f->outputs[0]->shape);
+  p->input_strides = calc_contiguous_strides(f, f->inputs[0]->shape);
+  p->output_strides = calc_contiguous_strides(f, f->outputs[0]->shape);
+  p->pad_width[0] = allocate_list(f, p->output_shape.size);
+  p->pad_width[1] = allocate_list(f, p->output_shape.size);
   p->output_size = calc_shape_size(p->output_shape);
-  p->out_position = allocate_list(p->output_shape.size);
 
   int i, j;
   for (i = 0; i < p->output_shape.size - context->pad_width.size / 2; i++) {
@@ -89,14 +90,13 @@ rt_function_error_t allocate_pad_local_context(rt_function_t *f) {
 rt_function_error_t free_pad_local_context(rt_function_t *f) {
   pad_private_t *p =
       (pad_private_t *)(((pad_local_context_t *)(f->local_context))->data);
-  free_list(p->input_shape);
-  free_list(p->output_shape);
-  free_list(p->input_strides);
-  free_list(p->output_strides);
-  free_list(p->out_position);
-  free_list(p->pad_width[0]);
-  free_list(p->pad_width[1]);
-  rt_free_func(p);
+  free_list(f, p->input_shape);
+  free_list(f, p->output_shape);
+  free_list(f, p->input_strides);
+  free_list(f, p->output_strides);
+  free_list(f, p->pad_width[0]);
+  free_list(f, p->pad_width[1]);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -109,20 +109,21 @@ rt_function_error_t exec_pad(rt_function_t *f) {
   pad_private_t *p = (pad_private_t *)(context->data);
   const float *x = (float *)(p->input->data);
   float *y = (float *)(p->output->data);
+  STACK_LIST(out_position, p->output_shape.size);
 
   if (context->mode == PAD_MODE_CONSTANT) {
     for (int o = 0; o < p->output_size; o++) {
       uint8_t is_constant = 0;
       int index = 0;
-      pos_to_shape(p->out_position, p->output->shape, o);
+      pos_to_shape(out_position, p->output->shape, o);
       for (int i = 0; i < p->output_shape.size; i++) {
-        if (p->out_position.data[i] < p->pad_width[0].data[i] ||
-            (p->out_position.data[i] >=
+        if (out_position.data[i] < p->pad_width[0].data[i] ||
+            (out_position.data[i] >=
              p->output_shape.data[i] - p->pad_width[1].data[i])) {
           is_constant = 1;
           break;
         }
-        index += (p->out_position.data[i] - p->pad_width[0].data[i]) *
+        index += (out_position.data[i] - p->pad_width[0].data[i]) *
                  p->input_strides.data[i];
       }
       if (is_constant) {
@@ -134,22 +135,22 @@ rt_function_error_t exec_pad(rt_function_t *f) {
   } else if (context->mode == PAD_MODE_REFLECT) {
     for (int o = 0; o < p->output_size; o++) {
       int index = 0;
-      pos_to_shape(p->out_position, p->output->shape, o);
+      pos_to_shape(out_position, p->output->shape, o);
       for (int i = 0; i < p->output_shape.size; i++) {
-        if (p->out_position.data[i] < p->pad_width[0].data[i]) {
+        if (out_position.data[i] < p->pad_width[0].data[i]) {
           int _p = p->pad_width[0].data[i];
-          int r = reflect_index(_p - p->out_position.data[i],
+          int r = reflect_index(_p - out_position.data[i],
                                 p->input_shape.data[i] - 1);
-          p->out_position.data[i] = _p + r;
+          out_position.data[i] = _p + r;
         }
-        if (p->out_position.data[i] >=
+        if (out_position.data[i] >=
             p->output_shape.data[i] - p->pad_width[1].data[i]) {
           int _p = p->pad_width[0].data[i] + p->input_shape.data[i];
-          int r = reflect_index(p->out_position.data[i] - _p + 1,
+          int r = reflect_index(out_position.data[i] - _p + 1,
                                 p->input_shape.data[i] - 1);
-          p->out_position.data[i] = _p - r - 1;
+          out_position.data[i] = _p - r - 1;
         }
-        index += (p->out_position.data[i] - p->pad_width[0].data[i]) *
+        index += (out_position.data[i] - p->pad_width[0].data[i]) *
                  p->input_strides.data[i];
       }
       y[o] = x[index];
@@ -161,20 +162,21 @@ rt_function_error_t exec_pad(rt_function_t *f) {
 rt_function_error_t exec_pad_generic(rt_function_t *f) {
   pad_local_context_t *context = (pad_local_context_t *)(f->local_context);
   pad_private_t *p = (pad_private_t *)(context->data);
+  STACK_LIST(out_position, p->output_shape.size);
 
   if (context->mode == PAD_MODE_CONSTANT) {
     for (int o = 0; o < p->output_size; o++) {
       uint8_t is_constant = 0;
       int index = 0;
-      pos_to_shape(p->out_position, p->output->shape, o);
+      pos_to_shape(out_position, p->output->shape, o);
       for (int i = 0; i < p->output_shape.size; i++) {
-        if (p->out_position.data[i] < p->pad_width[0].data[i] ||
-            (p->out_position.data[i] >=
+        if (out_position.data[i] < p->pad_width[0].data[i] ||
+            (out_position.data[i] >=
              p->output_shape.data[i] - p->pad_width[1].data[i])) {
           is_constant = 1;
           break;
         }
-        index += (p->out_position.data[i] - p->pad_width[0].data[i]) *
+        index += (out_position.data[i] - p->pad_width[0].data[i]) *
                  p->input_strides.data[i];
       }
       if (is_constant) {
@@ -187,22 +189,22 @@ rt_function_error_t exec_pad_generic(rt_function_t *f) {
   } else if (context->mode == PAD_MODE_REFLECT) {
     for (int o = 0; o < p->output_size; o++) {
       int index = 0;
-      pos_to_shape(p->out_position, p->output->shape, o);
+      pos_to_shape(out_position, p->output->shape, o);
       for (int i = 0; i < p->output_shape.size; i++) {
-        if (p->out_position.data[i] < p->pad_width[0].data[i]) {
+        if (out_position.data[i] < p->pad_width[0].data[i]) {
           int _p = p->pad_width[0].data[i];
-          int r = reflect_index(_p - p->out_position.data[i],
+          int r = reflect_index(_p - out_position.data[i],
                                 p->input_shape.data[i] - 1);
-          p->out_position.data[i] = _p + r;
+          out_position.data[i] = _p + r;
         }
-        if (p->out_position.data[i] >=
+        if (out_position.data[i] >=
             p->output_shape.data[i] - p->pad_width[1].data[i]) {
           int _p = p->pad_width[0].data[i] + p->input_shape.data[i];
-          int r = reflect_index(p->out_position.data[i] - _p + 1,
+          int r = reflect_index(out_position.data[i] - _p + 1,
                                 p->input_shape.data[i] - 1);
-          p->out_position.data[i] = _p - r - 1;
+          out_position.data[i] = _p - r - 1;
         }
-        index += (p->out_position.data[i] - p->pad_width[0].data[i]) *
+        index += (out_position.data[i] - p->pad_width[0].data[i]) *
                  p->input_strides.data[i];
       }
       float x = p->get_input(p->input, index);
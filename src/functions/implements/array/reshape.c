@@ -38,7 +38,7 @@ rt_function_error_t allocate_reshape_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
-  reshape_private_t *p = rt_malloc_func(sizeof(reshape_private_t));
+  reshape_private_t *p = rt_function_malloc(f, sizeof(reshape_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -49,7 +49,7 @@ rt_function_error_t allocate_reshape_local_context(rt_function_t *f) {
   p->set_output = select_setter(p->output);
   p->output_size = calc_shape_size(f->outputs[0]->shape);
   if (p->input_size != p->output_size) {
-    rt_free_func(p);
+    rt_function_free(f, p);
     return RT_FUNCTION_ERROR_INVALID_SHAPE;
   }
   ((reshape_local_context_t *)(f->local_context))->data = (void *)p;
@@ -67,7 +67,7 @@ rt_function_error_t allocate_reshape_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_reshape_local_context(rt_function_t *f) {
-  rt_free_func(((reshape_local_context_t *)(f->local_context))->data);
+  rt_function_free(f, ((reshape_local_context_t *)(f->local_context))->data);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
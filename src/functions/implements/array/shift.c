@@ -26,7 +26,6 @@ typedef struct {
   rt_list_t input_shape;
   rt_list_t output_shape;
   rt_list_t input_strides;
-  rt_list_t out_position;
   int **table;
   rt_variable_t *input;
   rt_variable_getter get_input;
@@ -48,29 +47,31 @@ rt_function_error_t allocate_shift_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
+  if (f->outputs[0]->shape.size > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
 
-  shift_private_t *p = rt_malloc_func(sizeof(shift_private_t));
+  shift_private_t *p = rt_function_malloc(f, sizeof(shift_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
   shift_local_context_t *context = (shift_local_context_t *)(f->local_context);
   ((shift_local_context_t *)(f->local_context))->data = (void *)p;
-  p->input_shape = clone_list(f->inputs[0]->shape);
-  p->output_shape = clone_list(f->outputs[0]->shape);
-  p->input_strides = calc_contiguous_strides(f->inputs[0]->shape);
-  p->out_position = allocate_list(p->output_shape.size);
+  p->input_shape = clone_list(f, f->inputs[0]->shape);
+  p->output_shape = clone_list(f, f->outputs[0]->shape);
+  p->input_strides = calc_contiguous_strides(f, f->inputs[0]->shape);
   p->input = f->inputs[0];
   p->get_input = select_getter(p->input);
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
   p->output_size = calc_shape_size(p->output->shape);
 
-  p->table = rt_malloc_func(sizeof(int *) * p->input_shape.size);
+  p->table = rt_function_malloc(f, sizeof(int *) * p->input_shape.size);
 
   for (int i = 0; i < p->input_shape.size; i++) {
     const int stride = p->input_strides.data[i];
     const int size = p->input_shape.data[i];
-    p->table[i] = rt_malloc_func(size * sizeof(int));
+    p->table[i] = rt_function_malloc(f, size * sizeof(int));
     const int shift_index = context->shifts.size - p->input_shape.size + i;
     const int shift = shift_index >= 0 ? -context->shifts.data[shift_index] : 0;
 
@@ -101,15 +102,14 @@ rt_function_error_t allocate_shift_local_context(rt_function_t *f) {
 rt_function_error_t free_shift_local_context(rt_function_t *f) {
   shift_private_t *p =
       (shift_private_t *)(((shift_local_context_t *)(f->local_context))->data);
-  free_list(p->input_shape);
-  free_list(p->output_shape);
-  free_list(p->input_strides);
-  free_list(p->out_position);
+  free_list(f, p->input_shape);
+  free_list(f, p->output_shape);
+  free_list(f, p->input_strides);
   for (int i = 0; i < p->input_shape.size; i++) {
-    rt_free_func(p->table[i]);
+    rt_function_free(f, p->table[i]);
   }
-  rt_free_func(p->table);
-  rt_free_func(p);
+  rt_function_free(f, p->table);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -119,12 +119,13 @@ rt_function_error_t exec_shift(rt_function_t *f) {
   shift_private_t *p = (shift_private_t *)(context->data);
   const float *x = (float *)(p->input->data);
   float *y = (float *)(p->output->data);
+  STACK_LIST(out_position, p->output_shape.size);
 
   for (int o = 0; o < p->output_size; o++) {
     int index = 0;
-    pos_to_shape(p->out_position, p->output->shape, o);
+    pos_to_shape(out_position, p->output->shape, o);
     for (int i = 0; i < p->input_shape.size; i++) {
-      index += p->table[i][p->out_position.data[i]];
+      index += p->table[i][out_position.data[i]];
     }
     y[o] = x[index];
   }
@@ -136,12 +137,13 @@ rt_function_error_t exec_shift(rt_function_t *f) {
 rt_function_error_t exec_shift_generic(rt_function_t *f) {
   shift_local_context_t *context = (shift_local_context_t *)(f->local_context);
   shift_private_t *p = (shift_private_t *)(context->data);
+  STACK_LIST(out_position, p->output_shape.size);
 
   for (int o = 0; o < p->output_size; o++) {
     int index = 0;
-    pos_to_shape(p->out_position, p->output->shape, o);
+    pos_to_shape(out_position, p->output->shape, o);
     for (int i = 0; i < p->input_shape.size; i++) {
-      index += p->table[i][p->out_position.data[i]];
+      index += p->table[i][out_position.data[i]];
     }
     float x = p->get_input(p->input, index);
     p->set_output(p->output, o, x);
@@ -27,8 +27,6 @@ typedef struct {
   rt_variable_getter get_input;
   rt_variable_t *output;
   rt_variable_setter set_output;
-  rt_list_t in_position;
-  rt_list_t out_position;
   int output_size;
 } slice_private_t;
 
@@ -42,8 +40,12 @@ rt_function_error_t allocate_slice_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
+  if (f->inputs[0]->shape.size > STACK_LIST_MAX_LENGTH ||
+      f->outputs[0]->shape.size > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
 
-  slice_private_t *p = rt_malloc_func(sizeof(slice_private_t));
+  slice_private_t *p = rt_function_malloc(f, sizeof(slice_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -53,10 +55,8 @@ rt_function_error_t allocate_slice_local_context(rt_function_t *f) {
   p->get_input = select_getter(p->input);
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
-  p->start = allocate_list(p->input->shape.size);
-  p->step = allocate_list(p->input->shape.size);
-  p->in_position = allocate_list(p->input->shape.size);
-  p->out_position = allocate_list(p->output->shape.size);
+  p->start = allocate_list(f, p->input->shape.size);
+  p->step = allocate_list(f, p->input->shape.size);
   p->output_size = calc_shape_size(p->output->shape);
 
   int i, j;
@@ -93,11 +93,9 @@ rt_function_error_t allocate_slice_local_context(rt_function_t *f) {
 rt_function_error_t free_slice_local_context(rt_function_t *f) {
   slice_private_t *p =
       (slice_private_t *)(((slice_local_context_t *)(f->local_context))->data);
-  free_list(p->start);
-  free_list(p->step);
-  free_list(p->in_position);
-  free_list(p->out_position);
-  rt_free_func(p);
+  free_list(f, p->start);
+  free_list(f, p->step);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -107,14 +105,16 @@ rt_function_error_t exec_slice(rt_function_t *f) {
   slice_private_t *p = (slice_private_t *)(context->data);
   const float *x = (float *)(p->input->data);
   float *y = (float *)(p->output->data);
+  STACK_LIST(in_position, p->input->shape.size);
+  STACK_LIST(out_position, p->output->shape.size);
 
   for (int o = 0; o < p->output_size; o++) {
-    pos_to_shape(p->out_position, p->output->shape, o);
+    pos_to_shape(out_position, p->output->shape, o);
     for (int i = 0; i < p->input->shape.size; i++) {
-      p->in_position.data[i] =
-          p->out_position.data[i] * p->step.data[i] + p->start.data[i];
+      in_position.data[i] =
+          out_position.data[i] * p->step.data[i] + p->start.data[i];
     }
-    int index = shape_to_pos(p->input->shape, p->in_position);
+    int index = shape_to_pos(p->input->shape, in_position);
     y[o] = x[index];
   }
   return RT_FUNCTION_ERROR_NOERROR;
@@ -125,14 +125,16 @@ rt_function_error_t exec_slice(rt_function_t *f) {
 rt_function_error_t exec_slice_generic(rt_function_t *f) {
   slice_local_context_t *context = (slice_local_context_t *)(f->local_context);
   slice_private_t *p = (slice_private_t *)(context->data);
+  STACK_LIST(in_position, p->input->shape.size);
+  STACK_LIST(out_position, p->output->shape.size);
 
   for (int o = 0; o < p->output_size; o++) {
-    pos_to_shape(p->out_position, p->output->shape, o);
+    pos_to_shape(out_position, p->output->shape, o);
     for (int i = 0; i < p->input->shape.size; i++) {
-      p->in_position.data[i] =
-          p->out_position.data[i] * p->step.data[i] + p->start.data[i];
+      in_position.data[i] =
+          out_position.data[i] * p->step.data[i] + p->start.data[i];
     }
-    int index = shape_to_pos(p->input->shape, p->in_position);
+    int index = shape_to_pos(p->input->shape, in_position);
     float x = p->get_input(p->input, index);
     p->set_output(p->output, o, x);
   }
@@ -56,7 +56,7 @@ rt_function_error_t allocate_split_local_context(rt_function_t *f) {
 #endif /* CONFIG_SPLIT_GENERIC */
 
   split_private_t *p =
-      (split_private_t *)rt_malloc_func(sizeof(split_private_t));
+      (split_private_t *)rt_function_malloc(f, sizeof(split_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -72,7 +72,7 @@ rt_function_error_t allocate_split_local_context(rt_function_t *f) {
 rt_function_error_t free_split_local_context(rt_function_t *f) {
   split_private_t *p =
       (split_private_t *)(((split_local_context_t *)(f->local_context))->data);
-  rt_free_func(p);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -54,7 +54,7 @@ rt_function_error_t allocate_stack_local_context(rt_function_t *f) {
 #endif /* CONFIG_STACK_GENERIC */
 
   stack_private_t *p =
-      (stack_private_t *)rt_malloc_func(sizeof(stack_private_t));
+      (stack_private_t *)rt_function_malloc(f, sizeof(stack_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -69,7 +69,7 @@ rt_function_error_t allocate_stack_local_context(rt_function_t *f) {
 rt_function_error_t free_stack_local_context(rt_function_t *f) {
   stack_private_t *p =
       (stack_private_t *)(((stack_local_context_t *)(f->local_context))->data);
-  rt_free_func(p);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -42,7 +42,7 @@ rt_function_error_t allocate_transpose_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
 
-  transpose_private_t *p = rt_malloc_func(sizeof(transpose_private_t));
+  transpose_private_t *p = rt_function_malloc(f, sizeof(transpose_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -50,12 +50,12 @@ rt_function_error_t allocate_transpose_local_context(rt_function_t *f) {
   ((transpose_local_context_t *)(f->local_context))->data = (void *)p;
   p->input = f->inputs[0];
   p->get_input = select_getter(p->input);
-  p->input_shape = clone_list(f->inputs[0]->shape);
-  p->input_strides = calc_contiguous_strides(f->inputs[0]->shape);
+  p->input_shape = clone_list(f, f->inputs[0]->shape);
+  p->input_strides = calc_contiguous_strides(f, f->inputs[0]->shape);
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
-  p->output_shape = clone_list(f->outputs[0]->shape);
-  p->output_strides = calc_contiguous_strides(f->outputs[0]->shape);
+  p->output_shape = clone_list(f, f->outputs[0]->shape);
+  p->output_strides = calc_contiguous_strides(f, f->outputs[0]->shape);
   p->output_size = calc_shape_size(f->outputs[0]->shape);
 
   if (p->input->type == NN_DATA_TYPE_FLOAT &&
@@ -75,11 +75,11 @@ rt_function_error_t free_transpose_local_context(rt_function_t *f) {
   transpose_private_t *p =
       (transpose_private_t *)(((transpose_local_context_t *)(f->local_context))
                                   ->data);
-  free_list(p->input_shape);
-  free_list(p->output_shape);
-  free_list(p->input_strides);
-  free_list(p->output_strides);
-  rt_free_func(p);
+  free_list(f, p->input_shape);
+  free_list(f, p->output_shape);
+  free_list(f, p->input_strides);
+  free_list(f, p->output_strides);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
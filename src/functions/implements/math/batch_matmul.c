@@ -31,6 +31,11 @@ typedef struct {
   int offset_a;
   int offset_b;
   int offset_y;
+  int inner_size;   // columns of op(a), rows of op(b)
+  int a_row_stride; // strides of op(a), which is a or its transpose
+  int a_col_stride;
+  int b_row_stride; // strides of op(b), which is b or its transpose
+  int b_col_stride;
   rt_variable_t *input_a;
   rt_variable_getter get_input_a;
   rt_variable_t *input_b;
@@ -54,7 +59,8 @@ rt_function_error_t allocate_batch_matmul_local_context(rt_function_t *f) {
 
   batch_matmul_local_context_t *context =
       (batch_matmul_local_context_t *)(f->local_context);
-  batch_matmul_private_t *p = rt_malloc_func(sizeof(batch_matmul_private_t));
+  batch_matmul_private_t *p =
+      rt_function_malloc(f, sizeof(batch_matmul_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -68,6 +74,11 @@ rt_function_error_t allocate_batch_matmul_local_context(rt_function_t *f) {
   p->offset_a = p->row_a * p->col_a;
   p->offset_b = p->row_b * p->col_b;
   p->offset_y = p->row_y * p->col_y;
+  p->inner_size = context->transpose_a ? p->row_a : p->col_a;
+  p->a_row_stride = context->transpose_a ? 1 : p->col_a;
+  p->a_col_stride = context->transpose_a ? p->col_a : 1;
+  p->b_row_stride = context->transpose_b ? 1 : p->col_b;
+  p->b_col_stride = context->transpose_b ? p->col_b : 1;
 
   p->input_a = f->inputs[0];
   p->get_input_a = select_getter(p->input_a);
@@ -107,76 +118,37 @@ rt_function_error_t allocate_batch_matmul_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_batch_matmul_local_context(rt_function_t *f) {
-  rt_free_func(((batch_matmul_local_context_t *)(f->local_context))->data);
+  rt_function_free(
+      f, ((batch_matmul_local_context_t *)(f->local_context))->data);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
-static int get_next(int i, int m, int n) { return (i % n) * m + i / n; }
-
-static int get_pre(int i, int m, int n) { return (i % m) * n + i / m; }
-
-static void move_data(float *mtx, int i, int m, int n) {
-  float temp = mtx[i];
-  int cur = i;
-  int pre = get_pre(cur, m, n);
-  while (pre != i) {
-    mtx[cur] = mtx[pre];
-    cur = pre;
-    pre = get_pre(cur, m, n);
-  }
-  mtx[cur] = temp;
-}
-
-static void transpose(float *mtx, int m, int n) {
-  for (int i = 0; i < m * n; i++) {
-    int next = get_next(i, m, n);
-    while (next > i)
-      next = get_next(next, m, n);
-    if (next == i)
-      move_data(mtx, i, m, n);
-  }
-}
-
+// Transposed operands are read through strides, so that neither the inputs,
+// which may be parameters shared with other contexts, nor the private context
+// are modified while executing.
 #ifdef CONFIG_BATCHMATMUL_FLOAT32
 rt_function_error_t exec_batch_matmul(rt_function_t *f) {
   batch_matmul_local_context_t *context =
       (batch_matmul_local_context_t *)(f->local_context);
   batch_matmul_private_t *p = (batch_matmul_private_t *)(context->data);
-  float *input_a = (float *)(p->input_a->data);
-  float *input_b = (float *)(p->input_b->data);
+  const float *input_a = (float *)(p->input_a->data);
+  const float *input_b = (float *)(p->input_b->data);
   float *output = (float *)(p->output->data);
 
   int i;
-  if (context->transpose_a) {
-    for (i = 0; i < p->samples; i++) {
-      transpose(input_a + p->offset_a * i, p->row_a, p->col_a);
-    }
-    p->row_a = p->row_a ^ p->col_a;
-    p->col_a = p->row_a ^ p->col_a;
-    p->row_a = p->row_a ^ p->col_a;
-  }
-  if (context->transpose_b) {
-    for (i = 0; i < p->samples; i++) {
-      transpose(input_b + p->offset_b * i, p->row_b, p->col_b);
-    }
-    p->row_b = p->row_b ^ p->col_b;
-    p->col_b = p->row_b ^ p->col_b;
-    p->row_b = p->row_b ^ p->col_b;
-  }
   for (i = 0; i < p->samples; i++) {
     float *mtx_y = output + p->offset_y * i;
-    float *mtx_a = input_a + p->offset_a * i;
-    float *mtx_b = input_b + p->offset_b * i;
-    int row_a = p->row_a;
-    int col_b = p->col_b;
-    int col_a = p->col_a;
-    for (int j = 0; j < row_a; j++) {
-      for (int k = 0; k < col_b; k++) {
-        for (int l = 0; l < col_a; l++) {
-          float a = *(mtx_a + col_a * j + l);
-          float b = *(mtx_b + col_b * l + k);
-          *(mtx_y + col_b * j + k) += a * b;
+    const float *mtx_a = input_a + p->offset_a * i;
+    const float *mtx_b = input_b + p->offset_b * i;
+    for (int j = 0; j < p->row_y; j++) {
+      for (int k = 0; k < p->col_y; k++) {
+        float y = 0.0f;
+        for (int l = 0; l < p->inner_size; l++) {
+          float a = *(mtx_a + p->a_row_stride * j + p->a_col_stride * l);
+          float b = *(mtx_b + p->b_row_stride * l + p->b_col_stride * k);
+          y += a * b;
         }
+        *(mtx_y + p->col_y * j + k) = y;
       }
     }
   }
@@ -190,39 +162,22 @@ rt_function_error_t exec_batch_matmul_generic(rt_function_t *f) {
   batch_matmul_local_context_t *context =
       (batch_matmul_local_context_t *)(f->local_context);
   batch_matmul_private_t *p = (batch_matmul_private_t *)(context->data);
-  float *input_a = (float *)(p->input_a->data);
-  float *input_b = (float *)(p->input_b->data);
 
   int i;
-  if (context->transpose_a) {
-    for (i = 0; i < p->samples; i++) {
-      transpose(input_a + p->offset_a * i, p->row_a, p->col_a);
-    }
-    p->row_a = p->row_a ^ p->col_a;
-    p->col_a = p->row_a ^ p->col_a;
-    p->row_a = p->row_a ^ p->col_a;
-  }
-  if (context->transpose_b) {
-    for (i = 0; i < p->samples; i++) {
-      transpose(input_b + p->offset_b * i, p->row_b, p->col_b);
-    }
-    p->row_b = p->row_b ^ p->col_b;
-    p->col_b = p->row_b ^ p->col_b;
-    p->row_b = p->row_b ^ p->col_b;
-  }
   for (i = 0; i < p->samples; i++) {
-    int row_a = p->row_a;
-    int col_b = p->col_b;
-    int col_a = p->col_a;
-    for (int j = 0; j < row_a; j++) {
-      for (int k = 0; k < col_b; k++) {
-        for (int l = 0; l < col_a; l++) {
-          float a = p->get_input_a(p->input_a, p->offset_y * i + col_a * j + l);
-          float b = p->get_input_b(p->input_b, p->offset_b * i + col_b * l + k);
-          float y = p->get_output(p->output, p->offset_y * i + col_b * j + k);
+    for (int j = 0; j < p->row_y; j++) {
+      for (int k = 0; k < p->col_y; k++) {
+        float y = 0.0f;
+        for (int l = 0; l < p->inner_size; l++) {
+          float a = p->get_input_a(p->input_a, p->offset_a * i +
+                                                   p->a_row_stride * j +
+                                                   p->a_col_stride * l);
+          float b = p->get_input_b(p->input_b, p->offset_b * i +
+                                                   p->b_row_stride * l +
+                                                   p->b_col_stride * k);
           y += a * b;
-          p->set_output(p->output, p->offset_y * i + col_b * j + k, y);
         }
+        p->set_output(p->output, p->offset_y * i + p->col_y * j + k, y);
       }
     }
   }
@@ -17,6 +17,9 @@
 #include <assert.h>
 #include <string.h>
 
+#include "../../../utilities/gemm.h"
+#include "../../../utilities/parallel.h"
+#include "../../../utilities/shared_cache.h"
 #include "affine_generic.h"
 #include "affine_internal.h"
 
@@ -29,7 +32,7 @@ rt_function_error_t allocate_affine_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
-  affine_private_t *p = rt_malloc_func(sizeof(affine_private_t));
+  affine_private_t *p = rt_function_malloc(f, sizeof(affine_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -52,6 +55,9 @@ rt_function_error_t allocate_affine_local_context(rt_function_t *f) {
   }
 
   p->alpha = 0;
+  p->activation = f->activation;
+  p->packed_weight = 0;
+  p->kernel = 0;
 
   p->output_size = calc_shape_size(p->output->shape);
 
@@ -77,9 +83,14 @@ rt_function_error_t allocate_affine_local_context(rt_function_t *f) {
       p->output->type == NN_DATA_TYPE_FLOAT &&
       p->weight->type == NN_DATA_TYPE_FLOAT &&
       ((p->bias && p->bias->type == NN_DATA_TYPE_FLOAT) || !p->bias)) {
+    if (prepack_affine_weight(f, p) != RT_FUNCTION_ERROR_NOERROR) {
+      rt_function_free(f, p);
+      return RT_FUNCTION_ERROR_MALLOC;
+    }
     f->exec_func = exec_affine;
   } else {
     f->exec_func = exec_affine_generic;
+    f->variant = "generic";
   }
 
   ((affine_local_context_t *)(f->local_context))->data = (void *)p;
@@ -87,56 +98,96 @@ rt_function_error_t allocate_affine_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_affine_local_context(rt_function_t *f) {
-  rt_free_func((((affine_local_context_t *)(f->local_context))->data));
-  return RT_FUNCTION_ERROR_NOERROR;
-}
-
-rt_function_error_t exec_affine(rt_function_t *f) {
   affine_private_t *p =
       (affine_private_t *)(((affine_local_context_t *)(f->local_context))
                                ->data);
-  int i, j, k; // Iterators.
-  float *input = (float *)(p->input->data);
-  float *weight = (float *)(p->weight->data);
-  float *output = (float *)(p->output->data);
-  float *alpha = 0;
+  free_shared_blob(f, p->packed_weight);
+  rt_function_free(f, p);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
 
-  if (p->alpha) {
-    alpha = (float *)p->alpha->data;
+// The float weight[output][input] is packed as the B operand of
+// output = input * weight^T, i.e. in panels of outputs which store the
+// weights of one input next to each other. The panel width is the one of
+// the kernel selected for the CPU. The packed weight only depends on the
+// weight, so contexts sharing the network share it through f->shared_cache.
+rt_function_error_t prepack_affine_weight(rt_function_t *f,
+                                          affine_private_t *p) {
+  const float *weight = (const float *)(p->weight->data);
+  int created;
+
+  p->kernel = select_affine_kernel(f);
+  p->packed_weight =
+      shared_blob(f, weight, SHARED_BLOB_PACKED_WEIGHT,
+                  sizeof(float) * sgemm_packed_b_size(p->input_loop_size,
+                                                      p->output_loop_size,
+                                                      p->kernel->width),
+                  &created);
+  if (p->packed_weight == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
   }
+  if (created) {
+    sgemm_pack_b(p->input_loop_size, p->output_loop_size, p->kernel->width,
+                 weight, 1, p->input_loop_size, p->packed_weight);
+  }
+  return RT_FUNCTION_ERROR_NOERROR;
+}
 
-  // Clear output
-  memset(output, 0, sizeof(float) * p->output_size);
-
-  for (k = 0; k < p->base_loop_size; k++) {
-    int output_offset = k * p->output_loop_size;
-    int input_offset = k * p->input_loop_size;
-    float *o_addr = output + output_offset;
-    float *alpha_addr = alpha;
-
-    for (j = 0; j < p->output_loop_size; ++j) {
-      int weight_offset = j * p->input_loop_size;
-
-      float *i_addr = input + input_offset;
-      float *w_addr = weight + weight_offset;
-      for (i = 0; i < p->input_loop_size; ++i) {
-        *o_addr += (*i_addr++) * (*w_addr++);
-      }
-      if (alpha) {
-        *o_addr *= *alpha_addr++;
+// Outputs of weight panels [q0, q1) of every sample.
+static void affine_panels(void *arg, int q0, int q1) {
+  affine_private_t *p = (affine_private_t *)arg;
+  const affine_kernel_t *kernel = p->kernel;
+  const int n = p->input_loop_size;
+  const int width = kernel->width;
+  float tile[AFFINE_ROWS * AFFINE_MAX_WIDTH];
+  int j, k, q, r; // Iterators.
+  int rows;
+  float *input = (float *)(p->input->data);
+  float *output = (float *)(p->output->data);
+  float *alpha = p->alpha ? (float *)(p->alpha->data) : 0;
+  float *bias = p->bias ? (float *)(p->bias->data) : 0;
+
+  for (q = q0; q < q1; q++) {
+    const int j0 = q * width;
+    const int nr = (p->output_loop_size - j0) < width
+                       ? (p->output_loop_size - j0)
+                       : width;
+    const float *w = p->packed_weight + j0 * n;
+
+    // The panel stays in cache while it is applied to every sample.
+    for (k = 0; k < p->base_loop_size; k += rows) {
+      if (p->base_loop_size - k >= AFFINE_ROWS) {
+        rows = AFFINE_ROWS;
+        kernel->tile_n(n, input + k * n, n, w, tile);
+      } else {
+        rows = 1;
+        kernel->tile_1(n, input + k * n, n, w, tile);
       }
-      ++o_addr;
-    }
-
-    // Bias
-    if (p->bias) {
-      float *bias = (float *)(p->bias->data);
-      for (i = 0; i < p->output_loop_size; i++) {
-        int opos = output_offset + i;
-        int bpos = i;
-        *(output + opos) = *(output + opos) + *(bias + bpos);
+      // Alpha, bias and activation are applied while the tile is hot.
+      for (r = 0; r < rows; r++) {
+        const float *sum = tile + r * width;
+        float *o_addr = output + (k + r) * p->output_loop_size + j0;
+        for (j = 0; j < nr; j++) {
+          float value = sum[j];
+          if (alpha) {
+            value *= alpha[j0 + j];
+          }
+          if (bias) {
+            value += bias[j0 + j];
+          }
+          o_addr[j] = activate(&p->activation, value);
+        }
       }
     }
   }
+}
+
+rt_function_error_t exec_affine(rt_function_t *f) {
+  affine_private_t *p =
+      (affine_private_t *)(((affine_local_context_t *)(f->local_context))
+                               ->data);
+  const int width = p->kernel->width;
+  parallel_for(f, (p->output_loop_size + width - 1) / width, affine_panels,
+               p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
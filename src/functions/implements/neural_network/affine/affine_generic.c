@@ -62,6 +62,8 @@ rt_function_error_t exec_affine_generic(rt_function_t *f) {
                                            p->get_bias(p->bias, bpos));
       }
     }
+    activate_variable(&p->activation, p->output, output_offset,
+                      p->output_loop_size);
   }
 
   return RT_FUNCTION_ERROR_NOERROR;
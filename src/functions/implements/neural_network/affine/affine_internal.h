@@ -16,8 +16,30 @@
 #define H_AFFINE_INTERNAL_H_171218154530_
 
 #include "../../../utilities/accessor.h"
+#include "../../../utilities/activation.h"
 #include "../../../utilities/shape.h"
 
+// Samples multiplied by one weight panel at once.
+#define AFFINE_ROWS (4)
+
+// Widest weight panel of the affine kernels.
+#define AFFINE_MAX_WIDTH (32)
+
+// tile[r][j] = sum_i x[r * ldx + i] * w[i * width + j] over the rows of one
+// call, where w is a weight panel of n inputs and width outputs.
+typedef void (*affine_tile_func_t)(int n, const float *x, int ldx,
+                                   const float *w, float *tile);
+
+typedef struct {
+  int width;                 // outputs per weight panel
+  affine_tile_func_t tile_1; // one sample
+  affine_tile_func_t tile_n; // AFFINE_ROWS samples
+} affine_kernel_t;
+
+// Select the fastest float kernel allowed by f->cpu_features, which also
+// sets f->exec_func to exec_affine and reports the kernel in f->variant.
+const affine_kernel_t *select_affine_kernel(rt_function_t *f);
+
 typedef struct {
   rt_variable_t *input;
   rt_variable_getter get_input;
@@ -40,6 +62,12 @@ typedef struct {
   int input_loop_size;
   int output_loop_size;
 
+  rt_activation_t activation;    // epilogue fused by the runtime
+  float *packed_weight;          // weight packed by prepack_affine_weight
+  const affine_kernel_t *kernel; // tile kernel reading packed_weight
 } affine_private_t;
 
+rt_function_error_t prepack_affine_weight(rt_function_t *f,
+                                          affine_private_t *p);
+
 #endif // H_AFFINE_INTERNAL_H_171218154530_
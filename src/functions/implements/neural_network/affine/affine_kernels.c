@@ -0,0 +1,339 @@
+// Copyright (c) 2017 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../../../utilities/dispatch.h"
+#include "affine_internal.h"
+
+#include <string.h>
+
+/*
+ * Every kernel keeps its accumulators in registers for the whole input
+ * loop, and AFFINE_ROWS samples share every load of the weight panel.
+ * The SIMD kernels split a single sample into two interleaved sums over
+ * even and odd inputs so that consecutive multiply-adds do not wait for
+ * each other.
+ */
+
+// Portable C99 kernel.
+#define C_WIDTH (8)
+
+static void tile_1_c(int n, const float *x, int ldx, const float *w,
+                     float *tile) {
+  float acc[C_WIDTH] = {0.0f};
+  int i, j;
+
+  for (i = 0; i < n; i++) {
+    const float *wi = w + i * C_WIDTH;
+    for (j = 0; j < C_WIDTH; j++) {
+      acc[j] += x[i] * wi[j];
+    }
+  }
+  memcpy(tile, acc, sizeof(acc));
+}
+
+static void tile_n_c(int n, const float *x, int ldx, const float *w,
+                     float *tile) {
+  const float *x0 = x;
+  const float *x1 = x + ldx;
+  const float *x2 = x + 2 * ldx;
+  const float *x3 = x + 3 * ldx;
+  float acc[AFFINE_ROWS][C_WIDTH] = {{0.0f}};
+  int i, j;
+
+  for (i = 0; i < n; i++) {
+    const float *wi = w + i * C_WIDTH;
+    for (j = 0; j < C_WIDTH; j++) {
+      acc[0][j] += x0[i] * wi[j];
+      acc[1][j] += x1[i] * wi[j];
+      acc[2][j] += x2[i] * wi[j];
+      acc[3][j] += x3[i] * wi[j];
+    }
+  }
+  memcpy(tile, acc, sizeof(acc));
+}
+
+static const affine_kernel_t kernel_c = {C_WIDTH, tile_1_c, tile_n_c};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AFFINE_X86
+#include <immintrin.h>
+
+// Kernels are compiled for their instruction set whatever the compiler
+// flags are, and only called when the CPU supports it.
+#define X86_TARGET(isa) __attribute__((target(isa)))
+
+// SSE, 2 x 4 outputs per panel.
+#define SSE_WIDTH (8)
+
+X86_TARGET("sse")
+static void tile_1_sse(int n, const float *x, int ldx, const float *w,
+                       float *tile) {
+  __m128 a0 = _mm_setzero_ps();
+  __m128 a1 = _mm_setzero_ps();
+  __m128 b0 = _mm_setzero_ps();
+  __m128 b1 = _mm_setzero_ps();
+  int i;
+
+  for (i = 0; i + 1 < n; i += 2) {
+    const float *wi = w + i * SSE_WIDTH;
+    const __m128 xa = _mm_set1_ps(x[i]);
+    const __m128 xb = _mm_set1_ps(x[i + 1]);
+    a0 = _mm_add_ps(a0, _mm_mul_ps(xa, _mm_load_ps(wi)));
+    a1 = _mm_add_ps(a1, _mm_mul_ps(xa, _mm_load_ps(wi + 4)));
+    b0 = _mm_add_ps(b0, _mm_mul_ps(xb, _mm_load_ps(wi + SSE_WIDTH)));
+    b1 = _mm_add_ps(b1, _mm_mul_ps(xb, _mm_load_ps(wi + SSE_WIDTH + 4)));
+  }
+  if (i < n) {
+    const float *wi = w + i * SSE_WIDTH;
+    const __m128 xa = _mm_set1_ps(x[i]);
+    a0 = _mm_add_ps(a0, _mm_mul_ps(xa, _mm_load_ps(wi)));
+    a1 = _mm_add_ps(a1, _mm_mul_ps(xa, _mm_load_ps(wi + 4)));
+  }
+  _mm_storeu_ps(tile, _mm_add_ps(a0, b0));
+  _mm_storeu_ps(tile + 4, _mm_add_ps(a1, b1));
+}
+
+X86_TARGET("sse")
+static void tile_n_sse(int n, const float *x, int ldx, const float *w,
+                       float *tile) {
+  __m128 c[AFFINE_ROWS][2];
+  int i, r;
+
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    c[r][0] = _mm_setzero_ps();
+    c[r][1] = _mm_setzero_ps();
+  }
+  for (i = 0; i < n; i++) {
+    const __m128 w0 = _mm_load_ps(w + i * SSE_WIDTH);
+    const __m128 w1 = _mm_load_ps(w + i * SSE_WIDTH + 4);
+    for (r = 0; r < AFFINE_ROWS; r++) {
+      const __m128 xr = _mm_set1_ps(x[r * ldx + i]);
+      c[r][0] = _mm_add_ps(c[r][0], _mm_mul_ps(xr, w0));
+      c[r][1] = _mm_add_ps(c[r][1], _mm_mul_ps(xr, w1));
+    }
+  }
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    _mm_storeu_ps(tile + r * SSE_WIDTH, c[r][0]);
+    _mm_storeu_ps(tile + r * SSE_WIDTH + 4, c[r][1]);
+  }
+}
+
+static const affine_kernel_t kernel_sse = {SSE_WIDTH, tile_1_sse, tile_n_sse};
+
+// AVX2 with FMA3, 2 x 8 outputs per panel.
+#define AVX2_WIDTH (16)
+
+X86_TARGET("avx2,fma")
+static void tile_1_avx2(int n, const float *x, int ldx, const float *w,
+                        float *tile) {
+  __m256 a0 = _mm256_setzero_ps();
+  __m256 a1 = _mm256_setzero_ps();
+  __m256 b0 = _mm256_setzero_ps();
+  __m256 b1 = _mm256_setzero_ps();
+  int i;
+
+  for (i = 0; i + 1 < n; i += 2) {
+    const float *wi = w + i * AVX2_WIDTH;
+    const __m256 xa = _mm256_set1_ps(x[i]);
+    const __m256 xb = _mm256_set1_ps(x[i + 1]);
+    a0 = _mm256_fmadd_ps(xa, _mm256_load_ps(wi), a0);
+    a1 = _mm256_fmadd_ps(xa, _mm256_load_ps(wi + 8), a1);
+    b0 = _mm256_fmadd_ps(xb, _mm256_load_ps(wi + AVX2_WIDTH), b0);
+    b1 = _mm256_fmadd_ps(xb, _mm256_load_ps(wi + AVX2_WIDTH + 8), b1);
+  }
+  if (i < n) {
+    const float *wi = w + i * AVX2_WIDTH;
+    const __m256 xa = _mm256_set1_ps(x[i]);
+    a0 = _mm256_fmadd_ps(xa, _mm256_load_ps(wi), a0);
+    a1 = _mm256_fmadd_ps(xa, _mm256_load_ps(wi + 8), a1);
+  }
+  _mm256_storeu_ps(tile, _mm256_add_ps(a0, b0));
+  _mm256_storeu_ps(tile + 8, _mm256_add_ps(a1, b1));
+}
+
+X86_TARGET("avx2,fma")
+static void tile_n_avx2(int n, const float *x, int ldx, const float *w,
+                        float *tile) {
+  __m256 c[AFFINE_ROWS][2];
+  int i, r;
+
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    c[r][0] = _mm256_setzero_ps();
+    c[r][1] = _mm256_setzero_ps();
+  }
+  for (i = 0; i < n; i++) {
+    const __m256 w0 = _mm256_load_ps(w + i * AVX2_WIDTH);
+    const __m256 w1 = _mm256_load_ps(w + i * AVX2_WIDTH + 8);
+    for (r = 0; r < AFFINE_ROWS; r++) {
+      const __m256 xr = _mm256_set1_ps(x[r * ldx + i]);
+      c[r][0] = _mm256_fmadd_ps(xr, w0, c[r][0]);
+      c[r][1] = _mm256_fmadd_ps(xr, w1, c[r][1]);
+    }
+  }
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    _mm256_storeu_ps(tile + r * AVX2_WIDTH, c[r][0]);
+    _mm256_storeu_ps(tile + r * AVX2_WIDTH + 8, c[r][1]);
+  }
+}
+
+static const affine_kernel_t kernel_avx2 = {AVX2_WIDTH, tile_1_avx2,
+                                            tile_n_avx2};
+
+// AVX-512, 2 x 16 outputs per panel.
+#define AVX512_WIDTH (32)
+
+X86_TARGET("avx512f")
+static void tile_1_avx512(int n, const float *x, int ldx, const float *w,
+                          float *tile) {
+  __m512 a0 = _mm512_setzero_ps();
+  __m512 a1 = _mm512_setzero_ps();
+  __m512 b0 = _mm512_setzero_ps();
+  __m512 b1 = _mm512_setzero_ps();
+  int i;
+
+  for (i = 0; i + 1 < n; i += 2) {
+    const float *wi = w + i * AVX512_WIDTH;
+    const __m512 xa = _mm512_set1_ps(x[i]);
+    const __m512 xb = _mm512_set1_ps(x[i + 1]);
+    a0 = _mm512_fmadd_ps(xa, _mm512_load_ps(wi), a0);
+    a1 = _mm512_fmadd_ps(xa, _mm512_load_ps(wi + 16), a1);
+    b0 = _mm512_fmadd_ps(xb, _mm512_load_ps(wi + AVX512_WIDTH), b0);
+    b1 = _mm512_fmadd_ps(xb, _mm512_load_ps(wi + AVX512_WIDTH + 16), b1);
+  }
+  if (i < n) {
+    const float *wi = w + i * AVX512_WIDTH;
+    const __m512 xa = _mm512_set1_ps(x[i]);
+    a0 = _mm512_fmadd_ps(xa, _mm512_load_ps(wi), a0);
+    a1 = _mm512_fmadd_ps(xa, _mm512_load_ps(wi + 16), a1);
+  }
+  _mm512_storeu_ps(tile, _mm512_add_ps(a0, b0));
+  _mm512_storeu_ps(tile + 16, _mm512_add_ps(a1, b1));
+}
+
+X86_TARGET("avx512f")
+static void tile_n_avx512(int n, const float *x, int ldx, const float *w,
+                          float *tile) {
+  __m512 c[AFFINE_ROWS][2];
+  int i, r;
+
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    c[r][0] = _mm512_setzero_ps();
+    c[r][1] = _mm512_setzero_ps();
+  }
+  for (i = 0; i < n; i++) {
+    const __m512 w0 = _mm512_load_ps(w + i * AVX512_WIDTH);
+    const __m512 w1 = _mm512_load_ps(w + i * AVX512_WIDTH + 16);
+    for (r = 0; r < AFFINE_ROWS; r++) {
+      const __m512 xr = _mm512_set1_ps(x[r * ldx + i]);
+      c[r][0] = _mm512_fmadd_ps(xr, w0, c[r][0]);
+      c[r][1] = _mm512_fmadd_ps(xr, w1, c[r][1]);
+    }
+  }
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    _mm512_storeu_ps(tile + r * AVX512_WIDTH, c[r][0]);
+    _mm512_storeu_ps(tile + r * AVX512_WIDTH + 16, c[r][1]);
+  }
+}
+
+static const affine_kernel_t kernel_avx512 = {AVX512_WIDTH, tile_1_avx512,
+                                              tile_n_avx512};
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AFFINE_NEON
+#include <arm_neon.h>
+
+// acc + a * b, fused where the instruction set has it.
+#if defined(__aarch64__)
+#define NEON_MLA(acc, a, b) vfmaq_f32(acc, a, b)
+#else
+#define NEON_MLA(acc, a, b) vmlaq_f32(acc, a, b)
+#endif
+
+// NEON, 2 x 4 outputs per panel.
+#define NEON_WIDTH (8)
+
+static void tile_1_neon(int n, const float *x, int ldx, const float *w,
+                        float *tile) {
+  float32x4_t a0 = vdupq_n_f32(0.0f);
+  float32x4_t a1 = vdupq_n_f32(0.0f);
+  float32x4_t b0 = vdupq_n_f32(0.0f);
+  float32x4_t b1 = vdupq_n_f32(0.0f);
+  int i;
+
+  for (i = 0; i + 1 < n; i += 2) {
+    const float *wi = w + i * NEON_WIDTH;
+    const float32x4_t xa = vdupq_n_f32(x[i]);
+    const float32x4_t xb = vdupq_n_f32(x[i + 1]);
+    a0 = NEON_MLA(a0, xa, vld1q_f32(wi));
+    a1 = NEON_MLA(a1, xa, vld1q_f32(wi + 4));
+    b0 = NEON_MLA(b0, xb, vld1q_f32(wi + NEON_WIDTH));
+    b1 = NEON_MLA(b1, xb, vld1q_f32(wi + NEON_WIDTH + 4));
+  }
+  if (i < n) {
+    const float *wi = w + i * NEON_WIDTH;
+    const float32x4_t xa = vdupq_n_f32(x[i]);
+    a0 = NEON_MLA(a0, xa, vld1q_f32(wi));
+    a1 = NEON_MLA(a1, xa, vld1q_f32(wi + 4));
+  }
+  vst1q_f32(tile, vaddq_f32(a0, b0));
+  vst1q_f32(tile + 4, vaddq_f32(a1, b1));
+}
+
+static void tile_n_neon(int n, const float *x, int ldx, const float *w,
+                        float *tile) {
+  float32x4_t c[AFFINE_ROWS][2];
+  int i, r;
+
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    c[r][0] = vdupq_n_f32(0.0f);
+    c[r][1] = vdupq_n_f32(0.0f);
+  }
+  for (i = 0; i < n; i++) {
+    const float32x4_t w0 = vld1q_f32(w + i * NEON_WIDTH);
+    const float32x4_t w1 = vld1q_f32(w + i * NEON_WIDTH + 4);
+    for (r = 0; r < AFFINE_ROWS; r++) {
+      const float32x4_t xr = vdupq_n_f32(x[r * ldx + i]);
+      c[r][0] = NEON_MLA(c[r][0], xr, w0);
+      c[r][1] = NEON_MLA(c[r][1], xr, w1);
+    }
+  }
+  for (r = 0; r < AFFINE_ROWS; r++) {
+    vst1q_f32(tile + r * NEON_WIDTH, c[r][0]);
+    vst1q_f32(tile + r * NEON_WIDTH + 4, c[r][1]);
+  }
+}
+
+static const affine_kernel_t kernel_neon = {NEON_WIDTH, tile_1_neon,
+                                            tile_n_neon};
+#endif
+
+// Fastest first, the C99 kernel runs everywhere.
+static const exec_variant_t variants[] = {
+#ifdef AFFINE_X86
+    {"avx512", RT_CPU_FEATURE_AVX512F, exec_affine, &kernel_avx512},
+    {"avx2", RT_CPU_FEATURE_AVX2, exec_affine, &kernel_avx2},
+    {"sse", RT_CPU_FEATURE_SSE, exec_affine, &kernel_sse},
+#endif
+#ifdef AFFINE_NEON
+    {"neon", RT_CPU_FEATURE_NEON, exec_affine, &kernel_neon},
+#endif
+    {"c", 0, exec_affine, &kernel_c},
+};
+
+const affine_kernel_t *select_affine_kernel(rt_function_t *f) {
+  const exec_variant_t *v = select_exec_variant(
+      f, variants, sizeof(variants) / sizeof(variants[0]));
+  return (const affine_kernel_t *)(v->kernel);
+}
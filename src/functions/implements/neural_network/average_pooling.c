@@ -21,9 +21,9 @@
 rt_function_error_t allocate_average_pooling_local_context(rt_function_t *f) {
   average_pooling_local_context_t *context =
       (average_pooling_local_context_t *)(f->local_context);
-  pooling_private_t *p = rt_malloc_func(sizeof(pooling_private_t));
-  rt_function_error_t ret =
-      allocate_pooling(f, (pooling_context_t *)context, p);
+  pooling_private_t *p = rt_function_malloc(f, sizeof(pooling_private_t));
+  rt_function_error_t ret = allocate_pooling(f, (pooling_context_t *)context,
+                                             POOLING_AVERAGE, p);
 
   ((average_pooling_local_context_t *)(f->local_context))->data = (void *)p;
   f->exec_func = exec_average_pooling;
@@ -34,7 +34,7 @@ rt_function_error_t free_average_pooling_local_context(rt_function_t *f) {
   pooling_private_t *p =
       (pooling_private_t
            *)(((average_pooling_local_context_t *)(f->local_context))->data);
-  return free_pooling(p);
+  return free_pooling(f, p);
 }
 
 rt_function_error_t exec_average_pooling(rt_function_t *f) {
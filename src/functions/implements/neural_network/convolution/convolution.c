@@ -34,6 +34,7 @@
 rt_function_error_t allocate_convolution_local_context(rt_function_t *f) {
 #ifdef CONFIG_CONVOLUTION_FLOAT32
   f->exec_func = exec_convolution_float;
+  f->variant = "direct";
 #endif /* CONFIG_CONVOLUTION_FLOAT32 */
 
 #ifdef CONFIG_CONVOLUTION_GENERIC
@@ -42,6 +43,7 @@ rt_function_error_t allocate_convolution_local_context(rt_function_t *f) {
 #ifdef CONFIG_CONVOLUTION_FIXED8
     if (f->inputs[i]->type == NN_DATA_TYPE_INT8) {
       f->exec_func = exec_convolution_int8;
+      f->variant = "int8";
       break;
     }
 #endif /* CONFIG_CONVOLUTION_FIXED8 */
@@ -49,12 +51,14 @@ rt_function_error_t allocate_convolution_local_context(rt_function_t *f) {
 #ifdef CONFIG_CONVOLUTION_FIXED16
     if (f->inputs[i]->type == NN_DATA_TYPE_INT16) {
       f->exec_func = exec_convolution_int16;
+      f->variant = "int16";
       break;
     }
 #endif /* CONFIG_CONVOLUTION_FIXED16 */
 
     if (f->inputs[i]->type != NN_DATA_TYPE_FLOAT) {
       f->exec_func = exec_convolution_generic;
+      f->variant = "generic";
       break;
     }
   }
@@ -91,11 +95,48 @@ rt_function_error_t allocate_convolution_local_context(rt_function_t *f) {
 
     if (!conv_output_assigned) {
       f->exec_func = exec_convolution_generic;
+      f->variant = "generic";
     }
   }
 
-  return allocate_convolution_local_context_common(f, X, WEIGHT, BIAS, ALPHA,
-                                                   Y0);
+  rt_function_error_t ret = allocate_convolution_local_context_common(
+      f, X, WEIGHT, BIAS, ALPHA, Y0);
+  if (ret != RT_FUNCTION_ERROR_NOERROR) {
+    return ret;
+  }
+  convolution_private_t *p =
+      (convolution_private_t *)(((convolution_local_context_t *)
+                                     f->local_context)
+                                    ->data);
+  if (p->in_channel_last || p->out_channel_last) {
+    return allocate_convolution_channel_last_context(f);
+  }
+
+#ifdef CONFIG_CONVOLUTION_FLOAT32
+  // exec_convolution_float is kept as the reference implementation for shapes
+  // the pointwise, Winograd and im2col engines do not handle.
+  if (f->exec_func == exec_convolution_float) {
+    ret = allocate_convolution_float_pointwise_context(f);
+    if (ret != RT_FUNCTION_ERROR_NOERROR ||
+        f->exec_func != exec_convolution_float) {
+      return ret;
+    }
+    ret = allocate_convolution_float_winograd_context(f);
+    if (ret != RT_FUNCTION_ERROR_NOERROR ||
+        f->exec_func != exec_convolution_float) {
+      return ret;
+    }
+    return allocate_convolution_float_im2col_context(f);
+  }
+#endif /* CONFIG_CONVOLUTION_FLOAT32 */
+
+#ifdef CONFIG_CONVOLUTION_FIXED8
+  if (f->exec_func == exec_convolution_int8) {
+    return allocate_convolution_int8_pointwise_context(f);
+  }
+#endif /* CONFIG_CONVOLUTION_FIXED8 */
+
+  return ret;
 }
 #endif /* CONFIG_CONVOLUTION_GENERIC */
 
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "../../../utilities/shape.h"
+#include "../../../utilities/shared_cache.h"
 #include "convolution_internal.h"
 #include <assert.h>
 #include <math.h>
@@ -35,38 +36,59 @@ allocate_convolution_local_context_common(rt_function_t *f, int x, int weight,
   rt_list_t in_shape = f->inputs[x]->shape;
   rt_list_t w_shape = f->inputs[weight]->shape;
   int spatial_dims = in_shape.size - c->base_axis - 1;
+  // With the channel_last attribute x is (batch..., spatial..., channels)
+  // and the weight is (outputs, kernel..., inputs).
+  int channel_axis = c->channel_last ? in_shape.size - 1 : c->base_axis;
+  int spatial_axis = c->channel_last ? c->base_axis : c->base_axis + 1;
+  int w_in_axis = c->channel_last ? spatial_dims + 1 : 1;
+  int kernel_axis = c->channel_last ? 1 : 2;
 
   if (c->base_axis >= in_shape.size - 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_INPUTS;
   }
+  if (spatial_dims > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
 
-  convolution_private_t *p = rt_malloc_func(sizeof(convolution_private_t));
+  convolution_private_t *p =
+      rt_function_malloc(f, sizeof(convolution_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
   c->data = (void *)p;
-
-  if (in_shape.data[c->base_axis] % c->group != 0) {
+  p->col_block = 0;
+  p->winograd_weight = 0;
+  p->packed_weight = 0;
+  p->activation = f->activation;
+  p->residual = 0;
+  p->in_channel_last =
+      c->channel_last || (f->channel_last & RT_CHANNEL_LAST_INPUT);
+  p->out_channel_last =
+      c->channel_last || (f->channel_last & RT_CHANNEL_LAST_OUTPUT);
+  p->tile_kernel = 0;
+  p->int8_weight = 0;
+  p->int8_sums = 0;
+
+  if (in_shape.data[channel_axis] % c->group != 0) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_INPUTS;
   }
 
-  p->in_var.shape = allocate_list(spatial_dims + 3);
+  p->in_var.shape = allocate_list(f, spatial_dims + 3);
   p->in_var.shape.data[B] = 1;
   for (i = 0; i < c->base_axis; ++i) {
     p->in_var.shape.data[B] *= in_shape.data[i];
   }
   p->in_var.shape.data[G] = c->group;
-  p->in_var.shape.data[I] = in_shape.data[c->base_axis] / c->group;
+  p->in_var.shape.data[I] = in_shape.data[channel_axis] / c->group;
 
-  p->out_var.shape = allocate_list(spatial_dims + 3);
+  p->out_var.shape = allocate_list(f, spatial_dims + 3);
   p->out_var.shape.data[B] = p->in_var.shape.data[B];
   p->out_var.shape.data[G] = c->group;
   p->out_var.shape.data[I] = w_shape.data[0] / c->group;
 
   for (i = 0; i < spatial_dims; ++i) {
-    int k = w_shape.data[i + 2];
-    int dims = p->in_var.shape.data[i + 3] =
-        in_shape.data[c->base_axis + 1 + i];
+    int k = w_shape.data[kernel_axis + i];
+    int dims = p->in_var.shape.data[i + 3] = in_shape.data[spatial_axis + i];
     int ks = c->dilation.data[i] * (k - 1) + 1;
     int o = (dims + 2 * c->pad.data[i] - ks) / c->stride.data[i] + 1;
     p->out_var.shape.data[i + 3] = o;
@@ -74,33 +96,33 @@ allocate_convolution_local_context_common(rt_function_t *f, int x, int weight,
   p->in_var.v = f->inputs[x];
   p->in_var.get = select_getter(f->inputs[x]);
   p->in_var.offset = 0;
-  p->in_var.stride = calc_contiguous_strides(p->in_var.shape);
+  p->in_var.stride = calc_contiguous_strides(f, p->in_var.shape);
   p->out_var.v = f->outputs[y0];
   p->out_var.get = select_getter(f->outputs[y0]);
   p->out_var.set = select_setter(f->outputs[y0]);
   p->out_var.offset = 0;
-  p->out_var.stride = calc_contiguous_strides(p->out_var.shape);
+  p->out_var.stride = calc_contiguous_strides(f, p->out_var.shape);
 
   p->w_var.v = f->inputs[weight];
   p->w_var.get = select_getter(f->inputs[weight]);
   p->w_var.offset = 0;
-  p->w_var.shape = allocate_list(spatial_dims + 3);
+  p->w_var.shape = allocate_list(f, spatial_dims + 3);
   p->w_var.shape.data[KG] = c->group;
   p->w_var.shape.data[KO] = w_shape.data[0] / c->group;
-  p->w_var.shape.data[KI] = w_shape.data[1];
+  p->w_var.shape.data[KI] = w_shape.data[w_in_axis];
   for (i = 0; i < spatial_dims; i++) {
-    p->w_var.shape.data[i + 3] = w_shape.data[i + 2];
+    p->w_var.shape.data[i + 3] = w_shape.data[kernel_axis + i];
   }
-  p->w_var.stride = calc_contiguous_strides(p->w_var.shape);
+  p->w_var.stride = calc_contiguous_strides(f, p->w_var.shape);
 
   if (f->num_of_inputs > bias) {
     p->b_var.v = f->inputs[bias];
     p->b_var.get = select_getter(f->inputs[bias]);
     p->b_var.offset = 0;
-    p->b_var.shape = allocate_list(2);
+    p->b_var.shape = allocate_list(f, 2);
     p->b_var.shape.data[KG] = c->group;
     p->b_var.shape.data[KO] = f->inputs[bias]->shape.data[0] / c->group;
-    p->b_var.stride = calc_contiguous_strides(p->b_var.shape);
+    p->b_var.stride = calc_contiguous_strides(f, p->b_var.shape);
   } else {
     p->b_var.v = 0;
   }
@@ -109,19 +131,17 @@ allocate_convolution_local_context_common(rt_function_t *f, int x, int weight,
     p->a_var.v = f->inputs[alpha];
     p->a_var.get = select_getter(f->inputs[alpha]);
     p->a_var.offset = 0;
-    p->a_var.shape = allocate_list(2);
+    p->a_var.shape = allocate_list(f, 2);
     p->a_var.shape.data[KG] = c->group;
     p->a_var.shape.data[KO] = f->inputs[alpha]->shape.data[0] / c->group;
-    p->a_var.stride = calc_contiguous_strides(p->a_var.shape);
+    p->a_var.stride = calc_contiguous_strides(f, p->a_var.shape);
   } else {
     p->a_var.v = 0;
   }
   p->spatial_dims = spatial_dims;
-  p->input_shape = allocate_list(p->spatial_dims);
-  p->kernel_shape = allocate_list(p->spatial_dims);
-  p->output_shape = allocate_list(p->spatial_dims);
-  p->in_position = allocate_list(p->spatial_dims);
-  p->out_position = allocate_list(p->spatial_dims);
+  p->input_shape = allocate_list(f, p->spatial_dims);
+  p->kernel_shape = allocate_list(f, p->spatial_dims);
+  p->output_shape = allocate_list(f, p->spatial_dims);
 
   for (i = 0; i < p->spatial_dims; i++) {
     p->kernel_shape.data[i] = p->w_var.shape.data[i + 3];
@@ -131,27 +151,80 @@ allocate_convolution_local_context_common(rt_function_t *f, int x, int weight,
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
-static inline void var_free(var_t *var) {
-  free_list(var->shape);
-  free_list(var->stride);
+// Whether y is the product of the weight and x as matrices of channels by
+// pixels: a 1x1 kernel with stride 1 and no padding, without alpha.
+int is_pointwise_convolution(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  int i;
+
+  if (p->a_var.v != 0) {
+    return 0;
+  }
+  for (i = 0; i < p->spatial_dims; i++) {
+    if (p->kernel_shape.data[i] != 1 || c->stride.data[i] != 1 ||
+        c->pad.data[i] != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// x or y stored channel last are only handled by the channel last engines,
+// which convolve 2D float or int8 activations.
+rt_function_error_t
+allocate_convolution_channel_last_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  int is_float = f->outputs[0]->type == NN_DATA_TYPE_FLOAT;
+  int is_int8 = f->outputs[0]->type == NN_DATA_TYPE_INT8;
+  int i;
+
+  if (p->spatial_dims != 2 || p->a_var.v != 0) {
+    return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+  }
+  for (i = 0; i < f->num_of_inputs; i++) {
+    is_float = is_float && f->inputs[i]->type == NN_DATA_TYPE_FLOAT;
+    is_int8 = is_int8 && f->inputs[i]->type == NN_DATA_TYPE_INT8;
+  }
+  if (is_float) {
+    return allocate_convolution_float_channel_last_context(f);
+  }
+  if (is_int8) {
+    return allocate_convolution_int8_channel_last_context(f);
+  }
+  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+}
+
+static inline void var_free(rt_function_t *f, var_t *var) {
+  free_list(f, var->shape);
+  free_list(f, var->stride);
 }
 
 rt_function_error_t free_convolution_local_context_common(rt_function_t *f) {
   convolution_local_context_t *c =
       (convolution_local_context_t *)(f->local_context);
   convolution_private_t *p = (convolution_private_t *)c->data;
-  var_free(&p->out_var);
-  var_free(&p->in_var);
-  var_free(&p->w_var);
+  var_free(f, &p->out_var);
+  var_free(f, &p->in_var);
+  var_free(f, &p->w_var);
   if (p->b_var.v != 0)
-    var_free(&p->b_var);
+    var_free(f, &p->b_var);
   if (p->a_var.v != 0)
-    var_free(&p->a_var);
-  free_list(p->input_shape);
-  free_list(p->kernel_shape);
-  free_list(p->in_position);
-  free_list(p->out_position);
-  free_list(p->output_shape);
-  rt_free_func(p);
+    var_free(f, &p->a_var);
+  free_list(f, p->input_shape);
+  free_list(f, p->kernel_shape);
+  free_list(f, p->output_shape);
+  if (p->winograd_weight != 0)
+    free_shared_blob(f, p->winograd_weight);
+  if (p->packed_weight != 0)
+    free_shared_blob(f, p->packed_weight);
+  if (p->int8_weight != 0)
+    free_shared_blob(f, p->int8_weight);
+  if (p->int8_sums != 0)
+    rt_function_free(f, p->int8_sums);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
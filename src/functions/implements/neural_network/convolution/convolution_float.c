@@ -14,6 +14,7 @@
 
 #include "convolution_internal.h"
 
+#include "../../../utilities/activation.h"
 #include "../../../utilities/list.h"
 #include "../../../utilities/shape.h"
 
@@ -149,11 +150,19 @@ rt_function_error_t exec_convolution_float(rt_function_t *f) {
   nn_size_t out_vars = p->out_var.shape.data[I];
   nn_size_t batch_size;
   nn_size_t om, im, g, b;
-  var_t *out_var = &p->out_var;
-  var_t *in_var = &p->in_var;
-  var_t *w_var = &p->w_var;
-  var_t *b_var = &p->b_var;
-  var_t *a_var = &p->a_var;
+  // Offsets are moved while iterating, so work on copies of the variables.
+  var_t out_v = p->out_var;
+  var_t in_v = p->in_var;
+  var_t w_v = p->w_var;
+  var_t b_v = p->b_var;
+  var_t a_v = p->a_var;
+  var_t *out_var = &out_v;
+  var_t *in_var = &in_v;
+  var_t *w_var = &w_v;
+  var_t *b_var = &b_v;
+  var_t *a_var = &a_v;
+  STACK_LIST(in_position, p->spatial_dims);
+  STACK_LIST(out_position, p->spatial_dims);
 
   int output_size = calc_shape_size(p->out_var.shape);
 
@@ -172,7 +181,7 @@ rt_function_error_t exec_convolution_float(rt_function_t *f) {
             var_setpos(in_var, i_pos, _S(i_pos));
             var_setpos(w_var, w_pos, _S(w_pos));
             conv2d(out_var, in_var, w_var, p->input_shape, p->output_shape,
-                   p->kernel_shape, p->in_position, p->out_position, c->pad,
+                   p->kernel_shape, in_position, out_position, c->pad,
                    c->stride, c->dilation, p->spatial_dims);
           }
           {
@@ -186,6 +195,9 @@ rt_function_error_t exec_convolution_float(rt_function_t *f) {
               add_bias(out_var, b_var);
             }
           }
+          add_and_activate_floats(
+              &p->activation, (float *)(out_var->v->data) + out_var->offset,
+              p->residual, out_var->offset, out_var->stride.data[I]);
         }
       }
     }
@@ -201,7 +213,7 @@ rt_function_error_t exec_convolution_float(rt_function_t *f) {
             var_setpos(in_var, i_pos, _S(i_pos));
             var_setpos(w_var, w_pos, _S(w_pos));
             convnd(out_var, in_var, w_var, p->input_shape, p->output_shape,
-                   p->kernel_shape, p->in_position, p->out_position, c->pad,
+                   p->kernel_shape, in_position, out_position, c->pad,
                    c->stride, c->dilation, p->spatial_dims);
           }
           {
@@ -215,6 +227,9 @@ rt_function_error_t exec_convolution_float(rt_function_t *f) {
               add_bias(out_var, b_var);
             }
           }
+          add_and_activate_floats(
+              &p->activation, (float *)(out_var->v->data) + out_var->offset,
+              p->residual, out_var->offset, out_var->stride.data[I]);
         }
       }
     }
@@ -0,0 +1,276 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/gemm.h"
+#include "../../../utilities/parallel.h"
+#include "../../../utilities/shape.h"
+#include "../../../utilities/shared_cache.h"
+
+#include <nnablart/functions.h>
+#include <string.h>
+
+// Floats of the workspace holding the patches of one block of pixels.
+#define CONV_CHANNEL_LAST_WORKSPACE (1 << 16)
+
+/*
+ * Each (batch, group) pair is computed as one matrix multiplication
+ *   out[(oh * ow) x out_vars] = patch[(oh * ow) x (kh * kw * in_vars)]
+ *                                 * weight[(kh * kw * in_vars) x out_vars]
+ * which is an Affine over the patches of the output pixels. A patch holds
+ * the channels of every kernel tap next to each other, so that it is
+ * gathered with contiguous copies from channel last x, and the output
+ * channels of a pixel are stored next to each other in channel last y.
+ * Pointwise convolution of channel last x reads the patches from x itself.
+ * Channel first x or y, at the border of a channel last subgraph, are
+ * transposed while gathering and storing.
+ */
+rt_function_error_t
+allocate_convolution_float_channel_last_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int kernel_size = calc_shape_size(p->kernel_shape);
+  const int patch = in_vars * kernel_size;
+  const int out_size = calc_shape_size(p->output_shape);
+  const float *weight = (const float *)(p->w_var.v->data);
+  int group_size, created, g, om, im, k;
+
+  p->tile_kernel = select_affine_kernel(f);
+  f->exec_func = exec_convolution_float_channel_last;
+  f->variant = "channel_last";
+  group_size = sgemm_packed_b_size(patch, out_vars, p->tile_kernel->width);
+
+  p->col_block = CONV_CHANNEL_LAST_WORKSPACE / patch;
+  p->col_block -= p->col_block % AFFINE_ROWS;
+  if (p->col_block < AFFINE_ROWS) {
+    p->col_block = AFFINE_ROWS;
+  }
+  if (p->col_block > out_size) {
+    p->col_block = out_size;
+  }
+  if (!p->in_channel_last || !is_pointwise_convolution(f)) {
+    f->workspace_size = sizeof(float) * patch * p->col_block;
+  }
+
+  p->packed_weight =
+      shared_blob(f, weight, SHARED_BLOB_CHANNEL_LAST_WEIGHT,
+                  sizeof(float) * c->group * group_size, &created);
+  if (p->packed_weight == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  if (created && c->channel_last) {
+    // weight[out_vars][kernel][in_vars] is the transposed patch matrix.
+    for (g = 0; g < c->group; g++) {
+      sgemm_pack_b(patch, out_vars, p->tile_kernel->width,
+                   weight + g * out_vars * patch, 1, patch,
+                   p->packed_weight + g * group_size);
+    }
+  } else if (created) {
+    // Move the input channels of weight[out_vars][in_vars][kernel] next
+    // to each other first.
+    float *w = rt_function_malloc(f, sizeof(float) * out_vars * patch);
+    if (w == 0) {
+      free_shared_blob(f, p->packed_weight);
+      p->packed_weight = 0;
+      return RT_FUNCTION_ERROR_MALLOC;
+    }
+    for (g = 0; g < c->group; g++) {
+      const float *src = weight + g * out_vars * patch;
+      for (om = 0; om < out_vars; om++) {
+        for (im = 0; im < in_vars; im++) {
+          for (k = 0; k < kernel_size; k++) {
+            w[om * patch + k * in_vars + im] =
+                src[(om * in_vars + im) * kernel_size + k];
+          }
+        }
+      }
+      sgemm_pack_b(patch, out_vars, p->tile_kernel->width, w, 1, patch,
+                   p->packed_weight + g * group_size);
+    }
+    rt_function_free(f, w);
+  }
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// State of one (batch, group, pixel block) step shared by the parallel loops.
+typedef struct {
+  convolution_local_context_t *c;
+  convolution_private_t *p;
+  const float *in; // x of the batch
+  const float *w;  // packed weight of the group
+  const float *bias;
+  float *out;        // y of the batch
+  const float *rows; // patches of the block, in f->workspace if gathered
+  int ldx;           // distance of the patches
+  int g;
+  int n0;
+  int nc;
+} channel_last_block_t;
+
+// Gather the patches of output pixels [n0 + r0, n0 + r1).
+static void gather_patches(void *arg, int r0, int r1) {
+  channel_last_block_t *blk = (channel_last_block_t *)arg;
+  convolution_local_context_t *c = blk->c;
+  convolution_private_t *p = blk->p;
+  const int in_vars = p->in_var.shape.data[I];
+  const int channels = c->group * in_vars;
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int kh = p->kernel_shape.data[SPH];
+  const int kw = p->kernel_shape.data[SPW];
+  const int ow = p->output_shape.data[SPW];
+  const int sh = c->stride.data[SPH];
+  const int sw = c->stride.data[SPW];
+  const int ph = c->pad.data[SPH];
+  const int pw = c->pad.data[SPW];
+  const int dh = c->dilation.data[SPH];
+  const int dw = c->dilation.data[SPW];
+  const int patch = in_vars * kh * kw;
+  // Distance of the channels and of the pixels of x.
+  const int cs = p->in_channel_last ? 1 : ih * iw;
+  const int ps = p->in_channel_last ? channels : 1;
+  const float *in = blk->in + blk->g * in_vars * cs;
+  int r, ky, kx, im;
+
+  for (r = r0; r < r1; r++) {
+    const int oy = (blk->n0 + r) / ow;
+    const int ox = (blk->n0 + r) % ow;
+    float *dst = (float *)blk->rows + r * patch;
+    for (ky = 0; ky < kh; ky++) {
+      const int iy = oy * sh - ph + ky * dh;
+      for (kx = 0; kx < kw; kx++, dst += in_vars) {
+        const int ix = ox * sw - pw + kx * dw;
+        if (iy < 0 || iy >= ih || ix < 0 || ix >= iw) {
+          memset(dst, 0, sizeof(float) * in_vars);
+        } else if (cs == 1) {
+          memcpy(dst, in + (iy * iw + ix) * ps, sizeof(float) * in_vars);
+        } else {
+          const float *src = in + (iy * iw + ix) * ps;
+          for (im = 0; im < in_vars; im++) {
+            dst[im] = src[im * cs];
+          }
+        }
+      }
+    }
+  }
+}
+
+// Output channels of weight panels [q0, q1) of the pixels of the block.
+static void multiply_panels(void *arg, int q0, int q1) {
+  channel_last_block_t *blk = (channel_last_block_t *)arg;
+  convolution_local_context_t *c = blk->c;
+  convolution_private_t *p = blk->p;
+  const affine_kernel_t *kernel = p->tile_kernel;
+  const int width = kernel->width;
+  const int out_vars = p->out_var.shape.data[I];
+  const int channels = c->group * out_vars;
+  const int out_size = calc_shape_size(p->output_shape);
+  const int patch = p->in_var.shape.data[I] * calc_shape_size(p->kernel_shape);
+  const float *y0 = (const float *)(p->out_var.v->data);
+  float tile[AFFINE_ROWS * AFFINE_MAX_WIDTH];
+  int q, r, rr, j, rows;
+
+  for (q = q0; q < q1; q++) {
+    const int j0 = q * width;
+    const int nr = (out_vars - j0) < width ? (out_vars - j0) : width;
+    const float *w = blk->w + j0 * patch;
+    const int oc = blk->g * out_vars + j0;
+
+    for (r = 0; r < blk->nc; r += rows) {
+      if (blk->nc - r >= AFFINE_ROWS) {
+        rows = AFFINE_ROWS;
+        kernel->tile_n(patch, blk->rows + r * blk->ldx, blk->ldx, w, tile);
+      } else {
+        rows = 1;
+        kernel->tile_1(patch, blk->rows + r * blk->ldx, blk->ldx, w, tile);
+      }
+      for (rr = 0; rr < rows; rr++) {
+        const float *sum = tile + rr * width;
+        const int n = blk->n0 + r + rr;
+        if (p->out_channel_last) {
+          float *out = blk->out + n * channels + oc;
+          for (j = 0; j < nr; j++) {
+            out[j] = sum[j] + (blk->bias ? blk->bias[oc + j] : 0.0f);
+          }
+          add_and_activate_floats(&p->activation, out, p->residual,
+                                  out - y0, nr);
+        } else {
+          for (j = 0; j < nr; j++) {
+            float *out = blk->out + (oc + j) * out_size + n;
+            *out = sum[j] + (blk->bias ? blk->bias[oc + j] : 0.0f);
+            add_and_activate_floats(&p->activation, out, p->residual,
+                                    out - y0, 1);
+          }
+        }
+      }
+    }
+  }
+}
+
+rt_function_error_t exec_convolution_float_channel_last(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)f->local_context;
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+
+  const int batch_size = p->in_var.shape.data[B];
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int in_size = group * in_vars * calc_shape_size(p->input_shape);
+  const int out_size = calc_shape_size(p->output_shape);
+  const int patch = in_vars * calc_shape_size(p->kernel_shape);
+  const int width = p->tile_kernel->width;
+  const int group_size = sgemm_packed_b_size(patch, out_vars, width);
+  const int panels = (out_vars + width - 1) / width;
+  // Patches of pointwise convolution are the pixels of channel last x.
+  const int pointwise = p->in_channel_last && patch == in_vars &&
+                        c->stride.data[SPH] == 1 && c->stride.data[SPW] == 1 &&
+                        c->pad.data[SPH] == 0 && c->pad.data[SPW] == 0;
+  const float *input = (const float *)(p->in_var.v->data);
+  float *output = (float *)(p->out_var.v->data);
+  channel_last_block_t blk;
+  int b, g, n0;
+
+  blk.c = c;
+  blk.p = p;
+  blk.bias = p->b_var.v ? (const float *)(p->b_var.v->data) : 0;
+  for (b = 0; b < batch_size; b++) {
+    blk.in = input + b * in_size;
+    blk.out = output + b * group * out_vars * out_size;
+    for (g = 0; g < group; g++) {
+      blk.g = g;
+      blk.w = p->packed_weight + g * group_size;
+      for (n0 = 0; n0 < out_size; n0 += p->col_block) {
+        blk.n0 = n0;
+        blk.nc = (out_size - n0) < p->col_block ? (out_size - n0)
+                                                 : p->col_block;
+        if (pointwise) {
+          blk.rows = blk.in + n0 * group * in_vars + g * in_vars;
+          blk.ldx = group * in_vars;
+        } else {
+          blk.rows = (const float *)f->workspace;
+          blk.ldx = patch;
+          parallel_for(f, blk.nc, gather_patches, &blk);
+        }
+        parallel_for(f, panels, multiply_panels, &blk);
+      }
+    }
+  }
+  return RT_FUNCTION_ERROR_NOERROR;
+}
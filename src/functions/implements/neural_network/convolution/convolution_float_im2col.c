@@ -0,0 +1,164 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/gemm.h"
+#include "../../../utilities/parallel.h"
+#include "../../../utilities/shape.h"
+
+#include <nnablart/functions.h>
+
+// Number of output pixels lowered at once.
+// The workspace holds (in_vars * kernel size) x CONV_IM2COL_BLOCK floats.
+#define CONV_IM2COL_BLOCK (256)
+
+/*
+ * Each (batch, group) pair is computed as one matrix multiplication
+ *   out[out_vars x (oh * ow)] = weight[out_vars x (in_vars * kh * kw)]
+ *                                 * col[(in_vars * kh * kw) x (oh * ow)]
+ * by the Affine tile kernels, like the pointwise engine. The col matrix is
+ * built block by block over output pixels straight into the panels the
+ * kernels read, so that the workspace stays small, and padding is resolved
+ * while building it instead of in the inner loop. The weight is used as it
+ * is.
+ */
+rt_function_error_t
+allocate_convolution_float_im2col_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  int i;
+
+  if (p->spatial_dims != 2 || p->a_var.v != 0) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+  for (i = 0; i < f->num_of_inputs; i++) {
+    if (f->inputs[i]->type != NN_DATA_TYPE_FLOAT) {
+      return RT_FUNCTION_ERROR_NOERROR;
+    }
+  }
+  if (f->outputs[0]->type != NN_DATA_TYPE_FLOAT) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+
+  int col_rows = p->in_var.shape.data[I] * calc_shape_size(p->kernel_shape);
+  int out_size = calc_shape_size(p->output_shape);
+  p->col_block = out_size < CONV_IM2COL_BLOCK ? out_size : CONV_IM2COL_BLOCK;
+  p->tile_kernel = select_affine_kernel(f);
+  f->workspace_size =
+      sizeof(float) *
+      sgemm_packed_b_size(col_rows, p->col_block, p->tile_kernel->width);
+  f->exec_func = exec_convolution_float_im2col;
+  f->variant = "im2col";
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// Lower input channels [im0, im1) of output pixels [n0, n0 + nc) into the
+// panels, where col[row][j] is the element j % width of row in panel
+// j / width. Columns of the last panel beyond nc are zero.
+static void im2col_2d(void *arg, int im0, int im1) {
+  convolution_block_t *blk = (convolution_block_t *)arg;
+  convolution_local_context_t *c = blk->c;
+  convolution_private_t *p = blk->p;
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int kh = p->kernel_shape.data[SPH];
+  const int kw = p->kernel_shape.data[SPW];
+  const int ow = p->output_shape.data[SPW];
+  const int sh = c->stride.data[SPH];
+  const int sw = c->stride.data[SPW];
+  const int ph = c->pad.data[SPH];
+  const int pw = c->pad.data[SPW];
+  const int dh = c->dilation.data[SPH];
+  const int dw = c->dilation.data[SPW];
+  const int width = p->tile_kernel->width;
+  const int nc = blk->nc;
+  int im, ky, kx, j0, j;
+
+  for (im = im0; im < im1; im++) {
+    const float *in = blk->in + im * ih * iw;
+    for (ky = 0; ky < kh; ky++) {
+      for (kx = 0; kx < kw; kx++) {
+        float *dst = blk->panels + ((im * kh + ky) * kw + kx) * width;
+        int oy = blk->n0 / ow;
+        int ox = blk->n0 % ow;
+        // Panel j0 / width starts at j0 * k.
+        for (j0 = 0; j0 < nc; j0 += width, dst += width * blk->k) {
+          for (j = 0; j < width && j0 + j < nc; j++) {
+            int iy = oy * sh - ph + ky * dh;
+            int ix = ox * sw - pw + kx * dw;
+            if (iy >= 0 && iy < ih && ix >= 0 && ix < iw) {
+              dst[j] = in[iy * iw + ix];
+            } else {
+              dst[j] = 0.0f;
+            }
+            if (++ox == ow) {
+              ox = 0;
+              oy++;
+            }
+          }
+          for (; j < width; j++) {
+            dst[j] = 0.0f;
+          }
+        }
+      }
+    }
+  }
+}
+
+rt_function_error_t exec_convolution_float_im2col(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)f->local_context;
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+
+  const int batch_size = p->in_var.shape.data[B];
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int in_size = in_vars * calc_shape_size(p->input_shape);
+  const int out_size = calc_shape_size(p->output_shape);
+  const int col_rows = in_vars * calc_shape_size(p->kernel_shape);
+  const int rows = (out_vars + AFFINE_ROWS - 1) / AFFINE_ROWS;
+
+  const float *input = (const float *)(p->in_var.v->data);
+  const float *weight = (const float *)(p->w_var.v->data);
+  const float *bias = p->b_var.v ? (const float *)(p->b_var.v->data) : 0;
+  float *output = (float *)(p->out_var.v->data);
+  convolution_block_t blk;
+  int b, g, n0;
+
+  blk.c = c;
+  blk.p = p;
+  blk.panels = (float *)f->workspace;
+  blk.k = col_rows;
+  for (b = 0; b < batch_size; b++) {
+    for (g = 0; g < group; g++) {
+      blk.in = input + (b * group + g) * in_size;
+      blk.w = weight + g * out_vars * col_rows;
+      blk.bias = bias ? bias + g * out_vars : 0;
+      blk.out = output + (b * group + g) * out_vars * out_size;
+
+      for (n0 = 0; n0 < out_size; n0 += p->col_block) {
+        blk.n0 = n0;
+        blk.nc = (out_size - n0) < p->col_block ? (out_size - n0)
+                                                 : p->col_block;
+        parallel_for(f, in_vars, im2col_2d, &blk);
+        parallel_for(f, rows, multiply_convolution_panels, &blk);
+      }
+    }
+  }
+
+  return RT_FUNCTION_ERROR_NOERROR;
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/gemm.h"
+#include "../../../utilities/parallel.h"
+#include "../../../utilities/shape.h"
+
+#include <nnablart/functions.h>
+
+// Number of output pixels multiplied at once, so that the block of x stays
+// in cache while every output channel runs over it.
+#define CONV_POINTWISE_BLOCK (256)
+
+/*
+ * A pointwise convolution of each (batch, group) pair is the matrix
+ * multiplication
+ *   out[out_vars x pixels] = weight[out_vars x in_vars] * x[in_vars x pixels]
+ * computed by the Affine tile kernels, with the rows of the weight as the
+ * samples and the pixels of x as the outputs. x needs no lowering: a block
+ * of its pixels is only split into the panels the kernels read, and the
+ * weight is used as it is.
+ */
+rt_function_error_t
+allocate_convolution_float_pointwise_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_size = calc_shape_size(p->output_shape);
+  int i;
+
+  if (!is_pointwise_convolution(f)) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+  for (i = 0; i < f->num_of_inputs; i++) {
+    if (f->inputs[i]->type != NN_DATA_TYPE_FLOAT) {
+      return RT_FUNCTION_ERROR_NOERROR;
+    }
+  }
+  if (f->outputs[0]->type != NN_DATA_TYPE_FLOAT) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+
+  p->col_block =
+      out_size < CONV_POINTWISE_BLOCK ? out_size : CONV_POINTWISE_BLOCK;
+  p->tile_kernel = select_affine_kernel(f);
+  f->workspace_size =
+      sizeof(float) *
+      sgemm_packed_b_size(in_vars, p->col_block, p->tile_kernel->width);
+  f->exec_func = exec_convolution_float_pointwise;
+  f->variant = "pointwise";
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// Panels [q0, q1) of output pixels [n0, n0 + nc).
+static void pack_panels(void *arg, int q0, int q1) {
+  convolution_block_t *blk = (convolution_block_t *)arg;
+  convolution_private_t *p = blk->p;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_size = calc_shape_size(p->output_shape);
+  const int width = p->tile_kernel->width;
+  const int j0 = q0 * width;
+  const int j1 = q1 * width < blk->nc ? q1 * width : blk->nc;
+
+  sgemm_pack_b(in_vars, j1 - j0, width, blk->in + blk->n0 + j0, out_size, 1,
+               blk->panels + j0 * in_vars);
+}
+
+// Output channels [AFFINE_ROWS * r0, AFFINE_ROWS * r1) of the block of a
+// convolution_block_t, whose pixels are packed into blk->panels. Shared by
+// the pointwise and im2col engines, which only differ in the packing.
+void multiply_convolution_panels(void *arg, int r0, int r1) {
+  convolution_block_t *blk = (convolution_block_t *)arg;
+  convolution_private_t *p = blk->p;
+  const affine_kernel_t *kernel = p->tile_kernel;
+  const int width = kernel->width;
+  const int k = blk->k;
+  const int out_vars = p->out_var.shape.data[I];
+  const int out_size = calc_shape_size(p->output_shape);
+  const int om1 = r1 * AFFINE_ROWS < out_vars ? r1 * AFFINE_ROWS : out_vars;
+  float tile[AFFINE_ROWS * AFFINE_MAX_WIDTH];
+  int om0, rows, r, j0, nr, j;
+
+  for (om0 = r0 * AFFINE_ROWS; om0 < om1; om0 += rows) {
+    const float *w = blk->w + om0 * k;
+    rows = om1 - om0 < AFFINE_ROWS ? 1 : AFFINE_ROWS;
+    for (j0 = 0; j0 < blk->nc; j0 += width) {
+      const float *panel = blk->panels + j0 * k;
+      nr = blk->nc - j0 < width ? blk->nc - j0 : width;
+      if (rows == AFFINE_ROWS) {
+        kernel->tile_n(k, w, k, panel, tile);
+      } else {
+        kernel->tile_1(k, w, k, panel, tile);
+      }
+      for (r = 0; r < rows; r++) {
+        const float init = blk->bias ? blk->bias[om0 + r] : 0.0f;
+        float *out = blk->out + (om0 + r) * out_size + blk->n0 + j0;
+        for (j = 0; j < nr; j++) {
+          out[j] = tile[r * width + j] + init;
+        }
+      }
+    }
+    // Rows of the block are still in cache.
+    for (r = 0; r < rows; r++) {
+      float *row = blk->out + (om0 + r) * out_size + blk->n0;
+      add_and_activate_floats(&p->activation, row, p->residual,
+                              row - (float *)(p->out_var.v->data), blk->nc);
+    }
+  }
+}
+
+rt_function_error_t exec_convolution_float_pointwise(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)f->local_context;
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+
+  const int batch_size = p->in_var.shape.data[B];
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int out_size = calc_shape_size(p->output_shape);
+  const int width = p->tile_kernel->width;
+  const int rows = (out_vars + AFFINE_ROWS - 1) / AFFINE_ROWS;
+  const float *input = (const float *)(p->in_var.v->data);
+  const float *weight = (const float *)(p->w_var.v->data);
+  const float *bias = p->b_var.v ? (const float *)(p->b_var.v->data) : 0;
+  float *output = (float *)(p->out_var.v->data);
+  convolution_block_t blk;
+  int b, g, n0;
+
+  blk.c = c;
+  blk.p = p;
+  blk.panels = (float *)f->workspace;
+  blk.k = in_vars;
+  for (b = 0; b < batch_size; b++) {
+    for (g = 0; g < group; g++) {
+      blk.in = input + (b * group + g) * in_vars * out_size;
+      blk.w = weight + g * out_vars * in_vars;
+      blk.bias = bias ? bias + g * out_vars : 0;
+      blk.out = output + (b * group + g) * out_vars * out_size;
+
+      for (n0 = 0; n0 < out_size; n0 += p->col_block) {
+        blk.n0 = n0;
+        blk.nc = (out_size - n0) < p->col_block ? (out_size - n0)
+                                                 : p->col_block;
+        parallel_for(f, (blk.nc + width - 1) / width, pack_panels, &blk);
+        parallel_for(f, rows, multiply_convolution_panels, &blk);
+      }
+    }
+  }
+
+  return RT_FUNCTION_ERROR_NOERROR;
+}
@@ -0,0 +1,346 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/gemm.h"
+#include "../../../utilities/parallel.h"
+#include "../../../utilities/shape.h"
+#include "../../../utilities/shared_cache.h"
+
+#include <nnablart/functions.h>
+
+// Number of 2x2 output tiles transformed at once.
+#define WINOGRAD_TILE_BLOCK (128)
+
+// Elements of one transformed 4x4 tile.
+#define WINOGRAD_TILE_SIZE (16)
+
+// Below this number of channels transforms cost more than they save.
+#define WINOGRAD_MIN_CHANNELS (8)
+
+/*
+ * Winograd F(2x2, 3x3).
+ *   Y = A^T [ sum_i (G g_i G^T) .* (B^T d_i B) ] A
+ * The 16 element-wise products over input channels are computed as 16
+ * matrix multiplications
+ *   M[k][out_vars x tiles] = U[k][out_vars x in_vars] * V[k][in_vars x tiles]
+ * by the Affine tile kernels, with the rows of U as the samples like the
+ * pointwise engine. U is the weight transformed once at allocation time,
+ * and V is transformed straight into the panels the kernels read.
+ */
+
+static void weight_transform(const float *g, float *u, int stride) {
+  float t[4][3];
+  int i, j;
+  for (j = 0; j < 3; j++) {
+    t[0][j] = g[j];
+    t[1][j] = 0.5f * (g[j] + g[3 + j] + g[6 + j]);
+    t[2][j] = 0.5f * (g[j] - g[3 + j] + g[6 + j]);
+    t[3][j] = g[6 + j];
+  }
+  for (i = 0; i < 4; i++) {
+    u[(i * 4 + 0) * stride] = t[i][0];
+    u[(i * 4 + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);
+    u[(i * 4 + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);
+    u[(i * 4 + 3) * stride] = t[i][2];
+  }
+}
+
+static inline void input_transform(float d[4][4], float *v, int stride) {
+  float t[4][4];
+  int i, j;
+  for (j = 0; j < 4; j++) {
+    t[0][j] = d[0][j] - d[2][j];
+    t[1][j] = d[1][j] + d[2][j];
+    t[2][j] = d[2][j] - d[1][j];
+    t[3][j] = d[1][j] - d[3][j];
+  }
+  for (i = 0; i < 4; i++) {
+    v[(i * 4 + 0) * stride] = t[i][0] - t[i][2];
+    v[(i * 4 + 1) * stride] = t[i][1] + t[i][2];
+    v[(i * 4 + 2) * stride] = t[i][2] - t[i][1];
+    v[(i * 4 + 3) * stride] = t[i][1] - t[i][3];
+  }
+}
+
+static inline void output_transform(const float *m, int stride,
+                                     float y[2][2]) {
+  float t[2][4];
+  int i, j;
+  for (j = 0; j < 4; j++) {
+    t[0][j] = m[j * stride] + m[(4 + j) * stride] + m[(8 + j) * stride];
+    t[1][j] = m[(4 + j) * stride] - m[(8 + j) * stride] - m[(12 + j) * stride];
+  }
+  for (i = 0; i < 2; i++) {
+    y[i][0] = t[i][0] + t[i][1] + t[i][2];
+    y[i][1] = t[i][1] - t[i][2] - t[i][3];
+  }
+}
+
+rt_function_error_t
+allocate_convolution_float_winograd_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  int i, g, om, im;
+
+  if (p->spatial_dims != 2 || p->a_var.v != 0) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+  for (i = 0; i < f->num_of_inputs; i++) {
+    if (f->inputs[i]->type != NN_DATA_TYPE_FLOAT) {
+      return RT_FUNCTION_ERROR_NOERROR;
+    }
+  }
+  if (f->outputs[0]->type != NN_DATA_TYPE_FLOAT) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+  for (i = 0; i < 2; i++) {
+    if (p->kernel_shape.data[i] != 3 || c->stride.data[i] != 1 ||
+        c->dilation.data[i] != 1) {
+      return RT_FUNCTION_ERROR_NOERROR;
+    }
+  }
+
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  if (in_vars < WINOGRAD_MIN_CHANNELS || out_vars < WINOGRAD_MIN_CHANNELS) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+
+  const int tiles = ((p->output_shape.data[SPH] + 1) / 2) *
+                    ((p->output_shape.data[SPW] + 1) / 2);
+  p->col_block = tiles < WINOGRAD_TILE_BLOCK ? tiles : WINOGRAD_TILE_BLOCK;
+
+  // The transformed weight only depends on the weight, so contexts sharing
+  // the network share it through f->shared_cache.
+  const void *weight = p->w_var.v->data;
+  const int u_stride = out_vars * in_vars;
+  int created;
+  p->winograd_weight = shared_blob(
+      f, weight, SHARED_BLOB_WINOGRAD_WEIGHT,
+      sizeof(float) * WINOGRAD_TILE_SIZE * group * u_stride, &created);
+  if (p->winograd_weight == 0) {
+    // Keep the reference implementation.
+    p->col_block = 0;
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+
+  if (created) {
+    // U[g][k] holds the row-major [om][im] matrix.
+    for (g = 0; g < group; g++) {
+      float *u = p->winograd_weight + g * WINOGRAD_TILE_SIZE * u_stride;
+      for (om = 0; om < out_vars; om++) {
+        for (im = 0; im < in_vars; im++) {
+          weight_transform((const float *)weight +
+                               ((g * out_vars + om) * in_vars + im) * 9,
+                           u + om * in_vars + im, u_stride);
+        }
+      }
+    }
+  }
+
+  // V in panels of every tile_kernel->width tiles, then M.
+  p->tile_kernel = select_affine_kernel(f);
+  f->workspace_size =
+      sizeof(float) * WINOGRAD_TILE_SIZE *
+      (sgemm_packed_b_size(in_vars, p->col_block, p->tile_kernel->width) +
+       out_vars * p->col_block);
+  f->exec_func = exec_convolution_float_winograd;
+  f->variant = "winograd";
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// State of one (batch, group, tile block) step shared by the parallel loops.
+typedef struct {
+  convolution_local_context_t *c;
+  convolution_private_t *p;
+  const float *in;
+  const float *u;
+  const float *bias;
+  float *out;
+  float *v; // V[k] in panels of the tile kernel, in f->workspace
+  float *m; // M[k][om][tile], in f->workspace after V
+  int v_stride;
+  int t0;
+  int nt;
+} winograd_block_t;
+
+// V[k][im][tile] for input channels [im0, im1), where the tiles are split
+// into panels of width columns. Columns of the last panel beyond nt are zero.
+static void winograd_input(void *arg, int im0, int im1) {
+  winograd_block_t *blk = (winograd_block_t *)arg;
+  convolution_private_t *p = blk->p;
+  const int in_vars = p->in_var.shape.data[I];
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int ph = blk->c->pad.data[SPH];
+  const int pw = blk->c->pad.data[SPW];
+  const int tiles_w = (p->output_shape.data[SPW] + 1) / 2;
+  const int width = p->tile_kernel->width;
+  const int nt = blk->nt;
+  int im, tt, i, j, k;
+
+  for (im = im0; im < im1; im++) {
+    const float *x = blk->in + im * ih * iw;
+    for (tt = 0; tt < nt; tt++) {
+      const int iy0 = ((blk->t0 + tt) / tiles_w) * 2 - ph;
+      const int ix0 = ((blk->t0 + tt) % tiles_w) * 2 - pw;
+      float d[4][4];
+      if (iy0 >= 0 && iy0 + 4 <= ih && ix0 >= 0 && ix0 + 4 <= iw) {
+        for (i = 0; i < 4; i++) {
+          for (j = 0; j < 4; j++) {
+            d[i][j] = x[(iy0 + i) * iw + ix0 + j];
+          }
+        }
+      } else {
+        for (i = 0; i < 4; i++) {
+          for (j = 0; j < 4; j++) {
+            const int iy = iy0 + i;
+            const int ix = ix0 + j;
+            d[i][j] = (iy >= 0 && iy < ih && ix >= 0 && ix < iw)
+                          ? x[iy * iw + ix]
+                          : 0.0f;
+          }
+        }
+      }
+      input_transform(d,
+                      blk->v + (tt - tt % width) * in_vars + im * width +
+                          tt % width,
+                      blk->v_stride);
+    }
+    for (; tt % width != 0; tt++) {
+      float *v = blk->v + (tt - tt % width) * in_vars + im * width + tt % width;
+      for (k = 0; k < WINOGRAD_TILE_SIZE; k++) {
+        v[k * blk->v_stride] = 0.0f;
+      }
+    }
+  }
+}
+
+// M[k][om][tile] = U[k][om][im] * V[k][im][tile] and the output transform
+// for output channels [AFFINE_ROWS * r0, AFFINE_ROWS * r1).
+static void winograd_output(void *arg, int r0, int r1) {
+  winograd_block_t *blk = (winograd_block_t *)arg;
+  convolution_private_t *p = blk->p;
+  const affine_kernel_t *kernel = p->tile_kernel;
+  const int width = kernel->width;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int u_stride = out_vars * in_vars;
+  const int om1 = r1 * AFFINE_ROWS < out_vars ? r1 * AFFINE_ROWS : out_vars;
+  const int oh = p->output_shape.data[SPH];
+  const int ow = p->output_shape.data[SPW];
+  const int tiles_w = (ow + 1) / 2;
+  const int nt = blk->nt;
+  const int m_stride = out_vars * nt;
+  float tile[AFFINE_ROWS * AFFINE_MAX_WIDTH];
+  int om0, rows, om, tt, k, r, j0, nr, i, j;
+
+  for (k = 0; k < WINOGRAD_TILE_SIZE; k++) {
+    const float *v = blk->v + k * blk->v_stride;
+    for (om0 = r0 * AFFINE_ROWS; om0 < om1; om0 += rows) {
+      const float *u = blk->u + k * u_stride + om0 * in_vars;
+      rows = om1 - om0 < AFFINE_ROWS ? 1 : AFFINE_ROWS;
+      for (j0 = 0; j0 < nt; j0 += width) {
+        const float *panel = v + j0 * in_vars;
+        nr = nt - j0 < width ? nt - j0 : width;
+        if (rows == AFFINE_ROWS) {
+          kernel->tile_n(in_vars, u, in_vars, panel, tile);
+        } else {
+          kernel->tile_1(in_vars, u, in_vars, panel, tile);
+        }
+        for (r = 0; r < rows; r++) {
+          float *m = blk->m + k * m_stride + (om0 + r) * nt + j0;
+          for (j = 0; j < nr; j++) {
+            m[j] = tile[r * width + j];
+          }
+        }
+      }
+    }
+  }
+
+  const float *y_base = (const float *)(p->out_var.v->data);
+  rt_variable_getter get_z = p->residual ? select_getter(p->residual) : 0;
+  for (om = r0 * AFFINE_ROWS; om < om1; om++) {
+    const float bias_value = blk->bias ? blk->bias[om] : 0.0f;
+    float *y = blk->out + om * oh * ow;
+    for (tt = 0; tt < nt; tt++) {
+      const int oy0 = ((blk->t0 + tt) / tiles_w) * 2;
+      const int ox0 = ((blk->t0 + tt) % tiles_w) * 2;
+      float res[2][2];
+      output_transform(blk->m + om * nt + tt, m_stride, res);
+      for (i = 0; i < 2 && oy0 + i < oh; i++) {
+        for (j = 0; j < 2 && ox0 + j < ow; j++) {
+          const int o = (oy0 + i) * ow + ox0 + j;
+          float z = 0.0f;
+          if (p->residual) {
+            z = get_z(p->residual, y - y_base + o);
+          }
+          y[o] = activate(&p->activation, res[i][j] + bias_value + z);
+        }
+      }
+    }
+  }
+}
+
+rt_function_error_t exec_convolution_float_winograd(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)f->local_context;
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+
+  const int batch_size = p->in_var.shape.data[B];
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int in_size = in_vars * calc_shape_size(p->input_shape);
+  const int out_size = calc_shape_size(p->output_shape);
+  const int tiles = ((p->output_shape.data[SPH] + 1) / 2) *
+                    ((p->output_shape.data[SPW] + 1) / 2);
+  const int u_stride = out_vars * in_vars;
+  const int width = p->tile_kernel->width;
+  const int rows = (out_vars + AFFINE_ROWS - 1) / AFFINE_ROWS;
+
+  const float *input = (const float *)(p->in_var.v->data);
+  const float *bias = p->b_var.v ? (const float *)(p->b_var.v->data) : 0;
+  float *output = (float *)(p->out_var.v->data);
+  winograd_block_t blk;
+  int b, g, t0;
+
+  blk.c = c;
+  blk.p = p;
+  blk.v = (float *)f->workspace;
+  for (b = 0; b < batch_size; b++) {
+    for (g = 0; g < group; g++) {
+      blk.in = input + (b * group + g) * in_size;
+      blk.u = p->winograd_weight + g * WINOGRAD_TILE_SIZE * u_stride;
+      blk.bias = bias ? bias + g * out_vars : 0;
+      blk.out = output + (b * group + g) * out_vars * out_size;
+
+      for (t0 = 0; t0 < tiles; t0 += p->col_block) {
+        blk.t0 = t0;
+        blk.nt = (tiles - t0) < p->col_block ? (tiles - t0) : p->col_block;
+        blk.v_stride = sgemm_packed_b_size(in_vars, blk.nt, width);
+        blk.m = blk.v + WINOGRAD_TILE_SIZE * blk.v_stride;
+        parallel_for(f, in_vars, winograd_input, &blk);
+        parallel_for(f, rows, winograd_output, &blk);
+      }
+    }
+  }
+
+  return RT_FUNCTION_ERROR_NOERROR;
+}
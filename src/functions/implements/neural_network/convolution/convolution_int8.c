@@ -14,6 +14,7 @@
 
 #include "convolution_internal.h"
 
+#include "../../../utilities/activation.h"
 #include "../../../utilities/fixedpoint.h"
 #include "../../../utilities/list.h"
 #include "../../../utilities/shape.h"
@@ -131,14 +132,15 @@ static inline void conv2d(var_t *out, var_t *in, var_t *we,
   }
 }
 
-static inline void add_bias(var_t *out, var_t *b) {
+static inline void add_bias(var_t *out, var_t *b, unsigned nbits_rescale) {
   int size = out->stride.data[I];
   int i;
   int8_t *bias = (int8_t *)(b->v->data);
   int8_t *output = (int8_t *)(out->v->data);
 
   for (i = 0; i < size; ++i) {
-    sum_acc_sat8(output + out->offset + i, *(bias + b->offset));
+    sum_acc_sat8(output + out->offset + i,
+                 *(bias + b->offset) / (1 << nbits_rescale));
   }
 }
 
@@ -172,29 +174,32 @@ rt_function_error_t exec_convolution_int8(rt_function_t *f) {
   nn_size_t batch_size;
   nn_size_t om, im, g, b;
 
-  var_t *out_var = &p->out_var;
-  var_t *in_var = &p->in_var;
-  var_t *w_var = &p->w_var;
-  var_t *b_var = &p->b_var;
-  var_t *a_var = &p->a_var;
+  // Offsets are moved while iterating, so work on copies of the variables.
+  var_t out_v = p->out_var;
+  var_t in_v = p->in_var;
+  var_t w_v = p->w_var;
+  var_t b_v = p->b_var;
+  var_t a_v = p->a_var;
+  var_t *out_var = &out_v;
+  var_t *in_var = &in_v;
+  var_t *w_var = &w_v;
+  var_t *b_var = &b_v;
+  var_t *a_var = &a_v;
+  STACK_LIST(in_position, p->spatial_dims);
+  STACK_LIST(out_position, p->spatial_dims);
 
   const unsigned output_size = calc_shape_size(out_var->shape);
-  const unsigned bias_size = calc_shape_size(b_var->shape);
 
+  // Bias with less range bits (=more precision bits) than output is rescaled
+  // while it is added. The bias itself is left untouched, as it is a parameter
+  // shared by every context using the network.
+  unsigned nbits_rescale_bias = 0;
   if (p->b_var.v) {
     unsigned int b_fp = b_var->v->fp_pos;
     unsigned int out_fp = out_var->v->fp_pos;
 
-    // If bias has less range bits (=more precision bits) than output, rescale
-    // bias.
-    // Otherwise, output has too few range bits. Change format before starting
-    // computations.
     if (b_fp > out_fp) {
-      int i;
-      int8_t *b_data = (int8_t *)(b_var->v->data);
-      for (i = 0; i < bias_size; i++) {
-        *(b_data + i) /= (1 << (b_fp - out_fp));
-      }
+      nbits_rescale_bias = b_fp - out_fp;
     } else if (b_fp < out_fp) {
       printf(
           "OUTPUT variable has less range bits than BIAS variable. Please "
@@ -219,7 +224,7 @@ rt_function_error_t exec_convolution_int8(rt_function_t *f) {
             var_setpos(in_var, i_pos, _S(i_pos));
             var_setpos(w_var, w_pos, _S(w_pos));
             conv2d(out_var, in_var, w_var, p->input_shape, p->output_shape,
-                   p->kernel_shape, p->in_position, p->out_position, c->pad,
+                   p->kernel_shape, in_position, out_position, c->pad,
                    c->stride, c->dilation, p->spatial_dims);
           }
           {
@@ -230,9 +235,11 @@ rt_function_error_t exec_convolution_int8(rt_function_t *f) {
             }
             if (p->b_var.v) {
               var_setpos(b_var, b_pos, _S(b_pos));
-              add_bias(out_var, b_var);
+              add_bias(out_var, b_var, nbits_rescale_bias);
             }
           }
+          add_and_activate_variable(&p->activation, out_var->v, p->residual,
+                                    out_var->offset, out_var->stride.data[I]);
         }
       }
     }
@@ -248,7 +255,7 @@ rt_function_error_t exec_convolution_int8(rt_function_t *f) {
             var_setpos(in_var, i_pos, _S(i_pos));
             var_setpos(w_var, w_pos, _S(w_pos));
             convnd(out_var, in_var, w_var, p->input_shape, p->output_shape,
-                   p->kernel_shape, p->in_position, p->out_position, c->pad,
+                   p->kernel_shape, in_position, out_position, c->pad,
                    c->stride, c->dilation, p->spatial_dims);
           }
           {
@@ -259,9 +266,11 @@ rt_function_error_t exec_convolution_int8(rt_function_t *f) {
             }
             if (p->b_var.v) {
               var_setpos(b_var, b_pos, _S(b_pos));
-              add_bias(out_var, b_var);
+              add_bias(out_var, b_var, nbits_rescale_bias);
             }
           }
+          add_and_activate_variable(&p->activation, out_var->v, p->residual,
+                                    out_var->offset, out_var->stride.data[I]);
         }
       }
     }
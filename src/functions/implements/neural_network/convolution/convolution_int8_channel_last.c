@@ -0,0 +1,182 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/fixedpoint.h"
+#include "../../../utilities/shape.h"
+#include "../../../utilities/shared_cache.h"
+
+#include <nnablart/functions.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Computes exactly what exec_convolution_int8 does: the products of each
+ * input channel are summed in 32 bits, rescaled, and accumulated into the
+ * 8 bit output with saturation, one input channel after the other. The
+ * loops run over the output channels of a pixel innermost, which are next
+ * to each other in the reordered weight[group][in_vars][kernel][out_vars],
+ * so that they vectorize.
+ */
+rt_function_error_t
+allocate_convolution_int8_channel_last_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int kernel_size = calc_shape_size(p->kernel_shape);
+  const int8_t *weight = (const int8_t *)(p->w_var.v->data);
+  int created, g, om, im, k;
+
+  p->int8_sums = rt_function_malloc(f, sizeof(int32_t) * 2 * out_vars);
+  if (p->int8_sums == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  p->int8_weight =
+      shared_blob(f, weight, SHARED_BLOB_CHANNEL_LAST_WEIGHT,
+                  sizeof(int8_t) * c->group * out_vars * in_vars * kernel_size,
+                  &created);
+  if (p->int8_weight == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  for (g = 0; created && g < c->group; g++) {
+    const int8_t *src = weight + g * out_vars * in_vars * kernel_size;
+    int8_t *dst = p->int8_weight + g * out_vars * in_vars * kernel_size;
+    for (om = 0; om < out_vars; om++) {
+      for (im = 0; im < in_vars; im++) {
+        for (k = 0; k < kernel_size; k++) {
+          // The channel_last attribute stores weight[out][kernel][in].
+          const int from = c->channel_last
+                               ? (om * kernel_size + k) * in_vars + im
+                               : (om * in_vars + im) * kernel_size + k;
+          dst[(im * kernel_size + k) * out_vars + om] = src[from];
+        }
+      }
+    }
+  }
+  f->exec_func = exec_convolution_int8_channel_last;
+  f->variant = "int8_channel_last";
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+rt_function_error_t exec_convolution_int8_channel_last(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)f->local_context;
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+
+  const int batch_size = p->in_var.shape.data[B];
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int kh = p->kernel_shape.data[SPH];
+  const int kw = p->kernel_shape.data[SPW];
+  const int oh = p->output_shape.data[SPH];
+  const int ow = p->output_shape.data[SPW];
+  const int sh = c->stride.data[SPH];
+  const int sw = c->stride.data[SPW];
+  const int ph = c->pad.data[SPH];
+  const int pw = c->pad.data[SPW];
+  const int dh = c->dilation.data[SPH];
+  const int dw = c->dilation.data[SPW];
+  const int kernel_size = kh * kw;
+  // Distance of the channels and of the pixels of x and y.
+  const int in_cs = p->in_channel_last ? 1 : ih * iw;
+  const int in_ps = p->in_channel_last ? group * in_vars : 1;
+  const int out_cs = p->out_channel_last ? 1 : oh * ow;
+  const int out_ps = p->out_channel_last ? group * out_vars : 1;
+  const int8_t *input = (const int8_t *)(p->in_var.v->data);
+  int8_t *output = (int8_t *)(p->out_var.v->data);
+  const int8_t *bias = p->b_var.v ? (const int8_t *)(p->b_var.v->data) : 0;
+  const unsigned nbits_rescale =
+      p->in_var.v->fp_pos + p->w_var.v->fp_pos - p->out_var.v->fp_pos;
+  int32_t *acc = p->int8_sums;
+  int32_t *sum = p->int8_sums + out_vars;
+  int b, g, oy, ox, im, ky, kx, om;
+
+  // Bias with less range bits (=more precision bits) than output is rescaled
+  // while it is added.
+  unsigned nbits_rescale_bias = 0;
+  if (bias) {
+    unsigned int b_fp = p->b_var.v->fp_pos;
+    unsigned int out_fp = p->out_var.v->fp_pos;
+
+    if (b_fp > out_fp) {
+      nbits_rescale_bias = b_fp - out_fp;
+    } else if (b_fp < out_fp) {
+      printf(
+          "OUTPUT variable has less range bits than BIAS variable. Please "
+          "make sure conv/b has same or less range bits than Output to avoid "
+          "overflow.\n");
+      return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+    }
+  }
+
+  for (b = 0; b < batch_size; b++) {
+    const int8_t *in_b = input + b * group * in_vars * ih * iw;
+    int8_t *out_b = output + b * group * out_vars * oh * ow;
+    for (g = 0; g < group; g++) {
+      const int8_t *in_g = in_b + g * in_vars * in_cs;
+      const int8_t *w_g = p->int8_weight + g * in_vars * kernel_size * out_vars;
+      for (oy = 0; oy < oh; oy++) {
+        for (ox = 0; ox < ow; ox++) {
+          int8_t *out = out_b + g * out_vars * out_cs + (oy * ow + ox) * out_ps;
+          for (om = 0; om < out_vars; om++) {
+            acc[om] = 0;
+          }
+          for (im = 0; im < in_vars; im++) {
+            const int8_t *w = w_g + im * kernel_size * out_vars;
+            for (om = 0; om < out_vars; om++) {
+              sum[om] = 0;
+            }
+            for (ky = 0; ky < kh; ky++) {
+              const int iy = oy * sh - ph + ky * dh;
+              for (kx = 0; kx < kw; kx++, w += out_vars) {
+                const int ix = ox * sw - pw + kx * dw;
+                if (iy < 0 || iy >= ih || ix < 0 || ix >= iw) {
+                  continue;
+                }
+                const int32_t x = in_g[im * in_cs + (iy * iw + ix) * in_ps];
+                for (om = 0; om < out_vars; om++) {
+                  sum[om] += x * w[om];
+                }
+              }
+            }
+            // Rescale SUM to the fractional bits of OUT, saturate and
+            // accumulate.
+            for (om = 0; om < out_vars; om++) {
+              acc[om] =
+                  saturate32_to_8(acc[om] + sum[om] / (1 << nbits_rescale));
+            }
+          }
+          for (om = 0; om < out_vars; om++) {
+            int8_t value = (int8_t)acc[om];
+            if (bias) {
+              sum_acc_sat8(&value,
+                           bias[g * out_vars + om] / (1 << nbits_rescale_bias));
+            }
+            out[om * out_cs] = value;
+          }
+        }
+      }
+    }
+  }
+  add_and_activate_variable(&p->activation, p->out_var.v, p->residual, 0,
+                            calc_shape_size(p->out_var.shape));
+  return RT_FUNCTION_ERROR_NOERROR;
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/fixedpoint.h"
+#include "../../../utilities/parallel.h"
+#include "../../../utilities/shape.h"
+
+#include <nnablart/functions.h>
+#include <stdint.h>
+
+// Output pixels and output channels accumulated at once.
+#define CONV_POINTWISE_INT8_BLOCK (256)
+#define CONV_POINTWISE_INT8_ROWS (4)
+
+/*
+ * Pointwise convolution of int8 x, weight and y as a blocked matrix
+ * multiplication of weight[out_vars x in_vars] by x[in_vars x pixels], read
+ * in place. It gives the results of exec_convolution_int8, which rescales
+ * the product of every input channel to the fractional bits of y and adds
+ * it with saturation, one input channel after the other. The accumulation
+ * is not associative, so the input channels stay the outer loop of a block
+ * and the pixels the inner one, which vectorizes.
+ */
+rt_function_error_t
+allocate_convolution_int8_pointwise_context(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  int i;
+
+  if (!is_pointwise_convolution(f)) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+  for (i = 0; i < f->num_of_inputs; i++) {
+    if (f->inputs[i]->type != NN_DATA_TYPE_INT8) {
+      return RT_FUNCTION_ERROR_NOERROR;
+    }
+  }
+  if (f->outputs[0]->type != NN_DATA_TYPE_INT8) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+  // Shifts exec_convolution_int8 does not support are left to it, so that
+  // it reports them.
+  if (p->in_var.v->fp_pos + p->w_var.v->fp_pos < p->out_var.v->fp_pos ||
+      (p->b_var.v && p->b_var.v->fp_pos < p->out_var.v->fp_pos)) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+
+  f->exec_func = exec_convolution_int8_pointwise;
+  f->variant = "int8_pointwise";
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// Rescale product as product / (1 << shift) of C, rounding towards zero,
+// without a division so that the loops over pixels vectorize.
+static inline int32_t rescale(int32_t product, int shift) {
+  return (product + ((product >> 31) & ((1 << shift) - 1))) >> shift;
+}
+
+// State of one (batch, group) step shared by the parallel loop.
+typedef struct {
+  convolution_private_t *p;
+  const int8_t *in;
+  const int8_t *w;
+  const int8_t *bias;
+  int8_t *out;
+} pointwise_int8_t;
+
+// Output channels [CONV_POINTWISE_INT8_ROWS * r0, CONV_POINTWISE_INT8_ROWS *
+// r1) of every output pixel.
+static void pointwise_int8_rows(void *arg, int r0, int r1) {
+  pointwise_int8_t *blk = (pointwise_int8_t *)arg;
+  convolution_private_t *p = blk->p;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int out_size = calc_shape_size(p->output_shape);
+  const int shift =
+      p->in_var.v->fp_pos + p->w_var.v->fp_pos - p->out_var.v->fp_pos;
+  const int bias_shift = p->b_var.v ? p->b_var.v->fp_pos - p->out_var.v->fp_pos
+                                    : 0;
+  const int om1 = r1 * CONV_POINTWISE_INT8_ROWS < out_vars
+                      ? r1 * CONV_POINTWISE_INT8_ROWS
+                      : out_vars;
+  int32_t acc[CONV_POINTWISE_INT8_ROWS][CONV_POINTWISE_INT8_BLOCK];
+  int om0, n0, nc, rows, r, im, i;
+
+  for (om0 = r0 * CONV_POINTWISE_INT8_ROWS; om0 < om1; om0 += rows) {
+    rows = om1 - om0 < CONV_POINTWISE_INT8_ROWS ? om1 - om0
+                                                : CONV_POINTWISE_INT8_ROWS;
+    for (n0 = 0; n0 < out_size; n0 += nc) {
+      nc = out_size - n0 < CONV_POINTWISE_INT8_BLOCK
+               ? out_size - n0
+               : CONV_POINTWISE_INT8_BLOCK;
+      for (r = 0; r < rows; r++) {
+        for (i = 0; i < nc; i++) {
+          acc[r][i] = 0;
+        }
+      }
+      for (im = 0; im < in_vars; im++) {
+        const int8_t *x = blk->in + im * out_size + n0;
+        for (r = 0; r < rows; r++) {
+          const int32_t w = blk->w[(om0 + r) * in_vars + im];
+          int32_t *a = acc[r];
+          for (i = 0; i < nc; i++) {
+            const int32_t sum = a[i] + rescale(x[i] * w, shift);
+            a[i] = sum < INT8_MIN ? INT8_MIN : sum > INT8_MAX ? INT8_MAX : sum;
+          }
+        }
+      }
+      for (r = 0; r < rows; r++) {
+        int8_t *y = blk->out + (om0 + r) * out_size + n0;
+        for (i = 0; i < nc; i++) {
+          y[i] = (int8_t)acc[r][i];
+        }
+        if (blk->bias) {
+          const int8_t b = blk->bias[om0 + r] / (1 << bias_shift);
+          for (i = 0; i < nc; i++) {
+            sum_acc_sat8(y + i, b);
+          }
+        }
+        add_and_activate_variable(&p->activation, p->out_var.v, p->residual,
+                                  y - (int8_t *)(p->out_var.v->data), nc);
+      }
+    }
+  }
+}
+
+rt_function_error_t exec_convolution_int8_pointwise(rt_function_t *f) {
+  convolution_local_context_t *c =
+      (convolution_local_context_t *)f->local_context;
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+
+  const int batch_size = p->in_var.shape.data[B];
+  const int group = c->group;
+  const int in_vars = p->in_var.shape.data[I];
+  const int out_vars = p->out_var.shape.data[I];
+  const int out_size = calc_shape_size(p->output_shape);
+  const int8_t *input = (const int8_t *)(p->in_var.v->data);
+  const int8_t *weight = (const int8_t *)(p->w_var.v->data);
+  const int8_t *bias = p->b_var.v ? (const int8_t *)(p->b_var.v->data) : 0;
+  int8_t *output = (int8_t *)(p->out_var.v->data);
+  const int blocks =
+      (out_vars + CONV_POINTWISE_INT8_ROWS - 1) / CONV_POINTWISE_INT8_ROWS;
+  pointwise_int8_t blk;
+  int b, g;
+
+  blk.p = p;
+  for (b = 0; b < batch_size; b++) {
+    for (g = 0; g < group; g++) {
+      blk.in = input + (b * group + g) * in_vars * out_size;
+      blk.w = weight + g * out_vars * in_vars;
+      blk.bias = bias ? bias + g * out_vars : 0;
+      blk.out = output + (b * group + g) * out_vars * out_size;
+      parallel_for(f, blocks, pointwise_int8_rows, &blk);
+    }
+  }
+  return RT_FUNCTION_ERROR_NOERROR;
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "../../../utilities/accessor.h"
+#include "../affine/affine_internal.h"
 #include <nnablart/functions.h>
 
 #ifndef H_CONVOLUTION_INTERNAL_H_171218154530_
@@ -39,10 +40,33 @@ typedef struct {
   rt_list_t input_shape;
   rt_list_t kernel_shape;
   rt_list_t output_shape;
-  rt_list_t in_position;
-  rt_list_t out_position;
+  int col_block;          // output pixels or Winograd tiles per pass
+  float *winograd_weight; // weight transformed by the Winograd engine
+  float *packed_weight;   // weight packed by the channel last engine
+  rt_activation_t activation; // epilogue fused by the runtime
+  rt_variable_t *residual;    // FusedConvolution z, added before activation
+  int in_channel_last;        // x stored as [batch][spatial][channels]
+  int out_channel_last;       // y and residual stored the same way
+  const affine_kernel_t *tile_kernel; // of the float engines but depthwise
+  int8_t *int8_weight; // weight reordered by the int8 channel last engine
+  int32_t *int8_sums;  // workspace of the int8 channel last engine
 } convolution_private_t;
 
+// One (batch, group, pixel block) step of the engines multiplying the weight
+// by a block of output pixels packed into the panels of p->tile_kernel.
+typedef struct {
+  convolution_local_context_t *c;
+  convolution_private_t *p;
+  const float *in;   // x of the group
+  const float *w;    // weight of the group
+  const float *bias; // bias of the group
+  float *out;        // y of the group
+  float *panels;     // panels of the block in f->workspace
+  int k;             // rows of each panel, columns of the weight
+  int n0;
+  int nc;
+} convolution_block_t;
+
 #define B (0) // batch dimension of input or output
 #define G (1) // group dimension of input or output
 #define I (2) // index dimension of input or output
@@ -60,11 +84,35 @@ typedef struct {
 
 rt_function_error_t exec_convolution_generic(rt_function_t *f);
 rt_function_error_t exec_convolution_float(rt_function_t *f);
+rt_function_error_t exec_convolution_float_im2col(rt_function_t *f);
+rt_function_error_t exec_convolution_float_pointwise(rt_function_t *f);
+rt_function_error_t exec_convolution_float_winograd(rt_function_t *f);
 rt_function_error_t exec_convolution_int8(rt_function_t *f);
+rt_function_error_t exec_convolution_int8_pointwise(rt_function_t *f);
 rt_function_error_t exec_convolution_int16(rt_function_t *f);
 rt_function_error_t
 allocate_convolution_local_context_common(rt_function_t *f, int x, int weight,
                                           int bias, int alpha, int y0);
 rt_function_error_t free_convolution_local_context_common(rt_function_t *f);
+int is_pointwise_convolution(rt_function_t *f);
+void multiply_convolution_panels(void *arg, int r0, int r1);
+rt_function_error_t
+allocate_convolution_float_pointwise_context(rt_function_t *f);
+rt_function_error_t
+allocate_convolution_int8_pointwise_context(rt_function_t *f);
+rt_function_error_t
+allocate_convolution_float_im2col_context(rt_function_t *f);
+rt_function_error_t
+allocate_convolution_float_winograd_context(rt_function_t *f);
+rt_function_error_t
+allocate_convolution_channel_last_context(rt_function_t *f);
+rt_function_error_t
+allocate_convolution_float_channel_last_context(rt_function_t *f);
+rt_function_error_t
+allocate_convolution_int8_channel_last_context(rt_function_t *f);
+rt_function_error_t exec_convolution_float_channel_last(rt_function_t *f);
+rt_function_error_t exec_convolution_int8_channel_last(rt_function_t *f);
+rt_function_error_t exec_depthwise_convolution_float_rows(rt_function_t *f);
+rt_function_error_t exec_depthwise_convolution_int8_rows(rt_function_t *f);
 
 #endif // H_CONVOLUTION_INTERNAL_H_171218154530_
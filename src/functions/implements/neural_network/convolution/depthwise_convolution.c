@@ -11,7 +11,10 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include "../../../utilities/activation.h"
+#include "../../../utilities/parallel.h"
 #include "../../../utilities/shape.h"
+#include "../../../utilities/shared_cache.h"
 #include "convolution_internal.h"
 #include <assert.h>
 #include <math.h>
@@ -20,6 +23,68 @@
 
 #ifdef CONFIG_DEPTHWISECONVOLUTION
 
+rt_function_error_t exec_depthwise_convolution_channel_last(rt_function_t *f);
+
+// Reorder weight[channels][kernel] as weight[kernel][channels], so that the
+// taps of the output channels of a pixel are next to each other.
+static rt_function_error_t
+allocate_depthwise_channel_last_context(rt_function_t *f,
+                                        convolution_private_t *p) {
+  const int channels = p->out_var.shape.data[G] * p->out_var.shape.data[I];
+  const int kernel_size = calc_shape_size(p->kernel_shape);
+  const float *weight = (const float *)(p->w_var.v->data);
+  int created, c, k;
+
+  if (p->spatial_dims != 2) {
+    return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+  }
+  for (c = 0; c < f->num_of_inputs; c++) {
+    if (f->inputs[c]->type != NN_DATA_TYPE_FLOAT) {
+      return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+    }
+  }
+  if (f->outputs[0]->type != NN_DATA_TYPE_FLOAT) {
+    return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+  }
+  p->packed_weight =
+      shared_blob(f, weight, SHARED_BLOB_CHANNEL_LAST_WEIGHT,
+                  sizeof(float) * channels * kernel_size, &created);
+  if (p->packed_weight == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  for (c = 0; created && c < channels; c++) {
+    for (k = 0; k < kernel_size; k++) {
+      p->packed_weight[k * channels + c] = weight[c * kernel_size + k];
+    }
+  }
+  f->exec_func = exec_depthwise_convolution_channel_last;
+  f->variant = "channel_last";
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// Variants of the exec_depthwise_convolution_*_rows kernels.
+static const char *const float_rows_variants[] = {"3x3s1", "3x3s2", "5x5s1",
+                                                  "5x5s2"};
+static const char *const int8_rows_variants[] = {
+    "int8_3x3s1", "int8_3x3s2", "int8_5x5s1", "int8_5x5s2"};
+
+// Index of the variant of the exec_depthwise_convolution_*_rows kernels for
+// a 3x3 or 5x5 kernel with stride 1 or 2 and no dilation, -1 otherwise.
+static int depthwise_rows_variant(depthwise_convolution_local_context_t *c,
+                                  convolution_private_t *p) {
+  if (p->spatial_dims != 2) {
+    return -1;
+  }
+  const int k = p->kernel_shape.data[SPH];
+  const int s = c->stride.data[SPH];
+  if (k != p->kernel_shape.data[SPW] || (k != 3 && k != 5) ||
+      s != c->stride.data[SPW] || (s != 1 && s != 2) ||
+      c->dilation.data[SPH] != 1 || c->dilation.data[SPW] != 1) {
+    return -1;
+  }
+  return (k == 5 ? 2 : 0) + (s == 2 ? 1 : 0);
+}
+
 rt_function_error_t
 allocate_depthwise_convolution_local_context(rt_function_t *f) {
   const int bias = 2;
@@ -48,13 +113,24 @@ allocate_depthwise_convolution_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_INPUTS;
   }
 
-  convolution_private_t *p = rt_malloc_func(sizeof(convolution_private_t));
+  convolution_private_t *p =
+      rt_function_malloc(f, sizeof(convolution_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
   c->data = (void *)p;
+  p->col_block = 0;
+  p->winograd_weight = 0;
+  p->packed_weight = 0;
+  p->activation = f->activation;
+  p->residual = 0;
+  p->in_channel_last = f->channel_last & RT_CHANNEL_LAST_INPUT;
+  p->out_channel_last = f->channel_last & RT_CHANNEL_LAST_OUTPUT;
+  p->tile_kernel = 0;
+  p->int8_weight = 0;
+  p->int8_sums = 0;
 
-  p->in_var.shape = allocate_list(spatial_dims + 3);
+  p->in_var.shape = allocate_list(f, spatial_dims + 3);
   p->in_var.shape.data[B] = 1;
   for (i = 0; i < c->base_axis; ++i) {
     p->in_var.shape.data[B] *= in_shape.data[i];
@@ -65,7 +141,7 @@ allocate_depthwise_convolution_local_context(rt_function_t *f) {
   // c->multiplier is used as c->group.
   group = c->multiplier = in_shape.data[c->base_axis];
 
-  p->out_var.shape = allocate_list(spatial_dims + 3);
+  p->out_var.shape = allocate_list(f, spatial_dims + 3);
   p->out_var.shape.data[B] = p->in_var.shape.data[B];
   p->out_var.shape.data[G] = group;
   p->out_var.shape.data[I] = multiplier;
@@ -81,44 +157,42 @@ allocate_depthwise_convolution_local_context(rt_function_t *f) {
   p->in_var.v = f->inputs[x];
   p->in_var.get = select_getter(f->inputs[x]);
   p->in_var.offset = 0;
-  p->in_var.stride = calc_contiguous_strides(p->in_var.shape);
+  p->in_var.stride = calc_contiguous_strides(f, p->in_var.shape);
   p->out_var.v = f->outputs[y0];
   p->out_var.get = select_getter(f->outputs[y0]);
   p->out_var.set = select_setter(f->outputs[y0]);
   p->out_var.offset = 0;
-  p->out_var.stride = calc_contiguous_strides(p->out_var.shape);
+  p->out_var.stride = calc_contiguous_strides(f, p->out_var.shape);
 
   p->w_var.v = f->inputs[weight];
   p->w_var.get = select_getter(f->inputs[weight]);
   p->w_var.offset = 0;
-  p->w_var.shape = allocate_list(spatial_dims + 3);
+  p->w_var.shape = allocate_list(f, spatial_dims + 3);
   p->w_var.shape.data[KG] = group;
   p->w_var.shape.data[KO] = multiplier;
   p->w_var.shape.data[KI] = 1;
   for (i = 0; i < spatial_dims; i++) {
     p->w_var.shape.data[i + 3] = w_shape.data[i + 1];
   }
-  p->w_var.stride = calc_contiguous_strides(p->w_var.shape);
+  p->w_var.stride = calc_contiguous_strides(f, p->w_var.shape);
 
   if (f->num_of_inputs > bias) {
     p->b_var.v = f->inputs[bias];
     p->b_var.get = select_getter(f->inputs[bias]);
     p->b_var.offset = 0;
-    p->b_var.shape = allocate_list(2);
+    p->b_var.shape = allocate_list(f, 2);
     p->b_var.shape.data[KG] = group;
     p->b_var.shape.data[KO] = multiplier;
-    p->b_var.stride = calc_contiguous_strides(p->b_var.shape);
+    p->b_var.stride = calc_contiguous_strides(f, p->b_var.shape);
   } else {
     p->b_var.v = 0;
   }
 
   p->a_var.v = 0;
   p->spatial_dims = spatial_dims;
-  p->input_shape = allocate_list(p->spatial_dims);
-  p->kernel_shape = allocate_list(p->spatial_dims);
-  p->output_shape = allocate_list(p->spatial_dims);
-  p->in_position = allocate_list(p->spatial_dims);
-  p->out_position = allocate_list(p->spatial_dims);
+  p->input_shape = allocate_list(f, p->spatial_dims);
+  p->kernel_shape = allocate_list(f, p->spatial_dims);
+  p->output_shape = allocate_list(f, p->spatial_dims);
 
   for (i = 0; i < p->spatial_dims; i++) {
     p->kernel_shape.data[i] = p->w_var.shape.data[i + 3];
@@ -144,31 +218,55 @@ allocate_depthwise_convolution_local_context(rt_function_t *f) {
 
   c->multiplier = group;
 
+  if (p->in_channel_last || p->out_channel_last) {
+    return allocate_depthwise_channel_last_context(f, p);
+  }
+
+  const int variant = depthwise_rows_variant(c, p);
+  if (variant < 0) {
+    return RT_FUNCTION_ERROR_NOERROR;
+  }
+#ifdef CONFIG_DEPTHWISECONVOLUTION_FLOAT32
+  if (f->exec_func == exec_depthwise_convolution) {
+    f->exec_func = exec_depthwise_convolution_float_rows;
+    f->variant = float_rows_variants[variant];
+  }
+#endif /* CONFIG_DEPTHWISECONVOLUTION_FLOAT32 */
+#ifdef CONFIG_DEPTHWISECONVOLUTION_FIXED8
+  int int8 = f->outputs[y0]->type == NN_DATA_TYPE_INT8;
+  for (i = 0; i < f->num_of_inputs; i++) {
+    int8 = int8 && f->inputs[i]->type == NN_DATA_TYPE_INT8;
+  }
+  if (int8) {
+    f->exec_func = exec_depthwise_convolution_int8_rows;
+    f->variant = int8_rows_variants[variant];
+  }
+#endif /* CONFIG_DEPTHWISECONVOLUTION_FIXED8 */
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
-static inline void var_free(var_t *var) {
-  free_list(var->shape);
-  free_list(var->stride);
+static inline void var_free(rt_function_t *f, var_t *var) {
+  free_list(f, var->shape);
+  free_list(f, var->stride);
 }
 
 rt_function_error_t free_depthwise_convolution_local_context(rt_function_t *f) {
   depthwise_convolution_local_context_t *c =
       (depthwise_convolution_local_context_t *)(f->local_context);
   convolution_private_t *p = (convolution_private_t *)c->data;
-  var_free(&p->out_var);
-  var_free(&p->in_var);
-  var_free(&p->w_var);
+  var_free(f, &p->out_var);
+  var_free(f, &p->in_var);
+  var_free(f, &p->w_var);
   if (p->b_var.v != 0)
-    var_free(&p->b_var);
+    var_free(f, &p->b_var);
   if (p->a_var.v != 0)
-    var_free(&p->a_var);
-  free_list(p->input_shape);
-  free_list(p->kernel_shape);
-  free_list(p->in_position);
-  free_list(p->out_position);
-  free_list(p->output_shape);
-  rt_free_func(p);
+    var_free(f, &p->a_var);
+  free_list(f, p->input_shape);
+  free_list(f, p->kernel_shape);
+  free_list(f, p->output_shape);
+  if (p->packed_weight != 0)
+    free_shared_blob(f, p->packed_weight);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -178,4 +276,93 @@ rt_function_error_t exec_depthwise_convolution(rt_function_t *f) {
 }
 #endif /* CONFIG_DEPTHWISECONVOLUTION_FLOAT32 */
 
+// Output rows [r0, r1), row r being row r % oh of sample r / oh. All the
+// output channels of a pixel are computed together, each as
+// exec_convolution_float does.
+static void depthwise_rows_channel_last(void *arg, int r0, int r1) {
+  rt_function_t *f = (rt_function_t *)arg;
+  depthwise_convolution_local_context_t *c =
+      (depthwise_convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  const int in_channels = p->in_var.shape.data[G];
+  const int multiplier = p->out_var.shape.data[I];
+  const int channels = in_channels * multiplier;
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int kh = p->kernel_shape.data[SPH];
+  const int kw = p->kernel_shape.data[SPW];
+  const int oh = p->output_shape.data[SPH];
+  const int ow = p->output_shape.data[SPW];
+  const int sh = c->stride.data[SPH];
+  const int sw = c->stride.data[SPW];
+  const int ph = c->pad.data[SPH];
+  const int pw = c->pad.data[SPW];
+  const int dh = c->dilation.data[SPH];
+  const int dw = c->dilation.data[SPW];
+  // Distance of the channels and of the pixels of x and y.
+  const int xcs = p->in_channel_last ? 1 : ih * iw;
+  const int xps = p->in_channel_last ? in_channels : 1;
+  const int ycs = p->out_channel_last ? 1 : oh * ow;
+  const int yps = p->out_channel_last ? channels : 1;
+  const float *bias = p->b_var.v ? (const float *)(p->b_var.v->data) : 0;
+  float *output = (float *)(p->out_var.v->data);
+  int r, ox, ky, kx, oc;
+
+  for (r = r0; r < r1; r++) {
+    const int oy = r % oh;
+    const float *x = (const float *)(p->in_var.v->data) +
+                     r / oh * in_channels * ih * iw;
+    float *y = output + r / oh * channels * oh * ow;
+    for (ox = 0; ox < ow; ox++) {
+      float *out = y + (oy * ow + ox) * yps;
+      for (oc = 0; oc < channels; oc++) {
+        out[oc * ycs] = 0.0f;
+      }
+      for (ky = 0; ky < kh; ky++) {
+        const int iy = oy * sh - ph + ky * dh;
+        for (kx = 0; kx < kw; kx++) {
+          const int ix = ox * sw - pw + kx * dw;
+          if (iy < 0 || iy >= ih || ix < 0 || ix >= iw) {
+            continue;
+          }
+          const float *w = p->packed_weight + (ky * kw + kx) * channels;
+          const float *in = x + (iy * iw + ix) * xps;
+          if (multiplier == 1) {
+            for (oc = 0; oc < channels; oc++) {
+              out[oc * ycs] += in[oc * xcs] * w[oc];
+            }
+          } else {
+            for (oc = 0; oc < channels; oc++) {
+              out[oc * ycs] += in[oc / multiplier * xcs] * w[oc];
+            }
+          }
+        }
+      }
+      if (bias) {
+        for (oc = 0; oc < channels; oc++) {
+          out[oc * ycs] += bias[oc];
+        }
+      }
+      if (p->out_channel_last) {
+        add_and_activate_floats(&p->activation, out, p->residual,
+                                out - output, channels);
+      } else {
+        for (oc = 0; oc < channels; oc++) {
+          add_and_activate_floats(&p->activation, out + oc * ycs, p->residual,
+                                  out + oc * ycs - output, 1);
+        }
+      }
+    }
+  }
+}
+
+rt_function_error_t exec_depthwise_convolution_channel_last(rt_function_t *f) {
+  depthwise_convolution_local_context_t *c =
+      (depthwise_convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  parallel_for(f, p->out_var.shape.data[B] * p->output_shape.data[SPH],
+               depthwise_rows_channel_last, f);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
 #endif /* CONFIG_DEPTHWISECONVOLUTION */
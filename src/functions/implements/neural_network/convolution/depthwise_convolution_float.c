@@ -0,0 +1,151 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/parallel.h"
+
+#include <nnablart/config.h>
+#include <nnablart/functions.h>
+
+#ifdef CONFIG_DEPTHWISECONVOLUTION_FLOAT32
+
+/*
+ * Depthwise convolution with a 3x3 or 5x5 kernel and stride 1 or 2,
+ * computed one output row at a time. The taps of a kernel row are added
+ * to the whole output row before those of the next kernel row, so every
+ * output is summed in the same order as exec_convolution_float does.
+ * Output columns whose taps all fall inside x run a loop without bounds
+ * checks, which the compiler unrolls over the taps and vectorizes over the
+ * columns; only the few columns next to the padding check each tap.
+ */
+
+// Add the taps of one kernel row to y[0, n), the input of column i
+// starting at x[i * stride].
+static inline void add_taps_interior(float *y, const float *x, const float *w,
+                                     int n, int k, int stride) {
+  int i, kx;
+  for (i = 0; i < n; i++) {
+    const float *in = x + i * stride;
+    float sum = y[i];
+    for (kx = 0; kx < k; kx++) {
+      sum += in[kx] * w[kx];
+    }
+    y[i] = sum;
+  }
+}
+
+// Same for output columns [ox0, ox1) of a row, skipping the padding.
+static void add_taps_border(float *y, const float *x, const float *w, int ox0,
+                            int ox1, int k, int stride, int pad, int iw) {
+  int ox, kx;
+  for (ox = ox0; ox < ox1; ox++) {
+    for (kx = 0; kx < k; kx++) {
+      const int ix = ox * stride - pad + kx;
+      if (ix >= 0 && ix < iw) {
+        y[ox] += x[ix] * w[kx];
+      }
+    }
+  }
+}
+
+// Output maps [n0, n1), map n being channel n % channels of sample
+// n / channels.
+static void depthwise_maps_float(void *arg, int n0, int n1) {
+  rt_function_t *f = (rt_function_t *)arg;
+  depthwise_convolution_local_context_t *c =
+      (depthwise_convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  const int in_channels = p->in_var.shape.data[G];
+  const int multiplier = p->out_var.shape.data[I];
+  const int channels = in_channels * multiplier;
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int k = p->kernel_shape.data[SPH];
+  const int oh = p->output_shape.data[SPH];
+  const int ow = p->output_shape.data[SPW];
+  const int stride = c->stride.data[SPH];
+  const int ph = c->pad.data[SPH];
+  const int pw = c->pad.data[SPW];
+  const int map_size = oh * ow;
+  const float *input = (const float *)(p->in_var.v->data);
+  const float *weight = (const float *)(p->w_var.v->data);
+  const float *bias = p->b_var.v ? (const float *)(p->b_var.v->data) : 0;
+  float *output = (float *)(p->out_var.v->data);
+  // Output columns [begin, end) read no padding.
+  int begin = (pw + stride - 1) / stride;
+  int end = iw + pw - k < 0 ? 0 : (iw + pw - k) / stride + 1;
+  int n, oy, ky, i;
+
+  begin = begin < ow ? begin : ow;
+  end = end < ow ? end : ow;
+  end = end > begin ? end : begin;
+
+  for (n = n0; n < n1; n++) {
+    const int oc = n % channels;
+    const float *x =
+        input + (n / channels * in_channels + oc / multiplier) * ih * iw;
+    const float *w = weight + oc * k * k;
+    float *y = output + n * map_size;
+
+    for (oy = 0; oy < oh; oy++) {
+      float *row = y + oy * ow;
+      for (i = 0; i < ow; i++) {
+        row[i] = 0.0f;
+      }
+      for (ky = 0; ky < k; ky++) {
+        const int iy = oy * stride - ph + ky;
+        if (iy < 0 || iy >= ih) {
+          continue;
+        }
+        const float *xr = x + iy * iw;
+        const float *wr = w + ky * k;
+        add_taps_border(row, xr, wr, 0, begin, k, stride, pw, iw);
+        if (end > begin) {
+          const float *xi = xr + begin * stride - pw;
+          if (k == 3 && stride == 1) {
+            add_taps_interior(row + begin, xi, wr, end - begin, 3, 1);
+          } else if (k == 3) {
+            add_taps_interior(row + begin, xi, wr, end - begin, 3, 2);
+          } else if (stride == 1) {
+            add_taps_interior(row + begin, xi, wr, end - begin, 5, 1);
+          } else {
+            add_taps_interior(row + begin, xi, wr, end - begin, 5, 2);
+          }
+        }
+        add_taps_border(row, xr, wr, end, ow, k, stride, pw, iw);
+      }
+    }
+    if (bias) {
+      for (i = 0; i < map_size; i++) {
+        y[i] += bias[oc];
+      }
+    }
+    add_and_activate_floats(&p->activation, y, p->residual, n * map_size,
+                            map_size);
+  }
+}
+
+rt_function_error_t exec_depthwise_convolution_float_rows(rt_function_t *f) {
+  depthwise_convolution_local_context_t *c =
+      (depthwise_convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  parallel_for(f, p->out_var.shape.data[B] * p->out_var.shape.data[G] *
+                      p->out_var.shape.data[I],
+               depthwise_maps_float, f);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+#endif /* CONFIG_DEPTHWISECONVOLUTION_FLOAT32 */
@@ -0,0 +1,194 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/activation.h"
+#include "../../../utilities/parallel.h"
+
+#include <nnablart/config.h>
+#include <nnablart/functions.h>
+#include <stdint.h>
+
+#ifdef CONFIG_DEPTHWISECONVOLUTION_FIXED8
+
+// Output columns accumulated at once.
+#define DEPTHWISE_INT8_BLOCK (256)
+
+/*
+ * The int8 counterpart of exec_depthwise_convolution_float_rows, which
+ * gives the results of exec_convolution_generic. The generic kernel sums
+ * the products in float, but every product of two int8 scaled by a power
+ * of two, and every sum of at most 25 of them, is exact in float, so the
+ * products are summed in 32 bit integers here and scaled once. The output
+ * is then quantized, the bias added and the result quantized again as the
+ * accessors of the generic kernel do.
+ */
+
+// Quantize value, already divided by the coefficient, as set_int8 does.
+// Written without branches so that the loops over a row vectorize.
+static inline int8_t quantize_int8(float value) {
+  value = value < INT8_MAX ? value : INT8_MAX;
+  value = value > INT8_MIN ? value : INT8_MIN;
+  return (int8_t)value;
+}
+
+// Add the taps of one kernel row to acc[0, n), the input of column i
+// starting at x[i * stride].
+static inline void add_taps_interior(int32_t *acc, const int8_t *x,
+                                     const int8_t *w, int n, int k,
+                                     int stride) {
+  int i, kx;
+  for (i = 0; i < n; i++) {
+    const int8_t *in = x + i * stride;
+    int32_t sum = acc[i];
+    for (kx = 0; kx < k; kx++) {
+      sum += in[kx] * w[kx];
+    }
+    acc[i] = sum;
+  }
+}
+
+// Same for output columns [ox0, ox1) of a row, acc[0] being column x0,
+// skipping the padding.
+static void add_taps_border(int32_t *acc, int x0, const int8_t *x,
+                            const int8_t *w, int ox0, int ox1, int k,
+                            int stride, int pad, int iw) {
+  int ox, kx;
+  for (ox = ox0; ox < ox1; ox++) {
+    for (kx = 0; kx < k; kx++) {
+      const int ix = ox * stride - pad + kx;
+      if (ix >= 0 && ix < iw) {
+        acc[ox - x0] += x[ix] * w[kx];
+      }
+    }
+  }
+}
+
+// Output maps [n0, n1), map n being channel n % channels of sample
+// n / channels.
+static void depthwise_maps_int8(void *arg, int n0, int n1) {
+  rt_function_t *f = (rt_function_t *)arg;
+  depthwise_convolution_local_context_t *c =
+      (depthwise_convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  const int in_channels = p->in_var.shape.data[G];
+  const int multiplier = p->out_var.shape.data[I];
+  const int channels = in_channels * multiplier;
+  const int ih = p->input_shape.data[SPH];
+  const int iw = p->input_shape.data[SPW];
+  const int k = p->kernel_shape.data[SPH];
+  const int oh = p->output_shape.data[SPH];
+  const int ow = p->output_shape.data[SPW];
+  const int stride = c->stride.data[SPH];
+  const int ph = c->pad.data[SPH];
+  const int pw = c->pad.data[SPW];
+  const int map_size = oh * ow;
+  const int8_t *input = (const int8_t *)(p->in_var.v->data);
+  const int8_t *weight = (const int8_t *)(p->w_var.v->data);
+  const int8_t *bias = p->b_var.v ? (const int8_t *)(p->b_var.v->data) : 0;
+  int8_t *output = (int8_t *)(p->out_var.v->data);
+  const float y_coef = p->out_var.v->coefficient;
+  // Dividing by a power of two is the same as multiplying by its inverse.
+  const float y_scale = 1.0f / y_coef;
+  const float b_coef = bias ? p->b_var.v->coefficient : 0.0f;
+  const float sum_coef = p->in_var.v->coefficient * p->w_var.v->coefficient;
+  int32_t acc[DEPTHWISE_INT8_BLOCK];
+  // Output columns [begin, end) read no padding.
+  int begin = (pw + stride - 1) / stride;
+  int end = iw + pw - k < 0 ? 0 : (iw + pw - k) / stride + 1;
+  int n, oy, x0, x1, ky, i;
+
+  begin = begin < ow ? begin : ow;
+  end = end < ow ? end : ow;
+  end = end > begin ? end : begin;
+
+  for (n = n0; n < n1; n++) {
+    const int oc = n % channels;
+    const int8_t *x =
+        input + (n / channels * in_channels + oc / multiplier) * ih * iw;
+    const int8_t *w = weight + oc * k * k;
+    int8_t *y = output + n * map_size;
+
+    for (oy = 0; oy < oh; oy++) {
+      for (x0 = 0; x0 < ow; x0 = x1) {
+        // Interior columns of the block.
+        const int lo = begin > x0 ? begin : x0;
+        int hi;
+        x1 = x0 + DEPTHWISE_INT8_BLOCK < ow ? x0 + DEPTHWISE_INT8_BLOCK : ow;
+        hi = end < x1 ? end : x1;
+        hi = hi > lo ? hi : lo;
+        for (i = 0; i < x1 - x0; i++) {
+          acc[i] = 0;
+        }
+        for (ky = 0; ky < k; ky++) {
+          const int iy = oy * stride - ph + ky;
+          if (iy < 0 || iy >= ih) {
+            continue;
+          }
+          const int8_t *xr = x + iy * iw;
+          const int8_t *wr = w + ky * k;
+          int32_t *ai = acc + (lo - x0);
+          add_taps_border(acc, x0, xr, wr, x0, lo, k, stride, pw, iw);
+          if (hi > lo) {
+            const int8_t *xi = xr + lo * stride - pw;
+            if (k == 3 && stride == 1) {
+              add_taps_interior(ai, xi, wr, hi - lo, 3, 1);
+            } else if (k == 3) {
+              add_taps_interior(ai, xi, wr, hi - lo, 3, 2);
+            } else if (stride == 1) {
+              add_taps_interior(ai, xi, wr, hi - lo, 5, 1);
+            } else {
+              add_taps_interior(ai, xi, wr, hi - lo, 5, 2);
+            }
+          }
+          add_taps_border(acc, x0, xr, wr, hi, x1, k, stride, pw, iw);
+        }
+        // Quantized as exec_convolution_generic stores the sums through the
+        // int8 accessor, then again after adding the bias, so that the
+        // results match it bit-exactly.
+        for (i = 0; i < x1 - x0; i++) {
+          float o = 0.0f;
+          o += (float)acc[i] * sum_coef;
+          acc[i] = quantize_int8(o * y_scale);
+        }
+        if (bias) {
+          const float b = b_coef * bias[oc];
+          for (i = 0; i < x1 - x0; i++) {
+            float o = y_coef * acc[i];
+            o += b;
+            acc[i] = quantize_int8(o * y_scale);
+          }
+        }
+        for (i = 0; i < x1 - x0; i++) {
+          y[oy * ow + x0 + i] = (int8_t)acc[i];
+        }
+      }
+    }
+    add_and_activate_variable(&p->activation, p->out_var.v, p->residual,
+                              n * map_size, map_size);
+  }
+}
+
+rt_function_error_t exec_depthwise_convolution_int8_rows(rt_function_t *f) {
+  depthwise_convolution_local_context_t *c =
+      (depthwise_convolution_local_context_t *)(f->local_context);
+  convolution_private_t *p = (convolution_private_t *)(c->data);
+  parallel_for(f, p->out_var.shape.data[B] * p->out_var.shape.data[G] *
+                      p->out_var.shape.data[I],
+               depthwise_maps_int8, f);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+#endif /* CONFIG_DEPTHWISECONVOLUTION_FIXED8 */
@@ -0,0 +1,376 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "convolution_internal.h"
+
+#include "../../../utilities/shape.h"
+#include "../../../utilities/shared_cache.h"
+#include "../../normalization/batch_normalization_internal.h"
+
+#include <nnablart/config.h>
+#include <nnablart/functions.h>
+#include <string.h>
+
+#ifdef CONFIG_FUSEDCONVOLUTION
+
+#define X (0)      // x input
+#define WEIGHT (1) // weight
+#define Y0 (0)     // y0 output
+
+typedef struct {
+  rt_function_t conv;                  // Convolution computing y
+  convolution_local_context_t context; // local context of conv
+  rt_variable_t *conv_inputs[3];       // x, weight and bias of conv
+  rt_variable_t folded_weight; // weight with BatchNormalization folded in
+  rt_variable_t folded_bias;   // bias with BatchNormalization folded in
+  rt_variable_t *bn_inputs[4]; // beta, gamma, mean and variance, or 0
+  rt_variable_t *residual;     // z, or 0
+  rt_activation_t activation;  // nonlinearity
+  batch_normalization_shape_t shape; // y seen by BatchNormalization
+  float *buffer; // mean, variance, scale and shift per channel
+} fused_convolution_private_t;
+
+rt_function_error_t exec_fused_convolution_generic(rt_function_t *f);
+
+static rt_activation_t
+nonlinearity_to_activation(fused_convolution_nonlinearity_value_t n) {
+  // nonlinearity_args is not stored in nnb, its defaults are used.
+  rt_activation_t a = {RT_ACTIVATION_NONE, 0.0f};
+  switch (n) {
+  case FUSED_CONVOLUTION_NONLINEARITY_RELU:
+    a.type = RT_ACTIVATION_RELU;
+    break;
+  case FUSED_CONVOLUTION_NONLINEARITY_SIGMOID:
+    a.type = RT_ACTIVATION_SIGMOID;
+    break;
+  case FUSED_CONVOLUTION_NONLINEARITY_TANH:
+    a.type = RT_ACTIVATION_TANH;
+    break;
+  case FUSED_CONVOLUTION_NONLINEARITY_LEAKY_RELU:
+    a.type = RT_ACTIVATION_LEAKY_RELU;
+    a.alpha = 0.1f;
+    break;
+  case FUSED_CONVOLUTION_NONLINEARITY_ELU:
+    a.type = RT_ACTIVATION_ELU;
+    a.alpha = 1.0f;
+    break;
+  case FUSED_CONVOLUTION_NONLINEARITY_RELU6:
+    a.type = RT_ACTIVATION_RELU6;
+    break;
+  default:
+    break;
+  }
+  return a;
+}
+
+// Fold the running statistics into the weight and the bias, so that
+// Convolution alone computes the normalized y.
+static rt_function_error_t
+fold_batch_normalization(rt_function_t *f, fused_convolution_private_t *p,
+                         rt_variable_t *bias) {
+  fused_convolution_local_context_t *c =
+      (fused_convolution_local_context_t *)(f->local_context);
+  rt_variable_t *weight = f->inputs[WEIGHT];
+  rt_variable_t **bn = p->bn_inputs;
+  const int channels = weight->shape.data[0];
+  const int size = calc_shape_size(weight->shape);
+  const int kernel_size = size / channels;
+  float *mean = p->buffer;
+  float *var = mean + channels;
+  float *scale = var + channels;
+  float *shift = scale + channels;
+  int created, i;
+
+  if (channels != p->shape.channels) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
+  batch_normalization_statistics(&p->shape, 0, 0, 0.0f, bn[2], bn[3], mean,
+                                 var);
+  batch_normalization_scale_shift(channels, bn[0], bn[1], mean, var, c->eps,
+                                  scale, shift);
+
+  // Running statistics are parameters of an inference network, so contexts
+  // sharing the network share the folded parameters as well.
+  p->folded_weight = *weight;
+  p->folded_weight.type = NN_DATA_TYPE_FLOAT;
+  p->folded_weight.fp_pos = 0;
+  p->folded_weight.data =
+      shared_blob(f, bn[2]->data, SHARED_BLOB_FOLDED_WEIGHT,
+                  sizeof(float) * size, &created);
+  if (p->folded_weight.data == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  if (created) {
+    rt_variable_getter get_weight = select_getter(weight);
+    float *w = (float *)(p->folded_weight.data);
+    for (i = 0; i < size; i++) {
+      w[i] = get_weight(weight, i) * scale[i / kernel_size];
+    }
+  }
+
+  // The first dimension of the weight is the one of the bias.
+  p->folded_bias = p->folded_weight;
+  p->folded_bias.shape.size = 1;
+  p->folded_bias.data =
+      shared_blob(f, bn[2]->data, SHARED_BLOB_FOLDED_BIAS,
+                  sizeof(float) * channels, &created);
+  if (p->folded_bias.data == 0) {
+    free_shared_blob(f, p->folded_weight.data);
+    p->folded_weight.data = 0;
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  if (created) {
+    rt_variable_getter get_bias = bias ? select_getter(bias) : 0;
+    float *b = (float *)(p->folded_bias.data);
+    for (i = 0; i < channels; i++) {
+      b[i] = (bias ? get_bias(bias, i) * scale[i] : 0.0f) + shift[i];
+    }
+  }
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+// Convolution does all the work, BatchNormalization included, unless it
+// uses batch statistics. Those are known once y is complete, and a second
+// pass then normalizes y in place.
+static rt_function_error_t
+allocate_fused_convolution(rt_function_t *f, fused_convolution_private_t *p) {
+  fused_convolution_local_context_t *c =
+      (fused_convolution_local_context_t *)(f->local_context);
+  rt_variable_t *bias = 0;
+  int next = WEIGHT + 1;
+  int i;
+
+  // Optional inputs are told apart by their rank, bias is the only 1-D one.
+  if (next < f->num_of_inputs && f->inputs[next]->shape.size == 1) {
+    bias = f->inputs[next++];
+  }
+  if (f->num_of_inputs - next >= 4) {
+    for (i = 0; i < 4; i++) {
+      p->bn_inputs[i] = f->inputs[next++];
+    }
+  }
+  if (f->num_of_inputs - next == 1) {
+    p->residual = f->inputs[next++];
+  }
+  if (next != f->num_of_inputs || f->num_of_inputs < 2) {
+    return RT_FUNCTION_ERROR_INVALID_NUM_OF_INPUTS;
+  }
+  if (f->num_of_outputs != 1) {
+    return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
+  }
+
+  p->activation = nonlinearity_to_activation(c->nonlinearity);
+  if (p->activation.type == RT_ACTIVATION_NONE) {
+    p->activation = f->activation;
+  }
+
+  p->conv.num_of_inputs = 2;
+  p->conv.inputs = p->conv_inputs;
+  p->conv.num_of_outputs = 1;
+  p->conv.outputs = f->outputs;
+  p->conv.local_context = &p->context;
+  p->conv.parallel = f->parallel;
+  p->conv.shared_cache = f->shared_cache;
+  p->conv.cpu_features = f->cpu_features;
+  p->conv.variant = 0;
+  p->conv.activation = p->activation;
+  p->conv.channel_last = f->channel_last;
+  p->conv_inputs[0] = f->inputs[X];
+  p->conv_inputs[1] = f->inputs[WEIGHT];
+  p->conv_inputs[2] = bias;
+  if (bias) {
+    p->conv.num_of_inputs = 3;
+  }
+
+  if (p->bn_inputs[0]) {
+    rt_function_error_t ret = batch_normalization_shape(
+        f->outputs[Y0],
+        c->channel_last ? f->outputs[Y0]->shape.size - 1 : c->base_axis,
+        &p->shape);
+    if (ret != RT_FUNCTION_ERROR_NOERROR) {
+      return ret;
+    }
+    if (f->channel_last & RT_CHANNEL_LAST_OUTPUT) {
+      batch_normalization_channel_last(&p->shape);
+    }
+    for (i = 0; i < 4; i++) {
+      if (calc_shape_size(p->bn_inputs[i]->shape) != p->shape.channels) {
+        return RT_FUNCTION_ERROR_INVALID_SHAPE;
+      }
+    }
+    p->buffer = rt_function_malloc(f, sizeof(float) * 4 * p->shape.channels);
+    if (p->buffer == 0) {
+      return RT_FUNCTION_ERROR_MALLOC;
+    }
+    if (c->batch_stat) {
+      p->conv.activation.type = RT_ACTIVATION_NONE;
+    } else {
+      ret = fold_batch_normalization(f, p, bias);
+      if (ret != RT_FUNCTION_ERROR_NOERROR) {
+        return ret;
+      }
+      p->conv.num_of_inputs = 3;
+      p->conv_inputs[1] = &p->folded_weight;
+      p->conv_inputs[2] = &p->folded_bias;
+    }
+  }
+
+  p->context.base_axis = c->base_axis;
+  p->context.pad = c->pad;
+  p->context.stride = c->stride;
+  p->context.dilation = c->dilation;
+  p->context.group = c->group;
+  p->context.channel_last = c->channel_last;
+  p->context.data = 0;
+  return allocate_convolution_local_context_common(&p->conv, X, WEIGHT,
+                                                   WEIGHT + 1, -1, Y0);
+}
+
+// FusedConvolution
+rt_function_error_t allocate_fused_convolution_local_context(rt_function_t *f) {
+  fused_convolution_local_context_t *c =
+      (fused_convolution_local_context_t *)(f->local_context);
+
+#ifdef CONFIG_FUSEDCONVOLUTION_FLOAT32
+  f->exec_func = exec_fused_convolution;
+#endif /* CONFIG_FUSEDCONVOLUTION_FLOAT32 */
+
+  fused_convolution_private_t *p =
+      rt_function_malloc(f, sizeof(fused_convolution_private_t));
+  if (p == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  memset(p, 0, sizeof(fused_convolution_private_t));
+  c->data = (void *)p;
+
+  rt_function_error_t ret = allocate_fused_convolution(f, p);
+  if (ret != RT_FUNCTION_ERROR_NOERROR) {
+    return ret;
+  }
+  if (!c->batch_stat || p->bn_inputs[0] == 0) {
+    convolution_private_t *cp = (convolution_private_t *)(p->context.data);
+    cp->residual = p->residual;
+  }
+
+  int is_float = f->outputs[Y0]->type == NN_DATA_TYPE_FLOAT;
+  for (int i = 0; i < p->conv.num_of_inputs; i++) {
+    if (p->conv.inputs[i]->type != NN_DATA_TYPE_FLOAT) {
+      is_float = 0;
+    }
+  }
+  convolution_private_t *cp = (convolution_private_t *)(p->context.data);
+  if (cp->in_channel_last || cp->out_channel_last) {
+#ifdef CONFIG_FUSEDCONVOLUTION_FLOAT32
+    if (is_float) {
+      ret = allocate_convolution_channel_last_context(&p->conv);
+      f->variant = p->conv.variant;
+      return ret;
+    }
+#endif /* CONFIG_FUSEDCONVOLUTION_FLOAT32 */
+    return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+  }
+  // The int8 and int16 kernels assume that x, weight and y have the same
+  // type, which folding breaks, so other types take the generic kernel.
+#ifdef CONFIG_FUSEDCONVOLUTION_FLOAT32
+  if (is_float) {
+    p->conv.exec_func = exec_convolution_float;
+    p->conv.variant = "direct";
+    ret = allocate_convolution_float_pointwise_context(&p->conv);
+    if (ret == RT_FUNCTION_ERROR_NOERROR &&
+        p->conv.exec_func == exec_convolution_float) {
+      ret = allocate_convolution_float_winograd_context(&p->conv);
+    }
+    if (ret == RT_FUNCTION_ERROR_NOERROR &&
+        p->conv.exec_func == exec_convolution_float) {
+      ret = allocate_convolution_float_im2col_context(&p->conv);
+    }
+    f->variant = p->conv.variant;
+    return ret;
+  }
+#endif /* CONFIG_FUSEDCONVOLUTION_FLOAT32 */
+#ifdef CONFIG_FUSEDCONVOLUTION_GENERIC
+  if (!is_float) {
+    f->exec_func = exec_fused_convolution_generic;
+    f->variant = "generic";
+    p->conv.exec_func = exec_convolution_generic;
+  }
+#endif /* CONFIG_FUSEDCONVOLUTION_GENERIC */
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+rt_function_error_t free_fused_convolution_local_context(rt_function_t *f) {
+  fused_convolution_local_context_t *c =
+      (fused_convolution_local_context_t *)(f->local_context);
+  fused_convolution_private_t *p = (fused_convolution_private_t *)(c->data);
+
+  if (p->context.data != 0) {
+    free_convolution_local_context_common(&p->conv);
+  }
+  if (p->folded_weight.data != 0) {
+    free_shared_blob(f, p->folded_weight.data);
+    free_shared_blob(f, p->folded_bias.data);
+  }
+  if (p->buffer != 0) {
+    rt_function_free(f, p->buffer);
+  }
+  rt_function_free(f, p);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+#if defined(CONFIG_FUSEDCONVOLUTION_FLOAT32) ||                                \
+    defined(CONFIG_FUSEDCONVOLUTION_GENERIC)
+static rt_function_error_t forward_impl(rt_function_t *f) {
+  fused_convolution_local_context_t *c =
+      (fused_convolution_local_context_t *)(f->local_context);
+  fused_convolution_private_t *p = (fused_convolution_private_t *)(c->data);
+
+  if (p->conv.exec_func == 0) {
+    return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+  }
+  // The runtime may switch the executor between runs.
+  p->conv.parallel = f->parallel;
+  rt_function_error_t ret = p->conv.exec_func(&p->conv);
+  if (ret != RT_FUNCTION_ERROR_NOERROR || !c->batch_stat ||
+      p->bn_inputs[0] == 0) {
+    return ret;
+  }
+
+  rt_variable_t **bn = p->bn_inputs;
+  float *mean = p->buffer;
+  float *var = mean + p->shape.channels;
+  float *scale = var + p->shape.channels;
+  float *shift = scale + p->shape.channels;
+  batch_normalization_statistics(&p->shape, f->outputs[Y0], 1, c->decay_rate,
+                                 bn[2], bn[3], mean, var);
+  batch_normalization_scale_shift(p->shape.channels, bn[0], bn[1], mean, var,
+                                  c->eps, scale, shift);
+  batch_normalization_apply(&p->shape, f->outputs[Y0], scale, shift,
+                            p->residual, &p->activation, f->outputs[Y0]);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+#endif
+
+#ifdef CONFIG_FUSEDCONVOLUTION_FLOAT32
+rt_function_error_t exec_fused_convolution(rt_function_t *f) {
+  return forward_impl(f);
+}
+#endif /* CONFIG_FUSEDCONVOLUTION_FLOAT32 */
+
+#ifdef CONFIG_FUSEDCONVOLUTION_GENERIC
+rt_function_error_t exec_fused_convolution_generic(rt_function_t *f) {
+  return forward_impl(f);
+}
+#endif /* CONFIG_FUSEDCONVOLUTION_GENERIC */
+
+#endif /* CONFIG_FUSEDCONVOLUTION */
@@ -16,6 +16,7 @@
 #include <nnablart/functions.h>
 
 #include "../../utilities/accessor.h"
+#include "../../utilities/activation.h"
 #include "../../utilities/shape.h"
 #include <string.h>
 
@@ -38,11 +39,11 @@ typedef struct {
   rt_list_t input_shape;
   rt_list_t output_shape;
   rt_list_t kernel_shape;
-  rt_list_t in_position;
-  rt_list_t out_position;
 
   int spatial_dims;
   int base_loop_size;
+
+  rt_activation_t activation; // epilogue fused by the runtime
 } deconvolution_private_t;
 
 rt_function_error_t exec_deconvolution_generic(rt_function_t *f);
@@ -60,7 +61,12 @@ rt_function_error_t allocate_deconvolution_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
 
-  deconvolution_private_t *p = rt_malloc_func(sizeof(deconvolution_private_t));
+  if (f->inputs[0]->shape.size - c->base_axis - 1 > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
+
+  deconvolution_private_t *p =
+      rt_function_malloc(f, sizeof(deconvolution_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -81,6 +87,7 @@ rt_function_error_t allocate_deconvolution_local_context(rt_function_t *f) {
   } else {
     p->bias = 0;
   }
+  p->activation = f->activation;
 
   p->base_loop_size = 1;
   for (int i = 0; i < c->base_axis; i++) {
@@ -88,11 +95,9 @@ rt_function_error_t allocate_deconvolution_local_context(rt_function_t *f) {
   }
   p->spatial_dims = p->input->shape.size - c->base_axis - 1;
 
-  p->input_shape = allocate_list(p->spatial_dims);
-  p->kernel_shape = allocate_list(p->spatial_dims);
-  p->output_shape = allocate_list(p->spatial_dims);
-  p->in_position = allocate_list(p->spatial_dims);
-  p->out_position = allocate_list(p->spatial_dims);
+  p->input_shape = allocate_list(f, p->spatial_dims);
+  p->kernel_shape = allocate_list(f, p->spatial_dims);
+  p->output_shape = allocate_list(f, p->spatial_dims);
 
   for (int i = 0; i < p->spatial_dims; i++) {
     p->kernel_shape.data[i] = p->weight->shape.data[i + 2];
@@ -119,12 +124,10 @@ rt_function_error_t free_deconvolution_local_context(rt_function_t *f) {
   deconvolution_local_context_t *c =
       (deconvolution_local_context_t *)(f->local_context);
   deconvolution_private_t *p = (deconvolution_private_t *)(c->data);
-  free_list(p->input_shape);
-  free_list(p->output_shape);
-  free_list(p->kernel_shape);
-  free_list(p->in_position);
-  free_list(p->out_position);
-  rt_free_func(p);
+  free_list(f, p->input_shape);
+  free_list(f, p->output_shape);
+  free_list(f, p->kernel_shape);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -133,6 +136,8 @@ rt_function_error_t exec_deconvolution(rt_function_t *f) {
   deconvolution_local_context_t *c =
       (deconvolution_local_context_t *)(f->local_context);
   deconvolution_private_t *p = (deconvolution_private_t *)(c->data);
+  STACK_LIST(in_position, p->spatial_dims);
+  STACK_LIST(out_position, p->spatial_dims);
 
   int output_size = calc_shape_size(p->output_shape);
   int kernel_size = calc_shape_size(p->kernel_shape);
@@ -156,31 +161,31 @@ rt_function_error_t exec_deconvolution(rt_function_t *f) {
                               kernel_size;
           for (int o = 0; o < output_size; o++) {
             float sum = 0.0f;
-            pos_to_shape(p->out_position, p->output_shape, o);
+            pos_to_shape(out_position, p->output_shape, o);
             for (int k = 0; k < kernel_size; k++) {
-              pos_to_shape(p->in_position, p->kernel_shape, k);
+              pos_to_shape(in_position, p->kernel_shape, k);
               uint8_t condition = 1;
               for (int j = 0; j < p->spatial_dims; j++) {
                 int k1 =
                     c->dilation.data[j] * (p->kernel_shape.data[j] - 1) + 1;
-                p->in_position.data[j] *= c->dilation.data[j];
-                p->in_position.data[j] -= k1 - c->pad.data[j] - 1;
-                p->in_position.data[j] += p->out_position.data[j];
-                if (p->in_position.data[j] % c->stride.data[j] != 0) {
+                in_position.data[j] *= c->dilation.data[j];
+                in_position.data[j] -= k1 - c->pad.data[j] - 1;
+                in_position.data[j] += out_position.data[j];
+                if (in_position.data[j] % c->stride.data[j] != 0) {
                   condition = 0;
                   break;
                 }
-                p->in_position.data[j] =
-                    p->in_position.data[j] / c->stride.data[j];
-                if (p->in_position.data[j] < 0 ||
-                    p->in_position.data[j] >= p->input_shape.data[j]) {
+                in_position.data[j] =
+                    in_position.data[j] / c->stride.data[j];
+                if (in_position.data[j] < 0 ||
+                    in_position.data[j] >= p->input_shape.data[j]) {
                   condition = 0;
                   break;
                 }
               }
               if (condition) {
                 float x = *((float *)(p->input->data) + input_offset +
-                            shape_to_pos(p->input_shape, p->in_position));
+                            shape_to_pos(p->input_shape, in_position));
                 float w = *((float *)(p->weight->data) + kernel_offset +
                             (kernel_size - k - 1));
                 sum += x * w;
@@ -195,6 +200,9 @@ rt_function_error_t exec_deconvolution(rt_function_t *f) {
                 *((float *)(p->bias->data) + g * p->weight->shape.data[1] + om);
           }
         }
+        activate_floats(&p->activation,
+                        (float *)(p->output->data) + output_offset,
+                        output_size);
       }
     }
   }
@@ -208,6 +216,8 @@ rt_function_error_t exec_deconvolution_generic(rt_function_t *f) {
   deconvolution_local_context_t *c =
       (deconvolution_local_context_t *)(f->local_context);
   deconvolution_private_t *p = (deconvolution_private_t *)(c->data);
+  STACK_LIST(in_position, p->spatial_dims);
+  STACK_LIST(out_position, p->spatial_dims);
 
   int output_size = calc_shape_size(p->output_shape);
   int kernel_size = calc_shape_size(p->kernel_shape);
@@ -231,24 +241,24 @@ rt_function_error_t exec_deconvolution_generic(rt_function_t *f) {
                               kernel_size;
           for (int o = 0; o < output_size; o++) {
             float sum = 0.0f;
-            pos_to_shape(p->out_position, p->output_shape, o);
+            pos_to_shape(out_position, p->output_shape, o);
             for (int k = 0; k < kernel_size; k++) {
-              pos_to_shape(p->in_position, p->kernel_shape, k);
+              pos_to_shape(in_position, p->kernel_shape, k);
               uint8_t condition = 1;
               for (int j = 0; j < p->spatial_dims; j++) {
                 int k1 =
                     c->dilation.data[j] * (p->kernel_shape.data[j] - 1) + 1;
-                p->in_position.data[j] *= c->dilation.data[j];
-                p->in_position.data[j] -= k1 - c->pad.data[j] - 1;
-                p->in_position.data[j] += p->out_position.data[j];
-                if (p->in_position.data[j] % c->stride.data[j] != 0) {
+                in_position.data[j] *= c->dilation.data[j];
+                in_position.data[j] -= k1 - c->pad.data[j] - 1;
+                in_position.data[j] += out_position.data[j];
+                if (in_position.data[j] % c->stride.data[j] != 0) {
                   condition = 0;
                   break;
                 }
-                p->in_position.data[j] =
-                    p->in_position.data[j] / c->stride.data[j];
-                if (p->in_position.data[j] < 0 ||
-                    p->in_position.data[j] >= p->input_shape.data[j]) {
+                in_position.data[j] =
+                    in_position.data[j] / c->stride.data[j];
+                if (in_position.data[j] < 0 ||
+                    in_position.data[j] >= p->input_shape.data[j]) {
                   condition = 0;
                   break;
                 }
@@ -256,7 +266,7 @@ rt_function_error_t exec_deconvolution_generic(rt_function_t *f) {
               if (condition) {
                 float x = p->get_input(
                     p->input, input_offset +
-                                  shape_to_pos(p->input_shape, p->in_position));
+                                  shape_to_pos(p->input_shape, in_position));
                 float w = p->get_weight(p->weight,
                                         kernel_offset + (kernel_size - k - 1));
                 sum += x * w;
@@ -276,6 +286,8 @@ rt_function_error_t exec_deconvolution_generic(rt_function_t *f) {
             p->set_output(p->output, output_offset + o, y);
           }
         }
+        activate_variable(&p->activation, p->output, output_offset,
+                          output_size);
       }
     }
   }
@@ -24,9 +24,9 @@
 rt_function_error_t allocate_max_pooling_local_context(rt_function_t *f) {
   max_pooling_local_context_t *context =
       (max_pooling_local_context_t *)(f->local_context);
-  pooling_private_t *p = rt_malloc_func(sizeof(pooling_private_t));
+  pooling_private_t *p = rt_function_malloc(f, sizeof(pooling_private_t));
   rt_function_error_t ret =
-      allocate_pooling(f, (pooling_context_t *)context, p);
+      allocate_pooling(f, (pooling_context_t *)context, POOLING_MAX, p);
   ((max_pooling_local_context_t *)(f->local_context))->data = (void *)p;
   f->exec_func = exec_max_pooling;
   return ret;
@@ -36,7 +36,7 @@ rt_function_error_t free_max_pooling_local_context(rt_function_t *f) {
   pooling_private_t *p =
       (pooling_private_t *)(((max_pooling_local_context_t *)(f->local_context))
                                 ->data);
-  return free_pooling(p);
+  return free_pooling(f, p);
 }
 
 rt_function_error_t exec_max_pooling(rt_function_t *f) {
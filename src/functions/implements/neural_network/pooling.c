@@ -13,20 +13,40 @@
 // limitations under the License.
 
 #include "pooling.h"
+#include "../../utilities/parallel.h"
 #include "../../utilities/shape.h"
 #include <math.h>
 
 rt_function_error_t allocate_pooling(rt_function_t *f,
                                      pooling_context_t *context,
-                                     pooling_private_t *p) {
+                                     pooling_op_t op, pooling_private_t *p) {
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
-  p->input_shape = clone_list(f->inputs[0]->shape);
-  p->output_shape = clone_list(f->outputs[0]->shape);
-  p->input_n_kernel_size_diff = p->input_shape.size - context->kernel.size;
+  p->input_shape = clone_list(f, f->inputs[0]->shape);
+  p->output_shape = clone_list(f, f->outputs[0]->shape);
+  p->op = op;
+  // With the channel_last attribute the channels follow the pooled axes,
+  // otherwise the runtime may store them so.
+  p->input_n_kernel_size_diff = p->input_shape.size - context->kernel.size -
+                                (context->channel_last ? 1 : 0);
+  p->in_channel_last =
+      context->channel_last || (f->channel_last & RT_CHANNEL_LAST_INPUT);
+  p->out_channel_last =
+      context->channel_last || (f->channel_last & RT_CHANNEL_LAST_OUTPUT);
+  if (p->in_channel_last || p->out_channel_last) {
+    const int axis = context->channel_last ? p->input_shape.size - 1
+                                           : p->input_n_kernel_size_diff - 1;
+    if (context->kernel.size != 2 || axis < 0) {
+      return RT_FUNCTION_ERROR_UNIMPLEMENTED;
+    }
+    p->channels = p->input_shape.data[axis];
+    f->variant = "channel_last";
+  } else {
+    p->channels = 1;
+  }
   if (context->stride.size == 0) {
-    context->stride = clone_list(context->kernel);
+    context->stride = clone_list(f, context->kernel);
   } else {
     if (context->kernel.size != context->stride.size) {
       return RT_FUNCTION_ERROR_INVALID_SHAPE;
@@ -43,7 +63,7 @@ rt_function_error_t allocate_pooling(rt_function_t *f,
   }
 
   // Calc and set output shape.
-  rt_list_t shape = allocate_list(context->kernel.size);
+  rt_list_t shape = allocate_list(f, context->kernel.size);
   int i;
   for (i = 0; i < shape.size; i++) {
     int _w = p->input_shape.data[i + p->input_n_kernel_size_diff];
@@ -53,17 +73,18 @@ rt_function_error_t allocate_pooling(rt_function_t *f,
     shape.data[i] = (_w + _p - (context->ignore_border ? _k - _p : 1)) / _s + 1;
   }
   for (i = 0; i < p->input_shape.size; i++) {
-    if (i < p->input_n_kernel_size_diff) {
+    if (i < p->input_n_kernel_size_diff ||
+        i >= p->input_n_kernel_size_diff + context->kernel.size) {
       p->output_shape.data[i] = p->input_shape.data[i];
     } else {
       p->output_shape.data[i] = shape.data[i - p->input_n_kernel_size_diff];
     }
   }
-  free_list(shape);
+  free_list(f, shape);
 
   // Calc x_map_size and y_map_size.
-  p->input_strides = calc_contiguous_strides(f->inputs[0]->shape);
-  p->output_strides = calc_contiguous_strides(f->outputs[0]->shape);
+  p->input_strides = calc_contiguous_strides(f, f->inputs[0]->shape);
+  p->output_strides = calc_contiguous_strides(f, f->outputs[0]->shape);
   p->x_map_size = (p->input_n_kernel_size_diff == 0)
                       ? calc_shape_size(f->inputs[0]->shape)
                       : p->input_strides.data[p->input_n_kernel_size_diff - 1];
@@ -83,24 +104,37 @@ rt_function_error_t allocate_pooling(rt_function_t *f,
   p->calc_context.get_x = select_getter(p->calc_context.x);
   p->calc_context.y = f->outputs[0];
   p->calc_context.set_y = select_setter(p->calc_context.y);
-  p->calc_context.including_pad = context->including_pad;
+  p->calc_context.including_pad =
+      op == POOLING_AVERAGE ? context->including_pad : 0;
 
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
-rt_function_error_t free_pooling(pooling_private_t *p) {
-  free_list(p->input_shape);
-  free_list(p->output_shape);
-  free_list(p->input_strides);
-  free_list(p->output_strides);
-  rt_free_func(p);
+rt_function_error_t free_pooling(rt_function_t *f, pooling_private_t *p) {
+  free_list(f, p->input_shape);
+  free_list(f, p->output_shape);
+  free_list(f, p->input_strides);
+  free_list(f, p->output_strides);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
-rt_function_error_t exec_pooling(rt_function_t *f, pooling_context_t *context,
-                                 pooling_private_t *p,
-                                 exec_pooling_func_t exec) {
-  float *y = (float *)(p->calc_context.y->data);
+typedef struct {
+  rt_function_t *f;
+  pooling_context_t *context;
+  pooling_private_t *p;
+  exec_pooling_func_t exec;
+  int generic;
+} pooling_maps_t;
+
+// Pooling of maps [n0, n1).
+// calc_context is copied so that ranges can run concurrently.
+static void pooling_maps(void *arg, int n0, int n1) {
+  pooling_maps_t *m = (pooling_maps_t *)arg;
+  pooling_context_t *context = m->context;
+  pooling_private_t *p = m->p;
+  pooling_calc_context_t calc = p->calc_context;
+  float *y = (float *)(calc.y->data);
   const int hx = p->input_shape.data[p->input_n_kernel_size_diff + 0];
   const int wx = p->input_shape.data[p->input_n_kernel_size_diff + 1];
   const int hy = p->output_shape.data[p->input_n_kernel_size_diff + 0];
@@ -111,34 +145,36 @@ rt_function_error_t exec_pooling(rt_function_t *f, pooling_context_t *context,
   const int wstride = context->stride.data[1];
   const int hpad = context->pad.data[0];
   const int wpad = context->pad.data[1];
-  const int n_map = calc_shape_size(f->inputs[0]->shape) / p->x_map_size;
-  p->calc_context.offset_x = 0;
-  p->calc_context.offset_y = 0;
-  p->calc_context.kernel_size = context->kernel.size;
+  calc.offset_x = n0 * p->x_map_size;
+  calc.offset_y = n0 * p->y_map_size;
+  calc.kernel_size = context->kernel.size;
 
   if (context->kernel.size == 2) {
-    for (int n = 0; n < n_map; n++) {
+    for (int n = n0; n < n1; n++) {
       for (int iy = 0; iy < hy; iy++) {
         for (int jy = 0; jy < wy; jy++) {
           int hstart = iy * hstride - hpad;
           int wstart = jy * wstride - wpad;
           int hend = (int)fminf((float)(hstart + hkernel), (float)(hx + hpad));
           int wend = (int)fminf((float)(wstart + wkernel), (float)(wx + wpad));
-          p->calc_context.pool_size = (hend - hstart) * (wend - wstart);
-          p->calc_context.hstart = (int)fmaxf((float)hstart, 0);
-          p->calc_context.wstart = (int)fmaxf((float)wstart, 0);
-          p->calc_context.hend = (int)fminf((float)hend, (float)hx);
-          p->calc_context.wend = (int)fminf((float)wend, (float)wx);
-          p->calc_context.hstride =
-              p->input_strides.data[p->input_n_kernel_size_diff + 0];
+          calc.pool_size = (hend - hstart) * (wend - wstart);
+          calc.hstart = (int)fmaxf((float)hstart, 0);
+          calc.wstart = (int)fmaxf((float)wstart, 0);
+          calc.hend = (int)fminf((float)hend, (float)hx);
+          calc.wend = (int)fminf((float)wend, (float)wx);
+          calc.hstride = p->input_strides.data[p->input_n_kernel_size_diff + 0];
           int k =
               iy * p->output_strides.data[p->input_n_kernel_size_diff + 0] + jy;
-          float val = exec(p->calc_context);
-          *(y + k + p->calc_context.offset_y) = val;
+          float val = m->exec(calc);
+          if (m->generic) {
+            calc.set_y(calc.y, k + calc.offset_y, val);
+          } else {
+            *(y + k + calc.offset_y) = val;
+          }
         }
       }
-      p->calc_context.offset_x += p->x_map_size;
-      p->calc_context.offset_y += p->y_map_size;
+      calc.offset_x += p->x_map_size;
+      calc.offset_y += p->y_map_size;
     }
   } else if (context->kernel.size == 3) {
     const int dx = p->input_shape.data[p->input_n_kernel_size_diff + 2];
@@ -147,7 +183,7 @@ rt_function_error_t exec_pooling(rt_function_t *f, pooling_context_t *context,
     const int dstride = context->stride.data[2];
     const int dpad = context->pad.data[2];
 
-    for (int n = 0; n < n_map; n++) {
+    for (int n = n0; n < n1; n++) {
       for (int iy = 0; iy < hy; iy++) {
         for (int jy = 0; jy < wy; jy++) {
           for (int ky = 0; ky < dy; ky++) {
@@ -160,38 +196,55 @@ rt_function_error_t exec_pooling(rt_function_t *f, pooling_context_t *context,
                 (int)fminf((float)(wstart + wkernel), (float)(wx + wpad));
             int dend =
                 (int)fminf((float)(dstart + dkernel), (float)(dx + dpad));
-            p->calc_context.pool_size =
+            calc.pool_size =
                 (hend - hstart) * (wend - wstart) * (dend - dstart);
-            p->calc_context.hstart = (int)fmaxf((float)hstart, 0);
-            p->calc_context.wstart = (int)fmaxf((float)wstart, 0);
-            p->calc_context.dstart = (int)fmaxf((float)dstart, 0);
-            p->calc_context.hend = (int)fminf((float)hend, (float)hx);
-            p->calc_context.wend = (int)fminf((float)wend, (float)wx);
-            p->calc_context.dend = (int)fminf((float)dend, (float)dx);
-            p->calc_context.hstride =
+            calc.hstart = (int)fmaxf((float)hstart, 0);
+            calc.wstart = (int)fmaxf((float)wstart, 0);
+            calc.dstart = (int)fmaxf((float)dstart, 0);
+            calc.hend = (int)fminf((float)hend, (float)hx);
+            calc.wend = (int)fminf((float)wend, (float)wx);
+            calc.dend = (int)fminf((float)dend, (float)dx);
+            calc.hstride =
                 p->input_strides.data[p->input_n_kernel_size_diff + 0];
-            p->calc_context.wstride =
+            calc.wstride =
                 p->input_strides.data[p->input_n_kernel_size_diff + 1];
             int k =
                 iy * p->output_strides.data[p->input_n_kernel_size_diff + 0] +
                 jy * p->output_strides.data[p->input_n_kernel_size_diff + 1] +
                 ky;
-            float val = exec(p->calc_context);
-            *(y + k + p->calc_context.offset_y) = val;
+            float val = m->exec(calc);
+            if (m->generic) {
+              calc.set_y(calc.y, k + calc.offset_y, val);
+            } else {
+              *(y + k + calc.offset_y) = val;
+            }
           }
         }
       }
-      p->calc_context.offset_x += p->x_map_size;
-      p->calc_context.offset_y += p->y_map_size;
+      calc.offset_x += p->x_map_size;
+      calc.offset_y += p->y_map_size;
     }
   }
-  return RT_FUNCTION_ERROR_NOERROR;
 }
 
-rt_function_error_t exec_pooling_generic(rt_function_t *f,
-                                         pooling_context_t *context,
-                                         pooling_private_t *p,
-                                         exec_pooling_func_t exec) {
+// Channels pooled at once by pooling_rows_channel_last.
+#define POOLING_CHANNEL_BLOCK (64)
+
+// Pooling of output rows [r0, r1) of channel last x or y, where row r is
+// row r % hy of map r / hy. The channels of a pixel are pooled together,
+// each of them as calc_max, calc_sum or calc_average and their generic
+// versions do.
+static void pooling_rows_channel_last(void *arg, int r0, int r1) {
+  pooling_maps_t *m = (pooling_maps_t *)arg;
+  pooling_context_t *context = m->context;
+  pooling_private_t *p = m->p;
+  rt_variable_t *x = p->calc_context.x;
+  rt_variable_t *y = p->calc_context.y;
+  rt_variable_getter get_x = p->calc_context.get_x;
+  rt_variable_setter set_y = p->calc_context.set_y;
+  const float *xf = (const float *)(x->data);
+  float *yf = (float *)(y->data);
+  const int channels = p->channels;
   const int hx = p->input_shape.data[p->input_n_kernel_size_diff + 0];
   const int wx = p->input_shape.data[p->input_n_kernel_size_diff + 1];
   const int hy = p->output_shape.data[p->input_n_kernel_size_diff + 0];
@@ -202,82 +255,124 @@ rt_function_error_t exec_pooling_generic(rt_function_t *f,
   const int wstride = context->stride.data[1];
   const int hpad = context->pad.data[0];
   const int wpad = context->pad.data[1];
-  const int n_map = calc_shape_size(f->inputs[0]->shape) / p->x_map_size;
-  p->calc_context.offset_x = 0;
-  p->calc_context.offset_y = 0;
-  p->calc_context.kernel_size = context->kernel.size;
+  // Distance of the channels and of the pixels of x and y.
+  const int xcs = p->in_channel_last ? 1 : hx * wx;
+  const int xps = p->in_channel_last ? channels : 1;
+  const int ycs = p->out_channel_last ? 1 : hy * wy;
+  const int yps = p->out_channel_last ? channels : 1;
+  float acc[POOLING_CHANNEL_BLOCK];
+  int r, jy, ix, jx, c0, c;
 
-  if (context->kernel.size == 2) {
-    for (int n = 0; n < n_map; n++) {
-      for (int iy = 0; iy < hy; iy++) {
-        for (int jy = 0; jy < wy; jy++) {
-          int hstart = iy * hstride - hpad;
-          int wstart = jy * wstride - wpad;
-          int hend = (int)fminf((float)(hstart + hkernel), (float)(hx + hpad));
-          int wend = (int)fminf((float)(wstart + wkernel), (float)(wx + wpad));
-          p->calc_context.pool_size = (hend - hstart) * (wend - wstart);
-          p->calc_context.hstart = (int)fmaxf((float)hstart, 0);
-          p->calc_context.wstart = (int)fmaxf((float)wstart, 0);
-          p->calc_context.hend = (int)fminf((float)hend, (float)hx);
-          p->calc_context.wend = (int)fminf((float)wend, (float)wx);
-          p->calc_context.hstride =
-              p->input_strides.data[p->input_n_kernel_size_diff + 0];
-          int k =
-              iy * p->output_strides.data[p->input_n_kernel_size_diff + 0] + jy;
-          float val = exec(p->calc_context);
-          p->calc_context.set_y(p->calc_context.y, k + p->calc_context.offset_y,
-                                val);
-        }
+  for (r = r0; r < r1; r++) {
+    const int iy = r % hy;
+    const int xn = r / hy * channels * hx * wx;
+    const int yn = r / hy * channels * hy * wy;
+    for (jy = 0; jy < wy; jy++) {
+      int hstart = iy * hstride - hpad;
+      int wstart = jy * wstride - wpad;
+      int hend = (int)fminf((float)(hstart + hkernel), (float)(hx + hpad));
+      int wend = (int)fminf((float)(wstart + wkernel), (float)(wx + wpad));
+      int pool_size = (hend - hstart) * (wend - wstart);
+      hstart = (int)fmaxf((float)hstart, 0);
+      wstart = (int)fmaxf((float)wstart, 0);
+      hend = (int)fminf((float)hend, (float)hx);
+      wend = (int)fminf((float)wend, (float)wx);
+      if (!p->calc_context.including_pad) {
+        pool_size = (hend - hstart) * (wend - wstart);
       }
-      p->calc_context.offset_x += p->x_map_size;
-      p->calc_context.offset_y += p->y_map_size;
-    }
-  } else if (context->kernel.size == 3) {
-    const int dx = p->input_shape.data[p->input_n_kernel_size_diff + 2];
-    const int dy = p->output_shape.data[p->input_n_kernel_size_diff + 2];
-    const int dkernel = context->kernel.data[2];
-    const int dstride = context->stride.data[2];
-    const int dpad = context->pad.data[2];
+      const int y0 = yn + (iy * wy + jy) * yps;
 
-    for (int n = 0; n < n_map; n++) {
-      for (int iy = 0; iy < hy; iy++) {
-        for (int jy = 0; jy < wy; jy++) {
-          for (int ky = 0; ky < dy; ky++) {
-            int hstart = iy * hstride - hpad;
-            int wstart = jy * wstride - wpad;
-            int dstart = ky * dstride - dpad;
-            int hend =
-                (int)fminf((float)(hstart + hkernel), (float)(hx + hpad));
-            int wend =
-                (int)fminf((float)(wstart + wkernel), (float)(wx + wpad));
-            int dend =
-                (int)fminf((float)(dstart + dkernel), (float)(dx + dpad));
-            p->calc_context.pool_size =
-                (hend - hstart) * (wend - wstart) * (dend - dstart);
-            p->calc_context.hstart = (int)fmaxf((float)hstart, 0);
-            p->calc_context.wstart = (int)fmaxf((float)wstart, 0);
-            p->calc_context.dstart = (int)fmaxf((float)dstart, 0);
-            p->calc_context.hend = (int)fminf((float)hend, (float)hx);
-            p->calc_context.wend = (int)fminf((float)wend, (float)wx);
-            p->calc_context.dend = (int)fminf((float)dend, (float)dx);
-            p->calc_context.hstride =
-                p->input_strides.data[p->input_n_kernel_size_diff + 0];
-            p->calc_context.wstride =
-                p->input_strides.data[p->input_n_kernel_size_diff + 1];
-            int k =
-                iy * p->output_strides.data[p->input_n_kernel_size_diff + 0] +
-                jy * p->output_strides.data[p->input_n_kernel_size_diff + 1] +
-                ky;
-            float val = exec(p->calc_context);
-            p->calc_context.set_y(p->calc_context.y,
-                                  k + p->calc_context.offset_y, val);
+      for (c0 = 0; c0 < channels; c0 += POOLING_CHANNEL_BLOCK) {
+        const int nc = channels - c0 < POOLING_CHANNEL_BLOCK
+                           ? channels - c0
+                           : POOLING_CHANNEL_BLOCK;
+        const int x0 = xn + c0 * xcs;
+        // Float max starts from the first element of the window.
+        for (c = 0; c < nc; c++) {
+          acc[c] = (p->op == POOLING_MAX && !m->generic && hstart < hend &&
+                    wstart < wend)
+                       ? xf[x0 + (hstart * wx + wstart) * xps + c * xcs]
+                       : 0.0f;
+        }
+        for (ix = hstart; ix < hend; ix++) {
+          for (jx = wstart; jx < wend; jx++) {
+            const int i = x0 + (ix * wx + jx) * xps;
+            if (m->generic) {
+              for (c = 0; c < nc; c++) {
+                float val = get_x(x, i + c * xcs);
+                if (p->op != POOLING_MAX) {
+                  acc[c] += val;
+                } else if (acc[c] < val) {
+                  acc[c] = val;
+                }
+              }
+            } else if (p->op == POOLING_MAX) {
+              for (c = 0; c < nc; c++) {
+                float val = xf[i + c * xcs];
+                acc[c] = acc[c] < val ? val : acc[c];
+              }
+            } else {
+              for (c = 0; c < nc; c++) {
+                acc[c] += xf[i + c * xcs];
+              }
+            }
+          }
+        }
+        for (c = 0; c < nc; c++) {
+          float val = p->op == POOLING_AVERAGE ? acc[c] / pool_size : acc[c];
+          if (m->generic) {
+            set_y(y, y0 + (c0 + c) * ycs, val);
+          } else {
+            yf[y0 + (c0 + c) * ycs] = val;
           }
         }
       }
-      p->calc_context.offset_x += p->x_map_size;
-      p->calc_context.offset_y += p->y_map_size;
     }
   }
+}
+
+static rt_function_error_t exec_pooling_channel_last(rt_function_t *f,
+                                                     pooling_maps_t *m) {
+  pooling_private_t *p = m->p;
+  const int rows =
+      calc_shape_size(f->outputs[0]->shape) / p->channels /
+      p->output_shape.data[p->input_n_kernel_size_diff + 1];
+  if (p->calc_context.y->type == NN_DATA_TYPE_SIGN) {
+    // Maps of packed bits may share a byte.
+    pooling_rows_channel_last(m, 0, rows);
+  } else {
+    parallel_for(f, rows, pooling_rows_channel_last, m);
+  }
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+rt_function_error_t exec_pooling(rt_function_t *f, pooling_context_t *context,
+                                 pooling_private_t *p,
+                                 exec_pooling_func_t exec) {
+  pooling_maps_t m = {f, context, p, exec, 0};
+  if (p->in_channel_last || p->out_channel_last) {
+    return exec_pooling_channel_last(f, &m);
+  }
+  const int n_map = calc_shape_size(f->inputs[0]->shape) / p->x_map_size;
+  parallel_for(f, n_map, pooling_maps, &m);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+rt_function_error_t exec_pooling_generic(rt_function_t *f,
+                                         pooling_context_t *context,
+                                         pooling_private_t *p,
+                                         exec_pooling_func_t exec) {
+  pooling_maps_t m = {f, context, p, exec, 1};
+  if (p->in_channel_last || p->out_channel_last) {
+    return exec_pooling_channel_last(f, &m);
+  }
+  const int n_map = calc_shape_size(f->inputs[0]->shape) / p->x_map_size;
+  if (p->calc_context.y->type == NN_DATA_TYPE_SIGN) {
+    // Maps of packed bits may share a byte.
+    pooling_maps(&m, 0, n_map);
+  } else {
+    parallel_for(f, n_map, pooling_maps, &m);
+  }
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
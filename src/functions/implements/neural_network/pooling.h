@@ -23,10 +23,14 @@ typedef struct {
   rt_list_t stride; ///< Original type is [Shape]
   uint8_t ignore_border;
   rt_list_t pad; ///< Original type is [Shape]
-  uint8_t including_pad;
+  uint8_t channel_last;
+  uint8_t including_pad; ///< AveragePooling only
   void *data;
 } pooling_context_t;
 
+/// Pooling computed by a function.
+typedef enum { POOLING_MAX, POOLING_SUM, POOLING_AVERAGE } pooling_op_t;
+
 typedef struct {
   int hstart;
   int hend;
@@ -56,14 +60,18 @@ typedef struct {
   rt_list_t input_strides;
   rt_list_t output_strides;
   pooling_calc_context_t calc_context;
+  pooling_op_t op;
+  int in_channel_last;  ///< x stored as [outer][spatial][channels]
+  int out_channel_last; ///< y stored as [outer][spatial][channels]
+  int channels;         ///< Channels of channel last x or y
 } pooling_private_t;
 
 typedef float (*exec_pooling_func_t)(pooling_calc_context_t);
 
 rt_function_error_t allocate_pooling(rt_function_t *f,
                                      pooling_context_t *context,
-                                     pooling_private_t *p);
-rt_function_error_t free_pooling(pooling_private_t *p);
+                                     pooling_op_t op, pooling_private_t *p);
+rt_function_error_t free_pooling(rt_function_t *f, pooling_private_t *p);
 rt_function_error_t exec_pooling(rt_function_t *f, pooling_context_t *context,
                                  pooling_private_t *p,
                                  exec_pooling_func_t exec);
@@ -23,9 +23,9 @@
 rt_function_error_t allocate_sum_pooling_local_context(rt_function_t *f) {
   sum_pooling_local_context_t *context =
       (sum_pooling_local_context_t *)(f->local_context);
-  pooling_private_t *p = rt_malloc_func(sizeof(pooling_private_t));
+  pooling_private_t *p = rt_function_malloc(f, sizeof(pooling_private_t));
   rt_function_error_t ret =
-      allocate_pooling(f, (pooling_context_t *)context, p);
+      allocate_pooling(f, (pooling_context_t *)context, POOLING_SUM, p);
   ((sum_pooling_local_context_t *)(f->local_context))->data = (void *)p;
   f->exec_func = exec_sum_pooling;
   return ret;
@@ -35,7 +35,7 @@ rt_function_error_t free_sum_pooling_local_context(rt_function_t *f) {
   pooling_private_t *p =
       (pooling_private_t *)(((sum_pooling_local_context_t *)(f->local_context))
                                 ->data);
-  return free_pooling(p);
+  return free_pooling(f, p);
 }
 
 rt_function_error_t exec_sum_pooling(rt_function_t *f) {
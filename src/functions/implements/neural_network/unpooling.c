@@ -38,30 +38,30 @@ typedef struct {
 rt_function_error_t allocate_unpooling_local_context(rt_function_t *f) {
   unpooling_local_context_t *context =
       (unpooling_local_context_t *)(f->local_context);
-  unpooling_private_t *p = rt_malloc_func(sizeof(unpooling_private_t));
+  unpooling_private_t *p = rt_function_malloc(f, sizeof(unpooling_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
-  p->input_shape = clone_list(f->inputs[0]->shape);
-  p->output_shape = clone_list(f->outputs[0]->shape);
-  p->input_strides = calc_contiguous_strides(f->inputs[0]->shape);
-  p->output_strides = calc_contiguous_strides(f->outputs[0]->shape);
+  p->input_shape = clone_list(f, f->inputs[0]->shape);
+  p->output_shape = clone_list(f, f->outputs[0]->shape);
+  p->input_strides = calc_contiguous_strides(f, f->inputs[0]->shape);
+  p->output_strides = calc_contiguous_strides(f, f->outputs[0]->shape);
   p->input = f->inputs[0];
   p->get_input = select_getter(p->input);
   p->output = f->outputs[0];
   p->set_output = select_setter(p->output);
 
   if (context->kernel.size > p->input_shape.size) {
-    free_list(p->input_shape);
-    free_list(p->output_shape);
-    free_list(p->input_strides);
-    free_list(p->output_strides);
-    rt_free_func(p);
+    free_list(f, p->input_shape);
+    free_list(f, p->output_shape);
+    free_list(f, p->input_strides);
+    free_list(f, p->output_strides);
+    rt_function_free(f, p);
     return RT_FUNCTION_ERROR_INVALID_SHAPE;
   }
 
   // Calc and set output shape.
-  rt_list_t shape = allocate_list(p->input_shape.size);
+  rt_list_t shape = allocate_list(f, p->input_shape.size);
   int diff = p->input_shape.size - context->kernel.size;
   int i;
   for (i = 0; i < diff; i++) {
@@ -70,11 +70,11 @@ rt_function_error_t allocate_unpooling_local_context(rt_function_t *f) {
   for (i = diff; i < p->input_shape.size; i++) {
     shape.data[i] = context->kernel.data[i - diff];
   }
-  p->kernel = clone_list(shape);
+  p->kernel = clone_list(f, shape);
   for (i = 0; i < p->input_shape.size; i++) {
     p->output_shape.data[i] = p->input_shape.data[i] * p->kernel.data[i];
   }
-  free_list(shape);
+  free_list(f, shape);
 
   ((unpooling_local_context_t *)(f->local_context))->data = (void *)p;
 
@@ -87,12 +87,12 @@ rt_function_error_t free_unpooling_local_context(rt_function_t *f) {
   unpooling_private_t *p =
       (unpooling_private_t *)(((unpooling_local_context_t *)(f->local_context))
                                   ->data);
-  free_list(p->input_shape);
-  free_list(p->output_shape);
-  free_list(p->input_strides);
-  free_list(p->output_strides);
-  free_list(p->kernel);
-  rt_free_func(p);
+  free_list(f, p->input_shape);
+  free_list(f, p->output_shape);
+  free_list(f, p->input_strides);
+  free_list(f, p->output_strides);
+  free_list(f, p->kernel);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -38,17 +38,17 @@ allocate_batch_normalization_local_context(rt_function_t *f) {
   batch_normalization_local_context_t *context =
       (batch_normalization_local_context_t *)(f->local_context);
   batch_normalization_private_t *p =
-      rt_malloc_func(sizeof(batch_normalization_private_t));
+      rt_function_malloc(f, sizeof(batch_normalization_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
   // Check axes
   if (context->axes.size != 1) {
-    rt_free_func(p);
+    rt_function_free(f, p);
     return RT_FUNCTION_ERROR_INVALID_SHAPE;
   }
   // Check and parse shapes
-  rt_list_t input_shape = clone_list(f->inputs[0]->shape);
+  rt_list_t input_shape = clone_list(f, f->inputs[0]->shape);
   const int axis = context->axes.data[0];
   const int size = calc_shape_size(input_shape);
   const int size_axis =
@@ -57,20 +57,25 @@ allocate_batch_normalization_local_context(rt_function_t *f) {
   p->batch_size = size / size_axis;
   p->specified_axis_size = input_shape.data[context->axes.data[0]];
   p->output_size = size / p->batch_size / p->specified_axis_size;
+  if (f->channel_last & RT_CHANNEL_LAST_INPUT) {
+    // x[batch][axis][output] is stored as x[batch * output][axis][1].
+    p->batch_size *= p->output_size;
+    p->output_size = 1;
+  }
   p->multiplication_axis_output = p->specified_axis_size * p->output_size;
   p->multiplication_batch_axis = p->batch_size * p->output_size;
   if (p->batch_size * p->specified_axis_size * p->output_size != size) {
-    rt_free_func(p);
+    rt_function_free(f, p);
     return RT_FUNCTION_ERROR_INVALID_SHAPE;
   }
 
-  p->batch_mean.shape = clone_list(f->inputs[1]->shape);
-  p->batch_var.shape = clone_list(f->inputs[2]->shape);
-  p->batch_mean.data =
-      rt_malloc_func(sizeof(float) * calc_shape_size(p->batch_mean.shape));
-  p->batch_var.data =
-      rt_malloc_func(sizeof(float) * calc_shape_size(p->batch_var.shape));
-  free_list(input_shape);
+  p->batch_mean.shape = clone_list(f, f->inputs[1]->shape);
+  p->batch_var.shape = clone_list(f, f->inputs[2]->shape);
+  p->batch_mean.data = rt_function_malloc(
+      f, sizeof(float) * calc_shape_size(p->batch_mean.shape));
+  p->batch_var.data = rt_function_malloc(
+      f, sizeof(float) * calc_shape_size(p->batch_var.shape));
+  free_list(f, input_shape);
   ((batch_normalization_local_context_t *)(f->local_context))->data = (void *)p;
 
 #ifdef CONFIG_BATCHNORMALIZATION_FLOAT32
@@ -95,11 +100,11 @@ rt_function_error_t free_batch_normalization_local_context(rt_function_t *f) {
       (batch_normalization_private_t
            *)(((batch_normalization_local_context_t *)(f->local_context))
                   ->data);
-  free_list(p->batch_mean.shape);
-  free_list(p->batch_var.shape);
-  rt_free_func(p->batch_mean.data);
-  rt_free_func(p->batch_var.data);
-  rt_free_func(p);
+  free_list(f, p->batch_mean.shape);
+  free_list(f, p->batch_var.shape);
+  rt_function_free(f, p->batch_mean.data);
+  rt_function_free(f, p->batch_var.data);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -174,6 +179,19 @@ static void forward_impl_global(rt_function_t *f,
 
   // Subtract mean and divide by std, and apply beta and gamma.
   int i1;
+  if (output_size == 1) {
+    // Channel last, the channels of a pixel are normalized at once.
+    int i0;
+    for (i0 = 0; i0 < multiplication_batch_axis; i0++) {
+      const float *xi = x + i0 * specified_axis_size;
+      float *yi = y + i0 * specified_axis_size;
+      for (i1 = 0; i1 < specified_axis_size; i1++) {
+        const float stdvar = sqrtf(rv[i1] + context->eps);
+        yi[i1] = (xi[i1] - rm[i1]) * gamma[i1] / stdvar + beta[i1];
+      }
+    }
+    return;
+  }
   for (i1 = 0; i1 < specified_axis_size; i1++) {
     int i02;
     const float stdvar = sqrtf(rv[i1] + context->eps);
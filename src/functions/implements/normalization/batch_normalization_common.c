@@ -0,0 +1,154 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "batch_normalization_internal.h"
+#include "../../utilities/accessor.h"
+#include "../../utilities/activation.h"
+#include "../../utilities/shape.h"
+#include <math.h>
+
+rt_function_error_t batch_normalization_shape(rt_variable_t *x, int axis,
+                                              batch_normalization_shape_t *s) {
+  if (axis < 0 || axis >= x->shape.size) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
+  s->outer = shape_product_of(x, 0, axis);
+  s->channels = x->shape.data[axis];
+  s->inner = shape_product_of(x, axis + 1, x->shape.size);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+void batch_normalization_channel_last(batch_normalization_shape_t *s) {
+  s->outer *= s->inner;
+  s->inner = 1;
+}
+
+void batch_normalization_statistics(const batch_normalization_shape_t *s,
+                                    rt_variable_t *x, uint8_t batch_stat,
+                                    float decay_rate,
+                                    rt_variable_t *running_mean,
+                                    rt_variable_t *running_var, float *mean,
+                                    float *var) {
+  rt_variable_getter get_rm = select_getter(running_mean);
+  rt_variable_getter get_rv = select_getter(running_var);
+  const int n = s->outer * s->inner;
+  int c, o, i;
+
+  if (!batch_stat) {
+    for (c = 0; c < s->channels; c++) {
+      mean[c] = get_rm(running_mean, c);
+      var[c] = get_rv(running_var, c);
+    }
+    return;
+  }
+
+  rt_variable_getter get_x = select_getter(x);
+  rt_variable_setter set_rm = select_setter(running_mean);
+  rt_variable_setter set_rv = select_setter(running_var);
+  for (c = 0; c < s->channels; c++) {
+    float sum = 0.0f;
+    float sum2 = 0.0f;
+    for (o = 0; o < s->outer; o++) {
+      const int offset = (o * s->channels + c) * s->inner;
+      if (x->type == NN_DATA_TYPE_FLOAT) {
+        const float *data = (const float *)(x->data) + offset;
+        for (i = 0; i < s->inner; i++) {
+          sum += data[i];
+          sum2 += data[i] * data[i];
+        }
+      } else {
+        for (i = 0; i < s->inner; i++) {
+          const float value = get_x(x, offset + i);
+          sum += value;
+          sum2 += value * value;
+        }
+      }
+    }
+    mean[c] = sum / n;
+    var[c] = sum2 / n - mean[c] * mean[c];
+
+    // Moving mean and var
+    set_rm(running_mean, c,
+           decay_rate * get_rm(running_mean, c) + (1 - decay_rate) * mean[c]);
+    set_rv(running_var, c,
+           decay_rate * get_rv(running_var, c) +
+               (1 - decay_rate) * var[c] * n / (n - 1));
+  }
+}
+
+void batch_normalization_scale_shift(int channels, rt_variable_t *beta,
+                                     rt_variable_t *gamma, const float *mean,
+                                     const float *var, float eps, float *scale,
+                                     float *shift) {
+  rt_variable_getter get_beta = select_getter(beta);
+  rt_variable_getter get_gamma = select_getter(gamma);
+  int c;
+
+  for (c = 0; c < channels; c++) {
+    scale[c] = get_gamma(gamma, c) / sqrtf(var[c] + eps);
+    shift[c] = get_beta(beta, c) - mean[c] * scale[c];
+  }
+}
+
+void batch_normalization_apply(const batch_normalization_shape_t *s,
+                               rt_variable_t *x, const float *scale,
+                               const float *shift, rt_variable_t *z,
+                               const rt_activation_t *a, rt_variable_t *y) {
+  int o, c, i;
+
+  if (x->type == NN_DATA_TYPE_FLOAT && y->type == NN_DATA_TYPE_FLOAT &&
+      s->inner == 1) {
+    // Channel last, the channels of a pixel are normalized at once.
+    for (o = 0; o < s->outer; o++) {
+      const int offset = o * s->channels;
+      const float *in = (const float *)(x->data) + offset;
+      float *out = (float *)(y->data) + offset;
+      for (c = 0; c < s->channels; c++) {
+        out[c] = in[c] * scale[c] + shift[c];
+      }
+      add_and_activate_floats(a, out, z, offset, s->channels);
+    }
+    return;
+  }
+  if (x->type == NN_DATA_TYPE_FLOAT && y->type == NN_DATA_TYPE_FLOAT) {
+    for (o = 0; o < s->outer; o++) {
+      for (c = 0; c < s->channels; c++) {
+        const int offset = (o * s->channels + c) * s->inner;
+        const float *in = (const float *)(x->data) + offset;
+        float *out = (float *)(y->data) + offset;
+        for (i = 0; i < s->inner; i++) {
+          out[i] = in[i] * scale[c] + shift[c];
+        }
+        add_and_activate_floats(a, out, z, offset, s->inner);
+      }
+    }
+    return;
+  }
+
+  rt_variable_getter get_x = select_getter(x);
+  rt_variable_getter get_z = z ? select_getter(z) : 0;
+  rt_variable_setter set_y = select_setter(y);
+  for (o = 0; o < s->outer; o++) {
+    for (c = 0; c < s->channels; c++) {
+      const int offset = (o * s->channels + c) * s->inner;
+      for (i = offset; i < offset + s->inner; i++) {
+        float value = get_x(x, i) * scale[c] + shift[c];
+        if (z) {
+          value += get_z(z, i);
+        }
+        set_y(y, i, activate(a, value));
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_BATCH_NORMALIZATION_INTERNAL_H_181016094512_
+#define H_BATCH_NORMALIZATION_INTERNAL_H_181016094512_
+
+#include <nnablart/functions.h>
+
+// x seen as x[outer][channels][inner] by a normalization over one axis.
+typedef struct {
+  int outer;
+  int channels;
+  int inner;
+} batch_normalization_shape_t;
+
+// Split the shape of x at axis.
+rt_function_error_t batch_normalization_shape(rt_variable_t *x, int axis,
+                                              batch_normalization_shape_t *s);
+
+// Split of x stored channel last, i.e. as x[outer][inner][channels], which
+// is x[outer * inner][channels][1].
+void batch_normalization_channel_last(batch_normalization_shape_t *s);
+
+// Statistics per channel used to normalize x. With batch_stat they are
+// computed from x and the running statistics are updated with decay_rate,
+// otherwise they are the running statistics.
+void batch_normalization_statistics(const batch_normalization_shape_t *s,
+                                    rt_variable_t *x, uint8_t batch_stat,
+                                    float decay_rate,
+                                    rt_variable_t *running_mean,
+                                    rt_variable_t *running_var, float *mean,
+                                    float *var);
+
+// Per channel scale and shift such that x * scale + shift is
+// (x - mean) * gamma / sqrt(var + eps) + beta.
+void batch_normalization_scale_shift(int channels, rt_variable_t *beta,
+                                     rt_variable_t *gamma, const float *mean,
+                                     const float *var, float eps, float *scale,
+                                     float *shift);
+
+// y = a(x * scale + shift + z) in one pass, z may be 0 and y may be x.
+void batch_normalization_apply(const batch_normalization_shape_t *s,
+                               rt_variable_t *x, const float *scale,
+                               const float *shift, rt_variable_t *z,
+                               const rt_activation_t *a, rt_variable_t *y);
+
+#endif // H_BATCH_NORMALIZATION_INTERNAL_H_181016094512_
@@ -0,0 +1,145 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "batch_normalization_internal.h"
+#include <nnablart/config.h>
+#include <nnablart/functions.h>
+
+#ifdef CONFIG_FUSEDBATCHNORMALIZATION
+
+#define X (0)        // x input
+#define BETA (1)     // beta
+#define GAMMA (2)    // gamma
+#define MEAN (3)     // running mean
+#define VARIANCE (4) // running variance
+#define Z (5)        // z input added before the nonlinearity
+#define Y0 (0)       // y0 output
+
+typedef struct {
+  batch_normalization_shape_t shape;
+  float *mean;  // mean per channel, followed by the other arrays
+  float *var;   // variance per channel
+  float *scale; // x is normalized as x * scale + shift
+  float *shift; // per channel
+  rt_variable_t *residual;
+  rt_activation_t activation;
+} fused_batch_normalization_private_t;
+
+rt_function_error_t exec_fused_batch_normalization_generic(rt_function_t *f);
+
+// FusedBatchNormalization
+rt_function_error_t
+allocate_fused_batch_normalization_local_context(rt_function_t *f) {
+  fused_batch_normalization_local_context_t *context =
+      (fused_batch_normalization_local_context_t *)(f->local_context);
+  batch_normalization_shape_t shape;
+
+  if (f->num_of_inputs != Z && f->num_of_inputs != Z + 1) {
+    return RT_FUNCTION_ERROR_INVALID_NUM_OF_INPUTS;
+  }
+  if (f->num_of_outputs != 1) {
+    return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
+  }
+  if (context->axes.size != 1 ||
+      batch_normalization_shape(f->inputs[X], context->axes.data[0],
+                                &shape) != RT_FUNCTION_ERROR_NOERROR) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
+  if (f->channel_last & RT_CHANNEL_LAST_INPUT) {
+    batch_normalization_channel_last(&shape);
+  }
+
+  fused_batch_normalization_private_t *p =
+      rt_function_malloc(f, sizeof(fused_batch_normalization_private_t));
+  if (p == 0) {
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  p->mean = rt_function_malloc(f, sizeof(float) * 4 * shape.channels);
+  if (p->mean == 0) {
+    rt_function_free(f, p);
+    return RT_FUNCTION_ERROR_MALLOC;
+  }
+  p->var = p->mean + shape.channels;
+  p->scale = p->var + shape.channels;
+  p->shift = p->scale + shape.channels;
+  p->shape = shape;
+  p->residual = f->num_of_inputs > Z ? f->inputs[Z] : 0;
+  // ReLU is the only nonlinearity of FusedBatchNormalization.
+  p->activation.type = RT_ACTIVATION_RELU;
+  p->activation.alpha = 0.0f;
+  context->data = (void *)p;
+
+#ifdef CONFIG_FUSEDBATCHNORMALIZATION_FLOAT32
+  f->exec_func = exec_fused_batch_normalization;
+#endif /* CONFIG_FUSEDBATCHNORMALIZATION_FLOAT32 */
+#ifdef CONFIG_FUSEDBATCHNORMALIZATION_GENERIC
+  for (int i = 0; i < f->num_of_inputs; i++) {
+    if (f->inputs[i]->type != NN_DATA_TYPE_FLOAT) {
+      f->exec_func = exec_fused_batch_normalization_generic;
+      break;
+    }
+  }
+  if (f->outputs[Y0]->type != NN_DATA_TYPE_FLOAT) {
+    f->exec_func = exec_fused_batch_normalization_generic;
+  }
+#endif /* CONFIG_FUSEDBATCHNORMALIZATION_GENERIC */
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+rt_function_error_t
+free_fused_batch_normalization_local_context(rt_function_t *f) {
+  fused_batch_normalization_private_t *p =
+      (fused_batch_normalization_private_t
+           *)(((fused_batch_normalization_local_context_t *)(f->local_context))
+                  ->data);
+  rt_function_free(f, p->mean);
+  rt_function_free(f, p);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+
+#if defined(CONFIG_FUSEDBATCHNORMALIZATION_FLOAT32) ||                         \
+    defined(CONFIG_FUSEDBATCHNORMALIZATION_GENERIC)
+// The normalization, the residual and the nonlinearity are applied in a
+// single pass over x. The accessors pick the float path when they can.
+static rt_function_error_t forward_impl(rt_function_t *f) {
+  fused_batch_normalization_local_context_t *context =
+      (fused_batch_normalization_local_context_t *)(f->local_context);
+  fused_batch_normalization_private_t *p =
+      (fused_batch_normalization_private_t *)(context->data);
+
+  batch_normalization_statistics(&p->shape, f->inputs[X], context->batch_stat,
+                                 context->decay_rate, f->inputs[MEAN],
+                                 f->inputs[VARIANCE], p->mean, p->var);
+  batch_normalization_scale_shift(p->shape.channels, f->inputs[BETA],
+                                  f->inputs[GAMMA], p->mean, p->var,
+                                  context->eps, p->scale, p->shift);
+  batch_normalization_apply(&p->shape, f->inputs[X], p->scale, p->shift,
+                            p->residual, &p->activation, f->outputs[Y0]);
+  return RT_FUNCTION_ERROR_NOERROR;
+}
+#endif
+
+#ifdef CONFIG_FUSEDBATCHNORMALIZATION_FLOAT32
+rt_function_error_t exec_fused_batch_normalization(rt_function_t *f) {
+  return forward_impl(f);
+}
+#endif /* CONFIG_FUSEDBATCHNORMALIZATION_FLOAT32 */
+
+#ifdef CONFIG_FUSEDBATCHNORMALIZATION_GENERIC
+rt_function_error_t exec_fused_batch_normalization_generic(rt_function_t *f) {
+  return forward_impl(f);
+}
+#endif /* CONFIG_FUSEDBATCHNORMALIZATION_GENERIC */
+
+#endif /* CONFIG_FUSEDBATCHNORMALIZATION */
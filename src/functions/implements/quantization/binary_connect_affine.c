@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "../../utilities/shape.h"
+#include "../../utilities/shared_cache.h"
 #include "../neural_network/affine/affine_generic.h"
 #include "../neural_network/affine/affine_internal.h"
 #include <nnablart/config.h>
@@ -30,7 +31,7 @@ allocate_binary_connect_affine_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
-  affine_private_t *p = rt_malloc_func(sizeof(affine_private_t));
+  affine_private_t *p = rt_function_malloc(f, sizeof(affine_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -58,6 +59,9 @@ allocate_binary_connect_affine_local_context(rt_function_t *f) {
   int i; // Iterator
 
   p->alpha = 0;
+  p->activation = f->activation;
+  p->packed_weight = 0;
+  p->kernel = 0;
 
   p->base_loop_size = 1;
   for (i = 0; i < base_axis; i++) {
@@ -79,11 +83,16 @@ allocate_binary_connect_affine_local_context(rt_function_t *f) {
       p->weight->type == NN_DATA_TYPE_FLOAT &&
       ((p->bias && p->bias->type == NN_DATA_TYPE_FLOAT) || !p->bias)) {
 #ifdef CONFIG_BINARYCONNECTAFFINE_FLOAT32
+    if (prepack_affine_weight(f, p) != RT_FUNCTION_ERROR_NOERROR) {
+      rt_function_free(f, p);
+      return RT_FUNCTION_ERROR_MALLOC;
+    }
     f->exec_func = exec_affine;
 #endif /* CONFIG_BINARYCONNECTAFFINE_FLOAT32 */
   } else {
 #ifdef CONFIG_BINARYCONNECTAFFINE_GENERIC
     f->exec_func = exec_affine_generic;
+    f->variant = "generic";
 #endif /* CONFIG_BINARYCONNECTAFFINE_GENERIC */
   }
 
@@ -92,7 +101,11 @@ allocate_binary_connect_affine_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_binary_connect_affine_local_context(rt_function_t *f) {
-  rt_free_func((((affine_local_context_t *)(f->local_context))->data));
+  affine_private_t *p =
+      (affine_private_t *)(((affine_local_context_t *)(f->local_context))
+                               ->data);
+  free_shared_blob(f, p->packed_weight);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -40,7 +40,7 @@ rt_function_error_t allocate_binary_tanh_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
   binary_tanh_private_context_t *p =
-      rt_malloc_func(sizeof(binary_tanh_private_context_t));
+      rt_function_malloc(f, sizeof(binary_tanh_private_context_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
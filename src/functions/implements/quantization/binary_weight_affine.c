@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "../../utilities/shape.h"
+#include "../../utilities/shared_cache.h"
 #include "../neural_network/affine/affine_generic.h"
 #include "../neural_network/affine/affine_internal.h"
 #include <nnablart/config.h>
@@ -31,7 +32,7 @@ allocate_binary_weight_affine_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
-  affine_private_t *p = rt_malloc_func(sizeof(affine_private_t));
+  affine_private_t *p = rt_function_malloc(f, sizeof(affine_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -47,6 +48,9 @@ allocate_binary_weight_affine_local_context(rt_function_t *f) {
   p->set_output = select_setter(p->output);
 
   p->alpha = f->inputs[3];
+  p->activation = f->activation;
+  p->packed_weight = 0;
+  p->kernel = 0;
   p->get_alpha = select_getter(p->alpha);
 
   if (f->num_of_inputs > 4) {
@@ -81,11 +85,16 @@ allocate_binary_weight_affine_local_context(rt_function_t *f) {
       p->weight->type == NN_DATA_TYPE_FLOAT &&
       ((p->bias && p->bias->type == NN_DATA_TYPE_FLOAT) || !p->bias)) {
 #ifdef CONFIG_BINARYWEIGHTAFFINE_FLOAT32
+    if (prepack_affine_weight(f, p) != RT_FUNCTION_ERROR_NOERROR) {
+      rt_function_free(f, p);
+      return RT_FUNCTION_ERROR_MALLOC;
+    }
     f->exec_func = exec_affine;
 #endif /* CONFIG_BINARYWEIGHTAFFINE_FLOAT32 */
   } else {
 #ifdef CONFIG_BINARYWEIGHTAFFINE_GENERIC
     f->exec_func = exec_affine_generic;
+    f->variant = "generic";
 #endif /* CONFIG_BINARYWEIGHTAFFINE_GENERIC */
   }
 
@@ -94,7 +103,11 @@ allocate_binary_weight_affine_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_binary_weight_affine_local_context(rt_function_t *f) {
-  rt_free_func((((affine_local_context_t *)(f->local_context))->data));
+  affine_private_t *p =
+      (affine_private_t *)(((affine_local_context_t *)(f->local_context))
+                               ->data);
+  free_shared_blob(f, p->packed_weight);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -25,8 +25,6 @@ typedef struct {
   rt_variable_t *output;
   rt_variable_getter get_output;
   rt_variable_setter set_output;
-  rt_list_t in_position;
-  rt_list_t out_position;
   int input_size;
 } sum_private_t;
 
@@ -40,8 +38,12 @@ rt_function_error_t allocate_sum_local_context(rt_function_t *f) {
   if (f->num_of_outputs != 1) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
+  if (f->inputs[0]->shape.size > STACK_LIST_MAX_LENGTH ||
+      f->outputs[0]->shape.size > STACK_LIST_MAX_LENGTH) {
+    return RT_FUNCTION_ERROR_INVALID_SHAPE;
+  }
 
-  sum_private_t *p = rt_malloc_func(sizeof(sum_private_t));
+  sum_private_t *p = rt_function_malloc(f, sizeof(sum_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -55,9 +57,6 @@ rt_function_error_t allocate_sum_local_context(rt_function_t *f) {
   p->get_output = select_getter(p->output);
   p->set_output = select_setter(p->output);
 
-  p->in_position = allocate_list(p->input->shape.size);
-  p->out_position = allocate_list(p->output->shape.size);
-
   if (f->inputs[0]->type == NN_DATA_TYPE_FLOAT &&
       f->outputs[0]->type == NN_DATA_TYPE_FLOAT) {
 #ifdef CONFIG_SUM_FLOAT32
@@ -75,9 +74,7 @@ rt_function_error_t allocate_sum_local_context(rt_function_t *f) {
 rt_function_error_t free_sum_local_context(rt_function_t *f) {
   sum_private_t *p =
       (sum_private_t *)(((sum_local_context_t *)(f->local_context))->data);
-  free_list(p->in_position);
-  free_list(p->out_position);
-  rt_free_func(p);
+  rt_function_free(f, p);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -87,31 +84,33 @@ rt_function_error_t exec_sum(rt_function_t *f) {
   sum_private_t *p = (sum_private_t *)(context->data);
   const float *x = (float *)(p->input->data);
   float *y = (float *)(p->output->data);
+  STACK_LIST(in_position, p->input->shape.size);
+  STACK_LIST(out_position, p->output->shape.size);
 
   memset(p->output->data, 0, sizeof(float) * calc_shape_size(p->output->shape));
   for (int i = 0; i < p->input_size; i++) {
     int o = 0;
     int prev = -1;
-    pos_to_shape(p->in_position, p->input->shape, i);
+    pos_to_shape(in_position, p->input->shape, i);
     for (int a = 0; a < context->axes.size; a++) {
       for (int j = prev + 1; j < context->axes.data[a]; j++) {
-        if (o < p->out_position.size) {
-          p->out_position.data[o++] = p->in_position.data[j];
+        if (o < out_position.size) {
+          out_position.data[o++] = in_position.data[j];
         }
       }
       if (context->keep_dims) {
-        if (o < p->out_position.size) {
-          p->out_position.data[o++] = 0;
+        if (o < out_position.size) {
+          out_position.data[o++] = 0;
         }
       }
       prev = context->axes.data[a];
     }
-    for (int j = prev + 1; j < p->in_position.size; j++) {
-      if (o < p->out_position.size) {
-        p->out_position.data[o++] = p->in_position.data[j];
+    for (int j = prev + 1; j < in_position.size; j++) {
+      if (o < out_position.size) {
+        out_position.data[o++] = in_position.data[j];
       }
     }
-    int index = shape_to_pos(p->output->shape, p->out_position);
+    int index = shape_to_pos(p->output->shape, out_position);
     y[index] += x[i];
   }
   return RT_FUNCTION_ERROR_NOERROR;
@@ -122,31 +121,33 @@ rt_function_error_t exec_sum(rt_function_t *f) {
 rt_function_error_t exec_sum_generic(rt_function_t *f) {
   sum_local_context_t *context = (sum_local_context_t *)(f->local_context);
   sum_private_t *p = (sum_private_t *)(context->data);
+  STACK_LIST(in_position, p->input->shape.size);
+  STACK_LIST(out_position, p->output->shape.size);
 
   fill_variable_with(f->outputs[0], 0);
   for (int i = 0; i < p->input_size; i++) {
     int o = 0;
     int prev = -1;
-    pos_to_shape(p->in_position, p->input->shape, i);
+    pos_to_shape(in_position, p->input->shape, i);
     for (int a = 0; a < context->axes.size; a++) {
       for (int j = prev + 1; j < context->axes.data[a]; j++) {
-        if (o < p->out_position.size) {
-          p->out_position.data[o++] = p->in_position.data[j];
+        if (o < out_position.size) {
+          out_position.data[o++] = in_position.data[j];
         }
       }
       if (context->keep_dims) {
-        if (o < p->out_position.size) {
-          p->out_position.data[o++] = 0;
+        if (o < out_position.size) {
+          out_position.data[o++] = 0;
         }
       }
       prev = context->axes.data[a];
     }
-    for (int j = prev + 1; j < p->in_position.size; j++) {
-      if (o < p->out_position.size) {
-        p->out_position.data[o++] = p->in_position.data[j];
+    for (int j = prev + 1; j < in_position.size; j++) {
+      if (o < out_position.size) {
+        out_position.data[o++] = in_position.data[j];
       }
     }
-    int index = shape_to_pos(p->output->shape, p->out_position);
+    int index = shape_to_pos(p->output->shape, out_position);
     float x = p->get_input(p->input, i);
     float y = p->get_output(p->output, index);
     y += x;
@@ -38,7 +38,7 @@ rt_function_error_t allocate_dropout_local_context(rt_function_t *f) {
     return RT_FUNCTION_ERROR_INVALID_NUM_OF_OUTPUTS;
   }
 
-  dropout_private_t *p = rt_malloc_func(sizeof(dropout_private_t));
+  dropout_private_t *p = rt_function_malloc(f, sizeof(dropout_private_t));
   if (p == 0) {
     return RT_FUNCTION_ERROR_MALLOC;
   }
@@ -68,6 +68,7 @@ rt_function_error_t allocate_dropout_local_context(rt_function_t *f) {
 }
 
 rt_function_error_t free_dropout_local_context(rt_function_t *f) {
+  rt_function_free(f, ((dropout_local_context_t *)(f->local_context))->data);
   return RT_FUNCTION_ERROR_NOERROR;
 }
 
@@ -66,22 +66,6 @@ rt_function_error_t exec_gru(rt_function_t *f) {
 }
 #endif /* CONFIG_GRU */
 
-// FusedConvolution
-#ifdef CONFIG_FUSEDCONVOLUTION
-rt_function_error_t allocate_fused_convolution_local_context(rt_function_t *f) {
-  f->exec_func = exec_fused_convolution;
-  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
-}
-
-rt_function_error_t free_fused_convolution_local_context(rt_function_t *f) {
-  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
-}
-
-rt_function_error_t exec_fused_convolution(rt_function_t *f) {
-  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
-}
-#endif /* CONFIG_FUSEDCONVOLUTION */
-
 // DepthwiseDeconvolution
 #ifdef CONFIG_DEPTHWISEDECONVOLUTION
 rt_function_error_t
@@ -319,24 +303,6 @@ rt_function_error_t exec_gelu(rt_function_t *f) {
 // Normalization
 ////////////////////////////////////////////////////////////////////////////////
 
-// FusedBatchNormalization
-#ifdef CONFIG_FUSEDBATCHNORMALIZATION
-rt_function_error_t
-allocate_fused_batch_normalization_local_context(rt_function_t *f) {
-  f->exec_func = exec_fused_batch_normalization;
-  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
-}
-
-rt_function_error_t
-free_fused_batch_normalization_local_context(rt_function_t *f) {
-  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
-}
-
-rt_function_error_t exec_fused_batch_normalization(rt_function_t *f) {
-  return RT_FUNCTION_ERROR_UNIMPLEMENTED;
-}
-#endif /* CONFIG_FUSEDBATCHNORMALIZATION */
-
 // SyncBatchNormalization
 #ifdef CONFIG_SYNCBATCHNORMALIZATION
 rt_function_error_t
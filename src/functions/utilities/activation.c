@@ -0,0 +1,95 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "activation.h"
+#include "accessor.h"
+
+void activate_floats(const rt_activation_t *a, float *data, int size) {
+  int i;
+
+  // One loop per type keeps the switch out of the inner loop.
+  switch (a->type) {
+  case RT_ACTIVATION_NONE:
+    break;
+  case RT_ACTIVATION_RELU:
+    for (i = 0; i < size; i++) {
+      data[i] = data[i] > 0.0f ? data[i] : 0.0f;
+    }
+    break;
+  case RT_ACTIVATION_LEAKY_RELU:
+    for (i = 0; i < size; i++) {
+      data[i] = data[i] > 0.0f ? data[i] : data[i] * a->alpha;
+    }
+    break;
+  default:
+    for (i = 0; i < size; i++) {
+      data[i] = activate(a, data[i]);
+    }
+    break;
+  }
+}
+
+void activate_variable(const rt_activation_t *a, rt_variable_t *v, int offset,
+                       int size) {
+  rt_variable_getter get = select_getter(v);
+  rt_variable_setter set = select_setter(v);
+  int i;
+
+  if (a->type == RT_ACTIVATION_NONE) {
+    return;
+  }
+  for (i = offset; i < offset + size; i++) {
+    set(v, i, activate(a, get(v, i)));
+  }
+}
+
+void add_and_activate_floats(const rt_activation_t *a, float *data,
+                             rt_variable_t *residual, int offset, int size) {
+  int i;
+
+  if (residual == 0) {
+    activate_floats(a, data, size);
+    return;
+  }
+  if (residual->type == NN_DATA_TYPE_FLOAT) {
+    const float *z = (const float *)(residual->data) + offset;
+    for (i = 0; i < size; i++) {
+      data[i] += z[i];
+    }
+  } else {
+    rt_variable_getter get_z = select_getter(residual);
+    for (i = 0; i < size; i++) {
+      data[i] += get_z(residual, offset + i);
+    }
+  }
+  // The sums are still in cache.
+  activate_floats(a, data, size);
+}
+
+void add_and_activate_variable(const rt_activation_t *a, rt_variable_t *v,
+                               rt_variable_t *residual, int offset, int size) {
+  rt_variable_getter get = select_getter(v);
+  rt_variable_setter set = select_setter(v);
+  rt_variable_getter get_z;
+  int i;
+
+  if (residual == 0) {
+    activate_variable(a, v, offset, size);
+    return;
+  }
+  get_z = select_getter(residual);
+  for (i = offset; i < offset + size; i++) {
+    set(v, i, activate(a, get(v, i) + get_z(residual, i)));
+  }
+}
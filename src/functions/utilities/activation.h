@@ -0,0 +1,64 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_ACTIVATION_H_181010113208_
+#define H_ACTIVATION_H_181010113208_
+
+#include <math.h>
+
+#include <nnablart/functions.h>
+
+/// Value of activation a at x, computed as the standalone functions do.
+static inline float activate(const rt_activation_t *a, float x) {
+  switch (a->type) {
+  case RT_ACTIVATION_RELU:
+    return x > 0.0f ? x : 0.0f;
+  case RT_ACTIVATION_LEAKY_RELU:
+    return x > 0.0f ? x : x * a->alpha;
+  case RT_ACTIVATION_SIGMOID:
+    return 1.0f / (1.0f + expf(-x));
+  case RT_ACTIVATION_TANH:
+    return tanhf(x);
+  case RT_ACTIVATION_SWISH:
+    return x * (1.0f / (1.0f + expf(-x)));
+  case RT_ACTIVATION_ELU:
+    return x > 0.0f ? x : a->alpha * (expf(x) - 1.0f);
+  case RT_ACTIVATION_RELU6:
+    return x > 0.0f ? (x < 6.0f ? x : 6.0f) : 0.0f;
+  default:
+    return x;
+  }
+}
+
+/// Apply activation a to size floats in place.
+void activate_floats(const rt_activation_t *a, float *data, int size);
+
+/// Apply activation a in place to elements [offset, offset + size) of v of
+/// any type, through its getter and setter.
+void activate_variable(const rt_activation_t *a, rt_variable_t *v, int offset,
+                       int size);
+
+/// Add elements [offset, offset + size) of residual to the size floats of
+/// data, which hold the same elements of an output, then apply activation a.
+/// Does the activation alone if residual is 0.
+void add_and_activate_floats(const rt_activation_t *a, float *data,
+                             rt_variable_t *residual, int offset, int size);
+
+/// Add elements [offset, offset + size) of residual to those of v of any
+/// type, then apply activation a, as in y = a(y + z) of the fused functions.
+/// Does the activation alone if residual is 0.
+void add_and_activate_variable(const rt_activation_t *a, rt_variable_t *v,
+                               rt_variable_t *residual, int offset, int size);
+
+#endif // H_ACTIVATION_H_181010113208_
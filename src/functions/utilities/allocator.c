@@ -0,0 +1,32 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <nnablart/functions.h>
+
+void *rt_function_malloc(rt_function_t *f, size_t size) {
+  rt_allocator_t *a = f->allocator;
+  if (a == 0) {
+    return rt_malloc_func(size);
+  }
+  return a->malloc_func(a->user_data, size);
+}
+
+void rt_function_free(rt_function_t *f, void *ptr) {
+  rt_allocator_t *a = f->allocator;
+  if (a == 0) {
+    rt_free_func(ptr);
+    return;
+  }
+  a->free_func(a->user_data, ptr);
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <nnablart/functions.h>
+
+int rt_detect_cpu_features(void) {
+  int features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse")) {
+    features |= RT_CPU_FEATURE_SSE;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    features |= RT_CPU_FEATURE_AVX2;
+  }
+  if (__builtin_cpu_supports("avx512f")) {
+    features |= RT_CPU_FEATURE_AVX512F;
+  }
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  features |= RT_CPU_FEATURE_NEON;
+#endif
+  return features;
+}
@@ -0,0 +1,30 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dispatch.h"
+
+const exec_variant_t *select_exec_variant(rt_function_t *f,
+                                          const exec_variant_t *variants,
+                                          int num_of_variants) {
+  int i;
+  for (i = 0; i < num_of_variants; i++) {
+    const int required = variants[i].cpu_features;
+    if ((f->cpu_features & required) == required) {
+      f->exec_func = variants[i].exec_func;
+      f->variant = variants[i].name;
+      return variants + i;
+    }
+  }
+  return 0;
+}
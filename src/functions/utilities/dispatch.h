@@ -0,0 +1,36 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_DISPATCH_H_181016140218_
+#define H_DISPATCH_H_181016140218_
+
+#include <nnablart/functions.h>
+
+/// One implementation of a function and the CPU features it needs.
+typedef struct {
+  const char *name; ///< Reported as rt_function_t::variant
+  int cpu_features; ///< OR of rt_cpu_feature_t required
+  rt_function_error_t (*exec_func)(rt_function_t *f);
+  const void *kernel; ///< Data specific to the variant, may be 0
+} exec_variant_t;
+
+/// Select the first of variants whose features are all in f->cpu_features,
+/// so variants are listed from the fastest one. Sets f->exec_func and
+/// f->variant. Returns 0 and leaves f unchanged if none is supported, which
+/// a last variant without requirements avoids.
+const exec_variant_t *select_exec_variant(rt_function_t *f,
+                                          const exec_variant_t *variants,
+                                          int num_of_variants);
+
+#endif // H_DISPATCH_H_181016140218_
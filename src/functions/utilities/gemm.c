@@ -0,0 +1,32 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gemm.h"
+
+int sgemm_packed_b_size(int k, int n, int nr) {
+  return (n + nr - 1) / nr * nr * k;
+}
+
+void sgemm_pack_b(int k, int n, int nr, const float *b, int rs, int cs,
+                  float *packed) {
+  int j0, p, j;
+
+  for (j0 = 0; j0 < n; j0 += nr) {
+    for (p = 0; p < k; p++) {
+      for (j = 0; j < nr; j++) {
+        *packed++ = j0 + j < n ? b[p * rs + (j0 + j) * cs] : 0.0f;
+      }
+    }
+  }
+}
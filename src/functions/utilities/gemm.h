@@ -0,0 +1,30 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_GEMM_H_180910102315_
+#define H_GEMM_H_180910102315_
+
+// Panels of the B operand read by the Affine tile kernels.
+
+/// Number of floats taken by B[k x n] packed by sgemm_pack_b.
+/// B is split into panels of nr columns, the columns beyond n are zero.
+/// Each panel stores its k rows one after another.
+int sgemm_packed_b_size(int k, int n, int nr);
+
+/// Pack B[k x n] whose element B[p][j] is b[p * rs + j * cs].
+/// Passing rs = 1 and cs = ldb packs the transpose of a row-major matrix.
+void sgemm_pack_b(int k, int n, int nr, const float *b, int rs, int cs,
+                  float *packed);
+
+#endif // H_GEMM_H_180910102315_
@@ -16,24 +16,24 @@
 
 #include "list.h"
 
-rt_list_t allocate_list(int length) {
+rt_list_t allocate_list(rt_function_t *f, int length) {
   rt_list_t ret;
   assert(length >= 0);
   ret.size = length;
-  ret.data = (int *)rt_malloc_func(sizeof(int) * length);
+  ret.data = (int *)rt_function_malloc(f, sizeof(int) * length);
   return ret;
 }
 
-void free_list(rt_list_t s) {
+void free_list(rt_function_t *f, rt_list_t s) {
   if (s.data) {
-    rt_free_func(s.data);
+    rt_function_free(f, s.data);
   }
   s.data = 0;
 }
 
-rt_list_t clone_list(rt_list_t src) {
+rt_list_t clone_list(rt_function_t *f, rt_list_t src) {
   int i;
-  rt_list_t dst = allocate_list(src.size);
+  rt_list_t dst = allocate_list(f, src.size);
   for (i = 0; i < src.size; i++) {
     dst.data[i] = src.data[i];
   }
@@ -17,16 +17,26 @@
 
 #include <nnablart/functions.h>
 
-/// Allocate shape
-rt_list_t allocate_list(int length);
+/// Maximum length of list declared with STACK_LIST.
+#define STACK_LIST_MAX_LENGTH (16)
 
-/// Free allocated shape.
-void free_list(rt_list_t s);
+/// Declare list xName with xLength elements on the stack.
+/// Used for positions which are scratch of exec functions, so that functions
+/// do not write their private context while executing.
+#define STACK_LIST(xName, xLength)                                             \
+  int xName##_data[STACK_LIST_MAX_LENGTH];                                     \
+  rt_list_t xName = {(xLength), xName##_data}
+
+/// Allocate shape with the allocator of f.
+rt_list_t allocate_list(rt_function_t *f, int length);
+
+/// Free shape allocated for f.
+void free_list(rt_function_t *f, rt_list_t s);
 
 /// Clone shape
 ///
-/// list.shape will be allocated inside this function.
-/// User must free cloned shape.
-rt_list_t clone_list(rt_list_t src);
+/// list.shape will be allocated inside this function with the allocator of
+/// f. User must free cloned shape.
+rt_list_t clone_list(rt_function_t *f, rt_list_t src);
 
 #endif // H_LIST_H_171210064151_
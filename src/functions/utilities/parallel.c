@@ -0,0 +1,50 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parallel.h"
+
+typedef struct {
+  parallel_body_t body;
+  void *arg;
+  int size;
+  int num_of_tasks;
+} parallel_range_t;
+
+static void parallel_range_task(void *arg, int index) {
+  parallel_range_t *r = (parallel_range_t *)arg;
+  int begin = (int)((long long)r->size * index / r->num_of_tasks);
+  int end = (int)((long long)r->size * (index + 1) / r->num_of_tasks);
+  if (begin < end) {
+    r->body(r->arg, begin, end);
+  }
+}
+
+void parallel_for(rt_function_t *f, int size, parallel_body_t body,
+                  void *arg) {
+  rt_parallel_t *parallel = f->parallel;
+  if (parallel == 0 || parallel->run_tasks == 0 ||
+      parallel->num_of_threads <= 1 || size <= 1) {
+    body(arg, 0, size);
+    return;
+  }
+
+  parallel_range_t r;
+  r.body = body;
+  r.arg = arg;
+  r.size = size;
+  r.num_of_tasks =
+      parallel->num_of_threads < size ? parallel->num_of_threads : size;
+  parallel->run_tasks(parallel->executor, r.num_of_tasks, parallel_range_task,
+                      &r);
+}
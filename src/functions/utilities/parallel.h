@@ -0,0 +1,29 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_PARALLEL_H_180912143020_
+#define H_PARALLEL_H_180912143020_
+
+#include <nnablart/functions.h>
+
+/// Loop body called with a contiguous range [begin, end) of iterations.
+typedef void (*parallel_body_t)(void *arg, int begin, int end);
+
+/// Split [0, size) into one contiguous range per thread of f->parallel and
+/// run body on each of them. The split only depends on size and the number
+/// of threads, so results are reproducible for a fixed thread count.
+/// Runs body(arg, 0, size) on the calling thread if f has no executor.
+void parallel_for(rt_function_t *f, int size, parallel_body_t body, void *arg);
+
+#endif // H_PARALLEL_H_180912143020_
@@ -62,11 +62,11 @@ int shape_product_of(const rt_variable_t *v, unsigned shape_begin,
   return int_product(v->shape.data, shape_begin, shape_end);
 }
 
-rt_list_t calc_contiguous_strides(rt_list_t shape) {
+rt_list_t calc_contiguous_strides(rt_function_t *f, rt_list_t shape) {
   if (!shape.size) {
-    return allocate_list(0);
+    return allocate_list(f, 0);
   }
-  rt_list_t strides = allocate_list(shape.size);
+  rt_list_t strides = allocate_list(f, shape.size);
   int i;
   for (i = 0; i < shape.size; ++i) {
     strides.data[i] = 1;
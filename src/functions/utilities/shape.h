@@ -41,8 +41,9 @@ int calc_shape_size(rt_list_t shape);
 int shape_product_of(const rt_variable_t *v, unsigned shape_begin,
                      unsigned shape_end);
 
-/// Helper for getting strides of C contiguous memory arrangement.
-rt_list_t calc_contiguous_strides(rt_list_t shape);
+/// Helper for getting strides of C contiguous memory arrangement, allocated
+/// with the allocator of f.
+rt_list_t calc_contiguous_strides(rt_function_t *f, rt_list_t shape);
 
 /// @}
 
@@ -0,0 +1,70 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "shared_cache.h"
+#include <stdint.h>
+
+// The allocation is followed by the aligned data, and the pointer to the
+// allocation is stored just before the data so that it can be freed.
+static void *aligned_data(void *allocation) {
+  uintptr_t address = (uintptr_t)allocation + sizeof(void *);
+  address = (address + SHARED_BLOB_ALIGNMENT - 1) &
+            ~(uintptr_t)(SHARED_BLOB_ALIGNMENT - 1);
+  return (void *)address;
+}
+
+void *shared_blob(rt_function_t *f, const void *key, int tag, size_t size,
+                  int *created) {
+  rt_shared_cache_t *cache = f->shared_cache;
+  rt_shared_blob_t *blob;
+
+  *created = 0;
+  if (cache != 0) {
+    for (blob = cache->blobs; blob != 0; blob = blob->next) {
+      if (blob->key == key && blob->tag == tag && blob->size == size) {
+        return aligned_data(blob->data);
+      }
+    }
+  }
+
+  size_t allocation_size = size + sizeof(void *) + SHARED_BLOB_ALIGNMENT - 1;
+  void *allocation = cache ? cache->malloc_func(allocation_size)
+                           : rt_function_malloc(f, allocation_size);
+  if (allocation == 0) {
+    return 0;
+  }
+  if (cache != 0) {
+    blob = cache->malloc_func(sizeof(rt_shared_blob_t));
+    if (blob == 0) {
+      cache->free_func(allocation);
+      return 0;
+    }
+    blob->key = key;
+    blob->tag = tag;
+    blob->size = size;
+    blob->data = allocation;
+    blob->next = cache->blobs;
+    cache->blobs = blob;
+  }
+  void *data = aligned_data(allocation);
+  ((void **)data)[-1] = allocation;
+  *created = 1;
+  return data;
+}
+
+void free_shared_blob(rt_function_t *f, void *data) {
+  if (f->shared_cache == 0 && data != 0) {
+    rt_function_free(f, ((void **)data)[-1]);
+  }
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_SHARED_CACHE_H_180921110245_
+#define H_SHARED_CACHE_H_180921110245_
+
+#include <nnablart/functions.h>
+
+/// Kinds of data derived from parameters.
+typedef enum {
+  SHARED_BLOB_WINOGRAD_WEIGHT,     ///< Weight transformed by Winograd engine
+  SHARED_BLOB_FOLDED_WEIGHT,       ///< Weight scaled by BatchNormalization
+  SHARED_BLOB_FOLDED_BIAS,         ///< Bias shifted by BatchNormalization
+  SHARED_BLOB_PACKED_WEIGHT,       ///< Weight packed into GEMM panels
+  SHARED_BLOB_SCALED_WEIGHT,       ///< Weight scaled by Dropout
+  SHARED_BLOB_CHANNEL_LAST_WEIGHT, ///< Weight of channel last kernels
+} shared_blob_tag_t;
+
+/// Alignment of the data returned by shared_blob in bytes.
+#define SHARED_BLOB_ALIGNMENT (64)
+
+/// Get the blob derived from key with tag and size.
+/// A new blob is allocated if f->shared_cache has none, and *created is set
+/// to 1 so that the caller fills it. The data is aligned to
+/// SHARED_BLOB_ALIGNMENT bytes. Blobs in a cache are released with the
+/// cache, blobs allocated without a cache are owned by the caller.
+/// Returns 0 if allocation failed.
+void *shared_blob(rt_function_t *f, const void *key, int tag, size_t size,
+                  int *created);
+
+/// Release a blob obtained by shared_blob. Does nothing if f has a cache.
+void free_shared_blob(rt_function_t *f, void *data);
+
+#endif // H_SHARED_CACHE_H_180921110245_
@@ -0,0 +1,382 @@
+// Copyright (c) 2017 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "bench.h"
+#include "input.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#ifdef NNABLART_USE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define DEFAULT_ITERATIONS (100)
+#define DEFAULT_WARMUP (10)
+
+static double now(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// Peak resident set size of process in bytes, 0 if unknown.
+static size_t peak_rss(void) {
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return (size_t)usage.ru_maxrss;
+#else
+  return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/*
+ * Memory allocated by runtime is counted by installing malloc functions that
+ * keep the size in front of each block. The header keeps the alignment of
+ * malloc.
+ */
+#define ALLOCATION_HEADER (16)
+
+static size_t allocated_bytes = 0;
+#ifdef NNABLART_USE_PTHREAD
+static pthread_mutex_t allocated_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void count_allocation(size_t size, int sign) {
+#ifdef NNABLART_USE_PTHREAD
+  pthread_mutex_lock(&allocated_lock);
+#endif
+  if (sign > 0) {
+    allocated_bytes += size;
+  } else {
+    allocated_bytes -= size;
+  }
+#ifdef NNABLART_USE_PTHREAD
+  pthread_mutex_unlock(&allocated_lock);
+#endif
+}
+
+static void *counting_malloc(size_t size) {
+  uint8_t *p = malloc(size + ALLOCATION_HEADER);
+  if (p == 0) {
+    return 0;
+  }
+  *(size_t *)p = size;
+  count_allocation(size, 1);
+  return p + ALLOCATION_HEADER;
+}
+
+static void counting_free(void *ptr) {
+  if (ptr) {
+    uint8_t *p = (uint8_t *)ptr - ALLOCATION_HEADER;
+    count_allocation(*(size_t *)p, -1);
+    free(p);
+  }
+}
+
+typedef struct {
+  rt_context_pointer context;
+  int iterations;
+  double *latencies;
+  rt_return_value_t result;
+} bench_thread_t;
+
+static void *run_iterations(void *arg) {
+  bench_thread_t *t = arg;
+  int i;
+  t->result = RT_RET_NOERROR;
+  for (i = 0; i < t->iterations; i++) {
+    double begin = now();
+    t->result = rt_forward(t->context);
+    t->latencies[i] = now() - begin;
+    if (t->result != RT_RET_NOERROR) {
+      break;
+    }
+  }
+  return 0;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+// Nearest-rank percentile of sorted values.
+static double percentile(const double *sorted, int n, int p) {
+  int rank = (int)(((long long)p * n + 99) / 100);
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+typedef struct {
+  int iterations;
+  int warmup;
+  int threads;
+  double min, mean, p50, p90, p99, max;
+  double inferences_per_second;
+  size_t peak_rss;
+  size_t context_memory;
+  size_t activation_memory;
+} bench_result_t;
+
+static void write_json(FILE *fp, const bench_result_t *r) {
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"iterations\": %d,\n", r->iterations);
+  fprintf(fp, "  \"warmup\": %d,\n", r->warmup);
+  fprintf(fp, "  \"threads\": %d,\n", r->threads);
+  fprintf(fp,
+          "  \"latency_ms\": {\"min\": %.6f, \"mean\": %.6f, \"p50\": %.6f, "
+          "\"p90\": %.6f, \"p99\": %.6f, \"max\": %.6f},\n",
+          r->min * 1e3, r->mean * 1e3, r->p50 * 1e3, r->p90 * 1e3,
+          r->p99 * 1e3, r->max * 1e3);
+  fprintf(fp, "  \"inferences_per_second\": %.3f,\n",
+          r->inferences_per_second);
+  fprintf(fp, "  \"peak_rss_bytes\": %lu,\n", (unsigned long)r->peak_rss);
+  fprintf(fp, "  \"context_memory_bytes\": %lu,\n",
+          (unsigned long)r->context_memory);
+  fprintf(fp, "  \"activation_memory_bytes\": %lu\n",
+          (unsigned long)r->activation_memory);
+  fprintf(fp, "}\n");
+}
+
+static void usage(void) {
+  printf("Usage: nnablart bench NNB [-n ITERATIONS] [-w WARMUP] "
+         "[-t THREADS] [--json FILE] [INPUT...]\n");
+  printf("  Without INPUT files inputs are filled with random data.\n");
+}
+
+int bench(nn_network_t *net, int argc, char *argv[]) {
+  bench_result_t r;
+  const char *json_filename = 0;
+  bench_thread_t *threads = 0;
+  double *latencies = 0;
+  size_t memory_before;
+  double begin, wall;
+  int num_of_contexts = 0;
+  int i, j, n;
+  int result = -1;
+
+  r.iterations = DEFAULT_ITERATIONS;
+  r.warmup = DEFAULT_WARMUP;
+  r.threads = 1;
+  while (argc >= 2 && argv[0][0] == '-') {
+    if (strcmp(argv[0], "-n") == 0) {
+      r.iterations = atoi(argv[1]);
+    } else if (strcmp(argv[0], "-w") == 0) {
+      r.warmup = atoi(argv[1]);
+    } else if (strcmp(argv[0], "-t") == 0) {
+      r.threads = atoi(argv[1]);
+    } else if (strcmp(argv[0], "--json") == 0) {
+      json_filename = argv[1];
+    } else {
+      break;
+    }
+    argv += 2;
+    argc -= 2;
+  }
+  if ((argc > 0 && argv[0][0] == '-') || r.iterations <= 0 || r.warmup < 0 ||
+      r.threads <= 0) {
+    usage();
+    return -1;
+  }
+#ifndef NNABLART_USE_PTHREAD
+  if (r.threads > 1) {
+    printf("Threads are not available on this platform.\n");
+    return -1;
+  }
+#endif
+
+  threads = calloc(r.threads, sizeof(bench_thread_t));
+  latencies = malloc(sizeof(double) * r.iterations * r.threads);
+  if (threads == 0 || latencies == 0) {
+    printf("Cannot allocate memory.\n");
+    goto end;
+  }
+
+  // Contexts are created with counting allocators to measure their memory.
+  rt_set_malloc(counting_malloc);
+  rt_set_free(counting_free);
+  rt_set_variable_malloc(counting_malloc);
+  rt_set_variable_free(counting_free);
+  memory_before = allocated_bytes;
+
+  for (i = 0; i < r.threads; i++) {
+    rt_return_value_t ret;
+    if (i == 0) {
+      ret = rt_allocate_context(&threads[i].context);
+      if (ret == RT_RET_NOERROR) {
+        ret = rt_initialize_context(threads[i].context, net);
+      }
+    } else {
+      // Clones share weights derived at initialization with the first.
+      ret = rt_clone_context(threads[0].context, &threads[i].context);
+    }
+    if (threads[i].context) {
+      num_of_contexts++;
+    }
+    if (ret != RT_RET_NOERROR) {
+      printf("Cannot initialize context %d: %d.\n", i, ret);
+      goto end;
+    }
+    threads[i].iterations = r.iterations;
+    threads[i].latencies = latencies + r.iterations * i;
+  }
+  r.context_memory = allocated_bytes - memory_before;
+  r.activation_memory = rt_activation_memory_size(threads[0].context);
+
+  if (argc != 0 && argc != rt_num_of_input(threads[0].context)) {
+    printf("Incorrect input parameters.\n");
+    printf(" Required inputs: %d or none for random inputs\n",
+           rt_num_of_input(threads[0].context));
+    goto end;
+  }
+  for (i = 0; i < rt_num_of_input(threads[0].context); i++) {
+    if (prepare_input(threads[0].context, i, argc ? argv[i] : 0) < 0) {
+      goto end;
+    }
+    for (j = 1; j < r.threads; j++) {
+      memcpy(rt_input_buffer(threads[j].context, i),
+             rt_input_buffer(threads[0].context, i),
+             input_bytes(threads[0].context, i));
+    }
+  }
+
+  for (i = 0; i < r.threads; i++) {
+    for (j = 0; j < r.warmup; j++) {
+      if (rt_forward(threads[i].context) != RT_RET_NOERROR) {
+        printf("Error occurs in warmup.\n");
+        goto end;
+      }
+    }
+  }
+
+  begin = now();
+  if (r.threads == 1) {
+    run_iterations(threads);
+  } else {
+#ifdef NNABLART_USE_PTHREAD
+    pthread_t *handles = malloc(sizeof(pthread_t) * r.threads);
+    int started = 0;
+    if (handles) {
+      for (started = 0; started < r.threads; started++) {
+        if (pthread_create(handles + started, 0, run_iterations,
+                           threads + started) != 0) {
+          break;
+        }
+      }
+      for (i = 0; i < started; i++) {
+        pthread_join(handles[i], 0);
+      }
+      free(handles);
+    }
+    if (started != r.threads) {
+      printf("Cannot create threads.\n");
+      goto end;
+    }
+#endif
+  }
+  wall = now() - begin;
+
+  for (i = 0; i < r.threads; i++) {
+    if (threads[i].result != RT_RET_NOERROR) {
+      printf("Error occurs in bench process. %d\n", threads[i].result);
+      goto end;
+    }
+  }
+
+  n = r.iterations * r.threads;
+  qsort(latencies, n, sizeof(double), compare_double);
+  r.mean = 0;
+  for (i = 0; i < n; i++) {
+    r.mean += latencies[i];
+  }
+  r.mean /= n;
+  r.min = latencies[0];
+  r.p50 = percentile(latencies, n, 50);
+  r.p90 = percentile(latencies, n, 90);
+  r.p99 = percentile(latencies, n, 99);
+  r.max = latencies[n - 1];
+  r.inferences_per_second = wall > 0 ? n / wall : 0;
+  r.peak_rss = peak_rss();
+
+  printf("Iterations:        %d x %d threads (warmup %d)\n", r.iterations,
+         r.threads, r.warmup);
+  printf("Latency [ms]:      min %.4f mean %.4f p50 %.4f p90 %.4f p99 %.4f "
+         "max %.4f\n",
+         r.min * 1e3, r.mean * 1e3, r.p50 * 1e3, r.p90 * 1e3, r.p99 * 1e3,
+         r.max * 1e3);
+  printf("Throughput:        %.3f inferences/s\n", r.inferences_per_second);
+  printf("Peak RSS:          %lu bytes\n", (unsigned long)r.peak_rss);
+  printf("Context memory:    %lu bytes (%d contexts)\n",
+         (unsigned long)r.context_memory, r.threads);
+  printf("Activation memory: %lu bytes per context\n",
+         (unsigned long)r.activation_memory);
+
+  if (json_filename) {
+    FILE *fp = 0;
+#ifdef _MSC_VER
+    fopen_s(&fp, json_filename, "w");
+#else
+    fp = fopen(json_filename, "w");
+#endif
+    if (fp == NULL) {
+      printf("Cannot open output file:%s.\n", json_filename);
+      goto end;
+    }
+    write_json(fp, &r);
+    fclose(fp);
+  }
+  result = 0;
+
+end:
+  for (i = 0; i < num_of_contexts; i++) {
+    rt_free_context(&threads[i].context);
+  }
+  rt_set_malloc(0);
+  rt_set_free(0);
+  rt_set_variable_malloc(0);
+  rt_set_variable_free(0);
+  free(latencies);
+  free(threads);
+  return result;
+}
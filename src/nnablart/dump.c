@@ -22,6 +22,57 @@
 #include "../runtime/runtime_internal.h"
 #include "dump_function.h"
 
+static void dump_cpu_features(int features) {
+  printf("Runtime: CPU features:   ");
+  if (features == 0) {
+    printf(" none");
+  }
+  if (features & RT_CPU_FEATURE_SSE) {
+    printf(" sse");
+  }
+  if (features & RT_CPU_FEATURE_AVX2) {
+    printf(" avx2");
+  }
+  if (features & RT_CPU_FEATURE_AVX512F) {
+    printf(" avx512f");
+  }
+  if (features & RT_CPU_FEATURE_NEON) {
+    printf(" neon");
+  }
+  printf("\n");
+}
+
+// Kernels are selected when functions are initialized, show what the
+// context would run on this machine.
+static void dump_variants(nn_network_t *net) {
+  rt_context_pointer context = 0;
+  rt_return_value_t ret;
+  int i;
+
+  if (rt_allocate_context(&context) != RT_RET_NOERROR) {
+    printf("Runtime: Cannot allocate context.\n");
+    return;
+  }
+  dump_cpu_features(rt_cpu_features(context));
+  ret = rt_initialize_context(context, net);
+  if (ret != RT_RET_NOERROR) {
+    printf("Runtime: rt_initialize_context() failed with %d.\n", ret);
+  } else {
+    rt_context_t *c = context;
+    printf("Runtime: Has %d functions.\n", c->num_of_functions);
+    for (i = 0; i < c->num_of_functions; i++) {
+      const char *variant = rt_function_variant(context, i);
+      printf("Runtime: Function[%d] %-28s variant: %s\n", i,
+             function_name(c->functions[i].info->type),
+             variant ? variant : "-");
+    }
+    printf("Runtime: Aliased %d functions, %lu bytes not copied.\n",
+           rt_num_of_aliased_functions(context),
+           (unsigned long)rt_aliased_bytes(context));
+  }
+  rt_free_context(&context);
+}
+
 int dump(nn_network_t *net, int argc, char *argv[]) {
   unsigned int i, j;
 
@@ -71,5 +122,6 @@ int dump(nn_network_t *net, int argc, char *argv[]) {
     printf("NNB: Output[%d]  Variable id:%d\n", i, *(list + i));
   }
 
+  dump_variants(net);
   return 0;
 }
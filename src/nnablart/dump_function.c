@@ -1841,3 +1841,384 @@ void dump_function(nn_network_t *net, nn_function_t *func) {
   default:;
   }
 }
+
+const char *function_name(nn_function_type_t type) {
+  switch (type) {
+  case NN_FUNCTION_AFFINE: // Affine
+    return "Affine";
+  case NN_FUNCTION_RNN: // RNN
+    return "RNN";
+  case NN_FUNCTION_LSTM: // LSTM
+    return "LSTM";
+  case NN_FUNCTION_GRU: // GRU
+    return "GRU";
+  case NN_FUNCTION_CONVOLUTION: // Convolution
+    return "Convolution";
+  case NN_FUNCTION_FUSED_CONVOLUTION: // FusedConvolution
+    return "FusedConvolution";
+  case NN_FUNCTION_DEPTHWISE_CONVOLUTION: // DepthwiseConvolution
+    return "DepthwiseConvolution";
+  case NN_FUNCTION_DECONVOLUTION: // Deconvolution
+    return "Deconvolution";
+  case NN_FUNCTION_DEPTHWISE_DECONVOLUTION: // DepthwiseDeconvolution
+    return "DepthwiseDeconvolution";
+  case NN_FUNCTION_ADAPTIVE_SEPARABLE_CONVOLUTION: // AdaptiveSeparableConvolution
+    return "AdaptiveSeparableConvolution";
+  case NN_FUNCTION_MAX_POOLING: // MaxPooling
+    return "MaxPooling";
+  case NN_FUNCTION_AVERAGE_POOLING: // AveragePooling
+    return "AveragePooling";
+  case NN_FUNCTION_GLOBAL_AVERAGE_POOLING: // GlobalAveragePooling
+    return "GlobalAveragePooling";
+  case NN_FUNCTION_SUM_POOLING: // SumPooling
+    return "SumPooling";
+  case NN_FUNCTION_UNPOOLING: // Unpooling
+    return "Unpooling";
+  case NN_FUNCTION_EMBED: // Embed
+    return "Embed";
+  case NN_FUNCTION_SIGMOID: // Sigmoid
+    return "Sigmoid";
+  case NN_FUNCTION_SWISH: // Swish
+    return "Swish";
+  case NN_FUNCTION_TANH: // Tanh
+    return "Tanh";
+  case NN_FUNCTION_RELU: // ReLU
+    return "ReLU";
+  case NN_FUNCTION_LEAKY_RELU: // LeakyReLU
+    return "LeakyReLU";
+  case NN_FUNCTION_SOFTMAX: // Softmax
+    return "Softmax";
+  case NN_FUNCTION_LOG_SOFTMAX: // LogSoftmax
+    return "LogSoftmax";
+  case NN_FUNCTION_ELU: // ELU
+    return "ELU";
+  case NN_FUNCTION_SELU: // SELU
+    return "SELU";
+  case NN_FUNCTION_CRELU: // CReLU
+    return "CReLU";
+  case NN_FUNCTION_CELU: // CELU
+    return "CELU";
+  case NN_FUNCTION_PRELU: // PReLU
+    return "PReLU";
+  case NN_FUNCTION_GELU: // GELU
+    return "GELU";
+  case NN_FUNCTION_RELU6: // ReLU6
+    return "ReLU6";
+  case NN_FUNCTION_HARD_SIGMOID: // HardSigmoid
+    return "HardSigmoid";
+  case NN_FUNCTION_HARD_TANH: // HardTanh
+    return "HardTanh";
+  case NN_FUNCTION_LOG_SIGMOID: // LogSigmoid
+    return "LogSigmoid";
+  case NN_FUNCTION_SOFTPLUS: // SoftPlus
+    return "SoftPlus";
+  case NN_FUNCTION_SOFTSIGN: // SoftSign
+    return "SoftSign";
+  case NN_FUNCTION_TANH_SHRINK: // TanhShrink
+    return "TanhShrink";
+  case NN_FUNCTION_SINC: // Sinc
+    return "Sinc";
+  case NN_FUNCTION_FUSED_BATCH_NORMALIZATION: // FusedBatchNormalization
+    return "FusedBatchNormalization";
+  case NN_FUNCTION_BATCH_NORMALIZATION: // BatchNormalization
+    return "BatchNormalization";
+  case NN_FUNCTION_SYNC_BATCH_NORMALIZATION: // SyncBatchNormalization
+    return "SyncBatchNormalization";
+  case NN_FUNCTION_MEAN_SUBTRACTION: // MeanSubtraction
+    return "MeanSubtraction";
+  case NN_FUNCTION_CLIP_GRAD_BY_VALUE: // ClipGradByValue
+    return "ClipGradByValue";
+  case NN_FUNCTION_CLIP_GRAD_BY_NORM: // ClipGradByNorm
+    return "ClipGradByNorm";
+  case NN_FUNCTION_SUM: // Sum
+    return "Sum";
+  case NN_FUNCTION_MEAN: // Mean
+    return "Mean";
+  case NN_FUNCTION_MAX: // Max
+    return "Max";
+  case NN_FUNCTION_MIN: // Min
+    return "Min";
+  case NN_FUNCTION_PROD: // Prod
+    return "Prod";
+  case NN_FUNCTION_REDUCE_SUM: // ReduceSum
+    return "ReduceSum";
+  case NN_FUNCTION_REDUCE_MEAN: // ReduceMean
+    return "ReduceMean";
+  case NN_FUNCTION_ADD2: // Add2
+    return "Add2";
+  case NN_FUNCTION_ADD_N: // AddN
+    return "AddN";
+  case NN_FUNCTION_BC_ADD2: // BcAdd2
+    return "BcAdd2";
+  case NN_FUNCTION_SUB2: // Sub2
+    return "Sub2";
+  case NN_FUNCTION_MUL2: // Mul2
+    return "Mul2";
+  case NN_FUNCTION_MUL_N: // MulN
+    return "MulN";
+  case NN_FUNCTION_DIV2: // Div2
+    return "Div2";
+  case NN_FUNCTION_POW2: // Pow2
+    return "Pow2";
+  case NN_FUNCTION_ADD_SCALAR: // AddScalar
+    return "AddScalar";
+  case NN_FUNCTION_MUL_SCALAR: // MulScalar
+    return "MulScalar";
+  case NN_FUNCTION_POW_SCALAR: // PowScalar
+    return "PowScalar";
+  case NN_FUNCTION_R_SUB_SCALAR: // RSubScalar
+    return "RSubScalar";
+  case NN_FUNCTION_R_DIV_SCALAR: // RDivScalar
+    return "RDivScalar";
+  case NN_FUNCTION_R_POW_SCALAR: // RPowScalar
+    return "RPowScalar";
+  case NN_FUNCTION_SIGN: // Sign
+    return "Sign";
+  case NN_FUNCTION_MINIMUM2: // Minimum2
+    return "Minimum2";
+  case NN_FUNCTION_MAXIMUM2: // Maximum2
+    return "Maximum2";
+  case NN_FUNCTION_MINIMUM_SCALAR: // MinimumScalar
+    return "MinimumScalar";
+  case NN_FUNCTION_MAXIMUM_SCALAR: // MaximumScalar
+    return "MaximumScalar";
+  case NN_FUNCTION_LOGICAL_AND: // LogicalAnd
+    return "LogicalAnd";
+  case NN_FUNCTION_LOGICAL_OR: // LogicalOr
+    return "LogicalOr";
+  case NN_FUNCTION_LOGICAL_XOR: // LogicalXor
+    return "LogicalXor";
+  case NN_FUNCTION_EQUAL: // Equal
+    return "Equal";
+  case NN_FUNCTION_NOT_EQUAL: // NotEqual
+    return "NotEqual";
+  case NN_FUNCTION_GREATER_EQUAL: // GreaterEqual
+    return "GreaterEqual";
+  case NN_FUNCTION_GREATER: // Greater
+    return "Greater";
+  case NN_FUNCTION_LESS_EQUAL: // LessEqual
+    return "LessEqual";
+  case NN_FUNCTION_LESS: // Less
+    return "Less";
+  case NN_FUNCTION_LOGICAL_AND_SCALAR: // LogicalAndScalar
+    return "LogicalAndScalar";
+  case NN_FUNCTION_LOGICAL_OR_SCALAR: // LogicalOrScalar
+    return "LogicalOrScalar";
+  case NN_FUNCTION_LOGICAL_XOR_SCALAR: // LogicalXorScalar
+    return "LogicalXorScalar";
+  case NN_FUNCTION_EQUAL_SCALAR: // EqualScalar
+    return "EqualScalar";
+  case NN_FUNCTION_NOT_EQUAL_SCALAR: // NotEqualScalar
+    return "NotEqualScalar";
+  case NN_FUNCTION_GREATER_EQUAL_SCALAR: // GreaterEqualScalar
+    return "GreaterEqualScalar";
+  case NN_FUNCTION_GREATER_SCALAR: // GreaterScalar
+    return "GreaterScalar";
+  case NN_FUNCTION_LESS_EQUAL_SCALAR: // LessEqualScalar
+    return "LessEqualScalar";
+  case NN_FUNCTION_LESS_SCALAR: // LessScalar
+    return "LessScalar";
+  case NN_FUNCTION_LOGICAL_NOT: // LogicalNot
+    return "LogicalNot";
+  case NN_FUNCTION_ISNAN: // IsNaN
+    return "IsNaN";
+  case NN_FUNCTION_ISINF: // IsInf
+    return "IsInf";
+  case NN_FUNCTION_RESET_NAN: // ResetNaN
+    return "ResetNaN";
+  case NN_FUNCTION_RESET_INF: // ResetInf
+    return "ResetInf";
+  case NN_FUNCTION_WHERE: // Where
+    return "Where";
+  case NN_FUNCTION_CONSTANT: // Constant
+    return "Constant";
+  case NN_FUNCTION_ARANGE: // Arange
+    return "Arange";
+  case NN_FUNCTION_ABS: // Abs
+    return "Abs";
+  case NN_FUNCTION_EXP: // Exp
+    return "Exp";
+  case NN_FUNCTION_LOG: // Log
+    return "Log";
+  case NN_FUNCTION_IDENTITY: // Identity
+    return "Identity";
+  case NN_FUNCTION_BATCH_MATMUL: // BatchMatmul
+    return "BatchMatmul";
+  case NN_FUNCTION_ROUND: // Round
+    return "Round";
+  case NN_FUNCTION_CEIL: // Ceil
+    return "Ceil";
+  case NN_FUNCTION_FLOOR: // Floor
+    return "Floor";
+  case NN_FUNCTION_SIN: // Sin
+    return "Sin";
+  case NN_FUNCTION_COS: // Cos
+    return "Cos";
+  case NN_FUNCTION_TAN: // Tan
+    return "Tan";
+  case NN_FUNCTION_SINH: // Sinh
+    return "Sinh";
+  case NN_FUNCTION_COSH: // Cosh
+    return "Cosh";
+  case NN_FUNCTION_ASIN: // ASin
+    return "ASin";
+  case NN_FUNCTION_ACOS: // ACos
+    return "ACos";
+  case NN_FUNCTION_ATAN: // ATan
+    return "ATan";
+  case NN_FUNCTION_ATAN2: // ATan2
+    return "ATan2";
+  case NN_FUNCTION_ASINH: // ASinh
+    return "ASinh";
+  case NN_FUNCTION_ACOSH: // ACosh
+    return "ACosh";
+  case NN_FUNCTION_ATANH: // ATanh
+    return "ATanh";
+  case NN_FUNCTION_CONCATENATE: // Concatenate
+    return "Concatenate";
+  case NN_FUNCTION_SPLIT: // Split
+    return "Split";
+  case NN_FUNCTION_STACK: // Stack
+    return "Stack";
+  case NN_FUNCTION_SLICE: // Slice
+    return "Slice";
+  case NN_FUNCTION_PAD: // Pad
+    return "Pad";
+  case NN_FUNCTION_TRANSPOSE: // Transpose
+    return "Transpose";
+  case NN_FUNCTION_BROADCAST: // Broadcast
+    return "Broadcast";
+  case NN_FUNCTION_BROADCAST_TO: // BroadcastTo
+    return "BroadcastTo";
+  case NN_FUNCTION_TILE: // Tile
+    return "Tile";
+  case NN_FUNCTION_ONE_HOT: // OneHot
+    return "OneHot";
+  case NN_FUNCTION_FLIP: // Flip
+    return "Flip";
+  case NN_FUNCTION_SHIFT: // Shift
+    return "Shift";
+  case NN_FUNCTION_SORT: // Sort
+    return "Sort";
+  case NN_FUNCTION_RESHAPE: // Reshape
+    return "Reshape";
+  case NN_FUNCTION_MATRIX_DIAG: // MatrixDiag
+    return "MatrixDiag";
+  case NN_FUNCTION_MATRIX_DIAG_PART: // MatrixDiagPart
+    return "MatrixDiagPart";
+  case NN_FUNCTION_BATCH_INV: // BatchInv
+    return "BatchInv";
+  case NN_FUNCTION_BATCH_DET: // BatchDet
+    return "BatchDet";
+  case NN_FUNCTION_ASSIGN: // Assign
+    return "Assign";
+  case NN_FUNCTION_GATHER_ND: // GatherNd
+    return "GatherNd";
+  case NN_FUNCTION_SCATTER_ND: // ScatterNd
+    return "ScatterNd";
+  case NN_FUNCTION_INTERPOLATE: // Interpolate
+    return "Interpolate";
+  case NN_FUNCTION_FFT: // FFT
+    return "FFT";
+  case NN_FUNCTION_IFFT: // IFFT
+    return "IFFT";
+  case NN_FUNCTION_DROPOUT: // Dropout
+    return "Dropout";
+  case NN_FUNCTION_TOP_K_DATA: // TopKData
+    return "TopKData";
+  case NN_FUNCTION_TOP_K_GRAD: // TopKGrad
+    return "TopKGrad";
+  case NN_FUNCTION_RAND: // Rand
+    return "Rand";
+  case NN_FUNCTION_RANDINT: // Randint
+    return "Randint";
+  case NN_FUNCTION_RANDN: // Randn
+    return "Randn";
+  case NN_FUNCTION_RAND_BINOMIAL: // RandBinomial
+    return "RandBinomial";
+  case NN_FUNCTION_RAND_BETA: // RandBeta
+    return "RandBeta";
+  case NN_FUNCTION_RAND_GAMMA: // RandGamma
+    return "RandGamma";
+  case NN_FUNCTION_RANDOM_CHOICE: // RandomChoice
+    return "RandomChoice";
+  case NN_FUNCTION_RANDOM_CROP: // RandomCrop
+    return "RandomCrop";
+  case NN_FUNCTION_RANDOM_FLIP: // RandomFlip
+    return "RandomFlip";
+  case NN_FUNCTION_RANDOM_SHIFT: // RandomShift
+    return "RandomShift";
+  case NN_FUNCTION_RANDOM_ERASE: // RandomErase
+    return "RandomErase";
+  case NN_FUNCTION_IMAGE_AUGMENTATION: // ImageAugmentation
+    return "ImageAugmentation";
+  case NN_FUNCTION_SIGMOID_CROSS_ENTROPY: // SigmoidCrossEntropy
+    return "SigmoidCrossEntropy";
+  case NN_FUNCTION_BINARY_CROSS_ENTROPY: // BinaryCrossEntropy
+    return "BinaryCrossEntropy";
+  case NN_FUNCTION_SOFTMAX_CROSS_ENTROPY: // SoftmaxCrossEntropy
+    return "SoftmaxCrossEntropy";
+  case NN_FUNCTION_CATEGORICAL_CROSS_ENTROPY: // CategoricalCrossEntropy
+    return "CategoricalCrossEntropy";
+  case NN_FUNCTION_SQUARED_ERROR: // SquaredError
+    return "SquaredError";
+  case NN_FUNCTION_ABSOLUTE_ERROR: // AbsoluteError
+    return "AbsoluteError";
+  case NN_FUNCTION_HUBER_LOSS: // HuberLoss
+    return "HuberLoss";
+  case NN_FUNCTION_EPSILON_INSENSITIVE_LOSS: // EpsilonInsensitiveLoss
+    return "EpsilonInsensitiveLoss";
+  case NN_FUNCTION_KL_MULTINOMIAL: // KLMultinomial
+    return "KLMultinomial";
+  case NN_FUNCTION_BINARY_SIGMOID: // BinarySigmoid
+    return "BinarySigmoid";
+  case NN_FUNCTION_BINARY_TANH: // BinaryTanh
+    return "BinaryTanh";
+  case NN_FUNCTION_BINARY_CONNECT_AFFINE: // BinaryConnectAffine
+    return "BinaryConnectAffine";
+  case NN_FUNCTION_BINARY_CONNECT_CONVOLUTION: // BinaryConnectConvolution
+    return "BinaryConnectConvolution";
+  case NN_FUNCTION_BINARY_WEIGHT_AFFINE: // BinaryWeightAffine
+    return "BinaryWeightAffine";
+  case NN_FUNCTION_BINARY_WEIGHT_CONVOLUTION: // BinaryWeightConvolution
+    return "BinaryWeightConvolution";
+  case NN_FUNCTION_INQ_AFFINE: // INQAffine
+    return "INQAffine";
+  case NN_FUNCTION_INQ_CONVOLUTION: // INQConvolution
+    return "INQConvolution";
+  case NN_FUNCTION_FIXED_POINT_QUANTIZE: // FixedPointQuantize
+    return "FixedPointQuantize";
+  case NN_FUNCTION_MIN_MAX_QUANTIZE: // MinMaxQuantize
+    return "MinMaxQuantize";
+  case NN_FUNCTION_POW2_QUANTIZE: // Pow2Quantize
+    return "Pow2Quantize";
+  case NN_FUNCTION_PRUNE: // Prune
+    return "Prune";
+  case NN_FUNCTION_QUANTIZE_LINEAR: // QuantizeLinear
+    return "QuantizeLinear";
+  case NN_FUNCTION_DEQUANTIZE_LINEAR: // DequantizeLinear
+    return "DequantizeLinear";
+  case NN_FUNCTION_TOP_N_ERROR: // TopNError
+    return "TopNError";
+  case NN_FUNCTION_BINARY_ERROR: // BinaryError
+    return "BinaryError";
+  case NN_FUNCTION_CONFUSION_MATRIX: // ConfusionMatrix
+    return "ConfusionMatrix";
+  case NN_FUNCTION_VAT_NOISE: // VATNoise
+    return "VATNoise";
+  case NN_FUNCTION_UNLINK: // Unlink
+    return "Unlink";
+  case NN_FUNCTION_SINK: // Sink
+    return "Sink";
+  case NN_FUNCTION_NMS_DETECTION2D: // NmsDetection2d
+    return "NmsDetection2d";
+  case NN_FUNCTION_MAX_POOLING_BACKWARD: // MaxPoolingBackward
+    return "MaxPoolingBackward";
+  case NN_FUNCTION_WARP_BY_FLOW: // WarpByFlow
+    return "WarpByFlow";
+  case NN_FUNCTION_PATCH_CORRELATION: // PatchCorrelation
+    return "PatchCorrelation";
+  default:
+    return "Unknown";
+  }
+}
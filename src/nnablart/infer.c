@@ -20,6 +20,8 @@
 #include <nnablart/network.h>
 #include <nnablart/runtime.h>
 
+#include "dump_function.h"
+
 static int check_data_size(int actual_size, int expected_size) {
   if (actual_size != expected_size) {
     printf("Input data size is invalid.\n");
@@ -30,9 +32,27 @@ static int check_data_size(int actual_size, int expected_size) {
   return 0;
 }
 
+// Remove `--trace <filename>` from arguments and return filename.
+static const char *trace_option(int *argc, char *argv[]) {
+  const char *filename = 0;
+  int i, j;
+  for (i = 0; i + 1 < *argc; i++) {
+    if (strcmp(argv[i], "--trace") == 0) {
+      filename = argv[i + 1];
+      for (j = i; j + 2 < *argc; j++) {
+        argv[j] = argv[j + 2];
+      }
+      *argc -= 2;
+      break;
+    }
+  }
+  return filename;
+}
+
 int infer(nn_network_t *net, int argc, char *argv[]) {
   int i, j; // Iterator
   rt_return_value_t ret;
+  const char *trace_filename = trace_option(&argc, argv);
   const char *data_type[] = {"NN_DATA_TYPE_FLOAT", "NN_DATA_TYPE_INT16",
                              "NN_DATA_TYPE_INT8", "NN_DATA_TYPE_SIGN",
                              "END_OF_NN_DATA_TYPE"};
@@ -141,12 +161,26 @@ int infer(nn_network_t *net, int argc, char *argv[]) {
     printf(" )\n");
   }
 
+  if (trace_filename) {
+    ret = rt_enable_trace(context, 1);
+    assert(ret == RT_RET_NOERROR);
+  }
+
   ret = rt_forward(context);
   if (ret != RT_RET_NOERROR) {
     printf("Error occurs in infer process. %d\n", ret);
     return -1;
   }
 
+  if (trace_filename) {
+    printf("Trace filename %s\n", trace_filename);
+    if (rt_write_trace(context, trace_filename, function_name) !=
+        RT_RET_NOERROR) {
+      printf("Cannot write trace file:%s.\n", trace_filename);
+      return -1;
+    }
+  }
+
   for (i = 0; i < rt_num_of_output(context); i++) {
     printf("Output[%d] size:%d\n", i, rt_output_size(context, i));
     size_t output_filename_length = strlen(*argv) + 10;
@@ -0,0 +1,76 @@
+// Copyright (c) 2017 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "input.h"
+
+size_t input_bytes(rt_context_pointer context, int index) {
+  size_t size = rt_input_size(context, index);
+  switch (rt_input_variable(context, index)->type) {
+  case NN_DATA_TYPE_FLOAT:
+    return size * sizeof(float);
+  case NN_DATA_TYPE_INT16:
+    return size * sizeof(int16_t);
+  case NN_DATA_TYPE_SIGN:
+    return size >> 3;
+  default:
+    return size;
+  }
+}
+
+int prepare_input(rt_context_pointer context, int index,
+                  const char *filename) {
+  size_t size = input_bytes(context, index);
+  uint8_t *buffer = rt_input_buffer(context, index);
+  size_t i;
+
+  if (filename == 0) {
+    // Random values in [-1, 1) for float, random bytes otherwise.
+    if (rt_input_variable(context, index)->type == NN_DATA_TYPE_FLOAT) {
+      float *data = (float *)buffer;
+      for (i = 0; i < size / sizeof(float); i++) {
+        data[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+      }
+    } else {
+      for (i = 0; i < size; i++) {
+        buffer[i] = (uint8_t)rand();
+      }
+    }
+    return 0;
+  }
+
+  FILE *input = 0;
+#ifdef _MSC_VER
+  fopen_s(&input, filename, "rb");
+#else
+  input = fopen(filename, "rb");
+#endif
+  if (input == NULL) {
+    printf("Cannot open input file: %s.\n", filename);
+    return -1;
+  }
+  size_t read_size = fread(buffer, sizeof(uint8_t), size, input);
+  fclose(input);
+  if (read_size != size) {
+    printf("Input data size of %s is invalid, expected %d bytes.\n", filename,
+           (int)size);
+    return -1;
+  }
+  return 0;
+}
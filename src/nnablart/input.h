@@ -0,0 +1,25 @@
+// Copyright (c) 2017 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_INPUT_H_181005093021_
+#define H_INPUT_H_181005093021_
+
+// Size of input buffer in bytes.
+size_t input_bytes(rt_context_pointer context, int index);
+
+// Fill input buffer with contents of file, or random data if filename is 0.
+// Returns -1 with message printed on failure.
+int prepare_input(rt_context_pointer context, int index, const char *filename);
+
+#endif // H_INPUT_H_181005093021_
@@ -12,15 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 
 #include <nnablart/network.h>
 #include <nnablart/runtime.h>
 
+#include "bench.h"
 #include "dump.h"
 #include "infer.h"
+#include "profile.h"
 
 int main(int argc, char *argv[]) {
   int ret = -1;
@@ -39,40 +40,33 @@ int main(int argc, char *argv[]) {
       argv += 3;
       argc -= 3;
 
-      FILE *nnb = 0;
-#ifdef _MSC_VER
-      fopen_s(&nnb, nnb_filename, "rb");
-#else
-      nnb = fopen(nnb_filename, "rb");
-#endif
-      assert(nnb);
-      fseek(nnb, 0L, SEEK_END);
-      size_t nnb_data_size = ftell(nnb);
-      fseek(nnb, 0L, SEEK_SET);
-      uint8_t *nnb_data = malloc(nnb_data_size);
-      assert(nnb_data);
-      int read_size = (int)fread(nnb_data, sizeof(uint8_t), nnb_data_size, nnb);
-      assert(read_size == nnb_data_size);
-      fclose(nnb);
-
-      nn_network_t *net = (nn_network_t *)nnb_data;
+      nn_network_t *net = 0;
+      if (rt_load_network_file(nnb_filename, &net) != RT_RET_NOERROR) {
+        printf("Cannot load network file: %s.\n", nnb_filename);
+        return -1;
+      }
 
       if (strncmp("dump", subcmd, 4) == 0) {
         ret = dump(net, argc, argv);
       } else if (strncmp("infer", subcmd, 5) == 0) {
         ret = infer(net, argc, argv);
+      } else if (strncmp("bench", subcmd, 5) == 0) {
+        ret = bench(net, argc, argv);
+      } else if (strncmp("profile", subcmd, 7) == 0) {
+        ret = profile(net, argc, argv);
       } else {
         printf("Unknown subcommand [%s]\n", subcmd);
       }
 
-      free(nnb_data);
+      rt_unload_network_file(net);
     } else {
       printf("Unknown subcommand [%s]\n", subcmd);
     }
 
   } else {
     printf("No subcommand.\n");
-    printf("Please specify sub command `dump`, `infer` or `version`.\n");
+    printf("Please specify sub command `bench`, `dump`, `infer`, `profile` "
+           "or `version`.\n");
   }
   return ret;
 }
@@ -0,0 +1,192 @@
+// Copyright (c) 2017 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "dump_function.h"
+#include "input.h"
+#include "profile.h"
+
+#define DEFAULT_ITERATIONS (10)
+
+typedef struct {
+  int index;
+  nn_function_type_t type;
+  int num_of_functions;
+  double time;
+  size_t output_bytes;
+  double flops;
+  const char *variant;
+} profile_row_t;
+
+static int compare_time(const void *a, const void *b) {
+  const profile_row_t *ra = a;
+  const profile_row_t *rb = b;
+  if (ra->time != rb->time) {
+    return ra->time < rb->time ? 1 : -1;
+  }
+  return ra->index - rb->index;
+}
+
+static void print_rows(const profile_row_t *rows, int num_of_rows,
+                       int iterations, double total, int per_layer) {
+  int i;
+  if (per_layer) {
+    printf("%6s %-28s %-17s", "Index", "Function", "Variant");
+  } else {
+    printf("%-35s %5s", "Function type", "Count");
+  }
+  printf(" %10s %7s %12s %10s %9s\n", "Time[ms]", "Ratio", "Output[B]",
+         "MFLOPs", "GFLOP/s");
+  for (i = 0; i < num_of_rows; i++) {
+    const profile_row_t *r = rows + i;
+    double time = r->time / iterations;
+    if (per_layer) {
+      printf("%6d %-28s %-17s", r->index, function_name(r->type),
+             r->variant ? r->variant : "-");
+    } else {
+      printf("%-35s %5d", function_name(r->type), r->num_of_functions);
+    }
+    printf(" %10.4f %6.2f%% %12lu %10.3f %9.3f\n", time * 1e3,
+           total > 0 ? r->time / total * 100.0 : 0.0,
+           (unsigned long)r->output_bytes, r->flops * 1e-6,
+           time > 0 ? r->flops / time * 1e-9 : 0.0);
+  }
+}
+
+static void usage(void) {
+  printf("Usage: nnablart profile NNB [-n ITERATIONS] [INPUT...]\n");
+  printf("  Without INPUT files inputs are filled with random data.\n");
+}
+
+int profile(nn_network_t *net, int argc, char *argv[]) {
+  int i, j;
+  int iterations = DEFAULT_ITERATIONS;
+  rt_return_value_t ret;
+  rt_context_pointer context = 0;
+  profile_row_t *rows = 0;
+  int num_of_functions, num_of_rows = 0;
+  double total = 0;
+  int result = -1;
+
+  while (argc >= 2 && argv[0][0] == '-') {
+    if (strcmp(argv[0], "-n") == 0) {
+      iterations = atoi(argv[1]);
+    } else {
+      break;
+    }
+    argv += 2;
+    argc -= 2;
+  }
+  if ((argc > 0 && argv[0][0] == '-') || iterations <= 0) {
+    usage();
+    return -1;
+  }
+
+  if (rt_allocate_context(&context) != RT_RET_NOERROR) {
+    printf("Cannot allocate context.\n");
+    return -1;
+  }
+  ret = rt_initialize_context(context, net);
+  if (ret != RT_RET_NOERROR) {
+    printf("rt_initialize_context() failed with %d.\n", ret);
+    goto end;
+  }
+
+  if (argc != 0 && argc != rt_num_of_input(context)) {
+    printf("Incorrect input parameters.\n");
+    printf(" Required inputs: %d or none for random inputs\n",
+           rt_num_of_input(context));
+    printf(" Actual inputs: %d\n", argc);
+    goto end;
+  }
+  for (i = 0; i < rt_num_of_input(context); i++) {
+    if (prepare_input(context, i, argc ? argv[i] : 0) < 0) {
+      goto end;
+    }
+  }
+
+  // The first run warms up caches and lazily initialized data.
+  ret = rt_forward(context);
+  if (ret == RT_RET_NOERROR) {
+    ret = rt_enable_profile(context, 1);
+  }
+  for (i = 0; i < iterations && ret == RT_RET_NOERROR; i++) {
+    ret = rt_forward(context);
+  }
+  if (ret != RT_RET_NOERROR) {
+    printf("Error occurs in profile process. %d\n", ret);
+    goto end;
+  }
+
+  num_of_functions = rt_num_of_functions(context);
+  rows = malloc(sizeof(profile_row_t) * (num_of_functions + 1));
+  if (rows == 0) {
+    printf("Cannot allocate memory.\n");
+    goto end;
+  }
+
+  for (i = 0; i < num_of_functions; i++) {
+    const rt_function_profile_t *p = rt_function_profile(context, i);
+    rows[i].index = i;
+    rows[i].type = p->type;
+    rows[i].num_of_functions = 1;
+    rows[i].time = p->time;
+    rows[i].output_bytes = p->output_bytes;
+    rows[i].flops = p->flops;
+    rows[i].variant = rt_function_variant(context, i);
+    total += p->time;
+  }
+
+  printf("Iterations: %d, average time of functions: %.4f [ms]\n",
+         iterations, total / iterations * 1e3);
+  printf("Aliased functions: %d, bytes not copied: %lu\n\n",
+         rt_num_of_aliased_functions(context),
+         (unsigned long)rt_aliased_bytes(context));
+  qsort(rows, num_of_functions, sizeof(profile_row_t), compare_time);
+  print_rows(rows, num_of_functions, iterations, total, 1);
+
+  // Merge rows into one per function type.
+  for (i = 0; i < num_of_functions; i++) {
+    for (j = 0; j < num_of_rows; j++) {
+      if (rows[j].type == rows[i].type) {
+        break;
+      }
+    }
+    if (j == num_of_rows) {
+      rows[num_of_rows] = rows[i];
+      rows[num_of_rows].index = num_of_rows;
+      num_of_rows++;
+    } else {
+      rows[j].num_of_functions++;
+      rows[j].time += rows[i].time;
+      rows[j].output_bytes += rows[i].output_bytes;
+      rows[j].flops += rows[i].flops;
+    }
+  }
+  printf("\n");
+  qsort(rows, num_of_rows, sizeof(profile_row_t), compare_time);
+  print_rows(rows, num_of_rows, iterations, total, 0);
+  result = 0;
+
+end:
+  free(rows);
+  rt_free_context(&context);
+  return result;
+}
@@ -17,6 +17,9 @@
 
 #include <nnablart/functions.h>
 #include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "trace.h"
 
 typedef struct {
   rt_buffer_allocate_type_t allocate_type;
@@ -26,6 +29,7 @@ typedef struct {
 typedef struct {
   nn_function_t *info;
   rt_function_t func;
+  int user_defined; // Allocated by a callback of rt_add_callback()
 } rt_function_context_t;
 
 typedef struct {
@@ -54,6 +58,66 @@ typedef struct {
 
   nn_network_t *network;
 
+  rt_parallel_t parallel;
+  void *thread_pool;
+
+  // Functions grouped by dependency, see rt_build_schedule().
+  int num_of_stages;
+  int *stage_offsets;
+  int *stage_functions;
+  rt_function_error_t *stage_results;
+  int current_stage;
+  int inter_op_parallel;
+  rt_parallel_t serial;
+
+  // Data derived from parameters, shared with clones, see rt_clone_context().
+  rt_shared_cache_t *shared_cache;
+
+  // Features kernels may use, see rt_set_cpu_features().
+  int cpu_features;
+
+  // Graph optimizations, see rt_set_optimization() and rt_build_graph().
+  int optimization;
+  int num_of_derived_variables;
+  rt_variable_t *derived_variables; // Folded weights and biases
+  int *derived_dims;                // Shape data of derived biases
+  int *aliases;         // Variable whose data each one is a view of, or -1
+  int *alias_offsets;   // Offset of each view in bytes
+  int num_of_aliased;   // Functions elided by making views
+  size_t aliased_bytes; // Size of the views
+
+  // Activation memory, see rt_plan_memory().
+  rt_memory_plan_t memory_plan;
+  void *arena;
+  size_t arena_size;
+
+  // Single block holding runtime data and activations, see
+  // rt_use_memory_block().
+  int use_memory_block;
+  void *memory_block_owned; // Allocated by runtime, 0 if supplied by user
+  uint8_t *memory_block;    // Aligned start
+  size_t memory_block_size; // Bytes from aligned start
+  size_t memory_block_used;
+  int measuring;             // Counting what functions allocate
+  size_t function_data_size; // Bytes counted while measuring
+  // Given to functions while using the block or measuring, see
+  // rt_function_t::allocator.
+  rt_allocator_t function_allocator;
+  nn_network_t *measured_network; // Network measured_size holds bytes for
+  size_t measured_size;           // Function data size of measured_network
+
+  // Scratch memory of functions, see rt_function_t::workspace.
+  void *workspace;         // Allocation, 0 if no function needs one
+  size_t workspace_size;   // Bytes from aligned start
+  int workspace_per_stage; // Functions of a stage have their own parts
+
+  // Instrumentation, see rt_set_function_hooks() and rt_enable_profile().
+  rt_function_hook_t pre_exec_hook;
+  rt_function_hook_t post_exec_hook;
+  void *hook_user_data;
+  rt_function_profile_t *profile;
+  rt_trace_t *trace;
+
 } rt_context_t;
 
 #endif // H_CONTEXT_H_171220164849_
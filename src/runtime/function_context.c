@@ -25,15 +25,16 @@
 
 #include "runtime_internal.h"
 
-void allocate_function_context(nn_network_t *n, nn_function_t *function,
+void allocate_function_context(rt_context_t *c, nn_network_t *n,
+                               nn_function_t *function,
                                rt_function_context_t *function_context) {
   switch (function_context->info->type) {
 #ifdef CONFIG_AFFINE
   case NN_FUNCTION_AFFINE: { // Affine
     function_context->func.free_local_context_func = free_affine_local_context;
     nn_function_affine_t *f = (nn_function_affine_t *)function;
-    affine_local_context_t *ctx =
-        rt_malloc_func(sizeof(affine_local_context_t));
+    affine_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(affine_local_context_t));
     ctx->base_axis = f->base_axis;
     function_context->func.local_context = ctx;
     allocate_affine_local_context(&function_context->func);
@@ -44,7 +45,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RNN: { // RNN
     function_context->func.free_local_context_func = free_rnn_local_context;
     nn_function_rnn_t *f = (nn_function_rnn_t *)function;
-    rnn_local_context_t *ctx = rt_malloc_func(sizeof(rnn_local_context_t));
+    rnn_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(rnn_local_context_t));
     ctx->num_layers = f->num_layers;
     ctx->nonlinearity = f->nonlinearity;
     ctx->dropout = f->dropout;
@@ -59,7 +61,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_LSTM: { // LSTM
     function_context->func.free_local_context_func = free_lstm_local_context;
     nn_function_lstm_t *f = (nn_function_lstm_t *)function;
-    lstm_local_context_t *ctx = rt_malloc_func(sizeof(lstm_local_context_t));
+    lstm_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(lstm_local_context_t));
     ctx->num_layers = f->num_layers;
     ctx->dropout = f->dropout;
     ctx->bidirectional = f->bidirectional;
@@ -73,7 +76,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_GRU: { // GRU
     function_context->func.free_local_context_func = free_gru_local_context;
     nn_function_gru_t *f = (nn_function_gru_t *)function;
-    gru_local_context_t *ctx = rt_malloc_func(sizeof(gru_local_context_t));
+    gru_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(gru_local_context_t));
     ctx->num_layers = f->num_layers;
     ctx->dropout = f->dropout;
     ctx->bidirectional = f->bidirectional;
@@ -88,8 +92,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_convolution_local_context;
     nn_function_convolution_t *f = (nn_function_convolution_t *)function;
-    convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(convolution_local_context_t));
+    convolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -103,8 +107,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_convolution_local_context;
     nn_function_convolution_t *f = (nn_function_convolution_t *)function;
-    convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(convolution_local_context_t));
+    convolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -122,8 +126,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_fused_convolution_local_context;
     nn_function_fused_convolution_t *f =
         (nn_function_fused_convolution_t *)function;
-    fused_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(fused_convolution_local_context_t));
+    fused_convolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(fused_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -145,8 +149,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_depthwise_convolution_local_context;
     nn_function_depthwise_convolution_t *f =
         (nn_function_depthwise_convolution_t *)function;
-    depthwise_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(depthwise_convolution_local_context_t));
+    depthwise_convolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(depthwise_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -162,8 +166,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_deconvolution_local_context;
     nn_function_deconvolution_t *f = (nn_function_deconvolution_t *)function;
-    deconvolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(deconvolution_local_context_t));
+    deconvolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(deconvolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -179,8 +183,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_deconvolution_local_context;
     nn_function_deconvolution_t *f = (nn_function_deconvolution_t *)function;
-    deconvolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(deconvolution_local_context_t));
+    deconvolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(deconvolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -196,8 +200,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_deconvolution_local_context;
     nn_function_deconvolution_t *f = (nn_function_deconvolution_t *)function;
-    deconvolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(deconvolution_local_context_t));
+    deconvolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(deconvolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -217,7 +221,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_depthwise_deconvolution_t *f =
         (nn_function_depthwise_deconvolution_t *)function;
     depthwise_deconvolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(depthwise_deconvolution_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(depthwise_deconvolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -243,8 +248,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_max_pooling_local_context;
     nn_function_max_pooling_t *f = (nn_function_max_pooling_t *)function;
-    max_pooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(max_pooling_local_context_t));
+    max_pooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(max_pooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -257,8 +262,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_max_pooling_local_context;
     nn_function_max_pooling_t *f = (nn_function_max_pooling_t *)function;
-    max_pooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(max_pooling_local_context_t));
+    max_pooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(max_pooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -275,8 +280,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_average_pooling_local_context;
     nn_function_average_pooling_t *f =
         (nn_function_average_pooling_t *)function;
-    average_pooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(average_pooling_local_context_t));
+    average_pooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(average_pooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -291,8 +296,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_average_pooling_local_context;
     nn_function_average_pooling_t *f =
         (nn_function_average_pooling_t *)function;
-    average_pooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(average_pooling_local_context_t));
+    average_pooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(average_pooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -318,8 +323,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_sum_pooling_local_context;
     nn_function_sum_pooling_t *f = (nn_function_sum_pooling_t *)function;
-    sum_pooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(sum_pooling_local_context_t));
+    sum_pooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(sum_pooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -332,8 +337,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_sum_pooling_local_context;
     nn_function_sum_pooling_t *f = (nn_function_sum_pooling_t *)function;
-    sum_pooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(sum_pooling_local_context_t));
+    sum_pooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(sum_pooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -349,8 +354,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_unpooling_local_context;
     nn_function_unpooling_t *f = (nn_function_unpooling_t *)function;
-    unpooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(unpooling_local_context_t));
+    unpooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(unpooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->channel_last = 0;
     function_context->func.local_context = ctx;
@@ -360,8 +365,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_unpooling_local_context;
     nn_function_unpooling_t *f = (nn_function_unpooling_t *)function;
-    unpooling_local_context_t *ctx =
-        rt_malloc_func(sizeof(unpooling_local_context_t));
+    unpooling_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(unpooling_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->channel_last = f->channel_last;
     function_context->func.local_context = ctx;
@@ -405,7 +410,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RELU: { // ReLU
     function_context->func.free_local_context_func = free_relu_local_context;
     nn_function_relu_t *f = (nn_function_relu_t *)function;
-    relu_local_context_t *ctx = rt_malloc_func(sizeof(relu_local_context_t));
+    relu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(relu_local_context_t));
     ctx->inplace = f->inplace;
     function_context->func.local_context = ctx;
     allocate_relu_local_context(&function_context->func);
@@ -417,8 +423,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_leaky_relu_local_context;
     nn_function_leaky_relu_t *f = (nn_function_leaky_relu_t *)function;
-    leaky_relu_local_context_t *ctx =
-        rt_malloc_func(sizeof(leaky_relu_local_context_t));
+    leaky_relu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(leaky_relu_local_context_t));
     ctx->alpha = f->alpha;
     ctx->inplace = 0;
     function_context->func.local_context = ctx;
@@ -428,8 +434,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_leaky_relu_local_context;
     nn_function_leaky_relu_t *f = (nn_function_leaky_relu_t *)function;
-    leaky_relu_local_context_t *ctx =
-        rt_malloc_func(sizeof(leaky_relu_local_context_t));
+    leaky_relu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(leaky_relu_local_context_t));
     ctx->alpha = f->alpha;
     ctx->inplace = f->inplace;
     function_context->func.local_context = ctx;
@@ -441,8 +447,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SOFTMAX: { // Softmax
     function_context->func.free_local_context_func = free_softmax_local_context;
     nn_function_softmax_t *f = (nn_function_softmax_t *)function;
-    softmax_local_context_t *ctx =
-        rt_malloc_func(sizeof(softmax_local_context_t));
+    softmax_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(softmax_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_softmax_local_context(&function_context->func);
@@ -454,8 +460,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_log_softmax_local_context;
     nn_function_log_softmax_t *f = (nn_function_log_softmax_t *)function;
-    log_softmax_local_context_t *ctx =
-        rt_malloc_func(sizeof(log_softmax_local_context_t));
+    log_softmax_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(log_softmax_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_log_softmax_local_context(&function_context->func);
@@ -466,7 +472,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_ELU: { // ELU
     function_context->func.free_local_context_func = free_elu_local_context;
     nn_function_elu_t *f = (nn_function_elu_t *)function;
-    elu_local_context_t *ctx = rt_malloc_func(sizeof(elu_local_context_t));
+    elu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(elu_local_context_t));
     ctx->alpha = f->alpha;
     function_context->func.local_context = ctx;
     allocate_elu_local_context(&function_context->func);
@@ -477,7 +484,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SELU: { // SELU
     function_context->func.free_local_context_func = free_selu_local_context;
     nn_function_selu_t *f = (nn_function_selu_t *)function;
-    selu_local_context_t *ctx = rt_malloc_func(sizeof(selu_local_context_t));
+    selu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(selu_local_context_t));
     ctx->scale = f->scale;
     ctx->alpha = f->alpha;
     function_context->func.local_context = ctx;
@@ -489,7 +497,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_CRELU: { // CReLU
     function_context->func.free_local_context_func = free_crelu_local_context;
     nn_function_crelu_t *f = (nn_function_crelu_t *)function;
-    crelu_local_context_t *ctx = rt_malloc_func(sizeof(crelu_local_context_t));
+    crelu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(crelu_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_crelu_local_context(&function_context->func);
@@ -500,7 +509,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_CELU: { // CELU
     function_context->func.free_local_context_func = free_celu_local_context;
     nn_function_celu_t *f = (nn_function_celu_t *)function;
-    celu_local_context_t *ctx = rt_malloc_func(sizeof(celu_local_context_t));
+    celu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(celu_local_context_t));
     ctx->alpha = f->alpha;
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
@@ -512,7 +522,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_PRELU: { // PReLU
     function_context->func.free_local_context_func = free_prelu_local_context;
     nn_function_prelu_t *f = (nn_function_prelu_t *)function;
-    prelu_local_context_t *ctx = rt_malloc_func(sizeof(prelu_local_context_t));
+    prelu_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(prelu_local_context_t));
     ctx->base_axis = f->base_axis;
     function_context->func.local_context = ctx;
     allocate_prelu_local_context(&function_context->func);
@@ -610,7 +621,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_fused_batch_normalization_t *f =
         (nn_function_fused_batch_normalization_t *)function;
     fused_batch_normalization_local_context_t *ctx =
-        rt_malloc_func(sizeof(fused_batch_normalization_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(fused_batch_normalization_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->decay_rate = f->decay_rate;
     ctx->eps = f->eps;
@@ -627,8 +639,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_batch_normalization_local_context;
     nn_function_batch_normalization_t *f =
         (nn_function_batch_normalization_t *)function;
-    batch_normalization_local_context_t *ctx =
-        rt_malloc_func(sizeof(batch_normalization_local_context_t));
+    batch_normalization_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(batch_normalization_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->decay_rate = f->decay_rate;
     ctx->eps = f->eps;
@@ -645,7 +657,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_sync_batch_normalization_t *f =
         (nn_function_sync_batch_normalization_t *)function;
     sync_batch_normalization_local_context_t *ctx =
-        rt_malloc_func(sizeof(sync_batch_normalization_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(sync_batch_normalization_local_context_t));
     ctx->group = f->group;
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->decay_rate = f->decay_rate;
@@ -662,8 +675,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_mean_subtraction_local_context;
     nn_function_mean_subtraction_t *f =
         (nn_function_mean_subtraction_t *)function;
-    mean_subtraction_local_context_t *ctx =
-        rt_malloc_func(sizeof(mean_subtraction_local_context_t));
+    mean_subtraction_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(mean_subtraction_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->update_running_mean = f->update_running_mean;
     function_context->func.local_context = ctx;
@@ -686,8 +699,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_clip_grad_by_norm_local_context;
     nn_function_clip_grad_by_norm_t *f =
         (nn_function_clip_grad_by_norm_t *)function;
-    clip_grad_by_norm_local_context_t *ctx =
-        rt_malloc_func(sizeof(clip_grad_by_norm_local_context_t));
+    clip_grad_by_norm_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(clip_grad_by_norm_local_context_t));
     ctx->clip_norm = f->clip_norm;
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     function_context->func.local_context = ctx;
@@ -699,7 +712,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SUM: { // Sum
     function_context->func.free_local_context_func = free_sum_local_context;
     nn_function_sum_t *f = (nn_function_sum_t *)function;
-    sum_local_context_t *ctx = rt_malloc_func(sizeof(sum_local_context_t));
+    sum_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(sum_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     function_context->func.local_context = ctx;
@@ -711,7 +725,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_MEAN: { // Mean
     function_context->func.free_local_context_func = free_mean_local_context;
     nn_function_mean_t *f = (nn_function_mean_t *)function;
-    mean_local_context_t *ctx = rt_malloc_func(sizeof(mean_local_context_t));
+    mean_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(mean_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     function_context->func.local_context = ctx;
@@ -723,7 +738,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_MAX_0: { // Max
     function_context->func.free_local_context_func = free_max_local_context;
     nn_function_max_t *f = (nn_function_max_t *)function;
-    max_local_context_t *ctx = rt_malloc_func(sizeof(max_local_context_t));
+    max_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(max_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     ctx->with_index = 0;
@@ -734,7 +750,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_MAX: { // Max
     function_context->func.free_local_context_func = free_max_local_context;
     nn_function_max_t *f = (nn_function_max_t *)function;
-    max_local_context_t *ctx = rt_malloc_func(sizeof(max_local_context_t));
+    max_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(max_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     ctx->with_index = f->with_index;
@@ -748,7 +765,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_MIN_0: { // Min
     function_context->func.free_local_context_func = free_min_local_context;
     nn_function_min_t *f = (nn_function_min_t *)function;
-    min_local_context_t *ctx = rt_malloc_func(sizeof(min_local_context_t));
+    min_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(min_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     ctx->with_index = 0;
@@ -759,7 +777,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_MIN: { // Min
     function_context->func.free_local_context_func = free_min_local_context;
     nn_function_min_t *f = (nn_function_min_t *)function;
-    min_local_context_t *ctx = rt_malloc_func(sizeof(min_local_context_t));
+    min_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(min_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     ctx->with_index = f->with_index;
@@ -773,7 +792,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_PROD: { // Prod
     function_context->func.free_local_context_func = free_prod_local_context;
     nn_function_prod_t *f = (nn_function_prod_t *)function;
-    prod_local_context_t *ctx = rt_malloc_func(sizeof(prod_local_context_t));
+    prod_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(prod_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->keep_dims = f->keep_dims;
     function_context->func.local_context = ctx;
@@ -803,7 +823,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_ADD2: { // Add2
     function_context->func.free_local_context_func = free_add2_local_context;
     nn_function_add2_t *f = (nn_function_add2_t *)function;
-    add2_local_context_t *ctx = rt_malloc_func(sizeof(add2_local_context_t));
+    add2_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(add2_local_context_t));
     ctx->inplace = f->inplace;
     function_context->func.local_context = ctx;
     allocate_add2_local_context(&function_context->func);
@@ -871,8 +892,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_add_scalar_local_context;
     nn_function_add_scalar_t *f = (nn_function_add_scalar_t *)function;
-    add_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(add_scalar_local_context_t));
+    add_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(add_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_add_scalar_local_context(&function_context->func);
@@ -884,8 +905,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_mul_scalar_local_context;
     nn_function_mul_scalar_t *f = (nn_function_mul_scalar_t *)function;
-    mul_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(mul_scalar_local_context_t));
+    mul_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(mul_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_mul_scalar_local_context(&function_context->func);
@@ -897,8 +918,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_pow_scalar_local_context;
     nn_function_pow_scalar_t *f = (nn_function_pow_scalar_t *)function;
-    pow_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(pow_scalar_local_context_t));
+    pow_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(pow_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_pow_scalar_local_context(&function_context->func);
@@ -910,8 +931,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_r_sub_scalar_local_context;
     nn_function_r_sub_scalar_t *f = (nn_function_r_sub_scalar_t *)function;
-    r_sub_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(r_sub_scalar_local_context_t));
+    r_sub_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(r_sub_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_r_sub_scalar_local_context(&function_context->func);
@@ -923,8 +944,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_r_div_scalar_local_context;
     nn_function_r_div_scalar_t *f = (nn_function_r_div_scalar_t *)function;
-    r_div_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(r_div_scalar_local_context_t));
+    r_div_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(r_div_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_r_div_scalar_local_context(&function_context->func);
@@ -936,8 +957,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_r_pow_scalar_local_context;
     nn_function_r_pow_scalar_t *f = (nn_function_r_pow_scalar_t *)function;
-    r_pow_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(r_pow_scalar_local_context_t));
+    r_pow_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(r_pow_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_r_pow_scalar_local_context(&function_context->func);
@@ -948,7 +969,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SIGN: { // Sign
     function_context->func.free_local_context_func = free_sign_local_context;
     nn_function_sign_t *f = (nn_function_sign_t *)function;
-    sign_local_context_t *ctx = rt_malloc_func(sizeof(sign_local_context_t));
+    sign_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(sign_local_context_t));
     ctx->alpha = f->alpha;
     function_context->func.local_context = ctx;
     allocate_sign_local_context(&function_context->func);
@@ -978,8 +1000,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_minimum_scalar_local_context;
     nn_function_minimum_scalar_t *f = (nn_function_minimum_scalar_t *)function;
-    minimum_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(minimum_scalar_local_context_t));
+    minimum_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(minimum_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_minimum_scalar_local_context(&function_context->func);
@@ -991,8 +1013,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_maximum_scalar_local_context;
     nn_function_maximum_scalar_t *f = (nn_function_maximum_scalar_t *)function;
-    maximum_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(maximum_scalar_local_context_t));
+    maximum_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(maximum_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_maximum_scalar_local_context(&function_context->func);
@@ -1083,8 +1105,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_logical_and_scalar_local_context;
     nn_function_logical_and_scalar_t *f =
         (nn_function_logical_and_scalar_t *)function;
-    logical_and_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(logical_and_scalar_local_context_t));
+    logical_and_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(logical_and_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_logical_and_scalar_local_context(&function_context->func);
@@ -1097,8 +1119,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_logical_or_scalar_local_context;
     nn_function_logical_or_scalar_t *f =
         (nn_function_logical_or_scalar_t *)function;
-    logical_or_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(logical_or_scalar_local_context_t));
+    logical_or_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(logical_or_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_logical_or_scalar_local_context(&function_context->func);
@@ -1111,8 +1133,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_logical_xor_scalar_local_context;
     nn_function_logical_xor_scalar_t *f =
         (nn_function_logical_xor_scalar_t *)function;
-    logical_xor_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(logical_xor_scalar_local_context_t));
+    logical_xor_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(logical_xor_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_logical_xor_scalar_local_context(&function_context->func);
@@ -1124,8 +1146,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_equal_scalar_local_context;
     nn_function_equal_scalar_t *f = (nn_function_equal_scalar_t *)function;
-    equal_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(equal_scalar_local_context_t));
+    equal_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(equal_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_equal_scalar_local_context(&function_context->func);
@@ -1138,8 +1160,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_not_equal_scalar_local_context;
     nn_function_not_equal_scalar_t *f =
         (nn_function_not_equal_scalar_t *)function;
-    not_equal_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(not_equal_scalar_local_context_t));
+    not_equal_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(not_equal_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_not_equal_scalar_local_context(&function_context->func);
@@ -1152,8 +1174,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_greater_equal_scalar_local_context;
     nn_function_greater_equal_scalar_t *f =
         (nn_function_greater_equal_scalar_t *)function;
-    greater_equal_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(greater_equal_scalar_local_context_t));
+    greater_equal_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(greater_equal_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_greater_equal_scalar_local_context(&function_context->func);
@@ -1165,8 +1187,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_greater_scalar_local_context;
     nn_function_greater_scalar_t *f = (nn_function_greater_scalar_t *)function;
-    greater_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(greater_scalar_local_context_t));
+    greater_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(greater_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_greater_scalar_local_context(&function_context->func);
@@ -1179,8 +1201,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_less_equal_scalar_local_context;
     nn_function_less_equal_scalar_t *f =
         (nn_function_less_equal_scalar_t *)function;
-    less_equal_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(less_equal_scalar_local_context_t));
+    less_equal_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(less_equal_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_less_equal_scalar_local_context(&function_context->func);
@@ -1192,8 +1214,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_less_scalar_local_context;
     nn_function_less_scalar_t *f = (nn_function_less_scalar_t *)function;
-    less_scalar_local_context_t *ctx =
-        rt_malloc_func(sizeof(less_scalar_local_context_t));
+    less_scalar_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(less_scalar_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_less_scalar_local_context(&function_context->func);
@@ -1230,8 +1252,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_reset_nan_local_context;
     nn_function_reset_nan_t *f = (nn_function_reset_nan_t *)function;
-    reset_nan_local_context_t *ctx =
-        rt_malloc_func(sizeof(reset_nan_local_context_t));
+    reset_nan_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(reset_nan_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_reset_nan_local_context(&function_context->func);
@@ -1243,8 +1265,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_reset_inf_local_context;
     nn_function_reset_inf_t *f = (nn_function_reset_inf_t *)function;
-    reset_inf_local_context_t *ctx =
-        rt_malloc_func(sizeof(reset_inf_local_context_t));
+    reset_inf_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(reset_inf_local_context_t));
     ctx->val = f->val;
     function_context->func.local_context = ctx;
     allocate_reset_inf_local_context(&function_context->func);
@@ -1264,8 +1286,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_constant_local_context;
     nn_function_constant_t *f = (nn_function_constant_t *)function;
-    constant_local_context_t *ctx =
-        rt_malloc_func(sizeof(constant_local_context_t));
+    constant_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(constant_local_context_t));
     ctx->val = f->val;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     function_context->func.local_context = ctx;
@@ -1277,8 +1299,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_ARANGE: { // Arange
     function_context->func.free_local_context_func = free_arange_local_context;
     nn_function_arange_t *f = (nn_function_arange_t *)function;
-    arange_local_context_t *ctx =
-        rt_malloc_func(sizeof(arange_local_context_t));
+    arange_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(arange_local_context_t));
     ctx->start = f->start;
     ctx->stop = f->stop;
     ctx->step = f->step;
@@ -1325,8 +1347,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_batch_matmul_local_context;
     nn_function_batch_matmul_t *f = (nn_function_batch_matmul_t *)function;
-    batch_matmul_local_context_t *ctx =
-        rt_malloc_func(sizeof(batch_matmul_local_context_t));
+    batch_matmul_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(batch_matmul_local_context_t));
     ctx->transpose_a = f->transpose_a;
     ctx->transpose_b = f->transpose_b;
     function_context->func.local_context = ctx;
@@ -1459,8 +1481,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_concatenate_local_context;
     nn_function_concatenate_t *f = (nn_function_concatenate_t *)function;
-    concatenate_local_context_t *ctx =
-        rt_malloc_func(sizeof(concatenate_local_context_t));
+    concatenate_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(concatenate_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_concatenate_local_context(&function_context->func);
@@ -1471,7 +1493,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SPLIT: { // Split
     function_context->func.free_local_context_func = free_split_local_context;
     nn_function_split_t *f = (nn_function_split_t *)function;
-    split_local_context_t *ctx = rt_malloc_func(sizeof(split_local_context_t));
+    split_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(split_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_split_local_context(&function_context->func);
@@ -1482,7 +1505,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_STACK: { // Stack
     function_context->func.free_local_context_func = free_stack_local_context;
     nn_function_stack_t *f = (nn_function_stack_t *)function;
-    stack_local_context_t *ctx = rt_malloc_func(sizeof(stack_local_context_t));
+    stack_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(stack_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_stack_local_context(&function_context->func);
@@ -1493,7 +1517,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SLICE: { // Slice
     function_context->func.free_local_context_func = free_slice_local_context;
     nn_function_slice_t *f = (nn_function_slice_t *)function;
-    slice_local_context_t *ctx = rt_malloc_func(sizeof(slice_local_context_t));
+    slice_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(slice_local_context_t));
     ctx->start = create_rt_list_from_nn_list(n, f->start);
     ctx->stop = create_rt_list_from_nn_list(n, f->stop);
     ctx->step = create_rt_list_from_nn_list(n, f->step);
@@ -1506,7 +1531,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_PAD: { // Pad
     function_context->func.free_local_context_func = free_pad_local_context;
     nn_function_pad_t *f = (nn_function_pad_t *)function;
-    pad_local_context_t *ctx = rt_malloc_func(sizeof(pad_local_context_t));
+    pad_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(pad_local_context_t));
     ctx->pad_width = create_rt_list_from_nn_list(n, f->pad_width);
     ctx->mode = f->mode;
     ctx->constant_value = f->constant_value;
@@ -1520,8 +1546,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_transpose_local_context;
     nn_function_transpose_t *f = (nn_function_transpose_t *)function;
-    transpose_local_context_t *ctx =
-        rt_malloc_func(sizeof(transpose_local_context_t));
+    transpose_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(transpose_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     function_context->func.local_context = ctx;
     allocate_transpose_local_context(&function_context->func);
@@ -1533,8 +1559,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_broadcast_local_context;
     nn_function_broadcast_t *f = (nn_function_broadcast_t *)function;
-    broadcast_local_context_t *ctx =
-        rt_malloc_func(sizeof(broadcast_local_context_t));
+    broadcast_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(broadcast_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     function_context->func.local_context = ctx;
     allocate_broadcast_local_context(&function_context->func);
@@ -1546,8 +1572,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_broadcast_to_local_context;
     nn_function_broadcast_to_t *f = (nn_function_broadcast_to_t *)function;
-    broadcast_to_local_context_t *ctx =
-        rt_malloc_func(sizeof(broadcast_to_local_context_t));
+    broadcast_to_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(broadcast_to_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_broadcast_to_local_context(&function_context->func);
@@ -1558,7 +1584,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_TILE: { // Tile
     function_context->func.free_local_context_func = free_tile_local_context;
     nn_function_tile_t *f = (nn_function_tile_t *)function;
-    tile_local_context_t *ctx = rt_malloc_func(sizeof(tile_local_context_t));
+    tile_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(tile_local_context_t));
     ctx->reps = create_rt_list_from_nn_list(n, f->reps);
     function_context->func.local_context = ctx;
     allocate_tile_local_context(&function_context->func);
@@ -1569,8 +1596,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_ONE_HOT: { // OneHot
     function_context->func.free_local_context_func = free_one_hot_local_context;
     nn_function_one_hot_t *f = (nn_function_one_hot_t *)function;
-    one_hot_local_context_t *ctx =
-        rt_malloc_func(sizeof(one_hot_local_context_t));
+    one_hot_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(one_hot_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     function_context->func.local_context = ctx;
     allocate_one_hot_local_context(&function_context->func);
@@ -1581,7 +1608,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_FLIP: { // Flip
     function_context->func.free_local_context_func = free_flip_local_context;
     nn_function_flip_t *f = (nn_function_flip_t *)function;
-    flip_local_context_t *ctx = rt_malloc_func(sizeof(flip_local_context_t));
+    flip_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(flip_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     function_context->func.local_context = ctx;
     allocate_flip_local_context(&function_context->func);
@@ -1592,7 +1620,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SHIFT: { // Shift
     function_context->func.free_local_context_func = free_shift_local_context;
     nn_function_shift_t *f = (nn_function_shift_t *)function;
-    shift_local_context_t *ctx = rt_malloc_func(sizeof(shift_local_context_t));
+    shift_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(shift_local_context_t));
     ctx->shifts = create_rt_list_from_nn_list(n, f->shifts);
     ctx->border_mode = f->border_mode;
     function_context->func.local_context = ctx;
@@ -1604,7 +1633,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SORT: { // Sort
     function_context->func.free_local_context_func = free_sort_local_context;
     nn_function_sort_t *f = (nn_function_sort_t *)function;
-    sort_local_context_t *ctx = rt_malloc_func(sizeof(sort_local_context_t));
+    sort_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(sort_local_context_t));
     ctx->axis = f->axis;
     ctx->reverse = f->reverse;
     ctx->with_index = f->with_index;
@@ -1618,8 +1648,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RESHAPE_0: { // Reshape
     function_context->func.free_local_context_func = free_reshape_local_context;
     nn_function_reshape_t *f = (nn_function_reshape_t *)function;
-    reshape_local_context_t *ctx =
-        rt_malloc_func(sizeof(reshape_local_context_t));
+    reshape_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(reshape_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     ctx->inplace = 1;
     function_context->func.local_context = ctx;
@@ -1628,8 +1658,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RESHAPE: { // Reshape
     function_context->func.free_local_context_func = free_reshape_local_context;
     nn_function_reshape_t *f = (nn_function_reshape_t *)function;
-    reshape_local_context_t *ctx =
-        rt_malloc_func(sizeof(reshape_local_context_t));
+    reshape_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(reshape_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     ctx->inplace = f->inplace;
     function_context->func.local_context = ctx;
@@ -1695,8 +1725,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_scatter_nd_local_context;
     nn_function_scatter_nd_t *f = (nn_function_scatter_nd_t *)function;
-    scatter_nd_local_context_t *ctx =
-        rt_malloc_func(sizeof(scatter_nd_local_context_t));
+    scatter_nd_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(scatter_nd_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     function_context->func.local_context = ctx;
     allocate_scatter_nd_local_context(&function_context->func);
@@ -1708,8 +1738,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_interpolate_local_context;
     nn_function_interpolate_t *f = (nn_function_interpolate_t *)function;
-    interpolate_local_context_t *ctx =
-        rt_malloc_func(sizeof(interpolate_local_context_t));
+    interpolate_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(interpolate_local_context_t));
     ctx->output_size = create_rt_list_from_nn_list(n, f->output_size);
     ctx->mode = f->mode;
     ctx->align_corners = f->align_corners;
@@ -1723,8 +1753,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_interpolate_local_context;
     nn_function_interpolate_t *f = (nn_function_interpolate_t *)function;
-    interpolate_local_context_t *ctx =
-        rt_malloc_func(sizeof(interpolate_local_context_t));
+    interpolate_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(interpolate_local_context_t));
     ctx->output_size = create_rt_list_from_nn_list(n, f->output_size);
     ctx->mode = f->mode;
     ctx->align_corners = f->align_corners;
@@ -1738,8 +1768,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_interpolate_local_context;
     nn_function_interpolate_t *f = (nn_function_interpolate_t *)function;
-    interpolate_local_context_t *ctx =
-        rt_malloc_func(sizeof(interpolate_local_context_t));
+    interpolate_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(interpolate_local_context_t));
     ctx->output_size = create_rt_list_from_nn_list(n, f->output_size);
     ctx->mode = f->mode;
     ctx->align_corners = f->align_corners;
@@ -1755,7 +1785,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_FFT: { // FFT
     function_context->func.free_local_context_func = free_fft_local_context;
     nn_function_fft_t *f = (nn_function_fft_t *)function;
-    fft_local_context_t *ctx = rt_malloc_func(sizeof(fft_local_context_t));
+    fft_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(fft_local_context_t));
     ctx->signal_ndim = f->signal_ndim;
     ctx->normalized = f->normalized;
     function_context->func.local_context = ctx;
@@ -1767,7 +1798,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_IFFT: { // IFFT
     function_context->func.free_local_context_func = free_ifft_local_context;
     nn_function_ifft_t *f = (nn_function_ifft_t *)function;
-    ifft_local_context_t *ctx = rt_malloc_func(sizeof(ifft_local_context_t));
+    ifft_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(ifft_local_context_t));
     ctx->signal_ndim = f->signal_ndim;
     ctx->normalized = f->normalized;
     function_context->func.local_context = ctx;
@@ -1779,8 +1811,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_DROPOUT: { // Dropout
     function_context->func.free_local_context_func = free_dropout_local_context;
     nn_function_dropout_t *f = (nn_function_dropout_t *)function;
-    dropout_local_context_t *ctx =
-        rt_malloc_func(sizeof(dropout_local_context_t));
+    dropout_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(dropout_local_context_t));
     ctx->p = f->p;
     ctx->seed = f->seed;
     function_context->func.local_context = ctx;
@@ -1793,8 +1825,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_top_k_data_local_context;
     nn_function_top_k_data_t *f = (nn_function_top_k_data_t *)function;
-    top_k_data_local_context_t *ctx =
-        rt_malloc_func(sizeof(top_k_data_local_context_t));
+    top_k_data_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(top_k_data_local_context_t));
     ctx->k = f->k;
     ctx->abs = f->abs;
     ctx->reduce = f->reduce;
@@ -1809,8 +1841,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_top_k_grad_local_context;
     nn_function_top_k_grad_t *f = (nn_function_top_k_grad_t *)function;
-    top_k_grad_local_context_t *ctx =
-        rt_malloc_func(sizeof(top_k_grad_local_context_t));
+    top_k_grad_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(top_k_grad_local_context_t));
     ctx->k = f->k;
     ctx->abs = f->abs;
     ctx->base_axis = f->base_axis;
@@ -1823,7 +1855,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RAND: { // Rand
     function_context->func.free_local_context_func = free_rand_local_context;
     nn_function_rand_t *f = (nn_function_rand_t *)function;
-    rand_local_context_t *ctx = rt_malloc_func(sizeof(rand_local_context_t));
+    rand_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(rand_local_context_t));
     ctx->low = f->low;
     ctx->high = f->high;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
@@ -1837,8 +1870,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RANDINT: { // Randint
     function_context->func.free_local_context_func = free_randint_local_context;
     nn_function_randint_t *f = (nn_function_randint_t *)function;
-    randint_local_context_t *ctx =
-        rt_malloc_func(sizeof(randint_local_context_t));
+    randint_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(randint_local_context_t));
     ctx->low = f->low;
     ctx->high = f->high;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
@@ -1852,7 +1885,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_RANDN: { // Randn
     function_context->func.free_local_context_func = free_randn_local_context;
     nn_function_randn_t *f = (nn_function_randn_t *)function;
-    randn_local_context_t *ctx = rt_malloc_func(sizeof(randn_local_context_t));
+    randn_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(randn_local_context_t));
     ctx->mu = f->mu;
     ctx->sigma = f->sigma;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
@@ -1867,8 +1901,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_rand_binomial_local_context;
     nn_function_rand_binomial_t *f = (nn_function_rand_binomial_t *)function;
-    rand_binomial_local_context_t *ctx =
-        rt_malloc_func(sizeof(rand_binomial_local_context_t));
+    rand_binomial_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(rand_binomial_local_context_t));
     ctx->n = f->n;
     ctx->p = f->p;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
@@ -1883,8 +1917,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_rand_beta_local_context;
     nn_function_rand_beta_t *f = (nn_function_rand_beta_t *)function;
-    rand_beta_local_context_t *ctx =
-        rt_malloc_func(sizeof(rand_beta_local_context_t));
+    rand_beta_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(rand_beta_local_context_t));
     ctx->alpha = f->alpha;
     ctx->beta = f->beta;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
@@ -1899,8 +1933,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_rand_gamma_local_context;
     nn_function_rand_gamma_t *f = (nn_function_rand_gamma_t *)function;
-    rand_gamma_local_context_t *ctx =
-        rt_malloc_func(sizeof(rand_gamma_local_context_t));
+    rand_gamma_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(rand_gamma_local_context_t));
     ctx->k = f->k;
     ctx->theta = f->theta;
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
@@ -1915,8 +1949,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_random_choice_local_context;
     nn_function_random_choice_t *f = (nn_function_random_choice_t *)function;
-    random_choice_local_context_t *ctx =
-        rt_malloc_func(sizeof(random_choice_local_context_t));
+    random_choice_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(random_choice_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     ctx->replace = f->replace;
     ctx->seed = f->seed;
@@ -1930,8 +1964,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_random_crop_local_context;
     nn_function_random_crop_t *f = (nn_function_random_crop_t *)function;
-    random_crop_local_context_t *ctx =
-        rt_malloc_func(sizeof(random_crop_local_context_t));
+    random_crop_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(random_crop_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     ctx->base_axis = f->base_axis;
     ctx->seed = f->seed;
@@ -1945,8 +1979,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_random_flip_local_context;
     nn_function_random_flip_t *f = (nn_function_random_flip_t *)function;
-    random_flip_local_context_t *ctx =
-        rt_malloc_func(sizeof(random_flip_local_context_t));
+    random_flip_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(random_flip_local_context_t));
     ctx->axes = create_rt_list_from_nn_list(n, f->axes);
     ctx->base_axis = f->base_axis;
     ctx->seed = f->seed;
@@ -1960,8 +1994,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_random_shift_local_context;
     nn_function_random_shift_t *f = (nn_function_random_shift_t *)function;
-    random_shift_local_context_t *ctx =
-        rt_malloc_func(sizeof(random_shift_local_context_t));
+    random_shift_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(random_shift_local_context_t));
     ctx->shifts = create_rt_list_from_nn_list(n, f->shifts);
     ctx->border_mode = f->border_mode;
     ctx->base_axis = f->base_axis;
@@ -1976,8 +2010,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_random_erase_local_context;
     nn_function_random_erase_t *f = (nn_function_random_erase_t *)function;
-    random_erase_local_context_t *ctx =
-        rt_malloc_func(sizeof(random_erase_local_context_t));
+    random_erase_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(random_erase_local_context_t));
     ctx->prob = f->prob;
     ctx->n = f->n;
     ctx->share = f->share;
@@ -1993,8 +2027,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_random_erase_local_context;
     nn_function_random_erase_t *f = (nn_function_random_erase_t *)function;
-    random_erase_local_context_t *ctx =
-        rt_malloc_func(sizeof(random_erase_local_context_t));
+    random_erase_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(random_erase_local_context_t));
     ctx->prob = f->prob;
     ctx->n = f->n;
     ctx->share = f->share;
@@ -2014,8 +2048,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_image_augmentation_local_context;
     nn_function_image_augmentation_t *f =
         (nn_function_image_augmentation_t *)function;
-    image_augmentation_local_context_t *ctx =
-        rt_malloc_func(sizeof(image_augmentation_local_context_t));
+    image_augmentation_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(image_augmentation_local_context_t));
     ctx->shape = create_rt_list_from_nn_list(n, f->shape);
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->min_scale = f->min_scale;
@@ -2061,8 +2095,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_softmax_cross_entropy_local_context;
     nn_function_softmax_cross_entropy_t *f =
         (nn_function_softmax_cross_entropy_t *)function;
-    softmax_cross_entropy_local_context_t *ctx =
-        rt_malloc_func(sizeof(softmax_cross_entropy_local_context_t));
+    softmax_cross_entropy_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(softmax_cross_entropy_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_softmax_cross_entropy_local_context(&function_context->func);
@@ -2076,7 +2110,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_categorical_cross_entropy_t *f =
         (nn_function_categorical_cross_entropy_t *)function;
     categorical_cross_entropy_local_context_t *ctx =
-        rt_malloc_func(sizeof(categorical_cross_entropy_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(categorical_cross_entropy_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_categorical_cross_entropy_local_context(&function_context->func);
@@ -2106,8 +2141,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_huber_loss_local_context;
     nn_function_huber_loss_t *f = (nn_function_huber_loss_t *)function;
-    huber_loss_local_context_t *ctx =
-        rt_malloc_func(sizeof(huber_loss_local_context_t));
+    huber_loss_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(huber_loss_local_context_t));
     ctx->delta = f->delta;
     function_context->func.local_context = ctx;
     allocate_huber_loss_local_context(&function_context->func);
@@ -2121,7 +2156,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_epsilon_insensitive_loss_t *f =
         (nn_function_epsilon_insensitive_loss_t *)function;
     epsilon_insensitive_loss_local_context_t *ctx =
-        rt_malloc_func(sizeof(epsilon_insensitive_loss_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(epsilon_insensitive_loss_local_context_t));
     ctx->epsilon = f->epsilon;
     function_context->func.local_context = ctx;
     allocate_epsilon_insensitive_loss_local_context(&function_context->func);
@@ -2133,8 +2169,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_kl_multinomial_local_context;
     nn_function_kl_multinomial_t *f = (nn_function_kl_multinomial_t *)function;
-    kl_multinomial_local_context_t *ctx =
-        rt_malloc_func(sizeof(kl_multinomial_local_context_t));
+    kl_multinomial_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(kl_multinomial_local_context_t));
     ctx->base_axis = f->base_axis;
     function_context->func.local_context = ctx;
     allocate_kl_multinomial_local_context(&function_context->func);
@@ -2165,8 +2201,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_binary_connect_affine_local_context;
     nn_function_binary_connect_affine_t *f =
         (nn_function_binary_connect_affine_t *)function;
-    binary_connect_affine_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_connect_affine_local_context_t));
+    binary_connect_affine_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(binary_connect_affine_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->quantize_zero_to = 1.0;
     function_context->func.local_context = ctx;
@@ -2177,8 +2213,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_binary_connect_affine_local_context;
     nn_function_binary_connect_affine_t *f =
         (nn_function_binary_connect_affine_t *)function;
-    binary_connect_affine_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_connect_affine_local_context_t));
+    binary_connect_affine_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(binary_connect_affine_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->quantize_zero_to = f->quantize_zero_to;
     function_context->func.local_context = ctx;
@@ -2193,7 +2229,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_binary_connect_convolution_t *f =
         (nn_function_binary_connect_convolution_t *)function;
     binary_connect_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_connect_convolution_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(binary_connect_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -2209,7 +2246,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_binary_connect_convolution_t *f =
         (nn_function_binary_connect_convolution_t *)function;
     binary_connect_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_connect_convolution_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(binary_connect_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -2227,8 +2265,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_binary_weight_affine_local_context;
     nn_function_binary_weight_affine_t *f =
         (nn_function_binary_weight_affine_t *)function;
-    binary_weight_affine_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_weight_affine_local_context_t));
+    binary_weight_affine_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(binary_weight_affine_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->quantize_zero_to = 1.0;
     function_context->func.local_context = ctx;
@@ -2239,8 +2277,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_binary_weight_affine_local_context;
     nn_function_binary_weight_affine_t *f =
         (nn_function_binary_weight_affine_t *)function;
-    binary_weight_affine_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_weight_affine_local_context_t));
+    binary_weight_affine_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(binary_weight_affine_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->quantize_zero_to = f->quantize_zero_to;
     function_context->func.local_context = ctx;
@@ -2255,7 +2293,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_binary_weight_convolution_t *f =
         (nn_function_binary_weight_convolution_t *)function;
     binary_weight_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_weight_convolution_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(binary_weight_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -2271,7 +2310,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     nn_function_binary_weight_convolution_t *f =
         (nn_function_binary_weight_convolution_t *)function;
     binary_weight_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(binary_weight_convolution_local_context_t));
+        rt_function_malloc(&function_context->func,
+                           sizeof(binary_weight_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -2288,8 +2328,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_inq_affine_local_context;
     nn_function_inq_affine_t *f = (nn_function_inq_affine_t *)function;
-    inq_affine_local_context_t *ctx =
-        rt_malloc_func(sizeof(inq_affine_local_context_t));
+    inq_affine_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(inq_affine_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->num_bits = f->num_bits;
     ctx->inq_iterations = create_rt_list_from_nn_list(n, f->inq_iterations);
@@ -2306,8 +2346,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_inq_convolution_local_context;
     nn_function_inq_convolution_t *f =
         (nn_function_inq_convolution_t *)function;
-    inq_convolution_local_context_t *ctx =
-        rt_malloc_func(sizeof(inq_convolution_local_context_t));
+    inq_convolution_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(inq_convolution_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->pad = create_rt_list_from_nn_list(n, f->pad);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
@@ -2328,8 +2368,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_fixed_point_quantize_local_context;
     nn_function_fixed_point_quantize_t *f =
         (nn_function_fixed_point_quantize_t *)function;
-    fixed_point_quantize_local_context_t *ctx =
-        rt_malloc_func(sizeof(fixed_point_quantize_local_context_t));
+    fixed_point_quantize_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(fixed_point_quantize_local_context_t));
     ctx->sign = f->sign;
     ctx->n = f->n;
     ctx->delta = f->delta;
@@ -2345,8 +2385,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_min_max_quantize_local_context;
     nn_function_min_max_quantize_t *f =
         (nn_function_min_max_quantize_t *)function;
-    min_max_quantize_local_context_t *ctx =
-        rt_malloc_func(sizeof(min_max_quantize_local_context_t));
+    min_max_quantize_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(min_max_quantize_local_context_t));
     ctx->decay = f->decay;
     ctx->x_min_max = f->x_min_max;
     ctx->ema = f->ema;
@@ -2360,8 +2400,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_min_max_quantize_local_context;
     nn_function_min_max_quantize_t *f =
         (nn_function_min_max_quantize_t *)function;
-    min_max_quantize_local_context_t *ctx =
-        rt_malloc_func(sizeof(min_max_quantize_local_context_t));
+    min_max_quantize_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(min_max_quantize_local_context_t));
     ctx->decay = f->decay;
     ctx->x_min_max = f->x_min_max;
     ctx->ema = f->ema;
@@ -2377,8 +2417,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_pow2_quantize_local_context;
     nn_function_pow2_quantize_t *f = (nn_function_pow2_quantize_t *)function;
-    pow2_quantize_local_context_t *ctx =
-        rt_malloc_func(sizeof(pow2_quantize_local_context_t));
+    pow2_quantize_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(pow2_quantize_local_context_t));
     ctx->sign = f->sign;
     ctx->with_zero = f->with_zero;
     ctx->n = f->n;
@@ -2393,7 +2433,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_PRUNE: { // Prune
     function_context->func.free_local_context_func = free_prune_local_context;
     nn_function_prune_t *f = (nn_function_prune_t *)function;
-    prune_local_context_t *ctx = rt_malloc_func(sizeof(prune_local_context_t));
+    prune_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(prune_local_context_t));
     ctx->rate = f->rate;
     function_context->func.local_context = ctx;
     allocate_prune_local_context(&function_context->func);
@@ -2406,8 +2447,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_quantize_linear_local_context;
     nn_function_quantize_linear_t *f =
         (nn_function_quantize_linear_t *)function;
-    quantize_linear_local_context_t *ctx =
-        rt_malloc_func(sizeof(quantize_linear_local_context_t));
+    quantize_linear_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(quantize_linear_local_context_t));
     ctx->round_mode = f->round_mode;
     ctx->narrow_range = f->narrow_range;
     ctx->dtype = f->dtype;
@@ -2430,8 +2471,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_top_n_error_local_context;
     nn_function_top_n_error_t *f = (nn_function_top_n_error_t *)function;
-    top_n_error_local_context_t *ctx =
-        rt_malloc_func(sizeof(top_n_error_local_context_t));
+    top_n_error_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(top_n_error_local_context_t));
     ctx->axis = f->axis;
     ctx->n = f->n;
     function_context->func.local_context = ctx;
@@ -2454,8 +2495,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_confusion_matrix_local_context;
     nn_function_confusion_matrix_t *f =
         (nn_function_confusion_matrix_t *)function;
-    confusion_matrix_local_context_t *ctx =
-        rt_malloc_func(sizeof(confusion_matrix_local_context_t));
+    confusion_matrix_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(confusion_matrix_local_context_t));
     ctx->axis = f->axis;
     function_context->func.local_context = ctx;
     allocate_confusion_matrix_local_context(&function_context->func);
@@ -2467,8 +2508,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
     function_context->func.free_local_context_func =
         free_vat_noise_local_context;
     nn_function_vat_noise_t *f = (nn_function_vat_noise_t *)function;
-    vat_noise_local_context_t *ctx =
-        rt_malloc_func(sizeof(vat_noise_local_context_t));
+    vat_noise_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(vat_noise_local_context_t));
     ctx->base_axis = f->base_axis;
     ctx->eps = f->eps;
     function_context->func.local_context = ctx;
@@ -2488,7 +2529,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
   case NN_FUNCTION_SINK: { // Sink
     function_context->func.free_local_context_func = free_sink_local_context;
     nn_function_sink_t *f = (nn_function_sink_t *)function;
-    sink_local_context_t *ctx = rt_malloc_func(sizeof(sink_local_context_t));
+    sink_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(sink_local_context_t));
     ctx->one_input_grad = f->one_input_grad;
     function_context->func.local_context = ctx;
     allocate_sink_local_context(&function_context->func);
@@ -2501,8 +2543,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_nms_detection2d_local_context;
     nn_function_nms_detection2d_t *f =
         (nn_function_nms_detection2d_t *)function;
-    nms_detection2d_local_context_t *ctx =
-        rt_malloc_func(sizeof(nms_detection2d_local_context_t));
+    nms_detection2d_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(nms_detection2d_local_context_t));
     ctx->thresh = f->thresh;
     ctx->nms = f->nms;
     ctx->nms_per_class = f->nms_per_class;
@@ -2517,8 +2559,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_max_pooling_backward_local_context;
     nn_function_max_pooling_backward_t *f =
         (nn_function_max_pooling_backward_t *)function;
-    max_pooling_backward_local_context_t *ctx =
-        rt_malloc_func(sizeof(max_pooling_backward_local_context_t));
+    max_pooling_backward_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(max_pooling_backward_local_context_t));
     ctx->kernel = create_rt_list_from_nn_list(n, f->kernel);
     ctx->stride = create_rt_list_from_nn_list(n, f->stride);
     ctx->ignore_border = f->ignore_border;
@@ -2544,8 +2586,8 @@ void allocate_function_context(nn_network_t *n, nn_function_t *function,
         free_patch_correlation_local_context;
     nn_function_patch_correlation_t *f =
         (nn_function_patch_correlation_t *)function;
-    patch_correlation_local_context_t *ctx =
-        rt_malloc_func(sizeof(patch_correlation_local_context_t));
+    patch_correlation_local_context_t *ctx = rt_function_malloc(
+        &function_context->func, sizeof(patch_correlation_local_context_t));
     ctx->patch = create_rt_list_from_nn_list(n, f->patch);
     ctx->shift = create_rt_list_from_nn_list(n, f->shift);
     ctx->patch_step = create_rt_list_from_nn_list(n, f->patch_step);
@@ -0,0 +1,1352 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "../functions/utilities/shared_cache.h"
+#include "graph.h"
+#include "memory_planner.h"
+#include "runtime_internal.h"
+
+static nn_variable_t *network_variable(nn_network_t *n, int index) {
+  int *list = (int *)NN_GET(n, n->variables.list);
+  return (nn_variable_t *)NN_GET(n, list[index]);
+}
+
+static nn_function_t *network_function(nn_network_t *n, int index) {
+  int *list = (int *)NN_GET(n, n->functions.list);
+  return (nn_function_t *)NN_GET(n, list[index]);
+}
+
+static int *copy_indices(nn_network_t *n, nn_list_t list, int num_of_variables,
+                         int capacity) {
+  rt_list_t l = create_rt_list_from_nn_list(n, list);
+  int *indices = rt_malloc_func(sizeof(int) * (capacity > 0 ? capacity : 1));
+  int i;
+  if (indices) {
+    for (i = 0; i < l.size; i++) {
+      indices[i] = l.data[i] < num_of_variables ? l.data[i] : -1;
+    }
+  }
+  return indices;
+}
+
+void rt_free_graph(rt_graph_t *g) {
+  int i;
+  if (g->functions) {
+    for (i = 0; i < g->num_of_functions; i++) {
+      if (g->functions[i].inputs) {
+        rt_free_func(g->functions[i].inputs);
+      }
+      if (g->functions[i].outputs) {
+        rt_free_func(g->functions[i].outputs);
+      }
+    }
+    rt_free_func(g->functions);
+  }
+  if (g->derived) {
+    rt_free_func(g->derived);
+  }
+  if (g->aliases) {
+    rt_free_func(g->aliases);
+  }
+  if (g->alias_offsets) {
+    rt_free_func(g->alias_offsets);
+  }
+  g->functions = 0;
+  g->derived = 0;
+  g->aliases = 0;
+  g->alias_offsets = 0;
+}
+
+static int has_callback(rt_context_t *c, nn_function_type_t type) {
+  int i;
+  for (i = 0; i < c->num_of_callbacks; i++) {
+    if (c->callbacks[i].type == type) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int is_network_input(nn_network_t *n, int variable) {
+  rt_list_t l = create_rt_list_from_nn_list(n, n->inputs);
+  int i;
+  for (i = 0; i < l.size; i++) {
+    if (l.data[i] == variable) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int is_network_output(nn_network_t *n, int variable) {
+  rt_list_t l = create_rt_list_from_nn_list(n, n->outputs);
+  int i;
+  for (i = 0; i < l.size; i++) {
+    if (l.data[i] == variable) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int num_of_consumers(rt_graph_t *g, int variable) {
+  int count = 0;
+  int i, j;
+  for (i = 0; i < g->num_of_functions; i++) {
+    for (j = 0; j < g->functions[i].num_of_inputs; j++) {
+      if (g->functions[i].inputs[j] == variable) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// Function writing variable before function index, or -1.
+static int producer_of(rt_graph_t *g, int variable, int index) {
+  int i, j;
+  for (i = index - 1; i >= 0; i--) {
+    for (j = 0; j < g->functions[i].num_of_outputs; j++) {
+      if (g->functions[i].outputs[j] == variable) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+// Float variable of network with data in parameters.
+static int is_parameter(nn_network_t *n, rt_graph_t *g, int variable) {
+  if (variable < 0 || variable >= g->num_of_variables) {
+    return 0;
+  }
+  nn_variable_t *v = network_variable(n, variable);
+  return v->data_index >= 0 && v->type == NN_DATA_TYPE_FLOAT;
+}
+
+static int is_float(nn_network_t *n, rt_graph_t *g, int variable) {
+  return variable >= 0 && variable < g->num_of_variables &&
+         network_variable(n, variable)->type == NN_DATA_TYPE_FLOAT;
+}
+
+static int num_of_elements(nn_network_t *n, int variable) {
+  rt_list_t shape =
+      create_rt_list_from_nn_list(n, network_variable(n, variable)->shape);
+  int size = 1;
+  int i;
+  for (i = 0; i < shape.size; i++) {
+    size *= shape.data[i];
+  }
+  return size;
+}
+
+static int buffer_of(nn_network_t *n, rt_graph_t *g, int variable) {
+  if (variable < 0 || variable >= g->num_of_variables) {
+    return -1;
+  }
+  int index = network_variable(n, variable)->data_index;
+  return index < 0 ? -index - 1 : -1;
+}
+
+// Whether function first may write variable, which is written by function
+// last originally. With buffers of network the buffer of variable must not
+// be used by functions in between either, with the liveness plan the arena
+// is planned from the optimized graph.
+static int can_write_early(rt_context_t *c, nn_network_t *n, rt_graph_t *g,
+                           int first, int last, int variable) {
+  int buffer = buffer_of(n, g, variable);
+  int i, j;
+
+  for (i = first; i < last; i++) {
+    rt_graph_function_t *f = g->functions + i;
+    for (j = 0; j < f->num_of_inputs; j++) {
+      if (f->inputs[j] == variable) {
+        return 0;
+      }
+    }
+    for (j = 0; j < f->num_of_outputs; j++) {
+      if (f->outputs[j] == variable) {
+        return 0;
+      }
+    }
+  }
+  if (c->memory_plan == RT_MEMORY_PLAN_LIVENESS || buffer < 0) {
+    return 1;
+  }
+  for (i = first; i < last; i++) {
+    rt_graph_function_t *f = g->functions + i;
+    for (j = 0; j < f->num_of_inputs; j++) {
+      if (buffer_of(n, g, f->inputs[j]) == buffer) {
+        return 0;
+      }
+    }
+    for (j = 0; i > first && j < f->num_of_outputs; j++) {
+      if (buffer_of(n, g, f->outputs[j]) == buffer) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+// Number of output channels of function if BatchNormalization over axis
+// can be folded into its weight, 0 otherwise.
+static int foldable_channels(nn_network_t *n, rt_graph_t *g, int index,
+                             int axis) {
+  nn_function_t *func = network_function(n, index);
+  rt_graph_function_t *f = g->functions + index;
+  int base_axis;
+  int channels = 0;
+
+  if (f->elided || f->activation.type != RT_ACTIVATION_NONE ||
+      f->num_of_outputs != 1 || f->num_of_inputs < 2 ||
+      f->num_of_inputs > 3 || !is_float(n, g, f->inputs[0]) ||
+      !is_float(n, g, f->outputs[0]) || !is_parameter(n, g, f->inputs[1]) ||
+      (f->num_of_inputs == 3 && !is_parameter(n, g, f->inputs[2]))) {
+    return 0;
+  }
+  rt_list_t y_shape = create_rt_list_from_nn_list(
+      n, network_variable(n, f->outputs[0])->shape);
+  rt_list_t w_shape = create_rt_list_from_nn_list(
+      n, network_variable(n, f->inputs[1])->shape);
+
+  switch (func->type) {
+  case NN_FUNCTION_CONVOLUTION: {
+    nn_function_convolution_t *conv = (nn_function_convolution_t *)func;
+    if (conv->channel_last) {
+      return 0;
+    }
+    base_axis = conv->base_axis;
+    channels = w_shape.data[0];
+    break;
+  }
+  case NN_FUNCTION_DEPTHWISE_CONVOLUTION:
+    base_axis = ((nn_function_depthwise_convolution_t *)func)->base_axis;
+    channels = w_shape.data[0];
+    break;
+  case NN_FUNCTION_AFFINE:
+    base_axis = ((nn_function_affine_t *)func)->base_axis;
+    if (y_shape.size != base_axis + 1) {
+      return 0;
+    }
+    // Weight is stored output major whatever its shape says, see
+    // affine_rows().
+    channels = y_shape.data[base_axis];
+    if (num_of_elements(n, f->inputs[1]) % channels != 0) {
+      return 0;
+    }
+    break;
+  default:
+    return 0;
+  }
+  if (axis != base_axis || base_axis >= y_shape.size ||
+      y_shape.data[base_axis] != channels) {
+    return 0;
+  }
+  if (f->num_of_inputs == 3 && num_of_elements(n, f->inputs[2]) != channels) {
+    return 0;
+  }
+  return channels;
+}
+
+static int add_derived(rt_graph_t *g, rt_derived_kind_t kind, int function,
+                       int source, int size) {
+  rt_graph_derived_t *d = g->derived + g->num_of_derived;
+  d->kind = kind;
+  d->function = function;
+  d->source = source;
+  d->size = size;
+  return g->num_of_variables + g->num_of_derived++;
+}
+
+/*
+ * y = (conv(x, w) + b - mean) / sqrt(var + eps) * gamma + beta
+ *   = conv(x, w * s) + (b - mean) * s + beta, s = gamma / sqrt(var + eps)
+ * The producer writes the output of BatchNormalization with the derived
+ * weight and bias, and BatchNormalization is elided.
+ */
+static rt_return_value_t fold_batch_normalization(rt_context_t *c,
+                                                  nn_network_t *n,
+                                                  rt_graph_t *g) {
+  int i, j, k;
+
+  for (j = 0; j < g->num_of_functions; j++) {
+    nn_function_t *func = network_function(n, j);
+    rt_graph_function_t *bn = g->functions + j;
+    if (func->type != NN_FUNCTION_BATCH_NORMALIZATION || bn->elided ||
+        bn->num_of_inputs != 5 || bn->num_of_outputs != 1) {
+      continue;
+    }
+    nn_function_batch_normalization_t *args =
+        (nn_function_batch_normalization_t *)func;
+    rt_list_t axes = create_rt_list_from_nn_list(n, args->axes);
+    if (args->batch_stat || axes.size != 1) {
+      continue;
+    }
+
+    int x = bn->inputs[0];
+    int y = bn->outputs[0];
+    i = x >= 0 ? producer_of(g, x, j) : -1;
+    if (i < 0 || num_of_consumers(g, x) != 1 || is_network_output(n, x) ||
+        is_network_input(n, x) || !is_float(n, g, y) ||
+        is_network_input(n, y)) {
+      continue;
+    }
+    int channels = foldable_channels(n, g, i, axes.data[0]);
+    for (k = 1; k < 5 && channels > 0; k++) {
+      if (!is_parameter(n, g, bn->inputs[k]) ||
+          num_of_elements(n, bn->inputs[k]) != channels) {
+        channels = 0;
+      }
+    }
+    if (channels == 0 || has_callback(c, func->type) ||
+        has_callback(c, network_function(n, i)->type) ||
+        !can_write_early(c, n, g, i, j, y)) {
+      continue;
+    }
+
+    rt_graph_function_t *f = g->functions + i;
+    if (f->num_of_inputs < 3) {
+      int *inputs = rt_malloc_func(sizeof(int) * 3);
+      if (inputs == 0) {
+        return RT_RET_ERROR_ALLOCATE_CONTEXT;
+      }
+      inputs[0] = f->inputs[0];
+      inputs[1] = f->inputs[1];
+      rt_free_func(f->inputs);
+      f->inputs = inputs;
+      f->num_of_inputs = 3;
+    }
+    f->inputs[1] = add_derived(g, RT_DERIVED_FOLDED_WEIGHT, i, j, channels);
+    f->inputs[2] = add_derived(g, RT_DERIVED_FOLDED_BIAS, i, j, channels);
+    f->outputs[0] = y;
+    bn->elided = 1;
+    bn->num_of_inputs = 0;
+    bn->num_of_outputs = 0;
+  }
+  return RT_RET_NOERROR;
+}
+
+// Epilogue computing activation function, type RT_ACTIVATION_NONE if there
+// is none.
+static rt_activation_t activation_of(nn_function_t *func) {
+  rt_activation_t a;
+  a.alpha = 0.0f;
+  switch (func->type) {
+  case NN_FUNCTION_RELU:
+    a.type = RT_ACTIVATION_RELU;
+    break;
+  case NN_FUNCTION_LEAKY_RELU:
+    a.type = RT_ACTIVATION_LEAKY_RELU;
+    a.alpha = ((nn_function_leaky_relu_t *)func)->alpha;
+    break;
+  case NN_FUNCTION_SIGMOID:
+    a.type = RT_ACTIVATION_SIGMOID;
+    break;
+  case NN_FUNCTION_TANH:
+    a.type = RT_ACTIVATION_TANH;
+    break;
+  case NN_FUNCTION_SWISH:
+    a.type = RT_ACTIVATION_SWISH;
+    break;
+  case NN_FUNCTION_ELU:
+    a.type = RT_ACTIVATION_ELU;
+    a.alpha = ((nn_function_elu_t *)func)->alpha;
+    break;
+  default:
+    a.type = RT_ACTIVATION_NONE;
+    break;
+  }
+  return a;
+}
+
+// Whether kernels of function apply rt_function_t::activation.
+static int has_epilogue(nn_function_t *func) {
+  switch (func->type) {
+  case NN_FUNCTION_DECONVOLUTION:
+    return !((nn_function_deconvolution_t *)func)->channel_last;
+  case NN_FUNCTION_FUSED_CONVOLUTION:
+    // Unless its own nonlinearity takes the epilogue.
+    return ((nn_function_fused_convolution_t *)func)->nonlinearity ==
+           FUSED_CONVOLUTION_NONLINEARITY_IDENTITY;
+  case NN_FUNCTION_CONVOLUTION:
+  case NN_FUNCTION_DEPTHWISE_CONVOLUTION:
+  case NN_FUNCTION_AFFINE:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/*
+ * The producer applies the activation to its outputs before storing them
+ * and writes the output of the activation, which is elided. The input of
+ * the activation must have the same type as the output, so that fixed point
+ * kernels scale the same way.
+ */
+static void fuse_activation(rt_context_t *c, nn_network_t *n, rt_graph_t *g) {
+  int i, j;
+
+  for (j = 0; j < g->num_of_functions; j++) {
+    nn_function_t *func = network_function(n, j);
+    rt_graph_function_t *act = g->functions + j;
+    rt_activation_t a = activation_of(func);
+    if (a.type == RT_ACTIVATION_NONE || act->elided ||
+        act->num_of_inputs != 1 || act->num_of_outputs != 1) {
+      continue;
+    }
+
+    int x = act->inputs[0];
+    int y = act->outputs[0];
+    i = x >= 0 ? producer_of(g, x, j) : -1;
+    if (i < 0 || y < 0 || num_of_consumers(g, x) != 1 ||
+        is_network_output(n, x) || is_network_input(n, x) ||
+        is_network_input(n, y)) {
+      continue;
+    }
+    rt_graph_function_t *f = g->functions + i;
+    nn_variable_t *vx = network_variable(n, x);
+    nn_variable_t *vy = network_variable(n, y);
+    if (f->elided || f->activation.type != RT_ACTIVATION_NONE ||
+        f->num_of_outputs != 1 || !has_epilogue(network_function(n, i)) ||
+        vx->type != vy->type || vx->fp_pos != vy->fp_pos ||
+        num_of_elements(n, x) != num_of_elements(n, y) ||
+        has_callback(c, func->type) ||
+        has_callback(c, network_function(n, i)->type) ||
+        !can_write_early(c, n, g, i, j, y)) {
+      continue;
+    }
+
+    f->outputs[0] = y;
+    f->activation = a;
+    act->elided = 1;
+    act->num_of_inputs = 0;
+    act->num_of_outputs = 0;
+  }
+}
+
+// Whether a function in [first, last) writes variable.
+static int written_between(rt_graph_t *g, int variable, int first, int last) {
+  int i, j;
+  for (i = first; i < last; i++) {
+    for (j = 0; j < g->functions[i].num_of_outputs; j++) {
+      if (g->functions[i].outputs[j] == variable) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+// Last function reading variable, or -1.
+static int last_consumer(rt_graph_t *g, int variable) {
+  int i, j;
+  for (i = g->num_of_functions - 1; i >= 0; i--) {
+    for (j = 0; j < g->functions[i].num_of_inputs; j++) {
+      if (g->functions[i].inputs[j] == variable) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+// Whether the data of variable stays intact from function first to last.
+// Buffers of network may be reused by other variables once the variable is
+// dead in the original network, the liveness plan is made from the
+// optimized graph.
+static int keeps_data(rt_context_t *c, nn_network_t *n, rt_graph_t *g,
+                      int variable, int first, int last) {
+  int buffer = buffer_of(n, g, variable);
+  int i, j;
+
+  if (written_between(g, variable, first + 1, g->num_of_functions)) {
+    return 0;
+  }
+  if (c->memory_plan == RT_MEMORY_PLAN_LIVENESS || buffer < 0) {
+    return 1;
+  }
+  for (i = first + 1; i <= last; i++) {
+    rt_graph_function_t *f = g->functions + i;
+    for (j = 0; j < f->num_of_outputs; j++) {
+      if (f->outputs[j] != variable &&
+          buffer_of(n, g, f->outputs[j]) == buffer) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+// Only consumer of variable if its weight can take a scale of variable
+// instead, -1 otherwise.
+static int scalable_consumer(nn_network_t *n, rt_graph_t *g, int variable) {
+  int i = last_consumer(g, variable);
+  if (i < 0 || num_of_consumers(g, variable) != 1) {
+    return -1;
+  }
+  rt_graph_function_t *f = g->functions + i;
+  switch (network_function(n, i)->type) {
+  case NN_FUNCTION_CONVOLUTION:
+  case NN_FUNCTION_DEPTHWISE_CONVOLUTION:
+  case NN_FUNCTION_DECONVOLUTION:
+  case NN_FUNCTION_AFFINE:
+    break;
+  default:
+    return -1;
+  }
+  if (f->num_of_inputs < 2 || f->inputs[0] != variable ||
+      !is_parameter(n, g, f->inputs[1]) || !is_float(n, g, f->outputs[0])) {
+    return -1;
+  }
+  return i;
+}
+
+// Bytes per element of variable, 0 if elements are not byte addressable.
+static int element_size(nn_network_t *n, int variable) {
+  switch (network_variable(n, variable)->type) {
+  case NN_DATA_TYPE_FLOAT:
+    return sizeof(float);
+  case NN_DATA_TYPE_INT16:
+    return sizeof(int16_t);
+  case NN_DATA_TYPE_INT8:
+    return sizeof(int8_t);
+  default:
+    return 0;
+  }
+}
+
+// Product of dimensions of variable in [first, last).
+static int dims_product(nn_network_t *n, int variable, int first, int last) {
+  rt_list_t shape =
+      create_rt_list_from_nn_list(n, network_variable(n, variable)->shape);
+  int size = 1;
+  int i;
+  for (i = first < 0 ? 0 : first; i < last && i < shape.size; i++) {
+    size *= shape.data[i];
+  }
+  return size;
+}
+
+// Offset in bytes of the part of input of Slice index taken as output, -1
+// if it is not contiguous. Arguments are read as exec_slice() does.
+static int slice_offset(nn_network_t *n, rt_graph_t *g, int index) {
+  nn_function_slice_t *args = (nn_function_slice_t *)network_function(n, index);
+  rt_graph_function_t *f = g->functions + index;
+  rt_list_t xs = create_rt_list_from_nn_list(
+      n, network_variable(n, f->inputs[0])->shape);
+  rt_list_t ys = create_rt_list_from_nn_list(
+      n, network_variable(n, f->outputs[0])->shape);
+  rt_list_t start = create_rt_list_from_nn_list(n, args->start);
+  rt_list_t step = create_rt_list_from_nn_list(n, args->step);
+  int leading = xs.size - start.size;
+  int stride = element_size(n, f->inputs[0]);
+  int offset = 0;
+  int a;
+
+  if (xs.size != ys.size || step.size != start.size || leading < 0) {
+    return -1;
+  }
+  // Inner axes taken whole, one axis taken as a range and outer axes taken
+  // at one index.
+  int whole = 1;
+  for (a = xs.size - 1; a >= 0; a--) {
+    int b = a - leading;
+    int s0 = b < 0 || start.data[b] < 0 || start.data[b] == INT_MAX
+                 ? 0
+                 : start.data[b];
+    int s1 = b < 0 || step.data[b] < 0 || step.data[b] == INT_MAX
+                 ? 1
+                 : step.data[b];
+    if (whole && ys.data[a] == xs.data[a] && s0 == 0) {
+      stride *= xs.data[a];
+      continue;
+    }
+    if (ys.data[a] != 1 && (!whole || s1 != 1)) {
+      return -1;
+    }
+    whole = 0;
+    offset += s0 * stride;
+    stride *= xs.data[a];
+  }
+  return offset;
+}
+
+// Offset in bytes of output k of function index inside its input if the
+// output is a contiguous part of it, -1 otherwise.
+static int view_offset(nn_network_t *n, rt_graph_t *g, int index, int k) {
+  nn_function_t *func = network_function(n, index);
+  rt_graph_function_t *f = g->functions + index;
+  int x = f->inputs[0];
+
+  switch (func->type) {
+  case NN_FUNCTION_RESHAPE_0:
+  case NN_FUNCTION_RESHAPE:
+  case NN_FUNCTION_IDENTITY:
+  case NN_FUNCTION_DROPOUT:
+    return num_of_elements(n, x) == num_of_elements(n, f->outputs[0]) ? 0
+                                                                      : -1;
+  case NN_FUNCTION_SPLIT: {
+    // Outputs are the input at each index of axis, with axis removed.
+    int axis = ((nn_function_split_t *)func)->axis;
+    rt_list_t xs =
+        create_rt_list_from_nn_list(n, network_variable(n, x)->shape);
+    if (axis < 0 || axis >= xs.size || xs.data[axis] != f->num_of_outputs ||
+        dims_product(n, x, 0, axis) != 1) {
+      return -1;
+    }
+    return k * dims_product(n, x, axis + 1, xs.size) * element_size(n, x);
+  }
+  case NN_FUNCTION_SLICE:
+    return slice_offset(n, g, index);
+  default:
+    return -1;
+  }
+}
+
+// Make variable a view of data of root at offset in bytes. Views of
+// variable move along.
+static void make_view(rt_graph_t *g, int variable, int root, int offset) {
+  int i;
+  if (g->aliases[root] >= 0) {
+    offset += g->alias_offsets[root];
+    root = g->aliases[root];
+  }
+  for (i = 0; i < g->num_of_variables; i++) {
+    if (g->aliases[i] == variable) {
+      g->aliases[i] = root;
+      g->alias_offsets[i] += offset;
+    }
+  }
+  g->aliases[variable] = root;
+  g->alias_offsets[variable] = offset;
+}
+
+static void elide_view(rt_graph_t *g, int index) {
+  rt_graph_function_t *f = g->functions + index;
+  f->elided = 1;
+  f->num_of_inputs = 0;
+  f->num_of_outputs = 0;
+  g->num_of_views++;
+}
+
+/*
+ * Reshape and Identity copy their input, Dropout at inference scales it by
+ * 1 - p, and Split and Slice copy parts of it. When the input is not written
+ * again and each output is a contiguous part of it written by nobody else,
+ * outputs are views of the input and the function is elided. The scale of
+ * Dropout goes into the weight of the linear function reading its output:
+ * conv(x * s, w) = conv(x, w * s).
+ */
+static void view_outputs(rt_context_t *c, nn_network_t *n, rt_graph_t *g,
+                         int index) {
+  nn_function_t *func = network_function(n, index);
+  rt_graph_function_t *f = g->functions + index;
+  float scale = 1.0f;
+  int offset, last = -1;
+  int i, k;
+
+  if (f->num_of_inputs != 1 || f->num_of_outputs < 1) {
+    return;
+  }
+  int x = f->inputs[0];
+  if (x < 0 || x >= g->num_of_variables || element_size(n, x) == 0) {
+    return;
+  }
+  for (k = 0; k < f->num_of_outputs; k++) {
+    int y = f->outputs[k];
+    if (y < 0 || y >= g->num_of_variables || y == x) {
+      return;
+    }
+    nn_variable_t *vx = network_variable(n, x);
+    nn_variable_t *vy = network_variable(n, y);
+    // Outputs may be bound to memory of user, see rt_bind_output().
+    if (vx->type != vy->type || vx->fp_pos != vy->fp_pos ||
+        view_offset(n, g, index, k) < 0 || is_network_input(n, y) ||
+        is_network_output(n, y) || written_between(g, y, 0, index) ||
+        written_between(g, y, index + 1, g->num_of_functions)) {
+      return;
+    }
+    i = last_consumer(g, y);
+    last = i > last ? i : last;
+  }
+  int root = g->aliases[x] >= 0 ? g->aliases[x] : x;
+  if (!keeps_data(c, n, g, root, index, last)) {
+    return;
+  }
+
+  if (func->type == NN_FUNCTION_DROPOUT) {
+    scale = 1.0f - ((nn_function_dropout_t *)func)->p;
+  }
+  if (scale != 1.0f) {
+    int y = f->outputs[0];
+    i = is_float(n, g, y) ? scalable_consumer(n, g, y) : -1;
+    if (i < 0 || has_callback(c, network_function(n, i)->type)) {
+      return;
+    }
+    g->functions[i].inputs[1] =
+        add_derived(g, RT_DERIVED_SCALED_WEIGHT, i, index, 0);
+  }
+
+  for (k = 0; k < f->num_of_outputs; k++) {
+    offset = view_offset(n, g, index, k);
+    make_view(g, f->outputs[k], x, offset);
+  }
+  elide_view(g, index);
+}
+
+// Last function reading variable or a view of it, or -1.
+static int last_use(rt_graph_t *g, int variable) {
+  int last = last_consumer(g, variable);
+  int i, k;
+  for (i = 0; i < g->num_of_variables; i++) {
+    if (g->aliases[i] == variable) {
+      k = last_consumer(g, i);
+      last = k > last ? k : last;
+    }
+  }
+  return last;
+}
+
+// Whether no variable but variable itself uses its buffer of network in
+// functions [first, last]. The liveness plan is made from the optimized
+// graph.
+static int owns_buffer(rt_context_t *c, nn_network_t *n, rt_graph_t *g,
+                       int variable, int first, int last) {
+  int buffer = buffer_of(n, g, variable);
+  int i, j;
+
+  if (c->memory_plan == RT_MEMORY_PLAN_LIVENESS || buffer < 0) {
+    return 1;
+  }
+  for (i = first; i <= last; i++) {
+    rt_graph_function_t *f = g->functions + i;
+    for (j = 0; j < f->num_of_inputs; j++) {
+      if (f->inputs[j] != variable &&
+          buffer_of(n, g, f->inputs[j]) == buffer) {
+        return 0;
+      }
+    }
+    for (j = 0; j < f->num_of_outputs; j++) {
+      if (f->outputs[j] != variable &&
+          buffer_of(n, g, f->outputs[j]) == buffer) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/*
+ * Concatenate copies its inputs one after another along axis. When nothing
+ * comes before axis, e.g. channels of a single sample, each input is a
+ * contiguous part of the output. Inputs written once by a function before
+ * become views of the output, so that their producers write there, and
+ * Concatenate is elided.
+ */
+static void place_inputs(rt_context_t *c, nn_network_t *n, rt_graph_t *g,
+                         int index) {
+  nn_function_concatenate_t *args =
+      (nn_function_concatenate_t *)network_function(n, index);
+  rt_graph_function_t *f = g->functions + index;
+  int offset = 0;
+  int i, k;
+
+  if (f->num_of_outputs != 1 || f->num_of_inputs < 1) {
+    return;
+  }
+  int y = f->outputs[0];
+  if (y < 0 || y >= g->num_of_variables || g->aliases[y] >= 0 ||
+      element_size(n, y) == 0 || args->axis < 0 ||
+      dims_product(n, y, 0, args->axis) != 1 ||
+      written_between(g, y, 0, index) ||
+      written_between(g, y, index + 1, g->num_of_functions)) {
+    return;
+  }
+  nn_variable_t *vy = network_variable(n, y);
+  int first = index;
+  int last = is_network_output(n, y) ? g->num_of_functions - 1
+                                     : last_use(g, y);
+  for (k = 0; k < f->num_of_inputs; k++) {
+    int x = f->inputs[k];
+    if (x < 0 || x >= g->num_of_variables || buffer_of(n, g, x) < 0 ||
+        g->aliases[x] >= 0) {
+      return;
+    }
+    nn_variable_t *vx = network_variable(n, x);
+    int producer = producer_of(g, x, index);
+    if (vx->type != vy->type || vx->fp_pos != vy->fp_pos || producer < 0 ||
+        is_network_input(n, x) || is_network_output(n, x) ||
+        written_between(g, x, 0, producer) ||
+        written_between(g, x, producer + 1, g->num_of_functions)) {
+      return;
+    }
+    for (i = 0; i < k; i++) {
+      if (f->inputs[i] == x) {
+        return;
+      }
+    }
+    i = last_use(g, x);
+    first = producer < first ? producer : first;
+    last = i > last ? i : last;
+    offset += num_of_elements(n, x) * element_size(n, x);
+  }
+  if (offset != num_of_elements(n, y) * element_size(n, y) ||
+      !owns_buffer(c, n, g, y, first, last)) {
+    return;
+  }
+
+  offset = 0;
+  for (k = 0; k < f->num_of_inputs; k++) {
+    int x = f->inputs[k];
+    make_view(g, x, y, offset);
+    offset += num_of_elements(n, x) * element_size(n, x);
+  }
+  elide_view(g, index);
+}
+
+static void alias_variables(rt_context_t *c, nn_network_t *n, rt_graph_t *g) {
+  int j;
+
+  for (j = 0; j < g->num_of_functions; j++) {
+    nn_function_t *func = network_function(n, j);
+    if (g->functions[j].elided || has_callback(c, func->type)) {
+      continue;
+    }
+    switch (func->type) {
+    case NN_FUNCTION_RESHAPE_0:
+    case NN_FUNCTION_RESHAPE:
+    case NN_FUNCTION_IDENTITY:
+    case NN_FUNCTION_DROPOUT:
+    case NN_FUNCTION_SPLIT:
+    case NN_FUNCTION_SLICE:
+      view_outputs(c, n, g, j);
+      break;
+    case NN_FUNCTION_CONCATENATE:
+      place_inputs(c, n, g, j);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// Type of variable, derived variables are float.
+static nn_data_type_t variable_type(nn_network_t *n, rt_graph_t *g,
+                                    int variable) {
+  if (variable >= g->num_of_variables) {
+    return NN_DATA_TYPE_FLOAT;
+  }
+  return network_variable(n, variable)->type;
+}
+
+// Whether inputs and outputs of function index are all of type.
+static int all_of_type(nn_network_t *n, rt_graph_t *g, int index,
+                       nn_data_type_t type) {
+  rt_graph_function_t *f = g->functions + index;
+  int j;
+  for (j = 0; j < f->num_of_inputs; j++) {
+    if (f->inputs[j] < 0 || variable_type(n, g, f->inputs[j]) != type) {
+      return 0;
+    }
+  }
+  for (j = 0; j < f->num_of_outputs; j++) {
+    if (f->outputs[j] < 0 || variable_type(n, g, f->outputs[j]) != type) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int rank_of(nn_network_t *n, int variable) {
+  return network_variable(n, variable)->shape.size;
+}
+
+// Input of FusedConvolution index added before its nonlinearity, or -1.
+// Optional inputs are told apart as the kernel does.
+static int fused_convolution_residual(nn_network_t *n, rt_graph_t *g,
+                                      int index) {
+  rt_graph_function_t *f = g->functions + index;
+  int next = 2;
+  if (next < f->num_of_inputs && f->inputs[next] >= 0 &&
+      f->inputs[next] < g->num_of_variables &&
+      rank_of(n, f->inputs[next]) == 1) {
+    next++;
+  }
+  if (f->num_of_inputs - next >= 4) {
+    next += 4;
+  }
+  return f->num_of_inputs - next == 1 ? next : -1;
+}
+
+typedef enum {
+  LAYOUT_FIXED,     // reads and writes the layout of network only
+  LAYOUT_CONVERTER, // x and y may be stored in different layouts
+  LAYOUT_FOLLOWER,  // all activations share one layout
+} layout_role_t;
+
+// Role of function index in place_channel_last. *tied gets the bits of the
+// inputs stored in the layout of output 0, i.e. every activation read by a
+// follower, and the residual of a converter whose x is input 0.
+static layout_role_t layout_role(rt_context_t *c, nn_network_t *n,
+                                 rt_graph_t *g, int index, int *tied) {
+  nn_function_t *func = network_function(n, index);
+  rt_graph_function_t *f = g->functions + index;
+  int j;
+
+  *tied = 0;
+  if (f->elided || has_callback(c, func->type) || f->num_of_inputs < 1 ||
+      f->num_of_outputs != 1 || f->inputs[0] < 0 || f->outputs[0] < 0 ||
+      f->inputs[0] >= g->num_of_variables) {
+    return LAYOUT_FIXED;
+  }
+  switch (func->type) {
+  case NN_FUNCTION_CONVOLUTION: {
+    nn_function_convolution_t *conv = (nn_function_convolution_t *)func;
+    if (conv->channel_last || conv->base_axis != 1 || conv->pad.size != 2 ||
+        (!all_of_type(n, g, index, NN_DATA_TYPE_FLOAT) &&
+         !all_of_type(n, g, index, NN_DATA_TYPE_INT8))) {
+      return LAYOUT_FIXED;
+    }
+    return LAYOUT_CONVERTER;
+  }
+  case NN_FUNCTION_FUSED_CONVOLUTION: {
+    nn_function_fused_convolution_t *conv =
+        (nn_function_fused_convolution_t *)func;
+    if (conv->channel_last || conv->base_axis != 1 || conv->pad.size != 2 ||
+        !all_of_type(n, g, index, NN_DATA_TYPE_FLOAT)) {
+      return LAYOUT_FIXED;
+    }
+    j = fused_convolution_residual(n, g, index);
+    *tied = j > 0 ? 1 << j : 0;
+    return LAYOUT_CONVERTER;
+  }
+  case NN_FUNCTION_DEPTHWISE_CONVOLUTION: {
+    nn_function_depthwise_convolution_t *conv =
+        (nn_function_depthwise_convolution_t *)func;
+    if (conv->base_axis != 1 || conv->pad.size != 2 ||
+        !all_of_type(n, g, index, NN_DATA_TYPE_FLOAT)) {
+      return LAYOUT_FIXED;
+    }
+    return LAYOUT_CONVERTER;
+  }
+  case NN_FUNCTION_MAX_POOLING:
+  case NN_FUNCTION_AVERAGE_POOLING:
+  case NN_FUNCTION_SUM_POOLING: {
+    // kernel and channel_last are at the same place in the three of them.
+    nn_function_max_pooling_t *pool = (nn_function_max_pooling_t *)func;
+    nn_data_type_t tx = variable_type(n, g, f->inputs[0]);
+    nn_data_type_t ty = variable_type(n, g, f->outputs[0]);
+    if (pool->channel_last || pool->kernel.size != 2 ||
+        rank_of(n, f->inputs[0]) != 4 ||
+        (tx != NN_DATA_TYPE_FLOAT && tx != NN_DATA_TYPE_INT8) ||
+        (ty != NN_DATA_TYPE_FLOAT && ty != NN_DATA_TYPE_INT8)) {
+      return LAYOUT_FIXED;
+    }
+    return LAYOUT_CONVERTER;
+  }
+  case NN_FUNCTION_BATCH_NORMALIZATION:
+  case NN_FUNCTION_FUSED_BATCH_NORMALIZATION: {
+    // axes is the first argument of both.
+    nn_function_batch_normalization_t *bn =
+        (nn_function_batch_normalization_t *)func;
+    rt_list_t axes = create_rt_list_from_nn_list(n, bn->axes);
+    if (axes.size != 1 || axes.data[0] != 1 || f->num_of_inputs < 5) {
+      return LAYOUT_FIXED;
+    }
+    *tied = f->num_of_inputs > 5 ? (1 << 0) | (1 << 5) : 1 << 0;
+    return LAYOUT_FOLLOWER;
+  }
+  case NN_FUNCTION_RELU:
+  case NN_FUNCTION_LEAKY_RELU:
+  case NN_FUNCTION_RELU6:
+  case NN_FUNCTION_SIGMOID:
+  case NN_FUNCTION_TANH:
+  case NN_FUNCTION_SWISH:
+  case NN_FUNCTION_ELU:
+  case NN_FUNCTION_SELU:
+  case NN_FUNCTION_ABS:
+  case NN_FUNCTION_EXP:
+  case NN_FUNCTION_IDENTITY:
+  case NN_FUNCTION_ADD_SCALAR:
+  case NN_FUNCTION_MUL_SCALAR:
+    if (f->num_of_inputs != 1) {
+      return LAYOUT_FIXED;
+    }
+    *tied = 1 << 0;
+    return LAYOUT_FOLLOWER;
+  case NN_FUNCTION_ADD2:
+  case NN_FUNCTION_SUB2:
+  case NN_FUNCTION_MUL2:
+    // Elementwise only without broadcast.
+    if (f->num_of_inputs != 2 || f->inputs[1] < 0 ||
+        f->inputs[1] >= g->num_of_variables ||
+        num_of_elements(n, f->inputs[0]) != num_of_elements(n, f->outputs[0]) ||
+        num_of_elements(n, f->inputs[1]) != num_of_elements(n, f->outputs[0])) {
+      return LAYOUT_FIXED;
+    }
+    *tied = (1 << 0) | (1 << 1);
+    return LAYOUT_FOLLOWER;
+  default:
+    return LAYOUT_FIXED;
+  }
+}
+
+// Whether variable of network may be stored channel last as far as it
+// alone is concerned: a 4-D activation inside the network with its own
+// data, written once as output 0 of a function that is not fixed and read
+// only where its layout may change.
+static int channel_last_candidate(nn_network_t *n, rt_graph_t *g,
+                                  const int *roles, const int *tied,
+                                  int variable) {
+  int writers = 0;
+  int i, j;
+
+  if (rank_of(n, variable) != 4 || is_network_input(n, variable) ||
+      is_network_output(n, variable) || g->aliases[variable] >= 0) {
+    return 0;
+  }
+  for (i = 0; i < g->num_of_variables; i++) {
+    if (g->aliases[i] == variable) {
+      return 0;
+    }
+  }
+  for (i = 0; i < g->num_of_functions; i++) {
+    rt_graph_function_t *f = g->functions + i;
+    for (j = 0; j < f->num_of_outputs; j++) {
+      if (f->outputs[j] == variable) {
+        if (j != 0 || roles[i] == LAYOUT_FIXED) {
+          return 0;
+        }
+        writers++;
+      }
+    }
+    for (j = 0; j < f->num_of_inputs; j++) {
+      if (f->inputs[j] != variable) {
+        continue;
+      }
+      if (roles[i] == LAYOUT_FIXED || j >= 32) {
+        return 0;
+      }
+      if (!((tied[i] >> j) & 1) && !(j == 0 && roles[i] == LAYOUT_CONVERTER)) {
+        return 0;
+      }
+    }
+  }
+  return writers == 1;
+}
+
+/*
+ * Convolutions, depthwise convolutions and pooling read and write their
+ * activations either channel first as in the network, or channel last,
+ * which lets their kernels vectorize over channels. An activation is stored
+ * channel last when every function reading or writing it supports that,
+ * and the functions between them which do not care about the layout, i.e.
+ * BatchNormalization and elementwise ones, see all their activations in the
+ * same layout. A subgraph stored channel last is thus bounded by converting
+ * functions, which transpose while reading x or writing y, so no transpose
+ * is added to the network.
+ */
+static rt_return_value_t place_channel_last(rt_context_t *c, nn_network_t *n,
+                                            rt_graph_t *g) {
+  int *roles = rt_malloc_func(sizeof(int) * (g->num_of_functions + 1));
+  int *tied = rt_malloc_func(sizeof(int) * (g->num_of_functions + 1));
+  char *last = rt_malloc_func(sizeof(char) * (g->num_of_variables + 1));
+  int changed = 1;
+  int i, j;
+
+  if (roles == 0 || tied == 0 || last == 0) {
+    rt_free_func(roles);
+    rt_free_func(tied);
+    rt_free_func(last);
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  for (i = 0; i < g->num_of_functions; i++) {
+    roles[i] = layout_role(c, n, g, i, tied + i);
+  }
+  for (i = 0; i < g->num_of_variables; i++) {
+    last[i] = channel_last_candidate(n, g, roles, tied, i);
+  }
+
+  // Tied activations of a function keep the layout of network as soon as
+  // one of them does, until every function agrees.
+  while (changed) {
+    changed = 0;
+    for (i = 0; i < g->num_of_functions; i++) {
+      rt_graph_function_t *f = g->functions + i;
+      int y = f->outputs[0];
+      int mixed = 0;
+      if (roles[i] == LAYOUT_FIXED) {
+        continue;
+      }
+      for (j = 0; j < f->num_of_inputs && j < 32; j++) {
+        if ((tied[i] >> j) & 1) {
+          int x = f->inputs[j];
+          mixed |= x < 0 || x >= g->num_of_variables || last[x] != last[y];
+        }
+      }
+      if (!mixed) {
+        continue;
+      }
+      if (last[y]) {
+        last[y] = 0;
+        changed = 1;
+      }
+      for (j = 0; j < f->num_of_inputs && j < 32; j++) {
+        int x = f->inputs[j];
+        if (((tied[i] >> j) & 1) && x >= 0 && x < g->num_of_variables &&
+            last[x]) {
+          last[x] = 0;
+          changed = 1;
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < g->num_of_functions; i++) {
+    rt_graph_function_t *f = g->functions + i;
+    if (roles[i] == LAYOUT_FIXED) {
+      continue;
+    }
+    if (last[f->inputs[0]]) {
+      f->channel_last |= RT_CHANNEL_LAST_INPUT;
+    }
+    if (last[f->outputs[0]]) {
+      f->channel_last |= RT_CHANNEL_LAST_OUTPUT;
+    }
+  }
+  rt_free_func(roles);
+  rt_free_func(tied);
+  rt_free_func(last);
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_build_graph(rt_context_t *c, nn_network_t *n,
+                                 rt_graph_t *g) {
+  int i;
+
+  g->num_of_variables = n->variables.size;
+  g->num_of_derived = 0;
+  g->num_of_functions = n->functions.size;
+  g->functions =
+      rt_malloc_func(sizeof(rt_graph_function_t) * (g->num_of_functions + 1));
+  // Every function gets at most a derived weight and bias.
+  g->derived =
+      rt_malloc_func(sizeof(rt_graph_derived_t) * 2 *
+                     (g->num_of_functions + 1));
+  g->aliases = rt_malloc_func(sizeof(int) * (g->num_of_variables + 1));
+  g->alias_offsets = rt_malloc_func(sizeof(int) * (g->num_of_variables + 1));
+  g->num_of_views = 0;
+  if (g->functions == 0 || g->derived == 0 || g->aliases == 0 ||
+      g->alias_offsets == 0) {
+    g->num_of_functions = 0;
+    rt_free_graph(g);
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  memset(g->functions, 0, sizeof(rt_graph_function_t) * g->num_of_functions);
+  for (i = 0; i < g->num_of_variables; i++) {
+    g->aliases[i] = -1;
+    g->alias_offsets[i] = 0;
+  }
+
+  for (i = 0; i < g->num_of_functions; i++) {
+    nn_function_t *func = network_function(n, i);
+    rt_graph_function_t *f = g->functions + i;
+    f->num_of_inputs = func->inputs.size;
+    f->inputs = copy_indices(n, func->inputs, g->num_of_variables,
+                             f->num_of_inputs);
+    f->num_of_outputs = func->outputs.size;
+    f->outputs = copy_indices(n, func->outputs, g->num_of_variables,
+                              f->num_of_outputs);
+    f->elided = 0;
+    f->activation.type = RT_ACTIVATION_NONE;
+    f->activation.alpha = 0.0f;
+    f->channel_last = 0;
+    if (f->inputs == 0 || f->outputs == 0) {
+      rt_free_graph(g);
+      return RT_RET_ERROR_ALLOCATE_CONTEXT;
+    }
+  }
+
+  if (c->optimization & RT_OPTIMIZATION_FOLD_BATCH_NORMALIZATION) {
+    rt_return_value_t ret = fold_batch_normalization(c, n, g);
+    if (ret != RT_RET_NOERROR) {
+      rt_free_graph(g);
+      return ret;
+    }
+  }
+  if (c->optimization & RT_OPTIMIZATION_FUSE_ACTIVATION) {
+    fuse_activation(c, n, g);
+  }
+  if (c->optimization & RT_OPTIMIZATION_ALIAS_VARIABLES) {
+    alias_variables(c, n, g);
+  }
+  if (c->optimization & RT_OPTIMIZATION_CHANNEL_LAST) {
+    rt_return_value_t ret = place_channel_last(c, n, g);
+    if (ret != RT_RET_NOERROR) {
+      rt_free_graph(g);
+      return ret;
+    }
+  }
+  return RT_RET_NOERROR;
+}
+
+rt_variable_t *rt_graph_variable(rt_context_t *c, int index) {
+  if (index < 0) {
+    return 0;
+  }
+  if (index < c->num_of_variables) {
+    return c->variables + index;
+  }
+  index -= c->num_of_variables;
+  return index < c->num_of_derived_variables ? c->derived_variables + index
+                                             : 0;
+}
+
+rt_return_value_t rt_allocate_derived(rt_context_t *c, nn_network_t *n,
+                                      rt_graph_t *g) {
+  int i;
+
+  c->num_of_derived_variables = g->num_of_derived;
+  if (g->num_of_derived == 0) {
+    return RT_RET_NOERROR;
+  }
+  c->derived_variables =
+      rt_context_malloc(c, sizeof(rt_variable_t) * g->num_of_derived);
+  c->derived_dims = rt_context_malloc(c, sizeof(int) * g->num_of_derived);
+  if (c->derived_variables == 0 || c->derived_dims == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+
+  for (i = 0; i < g->num_of_derived; i++) {
+    rt_graph_derived_t *d = g->derived + i;
+    rt_variable_t *v = c->derived_variables + i;
+    v->type = NN_DATA_TYPE_FLOAT;
+    v->fp_pos = 0;
+    v->coefficient = 0;
+    v->data = 0;
+    c->derived_dims[i] = d->size;
+    if (d->kind != RT_DERIVED_FOLDED_BIAS) {
+      nn_function_t *func = network_function(n, d->function);
+      rt_list_t inputs = create_rt_list_from_nn_list(n, func->inputs);
+      v->shape = c->variables[inputs.data[1]].shape;
+    } else {
+      v->shape.size = 1;
+      v->shape.data = c->derived_dims + i;
+    }
+  }
+  return RT_RET_NOERROR;
+}
+
+static void compute_folded(rt_context_t *c, nn_network_t *n,
+                           rt_graph_derived_t *d, float *data) {
+  nn_function_t *producer = network_function(n, d->function);
+  rt_list_t inputs = create_rt_list_from_nn_list(n, producer->inputs);
+  rt_list_t bn_inputs = create_rt_list_from_nn_list(
+      n, network_function(n, d->source)->inputs);
+  nn_function_batch_normalization_t *bn =
+      (nn_function_batch_normalization_t *)network_function(n, d->source);
+  const float *beta = (const float *)c->variables[bn_inputs.data[1]].data;
+  const float *gamma = (const float *)c->variables[bn_inputs.data[2]].data;
+  const float *mean = (const float *)c->variables[bn_inputs.data[3]].data;
+  const float *var = (const float *)c->variables[bn_inputs.data[4]].data;
+  int channels = d->size;
+  int i;
+
+  if (d->kind == RT_DERIVED_FOLDED_BIAS) {
+    const float *b = inputs.size > 2 && inputs.data[2] < c->num_of_variables
+                         ? (const float *)c->variables[inputs.data[2]].data
+                         : 0;
+    for (i = 0; i < channels; i++) {
+      float scale = gamma[i] / sqrtf(var[i] + bn->eps);
+      data[i] = ((b ? b[i] : 0.0f) - mean[i]) * scale + beta[i];
+    }
+    return;
+  }
+
+  // Weights are stored output channel major.
+  const rt_variable_t *w = c->variables + inputs.data[1];
+  const float *src = (const float *)w->data;
+  int size = (int)(rt_variable_size(w) / sizeof(float));
+  int inner = size / channels;
+  for (i = 0; i < size; i++) {
+    int oc = i / inner;
+    data[i] = src[i] * (gamma[oc] / sqrtf(var[oc] + bn->eps));
+  }
+}
+
+static void compute_scaled(rt_context_t *c, nn_network_t *n,
+                           rt_graph_derived_t *d, float *data) {
+  rt_list_t inputs =
+      create_rt_list_from_nn_list(n, network_function(n, d->function)->inputs);
+  nn_function_dropout_t *dropout =
+      (nn_function_dropout_t *)network_function(n, d->source);
+  const rt_variable_t *w = c->variables + inputs.data[1];
+  const float *src = (const float *)w->data;
+  int size = (int)(rt_variable_size(w) / sizeof(float));
+  int i;
+
+  for (i = 0; i < size; i++) {
+    data[i] = src[i] * (1.0f - dropout->p);
+  }
+}
+
+static shared_blob_tag_t derived_tag(rt_derived_kind_t kind) {
+  switch (kind) {
+  case RT_DERIVED_FOLDED_WEIGHT:
+    return SHARED_BLOB_FOLDED_WEIGHT;
+  case RT_DERIVED_FOLDED_BIAS:
+    return SHARED_BLOB_FOLDED_BIAS;
+  default:
+    return SHARED_BLOB_SCALED_WEIGHT;
+  }
+}
+
+rt_return_value_t rt_compute_derived(rt_context_t *c, nn_network_t *n,
+                                     rt_graph_t *g, int index) {
+  int i;
+
+  for (i = 0; i < g->num_of_derived; i++) {
+    rt_graph_derived_t *d = g->derived + i;
+    rt_variable_t *v = c->derived_variables + i;
+    int created = 0;
+    if (d->function != index) {
+      continue;
+    }
+    // Clones share the data through the cache, keyed by the merged function.
+    v->data = shared_blob(&(c->functions[index].func),
+                          network_function(n, d->source), derived_tag(d->kind),
+                          rt_variable_size(v), &created);
+    if (v->data == 0) {
+      return RT_RET_ERROR_ALLOCATE_CONTEXT;
+    }
+    if (created && d->kind == RT_DERIVED_SCALED_WEIGHT) {
+      compute_scaled(c, n, d, (float *)v->data);
+    } else if (created) {
+      compute_folded(c, n, d, (float *)v->data);
+    }
+  }
+  return RT_RET_NOERROR;
+}
+
+rt_function_error_t rt_exec_elided(rt_function_t *f) {
+  return RT_FUNCTION_ERROR_NOERROR;
+}
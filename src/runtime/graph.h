@@ -0,0 +1,87 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_GRAPH_H_181008141520_
+#define H_GRAPH_H_181008141520_
+
+#include "context.h"
+
+/// @brief Inputs and outputs of a function after optimization.
+/// Variable indices below num_of_variables of the graph are variables of
+/// network, indices from there are derived variables, and -1 is none.
+typedef struct {
+  int num_of_inputs;
+  int *inputs;
+  int num_of_outputs;
+  int *outputs;
+  int elided; ///< Work merged into another function, nothing to execute
+  rt_activation_t activation; ///< Epilogue of an activation merged into it
+  int channel_last; ///< OR of rt_channel_last_t set by the layout pass
+} rt_graph_function_t;
+
+/// @brief How a derived variable is computed.
+typedef enum {
+  RT_DERIVED_FOLDED_WEIGHT, ///< Weight scaled by BatchNormalization
+  RT_DERIVED_FOLDED_BIAS,   ///< Bias shifted by BatchNormalization
+  RT_DERIVED_SCALED_WEIGHT, ///< Weight scaled by Dropout before it
+} rt_derived_kind_t;
+
+/// @brief Parameter computed at initialization, e.g. folded weight.
+typedef struct {
+  rt_derived_kind_t kind;
+  int function; ///< Function using the variable
+  int source;   ///< Function whose parameters are merged
+  int size;     ///< Number of channels of a bias
+} rt_graph_derived_t;
+
+/// @brief Dataflow of network after optimizations of rt_set_optimization().
+/// The network itself is never modified.
+typedef struct {
+  int num_of_variables; ///< Variables of network
+  int num_of_derived;
+  rt_graph_derived_t *derived; ///< Indexed by variable - num_of_variables
+  int num_of_functions;
+  rt_graph_function_t *functions;
+  /// Variable of network whose data each variable of network is a view of,
+  /// or -1 if it has its own. Always a variable with its own data.
+  int *aliases;
+  int *alias_offsets; ///< Offset of each view in bytes
+  int num_of_views;   ///< Functions elided by making views
+} rt_graph_t;
+
+/// @brief Build graph of network and optimize it for context.
+rt_return_value_t rt_build_graph(rt_context_t *c, nn_network_t *n,
+                                 rt_graph_t *g);
+
+/// @brief Free graph built with rt_build_graph.
+void rt_free_graph(rt_graph_t *g);
+
+/// @brief Variable of context referred by index of graph, 0 for none.
+rt_variable_t *rt_graph_variable(rt_context_t *c, int index);
+
+/// @brief Allocate derived variables of graph in context.
+/// Shapes and types are set, data is computed by rt_compute_derived.
+rt_return_value_t rt_allocate_derived(rt_context_t *c, nn_network_t *n,
+                                      rt_graph_t *g);
+
+/// @brief Compute data of derived variables used by function index.
+/// Called before the local context of function is allocated, as kernels
+/// may transform parameters there.
+rt_return_value_t rt_compute_derived(rt_context_t *c, nn_network_t *n,
+                                     rt_graph_t *g, int index);
+
+/// @brief Execute function merged into another one.
+rt_function_error_t rt_exec_elided(rt_function_t *f);
+
+#endif // H_GRAPH_H_181008141520_
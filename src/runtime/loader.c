@@ -0,0 +1,143 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "runtime_internal.h"
+
+#ifdef NNABLART_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* NNABLART_USE_MMAP */
+
+// Size of network described by header, computed without overflow.
+static uint64_t network_size(const nn_network_t *n) {
+  return (uint64_t)sizeof(nn_network_t) +
+         (uint64_t)n->memory.num_of_data * sizeof(pointer_index_t) +
+         n->memory.data_size;
+}
+
+// All indexes must point inside the data area.
+static int validate_index(nn_network_t *n) {
+  pointer_index_t *index = NN_NETWORK_INDEX_POINTER(n);
+  nn_size_t i;
+  for (i = 0; i < n->memory.num_of_data; i++) {
+    if (index[i] < 0 || (nn_size_t)index[i] > n->memory.data_size) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+#ifdef NNABLART_USE_MMAP
+
+rt_return_value_t rt_load_network_file(const char *filename,
+                                       nn_network_t **network) {
+  nn_network_t header;
+  struct stat st;
+  int fd;
+
+  *network = 0;
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(nn_network_t) ||
+      read(fd, &header, sizeof(header)) != sizeof(header) ||
+      network_size(&header) > (uint64_t)st.st_size) {
+    close(fd);
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+
+  // Weights are used in place, so pages are shared by every process
+  // mapping the same file and only read when touched. Functions such as
+  // BatchNormalization with batch_stat update their parameters, so the
+  // mapping is writable and private: written pages are copied and the
+  // file is never modified.
+  void *p = mmap(0, NN_NETWORK_SIZE(&header), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+  if (!validate_index((nn_network_t *)p)) {
+    munmap(p, NN_NETWORK_SIZE(&header));
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+  *network = (nn_network_t *)p;
+  return RT_RET_NOERROR;
+}
+
+void rt_unload_network_file(nn_network_t *network) {
+  if (network) {
+    munmap(network, NN_NETWORK_SIZE(network));
+  }
+}
+
+#else /* NNABLART_USE_MMAP */
+
+rt_return_value_t rt_load_network_file(const char *filename,
+                                       nn_network_t **network) {
+  nn_network_t header;
+  FILE *fp = 0;
+  long file_size;
+
+  *network = 0;
+#ifdef _MSC_VER
+  fopen_s(&fp, filename, "rb");
+#else
+  fp = fopen(filename, "rb");
+#endif
+  if (fp == 0) {
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+  if (fseek(fp, 0L, SEEK_END) != 0 || (file_size = ftell(fp)) < 0 ||
+      file_size < (long)sizeof(nn_network_t) ||
+      fseek(fp, 0L, SEEK_SET) != 0 ||
+      fread(&header, sizeof(header), 1, fp) != 1 ||
+      network_size(&header) > (uint64_t)file_size) {
+    fclose(fp);
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+
+  nn_network_t *n = rt_malloc_func(NN_NETWORK_SIZE(&header));
+  if (n == 0) {
+    fclose(fp);
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+  fseek(fp, 0L, SEEK_SET);
+  size_t read_size = fread(n, 1, NN_NETWORK_SIZE(&header), fp);
+  fclose(fp);
+  if (read_size != NN_NETWORK_SIZE(&header) || !validate_index(n)) {
+    rt_free_func(n);
+    return RT_RET_ERROR_LOAD_NETWORK;
+  }
+  *network = n;
+  return RT_RET_NOERROR;
+}
+
+void rt_unload_network_file(nn_network_t *network) {
+  if (network) {
+    rt_free_func(network);
+  }
+}
+
+#endif /* NNABLART_USE_MMAP */
@@ -0,0 +1,211 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "memory_planner.h"
+#include "runtime_internal.h"
+
+typedef struct {
+  int variable;
+  size_t size; // Aligned size
+  int first;   // First function using the variable
+  int last;    // Last function using the variable
+  size_t offset;
+} plan_entry_t;
+
+size_t rt_variable_size(const rt_variable_t *v) {
+  size_t size = 1;
+  int i;
+  for (i = 0; i < v->shape.size; i++) {
+    size *= v->shape.data[i];
+  }
+  switch (v->type) {
+  case NN_DATA_TYPE_FLOAT:
+    return size * sizeof(float);
+  case NN_DATA_TYPE_INT16:
+    return size * sizeof(int16_t);
+  case NN_DATA_TYPE_INT8:
+    return size * sizeof(int8_t);
+  case NN_DATA_TYPE_SIGN:
+    return (size + 7) >> 3;
+  default:
+    return size * sizeof(float);
+  }
+}
+
+// Larger first, then earlier first so that the result is stable.
+static int compare_size(const void *a, const void *b) {
+  const plan_entry_t *x = (const plan_entry_t *)a;
+  const plan_entry_t *y = (const plan_entry_t *)b;
+  if (x->size != y->size) {
+    return x->size < y->size ? 1 : -1;
+  }
+  if (x->first != y->first) {
+    return x->first - y->first;
+  }
+  return x->variable - y->variable;
+}
+
+static int compare_offset(const void *a, const void *b) {
+  const plan_entry_t *x = *(const plan_entry_t *const *)a;
+  const plan_entry_t *y = *(const plan_entry_t *const *)b;
+  if (x->offset != y->offset) {
+    return x->offset < y->offset ? -1 : 1;
+  }
+  return 0;
+}
+
+static void use_variable(plan_entry_t *entries, int *entry_of, int variable,
+                         int num_of_variables, int step) {
+  if (variable >= 0 && variable < num_of_variables &&
+      entry_of[variable] >= 0) {
+    plan_entry_t *e = entries + entry_of[variable];
+    e->first = step < e->first ? step : e->first;
+    e->last = step > e->last ? step : e->last;
+  }
+}
+
+rt_return_value_t rt_plan_memory(nn_network_t *n, const rt_graph_t *g,
+                                 size_t *offsets, size_t *arena_size) {
+  int *list = (int *)NN_GET(n, n->variables.list);
+  int num_of_variables = n->variables.size;
+  int num_of_functions = g->num_of_functions;
+  int num_of_entries = 0;
+  int i, j;
+
+  *arena_size = 0;
+
+  plan_entry_t *entries =
+      rt_malloc_func(sizeof(plan_entry_t) * (num_of_variables + 1));
+  plan_entry_t **live =
+      rt_malloc_func(sizeof(plan_entry_t *) * (num_of_variables + 1));
+  int *entry_of = rt_malloc_func(sizeof(int) * (num_of_variables + 1));
+  if (entries == 0 || live == 0 || entry_of == 0) {
+    if (entries) {
+      rt_free_func(entries);
+    }
+    if (live) {
+      rt_free_func(live);
+    }
+    if (entry_of) {
+      rt_free_func(entry_of);
+    }
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+
+  for (i = 0; i < num_of_variables; i++) {
+    nn_variable_t *var = (nn_variable_t *)(NN_GET(n, *(list + i)));
+    entry_of[i] = -1;
+    if (var->data_index < 0 && g->aliases[i] < 0) {
+      plan_entry_t *e = entries + num_of_entries;
+      rt_variable_t v;
+      v.shape = create_rt_list_from_nn_list(n, var->shape);
+      v.type = var->type;
+      e->variable = i;
+      e->size = RT_MEMORY_ALIGN(rt_variable_size(&v));
+      e->first = num_of_functions;
+      e->last = -1;
+      entry_of[i] = num_of_entries++;
+    }
+  }
+  // Uses of a variable sharing data of another one keep that one alive.
+  for (i = 0; i < num_of_variables; i++) {
+    if (g->aliases[i] >= 0) {
+      entry_of[i] = entry_of[g->aliases[i]];
+    }
+  }
+
+  // Lifetimes
+  // Inputs stay as written by user, so that rt_forward() can be repeated.
+  rt_list_t net_inputs = create_rt_list_from_nn_list(n, n->inputs);
+  for (i = 0; i < net_inputs.size; i++) {
+    use_variable(entries, entry_of, net_inputs.data[i], num_of_variables, 0);
+    use_variable(entries, entry_of, net_inputs.data[i], num_of_variables,
+                 num_of_functions - 1);
+  }
+  rt_list_t net_outputs = create_rt_list_from_nn_list(n, n->outputs);
+  for (i = 0; i < net_outputs.size; i++) {
+    use_variable(entries, entry_of, net_outputs.data[i], num_of_variables,
+                 num_of_functions - 1);
+  }
+  for (i = 0; i < num_of_functions; i++) {
+    const rt_graph_function_t *f = g->functions + i;
+    for (j = 0; j < f->num_of_inputs; j++) {
+      use_variable(entries, entry_of, f->inputs[j], num_of_variables, i);
+    }
+    for (j = 0; j < f->num_of_outputs; j++) {
+      use_variable(entries, entry_of, f->outputs[j], num_of_variables, i);
+    }
+  }
+  for (i = 0; i < num_of_entries; i++) {
+    if (entries[i].first > entries[i].last) {
+      // Unused, e.g. merged away by rt_build_graph().
+      entries[i].size = 0;
+      entries[i].first = 0;
+      entries[i].last = 0;
+    }
+  }
+
+  // Offsets
+  qsort(entries, num_of_entries, sizeof(plan_entry_t), compare_size);
+  for (i = 0; i < num_of_entries; i++) {
+    plan_entry_t *e = entries + i;
+    int num_of_live = 0;
+    for (j = 0; j < i; j++) {
+      if (entries[j].first <= e->last && e->first <= entries[j].last) {
+        live[num_of_live++] = entries + j;
+      }
+    }
+    qsort(live, num_of_live, sizeof(plan_entry_t *), compare_offset);
+
+    size_t top = 0;
+    size_t best_gap = 0;
+    int found = 0;
+    e->offset = 0;
+    for (j = 0; j < num_of_live; j++) {
+      if (live[j]->offset > top) {
+        size_t gap = live[j]->offset - top;
+        if (gap >= e->size && (!found || gap < best_gap)) {
+          found = 1;
+          best_gap = gap;
+          e->offset = top;
+        }
+      }
+      if (live[j]->offset + live[j]->size > top) {
+        top = live[j]->offset + live[j]->size;
+      }
+    }
+    if (!found) {
+      e->offset = top;
+    }
+    if (e->offset + e->size > *arena_size) {
+      *arena_size = e->offset + e->size;
+    }
+  }
+
+  if (offsets) {
+    for (i = 0; i < num_of_entries; i++) {
+      offsets[entries[i].variable] = entries[i].offset;
+    }
+  }
+
+  rt_free_func(entries);
+  rt_free_func(live);
+  rt_free_func(entry_of);
+  return RT_RET_NOERROR;
+}
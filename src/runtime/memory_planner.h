@@ -0,0 +1,39 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_MEMORY_PLANNER_H_180925102317_
+#define H_MEMORY_PLANNER_H_180925102317_
+
+#include "context.h"
+#include "graph.h"
+
+/// @brief Place variables of network stored in buffers into one arena.
+/// The lifetime of a variable spans from the first to the last function
+/// using it in graph g, inputs are alive all the time and outputs until the
+/// end, and variables no function uses take no space. Variables sharing data
+/// of another one get no offset and extend the lifetime of that one instead.
+/// From the largest variable down, each one is placed into the smallest gap
+/// left by variables alive at the same time that fits it (best fit), or on
+/// top of them.
+/// Offsets are aligned to RT_MEMORY_ALIGNMENT.
+/// @param[out] offsets Offset of each variable stored in buffers, indexed by
+/// variable. May be 0 to only get the size.
+/// @param[out] arena_size Peak size of the arena.
+rt_return_value_t rt_plan_memory(nn_network_t *n, const rt_graph_t *g,
+                                 size_t *offsets, size_t *arena_size);
+
+/// @brief Size of variable data in bytes.
+size_t rt_variable_size(const rt_variable_t *v);
+
+#endif // H_MEMORY_PLANNER_H_180925102317_
@@ -0,0 +1,153 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <nnablart/functions.h>
+#include <nnablart/network.h>
+
+#include "profiler.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef NNABLART_USE_PTHREAD
+#include <pthread.h>
+#endif
+
+double rt_profiler_time(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+uintptr_t rt_profiler_thread(void) {
+#if defined(_WIN32)
+  return (uintptr_t)GetCurrentThreadId();
+#elif defined(NNABLART_USE_PTHREAD)
+  return (uintptr_t)pthread_self();
+#else
+  return 0;
+#endif
+}
+
+static double num_of_elements(const rt_variable_t *v) {
+  double size = 1;
+  int i;
+  for (i = 0; i < v->shape.size; i++) {
+    size *= v->shape.data[i];
+  }
+  return size;
+}
+
+double rt_estimate_flops(const rt_function_context_t *f) {
+  const rt_function_t *func = &(f->func);
+  const rt_variable_t *x = func->num_of_inputs > 0 ? func->inputs[0] : 0;
+  const rt_variable_t *w = func->num_of_inputs > 1 ? func->inputs[1] : 0;
+  double outputs = 0;
+  int i;
+
+  for (i = 0; i < func->num_of_outputs; i++) {
+    if (func->outputs[i]) {
+      outputs += num_of_elements(func->outputs[i]);
+    }
+  }
+  if (x == 0) {
+    return outputs;
+  }
+
+  switch (f->info->type) {
+  case NN_FUNCTION_CONVOLUTION_0:
+  case NN_FUNCTION_CONVOLUTION:
+  case NN_FUNCTION_FUSED_CONVOLUTION:
+  case NN_FUNCTION_DEPTHWISE_CONVOLUTION:
+    // Every output accumulates one filter.
+    if (w && w->shape.size > 0 && w->shape.data[0] > 0) {
+      return 2 * outputs * num_of_elements(w) / w->shape.data[0];
+    }
+    break;
+
+  case NN_FUNCTION_DECONVOLUTION_0:
+  case NN_FUNCTION_DECONVOLUTION_1:
+  case NN_FUNCTION_DECONVOLUTION:
+  case NN_FUNCTION_DEPTHWISE_DECONVOLUTION:
+    // Every input is scattered through one filter.
+    if (w && w->shape.size > 0 && w->shape.data[0] > 0) {
+      return 2 * num_of_elements(x) * num_of_elements(w) / w->shape.data[0];
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  // Arguments below come from local contexts of the default allocator.
+  if (f->user_defined) {
+    return outputs;
+  }
+
+  switch (f->info->type) {
+  case NN_FUNCTION_AFFINE: {
+    // Every output accumulates all features of its sample.
+    affine_local_context_t *c = (affine_local_context_t *)func->local_context;
+    double features = 1;
+    for (i = c->base_axis; i < x->shape.size; i++) {
+      features *= x->shape.data[i];
+    }
+    return 2 * outputs * features;
+  }
+
+  case NN_FUNCTION_BATCH_MATMUL: {
+    batch_matmul_local_context_t *c =
+        (batch_matmul_local_context_t *)func->local_context;
+    int rank = x->shape.size;
+    if (rank >= 2) {
+      return 2 * outputs * x->shape.data[c->transpose_a ? rank - 2 : rank - 1];
+    }
+    break;
+  }
+
+  case NN_FUNCTION_MAX_POOLING_0:
+  case NN_FUNCTION_MAX_POOLING:
+  case NN_FUNCTION_AVERAGE_POOLING_0:
+  case NN_FUNCTION_AVERAGE_POOLING:
+  case NN_FUNCTION_SUM_POOLING_0:
+  case NN_FUNCTION_SUM_POOLING: {
+    // Kernel is the first member of every pooling local context.
+    max_pooling_local_context_t *c =
+        (max_pooling_local_context_t *)func->local_context;
+    double kernel = 1;
+    for (i = 0; i < c->kernel.size; i++) {
+      kernel *= c->kernel.data[i];
+    }
+    return outputs * kernel;
+  }
+
+  default:
+    break;
+  }
+  return outputs;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_PROFILER_H_181002153412_
+#define H_PROFILER_H_181002153412_
+
+#include "context.h"
+
+/// @brief Monotonic wall clock in seconds.
+double rt_profiler_time(void);
+
+/// @brief Identifier of calling thread, unique among running threads.
+uintptr_t rt_profiler_thread(void);
+
+/// @brief Estimated number of arithmetic operations of one execution.
+/// Multiply-accumulate counts as two operations. Functions without a
+/// specific estimate count one operation per output element.
+double rt_estimate_flops(const rt_function_context_t *f);
+
+#endif // H_PROFILER_H_181002153412_
@@ -18,7 +18,16 @@
 #include <nnablart/network.h>
 #include <nnablart/runtime.h>
 
+#include "graph.h"
+#include "memory_planner.h"
+#include "profiler.h"
 #include "runtime_internal.h"
+#include "scheduler.h"
+#include "thread_pool.h"
+
+#ifdef NNABLART_USE_PTHREAD
+#include <pthread.h>
+#endif
 
 void *(*rt_variable_malloc_func)(size_t size) = malloc;
 void (*rt_variable_free_func)(void *ptr) = free;
@@ -26,14 +35,75 @@ void (*rt_variable_free_func)(void *ptr) = free;
 void *(*rt_malloc_func)(size_t size) = malloc;
 void (*rt_free_func)(void *ptr) = free;
 
+// Allocator of functions of a context which uses a memory block or is
+// measuring, see rt_context_t::function_allocator. Data is carved from the
+// block, or counted while measuring, and frees of carved data are ignored.
+static void *function_malloc(void *user_data, size_t size) {
+  rt_context_t *c = user_data;
+  if (c->use_memory_block) {
+    return rt_context_malloc(c, size);
+  }
+  c->function_data_size += RT_MEMORY_ALIGN(size);
+  return rt_malloc_func(size);
+}
+
+static void function_free(void *user_data, void *ptr) {
+  rt_context_free(user_data, ptr);
+}
+
 rt_return_value_t rt_allocate_context(rt_context_pointer *context) {
   rt_context_t *c = rt_malloc_func(sizeof(rt_context_t));
-  memset(c, 0, sizeof(rt_context_t));
   if (c == 0) {
     return RT_RET_ERROR_ALLOCATE_CONTEXT;
   }
+  memset(c, 0, sizeof(rt_context_t));
   c->callbacks = 0;
   c->num_of_callbacks = 0;
+  c->parallel.num_of_threads = 1;
+  c->parallel.run_tasks = 0;
+  c->parallel.executor = 0;
+  c->thread_pool = 0;
+  c->num_of_stages = 0;
+  c->stage_offsets = 0;
+  c->stage_functions = 0;
+  c->stage_results = 0;
+  c->inter_op_parallel = 0;
+  c->serial.num_of_threads = 1;
+  c->serial.run_tasks = 0;
+  c->serial.executor = 0;
+  c->shared_cache = 0;
+  c->cpu_features = rt_detect_cpu_features();
+  c->optimization = RT_OPTIMIZATION_ALL;
+  c->num_of_derived_variables = 0;
+  c->derived_variables = 0;
+  c->derived_dims = 0;
+  c->aliases = 0;
+  c->alias_offsets = 0;
+  c->num_of_aliased = 0;
+  c->aliased_bytes = 0;
+  c->memory_plan = RT_MEMORY_PLAN_NETWORK;
+  c->arena = 0;
+  c->arena_size = 0;
+  c->use_memory_block = 0;
+  c->memory_block_owned = 0;
+  c->memory_block = 0;
+  c->memory_block_size = 0;
+  c->memory_block_used = 0;
+  c->measuring = 0;
+  c->function_data_size = 0;
+  c->function_allocator.malloc_func = function_malloc;
+  c->function_allocator.free_func = function_free;
+  c->function_allocator.user_data = c;
+  c->measured_network = 0;
+  c->measured_size = 0;
+  c->workspace = 0;
+  c->workspace_size = 0;
+  c->workspace_per_stage = 0;
+  c->pre_exec_hook = 0;
+  c->post_exec_hook = 0;
+  c->hook_user_data = 0;
+  c->profile = 0;
+  c->trace = 0;
   *context = c;
   return RT_RET_NOERROR;
 }
@@ -97,54 +167,621 @@ rt_return_value_t rt_add_callback(
       allocate_local_context;
 
   c->num_of_callbacks += 1;
+  c->measured_network = 0;
   return RT_RET_NOERROR;
 }
 
-rt_return_value_t rt_initialize_context(rt_context_pointer context,
-                                        nn_network_t *n) {
+static void free_thread_pool(rt_context_t *c) {
+  if (c->thread_pool) {
+    rt_thread_pool_destroy(c->thread_pool);
+    c->thread_pool = 0;
+  }
+  c->parallel.num_of_threads = 1;
+  c->parallel.run_tasks = 0;
+  c->parallel.executor = 0;
+}
+
+rt_return_value_t rt_set_num_threads(rt_context_pointer context,
+                                     int num_of_threads) {
+  rt_context_t *c = context;
+
+  free_thread_pool(c);
+  if (num_of_threads <= 1) {
+    return RT_RET_NOERROR;
+  }
+
+  // Calling thread works as one of the threads.
+  c->thread_pool = rt_thread_pool_create(num_of_threads - 1);
+  if (c->thread_pool == 0) {
+    return RT_RET_ERROR_CREATE_THREAD;
+  }
+  c->parallel.num_of_threads = num_of_threads;
+  c->parallel.run_tasks = rt_thread_pool_run_tasks;
+  c->parallel.executor = c->thread_pool;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_set_task_runner(rt_context_pointer context,
+                                     rt_task_runner_t runner, void *user_data,
+                                     int num_of_threads) {
+  rt_context_t *c = context;
+
+  free_thread_pool(c);
+  if (runner == 0 || num_of_threads <= 1) {
+    return RT_RET_NOERROR;
+  }
+  c->parallel.num_of_threads = num_of_threads;
+  c->parallel.run_tasks = runner;
+  c->parallel.executor = user_data;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_set_inter_op_parallel(rt_context_pointer context,
+                                           int enable) {
+  rt_context_t *c = context;
+  c->inter_op_parallel = enable;
+  c->measured_network = 0;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_set_memory_plan(rt_context_pointer context,
+                                     rt_memory_plan_t plan) {
+  rt_context_t *c = context;
+  c->memory_plan = plan;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_set_optimization(rt_context_pointer context, int flags) {
+  rt_context_t *c = context;
+  c->optimization = flags;
+  c->measured_network = 0;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_set_cpu_features(rt_context_pointer context,
+                                      int features) {
   rt_context_t *c = context;
+  c->cpu_features = features & rt_detect_cpu_features();
+  c->measured_network = 0;
+  return RT_RET_NOERROR;
+}
+
+int rt_cpu_features(rt_context_pointer context) {
+  return ((rt_context_t *)context)->cpu_features;
+}
+
+// Size of buffer index of network in bytes.
+static size_t buffer_size(nn_network_t *n, int index) {
+  int *list = (int *)NN_GET(n, n->buffers.list);
+  if (n->version == 2) {
+    return *(list + index) * sizeof(float);
+  }
+  return *(list + index);
+}
+
+int rt_num_of_aliased_functions(rt_context_pointer context) {
+  return ((rt_context_t *)context)->num_of_aliased;
+}
+
+size_t rt_aliased_bytes(rt_context_pointer context) {
+  return ((rt_context_t *)context)->aliased_bytes;
+}
+
+size_t rt_activation_memory_size(rt_context_pointer context) {
+  rt_context_t *c = context;
+  size_t size = 0;
+  int i;
+
+  if (c->memory_plan == RT_MEMORY_PLAN_LIVENESS) {
+    return c->arena_size;
+  }
+  for (i = 0; i < c->num_of_buffers; i++) {
+    if (c->buffers[i].allocate_type == RT_BUFFER_ALLOCATE_TYPE_MALLOC) {
+      size += buffer_size(c->network, i);
+    }
+  }
+  return size;
+}
+
+rt_return_value_t rt_use_memory_block(rt_context_pointer context,
+                                      int enable) {
+  rt_context_t *c = context;
+  c->use_memory_block = enable;
+  c->memory_block = 0;
+  c->memory_block_size = 0;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_set_memory_block(rt_context_pointer context, void *block,
+                                      size_t size) {
+  rt_context_t *c = context;
+  size_t padding = (RT_MEMORY_ALIGNMENT - (size_t)block % RT_MEMORY_ALIGNMENT) %
+                   RT_MEMORY_ALIGNMENT;
+  c->use_memory_block = 1;
+  c->memory_block = (uint8_t *)block + padding;
+  c->memory_block_size = size > padding ? size - padding : 0;
+  return RT_RET_NOERROR;
+}
+
+// Create the cache of derived data unless c shares one of another context.
+// Shared cache as allocated by the runtime. Contexts sharing it may be
+// initialized, cloned and freed on different threads, so its reference count
+// and blob list are only touched with the mutex locked.
+typedef struct {
+  rt_shared_cache_t cache;
+#ifdef NNABLART_USE_PTHREAD
+  pthread_mutex_t mutex;
+#endif
+} runtime_shared_cache_t;
+
+static void lock_shared_cache(rt_shared_cache_t *cache) {
+#ifdef NNABLART_USE_PTHREAD
+  pthread_mutex_lock(&((runtime_shared_cache_t *)cache)->mutex);
+#endif
+}
+
+static void unlock_shared_cache(rt_shared_cache_t *cache) {
+#ifdef NNABLART_USE_PTHREAD
+  pthread_mutex_unlock(&((runtime_shared_cache_t *)cache)->mutex);
+#endif
+}
+
+static rt_return_value_t prepare_shared_cache(rt_context_t *c) {
+  if (c->shared_cache != 0) {
+    return RT_RET_NOERROR;
+  }
+  runtime_shared_cache_t *cache =
+      rt_malloc_func(sizeof(runtime_shared_cache_t));
+  if (cache == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+#ifdef NNABLART_USE_PTHREAD
+  if (pthread_mutex_init(&cache->mutex, 0) != 0) {
+    rt_free_func(cache);
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+#endif
+  c->shared_cache = &cache->cache;
+  c->shared_cache->ref_count = 1;
+  c->shared_cache->blobs = 0;
+  c->shared_cache->malloc_func = rt_malloc_func;
+  c->shared_cache->free_func = rt_free_func;
+  return RT_RET_NOERROR;
+}
+
+// Give c the settings of s and share its cache.
+static rt_return_value_t copy_settings(rt_context_t *c, const rt_context_t *s) {
+  int i;
+
+  for (i = 0; i < s->num_of_callbacks; i++) {
+    rt_return_value_t ret = rt_add_callback(
+        c, s->callbacks[i].type, s->callbacks[i].allocate_local_context);
+    if (ret != RT_RET_NOERROR) {
+      return ret;
+    }
+  }
+  c->inter_op_parallel = s->inter_op_parallel;
+  c->memory_plan = s->memory_plan;
+  c->optimization = s->optimization;
+  c->cpu_features = s->cpu_features;
+  c->use_memory_block = s->use_memory_block;
+  c->measured_network = s->measured_network;
+  c->measured_size = s->measured_size;
+  c->pre_exec_hook = s->pre_exec_hook;
+  c->post_exec_hook = s->post_exec_hook;
+  c->hook_user_data = s->hook_user_data;
+
+  c->shared_cache = s->shared_cache;
+  if (c->shared_cache) {
+    lock_shared_cache(c->shared_cache);
+    c->shared_cache->ref_count++;
+    unlock_shared_cache(c->shared_cache);
+  }
+  return RT_RET_NOERROR;
+}
+
+// Bytes functions of network allocate, their local contexts and workspace
+// included, measured by initializing a context with the settings of c once.
+// Data derived from weights on the way stays in the cache shared with c, so
+// that it is not computed again. The result is kept in c and its clones
+// until a setting it depends on changes.
+static rt_return_value_t measure_function_data(rt_context_t *c,
+                                               nn_network_t *n,
+                                               size_t *size) {
+  rt_context_pointer context;
+  rt_context_t *m;
+
+  if (c->measured_network == n) {
+    *size = c->measured_size;
+    return RT_RET_NOERROR;
+  }
+  rt_return_value_t ret = prepare_shared_cache(c);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+  ret = rt_allocate_context(&context);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+  m = context;
+  ret = copy_settings(m, c);
+  m->use_memory_block = 0;
+  m->measuring = 1;
+  if (ret == RT_RET_NOERROR) {
+    ret = rt_initialize_context(m, n);
+  }
+  *size = m->function_data_size + RT_MEMORY_ALIGN(m->workspace_size);
+  rt_free_context(&context);
+  if (ret == RT_RET_NOERROR) {
+    c->measured_network = n;
+    c->measured_size = *size;
+  }
+  return ret;
+}
+
+size_t rt_memory_block_size(rt_context_pointer context, nn_network_t *n) {
+  rt_context_t *c = context;
+  int num_of_functions = n->functions.size;
+  rt_graph_t g;
+  int i;
+
+  if (rt_build_graph(c, n, &g) != RT_RET_NOERROR) {
+    return 0;
+  }
+
+  // Alignment of the start of block
+  size_t size = RT_MEMORY_ALIGNMENT - 1;
+
+  // Same allocations as rt_initialize_context()
+  size += RT_MEMORY_ALIGN(sizeof(rt_variable_buffer_context_t) *
+                          n->buffers.size);
+  size += RT_MEMORY_ALIGN(sizeof(int *) * n->inputs.size);
+  size += RT_MEMORY_ALIGN(sizeof(int *) * n->outputs.size);
+  if (c->memory_plan == RT_MEMORY_PLAN_LIVENESS) {
+    size_t arena_size;
+    if (rt_plan_memory(n, &g, 0, &arena_size) != RT_RET_NOERROR) {
+      rt_free_graph(&g);
+      return 0;
+    }
+    size += RT_MEMORY_ALIGN(arena_size);
+  } else {
+    for (i = 0; i < n->buffers.size; i++) {
+      size += RT_MEMORY_ALIGN(buffer_size(n, i));
+    }
+  }
+  size += RT_MEMORY_ALIGN(sizeof(rt_variable_t) * n->variables.size);
+  if (g.num_of_derived > 0) {
+    size += RT_MEMORY_ALIGN(sizeof(rt_variable_t) * g.num_of_derived);
+    size += RT_MEMORY_ALIGN(sizeof(int) * g.num_of_derived);
+  }
+  if (g.num_of_views > 0) {
+    size += 2 * RT_MEMORY_ALIGN(sizeof(int) * n->variables.size);
+  }
+  size += RT_MEMORY_ALIGN(sizeof(rt_function_context_t) * num_of_functions);
+  for (i = 0; i < num_of_functions; i++) {
+    rt_graph_function_t *f = g.functions + i;
+    size += RT_MEMORY_ALIGN(sizeof(rt_variable_t *) * f->num_of_inputs);
+    size += RT_MEMORY_ALIGN(sizeof(rt_variable_t *) * f->num_of_outputs);
+  }
+  size += 2 * RT_MEMORY_ALIGN(sizeof(int) * (num_of_functions + 1));
+  size += RT_MEMORY_ALIGN(sizeof(rt_function_error_t) * (num_of_functions + 1));
+  rt_free_graph(&g);
+
+  // Local contexts and data of functions
+  size_t function_data_size;
+  if (measure_function_data(c, n, &function_data_size) != RT_RET_NOERROR) {
+    return 0;
+  }
+  return size + function_data_size;
+}
+
+// Allocate memory block of context if it is used.
+static rt_return_value_t prepare_memory_block(rt_context_t *c,
+                                              nn_network_t *n) {
+  if (!c->use_memory_block) {
+    return RT_RET_NOERROR;
+  }
+  size_t size = rt_memory_block_size(c, n);
+  if (size == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  if (c->memory_block == 0) {
+    c->memory_block_owned = rt_variable_malloc_func(size);
+    if (c->memory_block_owned == 0) {
+      return RT_RET_ERROR_ALLOCATE_CONTEXT;
+    }
+    rt_set_memory_block(c, c->memory_block_owned, size);
+  } else if (c->memory_block_size < size - (RT_MEMORY_ALIGNMENT - 1)) {
+    return RT_RET_ERROR_INSUFFICIENT_MEMORY_BLOCK;
+  }
+  c->memory_block_used = 0;
+  return RT_RET_NOERROR;
+}
+
+// Zero cleared memory for activations.
+static void *allocate_activation(rt_context_t *c, size_t size) {
+  void *p = c->use_memory_block ? rt_context_malloc(c, size)
+                                : rt_variable_malloc_func(size);
+  if (p) {
+    memset(p, 0, size);
+  }
+  return p;
+}
+
+// Place variables stored in buffers with rt_plan_memory().
+static rt_return_value_t allocate_arena(rt_context_t *c, nn_network_t *n,
+                                        const rt_graph_t *g) {
+  size_t *offsets = rt_malloc_func(sizeof(size_t) * (c->num_of_variables + 1));
+  uint8_t *arena;
+  int i;
+
+  if (offsets == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  rt_return_value_t ret = rt_plan_memory(n, g, offsets, &c->arena_size);
+  if (ret != RT_RET_NOERROR) {
+    rt_free_func(offsets);
+    return ret;
+  }
+
+  if (c->use_memory_block) {
+    c->arena = allocate_activation(c, c->arena_size);
+    arena = c->arena;
+  } else {
+    // Keep the start aligned as well as offsets.
+    c->arena = allocate_activation(c, c->arena_size + RT_MEMORY_ALIGNMENT - 1);
+    arena = (uint8_t *)c->arena +
+            (RT_MEMORY_ALIGNMENT - (size_t)c->arena % RT_MEMORY_ALIGNMENT) %
+                RT_MEMORY_ALIGNMENT;
+  }
+  if (c->arena == 0) {
+    rt_free_func(offsets);
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+
+  int *list = (int *)NN_GET(n, n->variables.list);
+  for (i = 0; i < c->num_of_variables; i++) {
+    nn_variable_t *var = (nn_variable_t *)(NN_GET(n, *(list + i)));
+    if (var->data_index < 0 && g->aliases[i] < 0) {
+      c->variables[i].data = arena + offsets[i];
+    }
+  }
+  rt_free_func(offsets);
+  return RT_RET_NOERROR;
+}
+
+// Point views to data of the variable they are a view of. Views replace
+// copies made by functions elided by rt_build_graph().
+static rt_return_value_t share_aliased_data(rt_context_t *c,
+                                            const rt_graph_t *g) {
+  int i;
+
+  c->num_of_aliased = g->num_of_views;
+  c->aliased_bytes = 0;
+  for (i = 0; i < c->num_of_variables; i++) {
+    if (g->aliases[i] >= 0) {
+      c->variables[i].data = (uint8_t *)c->variables[g->aliases[i]].data +
+                             g->alias_offsets[i];
+      c->aliased_bytes += rt_variable_size(c->variables + i);
+    }
+  }
+  if (c->num_of_aliased == 0) {
+    return RT_RET_NOERROR;
+  }
+  // Kept for rt_bind_input() and rt_bind_output().
+  c->aliases = rt_context_malloc(c, sizeof(int) * c->num_of_variables);
+  c->alias_offsets = rt_context_malloc(c, sizeof(int) * c->num_of_variables);
+  if (c->aliases == 0 || c->alias_offsets == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  memcpy(c->aliases, g->aliases, sizeof(int) * c->num_of_variables);
+  memcpy(c->alias_offsets, g->alias_offsets,
+         sizeof(int) * c->num_of_variables);
+  return RT_RET_NOERROR;
+}
+
+static void release_shared_cache(rt_context_t *c) {
+  rt_shared_cache_t *cache = c->shared_cache;
+  if (cache == 0) {
+    return;
+  }
+  c->shared_cache = 0;
+  lock_shared_cache(cache);
+  int ref_count = --cache->ref_count;
+  unlock_shared_cache(cache);
+  if (ref_count > 0) {
+    return;
+  }
+#ifdef NNABLART_USE_PTHREAD
+  pthread_mutex_destroy(&((runtime_shared_cache_t *)cache)->mutex);
+#endif
+  while (cache->blobs) {
+    rt_shared_blob_t *blob = cache->blobs;
+    cache->blobs = blob->next;
+    cache->free_func(blob->data);
+    cache->free_func(blob);
+  }
+  cache->free_func(cache);
+}
+
+rt_return_value_t rt_clone_context(rt_context_pointer src,
+                                   rt_context_pointer *context) {
+  rt_context_t *s = src;
+
+  *context = 0;
+  rt_return_value_t ret = rt_allocate_context(context);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+  ret = copy_settings(*context, s);
+  if (ret == RT_RET_NOERROR) {
+    ret = rt_initialize_context(*context, s->network);
+  }
+  if (ret != RT_RET_NOERROR) {
+    // Also gives back the reference to the shared cache.
+    rt_free_context(context);
+    *context = 0;
+  }
+  return ret;
+}
+
+// Share one workspace between the functions of c. Functions of a stage run
+// concurrently with rt_set_inter_op_parallel(), so they get parts of their
+// own, and the workspace is as large as the largest stage needs.
+static rt_return_value_t allocate_workspace(rt_context_t *c) {
+  size_t size = 0;
+  int s, i;
+
+  c->workspace_per_stage = c->inter_op_parallel;
+  for (s = 0; s < c->num_of_stages; s++) {
+    size_t offset = 0;
+    for (i = c->stage_offsets[s]; i < c->stage_offsets[s + 1]; i++) {
+      rt_function_t *f = &(c->functions[c->stage_functions[i]].func);
+      // Offset of the part of f until the workspace is allocated.
+      f->workspace = (void *)offset;
+      if (c->workspace_per_stage) {
+        offset += RT_MEMORY_ALIGN(f->workspace_size);
+      }
+      if (size < (size_t)f->workspace + f->workspace_size) {
+        size = (size_t)f->workspace + f->workspace_size;
+      }
+    }
+  }
+  if (size == 0 || c->measuring) {
+    c->workspace_size = size;
+    return RT_RET_NOERROR;
+  }
+
+  uint8_t *workspace;
+  if (c->use_memory_block) {
+    c->workspace = rt_context_malloc(c, size);
+    workspace = c->workspace;
+  } else {
+    c->workspace = rt_variable_malloc_func(size + RT_MEMORY_ALIGNMENT - 1);
+    workspace =
+        (uint8_t *)c->workspace +
+        (RT_MEMORY_ALIGNMENT - (size_t)c->workspace % RT_MEMORY_ALIGNMENT) %
+            RT_MEMORY_ALIGNMENT;
+  }
+  if (c->workspace == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  c->workspace_size = size;
+  for (i = 0; i < c->num_of_functions; i++) {
+    rt_function_t *f = &(c->functions[i].func);
+    f->workspace = workspace + (size_t)f->workspace;
+  }
+  return RT_RET_NOERROR;
+}
+
+// Allocate the local contexts of the functions of n.
+static rt_return_value_t allocate_functions(rt_context_t *c, nn_network_t *n,
+                                            rt_graph_t *g) {
+  rt_return_value_t ret;
   int i, j; // Iterator
 
-  //////////////////////////////////////////////////////////////////////////////
-  // Binary format version check
-  if (n->version < NN_BINARY_FORMAT_MINIMUM_VERSION ||
-      n->version > NN_BINARY_FORMAT_VERSION) {
-    return RT_RET_ERROR_VERSION_UNMATCH;
+  c->functions =
+      rt_context_malloc(c, sizeof(rt_function_context_t) * n->functions.size);
+  if (c->functions == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
   }
+  int *list = (int *)NN_GET(n, n->functions.list);
+  for (i = 0; i < n->functions.size; i++) {
+    nn_function_t *func = (nn_function_t *)(NN_GET(n, *(list + i)));
+    c->functions[i] = allocate_function_io(c, func, g->functions + i);
+    // Counted from here on, so that rt_free_context() frees it on error.
+    c->functions[i].func.local_context = 0;
+    c->functions[i].func.free_local_context_func = rt_exec_elided;
+    c->num_of_functions = i + 1;
+    if (g->functions[i].elided) {
+      c->functions[i].func.exec_func = rt_exec_elided;
+      continue;
+    }
+    ret = rt_compute_derived(c, n, g, i);
+    if (ret != RT_RET_NOERROR) {
+      return ret;
+    }
+
+    int callback_registered_flag = 0;
+    if (func->impl <= NN_END_OF_USER_DEFINED_FUNCTION_IMPLEMENT) {
+      for (j = 0; j < c->num_of_callbacks; j++) {
+        if ((c->callbacks + j)->type == func->type) {
+          rt_return_value_t ret =
+              (c->callbacks +
+               j)->allocate_local_context(n, (void *)(&(c->functions[i])));
+          if (ret == RT_RET_FUNCTION_MATCH) {
+            callback_registered_flag = 1;
+            c->functions[i].user_defined = 1;
+            break;
+          }
+        }
+      }
+    }
+    if (!callback_registered_flag) {
+      allocate_function_context(c, n, func, c->functions + i);
+    }
+  }
+  return RT_RET_NOERROR;
+}
+
+static rt_return_value_t initialize_context(rt_context_t *c, nn_network_t *n,
+                                            rt_graph_t *g) {
+  int i; // Iterator
 
   //////////////////////////////////////////////////////////////////////////////
   // API level check
-  if (n->api_level > NN_API_LEVEL_MAX) {
-    n->api_level = 1;
+  // The network may be shared by several contexts, so it is never modified.
+  uint32_t api_level = n->api_level;
+  if (api_level > NN_API_LEVEL_MAX) {
+    api_level = 1;
     printf("WARNING:\n"
            "The NNabla version is too low to find a suitable api level. \n"
            "Unexpected errors might occur.\n"
            "Please upgrade NNabla to latest version.\n");
   }
 
-  if (n->api_level > NN_API_LEVEL) {
-    printf("n->api_level: %d\n", n->api_level);
+  if (api_level > NN_API_LEVEL) {
+    printf("n->api_level: %d\n", api_level);
     return RT_RET_ERROR_VERSION_UNMATCH;
   }
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Shared cache
+  rt_return_value_t ret = prepare_shared_cache(c);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Memory block
+  ret = prepare_memory_block(c, n);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+
   //////////////////////////////////////////////////////////////////////////////
   // Buffer list
   c->num_of_buffers = n->buffers.size;
-  c->buffers =
-      rt_malloc_func(sizeof(rt_variable_buffer_context_t) * c->num_of_buffers);
+  c->buffers = rt_context_malloc(c, sizeof(rt_variable_buffer_context_t) *
+                                         c->num_of_buffers);
 
   if (c->buffers == 0) {
     return RT_RET_ERROR_ALLOCATE_CONTEXT;
   }
   for (i = 0; i < c->num_of_buffers; i++) {
     c->buffers[i].allocate_type = RT_BUFFER_ALLOCATE_TYPE_INITIAL;
+    c->buffers[i].buffer = 0;
   }
 
   //////////////////////////////////////////////////////////////////////////////
   // Inputs
   rt_list_t inputs = create_rt_list_from_nn_list(n, n->inputs);
   c->num_of_inputs = inputs.size;
-  c->input_variable_ids = rt_malloc_func(sizeof(int *) * c->num_of_inputs);
+  c->input_variable_ids =
+      rt_context_malloc(c, sizeof(int *) * c->num_of_inputs);
+  if (c->input_variable_ids == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
   for (i = 0; i < c->num_of_inputs; i++) {
     c->input_variable_ids[i] = inputs.data[i];
   }
@@ -153,25 +790,24 @@ rt_return_value_t rt_initialize_context(rt_context_pointer context,
   // Outputs
   rt_list_t outputs = create_rt_list_from_nn_list(n, n->outputs);
   c->num_of_outputs = outputs.size;
-  c->output_variable_ids = rt_malloc_func(sizeof(int *) * c->num_of_outputs);
+  c->output_variable_ids =
+      rt_context_malloc(c, sizeof(int *) * c->num_of_outputs);
+  if (c->output_variable_ids == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
   for (i = 0; i < c->num_of_outputs; i++) {
     c->output_variable_ids[i] = outputs.data[i];
   }
 
   //////////////////////////////////////////////////////////////////////////////
   // Allocate buffers
-  int *list = (int *)NN_GET(n, n->buffers.list);
+  // With RT_MEMORY_PLAN_LIVENESS variables are placed by rt_plan_memory()
+  // instead.
   for (i = 0; i < c->num_of_buffers; i++) {
-    if (c->buffers[i].allocate_type == RT_BUFFER_ALLOCATE_TYPE_INITIAL) {
+    if (c->memory_plan == RT_MEMORY_PLAN_NETWORK &&
+        c->buffers[i].allocate_type == RT_BUFFER_ALLOCATE_TYPE_INITIAL) {
       c->buffers[i].allocate_type = RT_BUFFER_ALLOCATE_TYPE_MALLOC;
-      if (n->version == 2) {
-        c->buffers[i].buffer =
-            rt_variable_malloc_func(*(list + i) * sizeof(float));
-        memset(c->buffers[i].buffer, 0, *(list + i) * sizeof(float));
-      } else {
-        c->buffers[i].buffer = rt_variable_malloc_func(*(list + i));
-        memset(c->buffers[i].buffer, 0, *(list + i));
-      }
+      c->buffers[i].buffer = allocate_activation(c, buffer_size(n, i));
       if (c->buffers[i].buffer == 0) {
         return RT_RET_ERROR_ALLOCATE_CONTEXT;
       }
@@ -181,12 +817,13 @@ rt_return_value_t rt_initialize_context(rt_context_pointer context,
   //////////////////////////////////////////////////////////////////////////////
   // Variables
   c->num_of_variables = n->variables.size;
-  c->variables = rt_malloc_func(sizeof(rt_variable_t) * c->num_of_variables);
+  c->variables =
+      rt_context_malloc(c, sizeof(rt_variable_t) * c->num_of_variables);
   if (c->variables == 0) {
     return RT_RET_ERROR_ALLOCATE_CONTEXT;
   }
 
-  list = (int *)NN_GET(n, n->variables.list);
+  int *list = (int *)NN_GET(n, n->variables.list);
   for (i = 0; i < c->num_of_variables; i++) {
     nn_variable_t *var = (nn_variable_t *)(NN_GET(n, *(list + i)));
     c->variables[i].shape = create_rt_list_from_nn_list(n, var->shape);
@@ -210,38 +847,70 @@ rt_return_value_t rt_initialize_context(rt_context_pointer context,
     }
   }
 
+  if (c->memory_plan == RT_MEMORY_PLAN_LIVENESS) {
+    ret = allocate_arena(c, n, g);
+    if (ret != RT_RET_NOERROR) {
+      return ret;
+    }
+  }
+
+  ret = share_aliased_data(c, g);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+
+  ret = rt_allocate_derived(c, n, g);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+
   //////////////////////////////////////////////////////////////////////////////
   // Functions
-  c->num_of_functions = n->functions.size;
-  c->functions =
-      rt_malloc_func(sizeof(rt_function_context_t) * c->num_of_functions);
-  list = (int *)NN_GET(n, n->functions.list);
-  for (i = 0; i < c->num_of_functions; i++) {
-    nn_function_t *func = (nn_function_t *)(NN_GET(n, *(list + i)));
-    c->functions[i] = allocate_function_io(n, c, func);
-
-    int callback_registered_flag = 0;
-    if (func->impl <= NN_END_OF_USER_DEFINED_FUNCTION_IMPLEMENT) {
-      for (j = 0; j < c->num_of_callbacks; j++) {
-        if ((c->callbacks + j)->type == func->type) {
-          rt_return_value_t ret =
-              (c->callbacks +
-               j)->allocate_local_context(n, (void *)(&(c->functions[i])));
-          if (ret == RT_RET_FUNCTION_MATCH) {
-            callback_registered_flag = 1;
-            break;
-          }
-        }
-      }
-    }
-    if (!callback_registered_flag) {
-      allocate_function_context(n, func, c->functions + i);
-    }
+  // Derived data and blobs of functions are looked up and created in the
+  // shared cache.
+  lock_shared_cache(c->shared_cache);
+  ret = allocate_functions(c, n, g);
+  unlock_shared_cache(c->shared_cache);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
   }
 
   c->network = n;
 
-  return RT_RET_NOERROR;
+  //////////////////////////////////////////////////////////////////////////////
+  // Schedule
+  ret = rt_build_schedule(c);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Workspace
+  return allocate_workspace(c);
+}
+
+rt_return_value_t rt_initialize_context(rt_context_pointer context,
+                                        nn_network_t *n) {
+  rt_context_t *c = context;
+  rt_graph_t g;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Binary format version check
+  if (n->version < NN_BINARY_FORMAT_MINIMUM_VERSION ||
+      n->version > NN_BINARY_FORMAT_VERSION) {
+    return RT_RET_ERROR_VERSION_UNMATCH;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Graph
+  // Optimizations only change what functions of context refer to.
+  rt_return_value_t ret = rt_build_graph(c, n, &g);
+  if (ret != RT_RET_NOERROR) {
+    return ret;
+  }
+  ret = initialize_context(c, n, &g);
+  rt_free_graph(&g);
+  return ret;
 }
 
 rt_return_value_t rt_free_context(rt_context_pointer *context) {
@@ -250,37 +919,69 @@ rt_return_value_t rt_free_context(rt_context_pointer *context) {
   int i; // Iterator
 
   // Buffers
-  for (i = 0; i < c->num_of_buffers; i++) {
-    if (c->buffers[i].allocate_type == RT_BUFFER_ALLOCATE_TYPE_MALLOC) {
+  for (i = 0; c->buffers && i < c->num_of_buffers; i++) {
+    if (c->buffers[i].allocate_type == RT_BUFFER_ALLOCATE_TYPE_MALLOC &&
+        !rt_context_in_memory_block(c, c->buffers[i].buffer)) {
       rt_variable_free_func(c->buffers[i].buffer);
     }
   }
-  rt_free_func(c->buffers);
+  rt_context_free(c, c->buffers);
+  if (c->arena && !rt_context_in_memory_block(c, c->arena)) {
+    rt_variable_free_func(c->arena);
+  }
 
   // Variables
-  rt_free_func(c->variables);
+  rt_context_free(c, c->variables);
+  if (c->derived_variables) {
+    // Data belongs to the shared cache.
+    rt_context_free(c, c->derived_variables);
+    rt_context_free(c, c->derived_dims);
+  }
+  if (c->aliases) {
+    rt_context_free(c, c->aliases);
+  }
+  if (c->alias_offsets) {
+    rt_context_free(c, c->alias_offsets);
+  }
 
   // Functions
   for (i = 0; i < c->num_of_functions; i++) {
-    rt_free_func(c->functions[i].func.inputs);
-    rt_free_func(c->functions[i].func.outputs);
+    rt_context_free(c, c->functions[i].func.inputs);
+    rt_context_free(c, c->functions[i].func.outputs);
 
     c->functions[i].func.free_local_context_func(&(c->functions[i].func));
     if (c->functions[i].func.local_context != 0) {
-      rt_free_func(c->functions[i].func.local_context);
+      rt_function_free(&(c->functions[i].func),
+                       c->functions[i].func.local_context);
       c->functions[i].func.local_context = NULL;
     }
   }
-  rt_free_func(c->functions);
+  rt_context_free(c, c->functions);
 
-  rt_free_func(c->input_variable_ids);
-  rt_free_func(c->output_variable_ids);
+  rt_context_free(c, c->input_variable_ids);
+  rt_context_free(c, c->output_variable_ids);
 
   // Callback
   if (c->callbacks) {
     rt_free_func(c->callbacks);
   }
 
+  if (c->workspace && !rt_context_in_memory_block(c, c->workspace)) {
+    rt_variable_free_func(c->workspace);
+  }
+
+  rt_free_schedule(c);
+  free_thread_pool(c);
+  release_shared_cache(c);
+  if (c->profile) {
+    rt_free_func(c->profile);
+  }
+  rt_enable_trace(c, 0);
+
+  if (c->memory_block_owned) {
+    rt_variable_free_func(c->memory_block_owned);
+  }
+
   rt_free_func(*context);
   return RT_RET_NOERROR;
 }
@@ -369,30 +1070,276 @@ nn_variable_t *rt_output_variable(rt_context_pointer context, size_t index) {
   return (nn_variable_t *)(NN_GET(n, *(list + i)));
 }
 
-rt_return_value_t rt_forward(rt_context_pointer context) {
-  int i; // Iterator
-  rt_function_error_t ret;
+// Make variable index use memory of user.
+// A buffer of the network holding only this variable is handed over to the
+// user as RT_BUFFER_ALLOCATE_TYPE_ALLOCATED, and its memory is released.
+static rt_return_value_t bind_variable(rt_context_t *c, int index, void *ptr) {
+  nn_network_t *n = c->network;
+  int *list = (int *)NN_GET(n, n->variables.list);
+  nn_variable_t *var = (nn_variable_t *)(NN_GET(n, *(list + index)));
+  int i;
+
+  if (ptr == 0) {
+    return RT_RET_ERROR_INIT_VARIABLE;
+  }
+  if (var->data_index < 0 && c->memory_plan == RT_MEMORY_PLAN_NETWORK) {
+    int b = (-1 * var->data_index) - 1;
+    int shared = 0;
+    for (i = 0; i < c->num_of_variables; i++) {
+      nn_variable_t *other = (nn_variable_t *)(NN_GET(n, *(list + i)));
+      if (i != index && other->data_index == var->data_index) {
+        shared = 1;
+        break;
+      }
+    }
+    if (!shared) {
+      if (c->buffers[b].allocate_type == RT_BUFFER_ALLOCATE_TYPE_MALLOC &&
+          !rt_context_in_memory_block(c, c->buffers[b].buffer)) {
+        rt_variable_free_func(c->buffers[b].buffer);
+      }
+      c->buffers[b].allocate_type = RT_BUFFER_ALLOCATE_TYPE_ALLOCATED;
+      c->buffers[b].buffer = ptr;
+    }
+  }
+
+  // Functions access data through c->variables, so nothing else refers to
+  // the previous memory but variables sharing it.
+  c->variables[index].data = ptr;
+  for (i = 0; c->aliases && i < c->num_of_variables; i++) {
+    if (c->aliases[i] == index) {
+      c->variables[i].data = (uint8_t *)ptr + c->alias_offsets[i];
+    }
+  }
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_bind_input(rt_context_pointer context, size_t index,
+                                void *ptr) {
+  rt_context_t *c = context;
+  if (index >= (size_t)c->num_of_inputs) {
+    return RT_RET_ERROR_INVALID_BUFFER_INDEX;
+  }
+  return bind_variable(c, c->input_variable_ids[index], ptr);
+}
+
+rt_return_value_t rt_bind_output(rt_context_pointer context, size_t index,
+                                 void *ptr) {
   rt_context_t *c = context;
+  if (index >= (size_t)c->num_of_outputs) {
+    return RT_RET_ERROR_INVALID_BUFFER_INDEX;
+  }
+  return bind_variable(c, c->output_variable_ids[index], ptr);
+}
+
+static rt_return_value_t check_function_result(rt_context_t *c, int i,
+                                               rt_function_error_t ret) {
+  if (ret != RT_FUNCTION_ERROR_NOERROR) {
+    switch (ret) {
+    case RT_FUNCTION_ERROR_UNIMPLEMENTED:
+      printf("Error: %d, Function (ID: %d) is not implemented in "
+             "nnabla-c-runtime!\n",
+             ret, c->functions[i].info->type);
+      return -1;
+    default:
+      printf("Failed to run exec_func, Error: %d.\n", ret);
+      return -1;
+    }
+  }
+  return RT_RET_NOERROR;
+}
 
+rt_return_value_t rt_set_function_hooks(rt_context_pointer context,
+                                        rt_function_hook_t pre_exec,
+                                        rt_function_hook_t post_exec,
+                                        void *user_data) {
+  rt_context_t *c = context;
+  c->pre_exec_hook = pre_exec;
+  c->post_exec_hook = post_exec;
+  c->hook_user_data = user_data;
+  return RT_RET_NOERROR;
+}
+
+rt_return_value_t rt_enable_profile(rt_context_pointer context, int enable) {
+  rt_context_t *c = context;
+  int i, j;
+
+  if (c->profile) {
+    rt_free_func(c->profile);
+    c->profile = 0;
+  }
+  if (!enable) {
+    return RT_RET_NOERROR;
+  }
+
+  c->profile =
+      rt_malloc_func(sizeof(rt_function_profile_t) * c->num_of_functions);
+  if (c->profile == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
   for (i = 0; i < c->num_of_functions; i++) {
-    ret = c->functions[i].func.exec_func(&(c->functions[i].func));
-    if (ret != RT_FUNCTION_ERROR_NOERROR) {
-      switch (ret) {
-      case RT_FUNCTION_ERROR_UNIMPLEMENTED:
-        printf("Error: %d, Function (ID: %d) is not implemented in "
-               "nnabla-c-runtime!\n",
-               ret, c->functions[i].info->type);
-        return -1;
-      default:
-        printf("Failed to run exec_func, Error: %d.\n", ret);
-        return -1;
+    rt_function_profile_t *p = c->profile + i;
+    rt_function_t *f = &(c->functions[i].func);
+    p->type = c->functions[i].info->type;
+    p->output_bytes = 0;
+    for (j = 0; j < f->num_of_outputs; j++) {
+      if (f->outputs[j]) {
+        p->output_bytes += rt_variable_size(f->outputs[j]);
+      }
+    }
+    p->flops = rt_estimate_flops(c->functions + i);
+  }
+  return rt_reset_profile(c);
+}
+
+rt_return_value_t rt_reset_profile(rt_context_pointer context) {
+  rt_context_t *c = context;
+  int i;
+  if (c->profile) {
+    for (i = 0; i < c->num_of_functions; i++) {
+      c->profile[i].num_of_calls = 0;
+      c->profile[i].time = 0;
+    }
+  }
+  return RT_RET_NOERROR;
+}
+
+int rt_num_of_functions(rt_context_pointer context) {
+  return ((rt_context_t *)context)->num_of_functions;
+}
+
+const char *rt_function_variant(rt_context_pointer context, size_t index) {
+  rt_context_t *c = context;
+  if (index >= (size_t)c->num_of_functions) {
+    return 0;
+  }
+  return c->functions[index].func.variant;
+}
+
+const rt_function_profile_t *rt_function_profile(rt_context_pointer context,
+                                                 size_t index) {
+  rt_context_t *c = context;
+  if (c->profile == 0 || index >= (size_t)c->num_of_functions) {
+    return 0;
+  }
+  return c->profile + index;
+}
+
+// Execute function index with instrumentation.
+static rt_function_error_t exec_function(rt_context_t *c, int i) {
+  rt_function_t *f = &(c->functions[i].func);
+  rt_trace_span_t *span = c->trace ? c->trace->current : 0;
+  rt_function_error_t ret;
+
+  if (c->pre_exec_hook == 0 && c->post_exec_hook == 0 && c->profile == 0 &&
+      span == 0) {
+    return f->exec_func(f);
+  }
+
+  if (c->pre_exec_hook) {
+    c->pre_exec_hook(c, i, c->functions[i].info, c->hook_user_data);
+  }
+  if (c->profile || span) {
+    // Each function runs on one thread at a time, so its record and span
+    // are not shared.
+    double begin = rt_profiler_time();
+    ret = f->exec_func(f);
+    double end = rt_profiler_time();
+    if (c->profile) {
+      c->profile[i].time += end - begin;
+      c->profile[i].num_of_calls++;
+    }
+    if (span) {
+      span[i].thread = rt_profiler_thread();
+      span[i].begin = begin;
+      span[i].end = end;
+    }
+  } else {
+    ret = f->exec_func(f);
+  }
+  if (c->post_exec_hook) {
+    c->post_exec_hook(c, i, c->functions[i].info, c->hook_user_data);
+  }
+  return ret;
+}
+
+static void exec_stage_function(void *arg, int index) {
+  rt_context_t *c = arg;
+  int i = c->stage_functions[c->stage_offsets[c->current_stage] + index];
+  c->stage_results[index] = exec_function(c, i);
+}
+
+static rt_return_value_t forward_stages(rt_context_t *c) {
+  int s, i;
+  rt_return_value_t ret;
+
+  for (s = 0; s < c->num_of_stages; s++) {
+    int begin = c->stage_offsets[s];
+    int size = c->stage_offsets[s + 1] - begin;
+
+    if (size == 1) {
+      // Single function uses all threads by itself.
+      int f = c->stage_functions[begin];
+      ret = check_function_result(c, f, exec_function(c, f));
+      if (ret != RT_RET_NOERROR) {
+        return ret;
+      }
+      continue;
+    }
+
+    // Functions running concurrently must not share the workers.
+    for (i = 0; i < size; i++) {
+      c->functions[c->stage_functions[begin + i]].func.parallel = &c->serial;
+    }
+    c->current_stage = s;
+    c->parallel.run_tasks(c->parallel.executor, size, exec_stage_function, c);
+    for (i = 0; i < size; i++) {
+      c->functions[c->stage_functions[begin + i]].func.parallel = &c->parallel;
+    }
+
+    for (i = 0; i < size; i++) {
+      ret = check_function_result(c, c->stage_functions[begin + i],
+                                  c->stage_results[i]);
+      if (ret != RT_RET_NOERROR) {
+        return ret;
       }
     }
   }
+  return RT_RET_NOERROR;
+}
+
+static rt_return_value_t forward_functions(rt_context_t *c) {
+  int i; // Iterator
+  rt_return_value_t ret;
+
+  if (c->inter_op_parallel && c->workspace_per_stage &&
+      c->parallel.run_tasks && c->parallel.num_of_threads > 1 &&
+      c->num_of_stages < c->num_of_functions) {
+    return forward_stages(c);
+  }
+
+  for (i = 0; i < c->num_of_functions; i++) {
+    ret = check_function_result(c, i, exec_function(c, i));
+    if (ret != RT_RET_NOERROR) {
+      return ret;
+    }
+  }
 
   return RT_RET_NOERROR;
 }
 
+rt_return_value_t rt_forward(rt_context_pointer context) {
+  rt_return_value_t ret;
+  rt_context_t *c = context;
+
+  if (c->trace == 0) {
+    return forward_functions(c);
+  }
+  rt_trace_begin_forward(c->trace, c->num_of_functions);
+  ret = forward_functions(c);
+  rt_trace_end_forward(c->trace, c->num_of_functions);
+  return ret;
+}
+
 const char *const rt_nnabla_version(void) { return NN_NNABLA_VERSION; }
 
 const char *const rt_c_runtime_version(void) { return NN_C_RUNTIME_VERSION; }
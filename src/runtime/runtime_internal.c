@@ -15,6 +15,7 @@
 #include <nnablart/network.h>
 #include <nnablart/runtime.h>
 
+#include "graph.h"
 #include "runtime_internal.h"
 
 rt_list_t create_rt_list_from_nn_list(nn_network_t *n, nn_list_t list) {
@@ -24,40 +25,66 @@ rt_list_t create_rt_list_from_nn_list(nn_network_t *n, nn_list_t list) {
   return l;
 }
 
-rt_function_context_t allocate_function_io(nn_network_t *n, rt_context_t *c,
-                                           nn_function_t *function) {
+rt_function_context_t allocate_function_io(rt_context_t *c,
+                                           nn_function_t *function,
+                                           const rt_graph_function_t *graph) {
   int i; // Iterator
 
   rt_function_context_t func;
   func.info = function;
+  func.user_defined = 0;
+  func.func.parallel = &(c->parallel);
+  func.func.shared_cache = c->shared_cache;
+  func.func.activation = graph->activation;
+  func.func.channel_last = graph->channel_last;
+  func.func.cpu_features = c->cpu_features;
+  func.func.variant = 0;
+  func.func.workspace_size = 0;
+  func.func.workspace = 0;
+  func.func.allocator =
+      c->use_memory_block || c->measuring ? &c->function_allocator : 0;
 
-  rt_list_t inputs = create_rt_list_from_nn_list(n, function->inputs);
-  func.func.num_of_inputs = inputs.size;
-  func.func.inputs = rt_malloc_func(sizeof(rt_variable_t *) * inputs.size);
+  func.func.num_of_inputs = graph->num_of_inputs;
+  func.func.inputs =
+      rt_context_malloc(c, sizeof(rt_variable_t *) * graph->num_of_inputs);
   if (func.func.inputs) {
-    for (i = 0; i < inputs.size; i++) {
-      int index = *(inputs.data + i);
-      if (index < c->num_of_variables) {
-        func.func.inputs[i] = &(c->variables[index]);
-      } else {
-        func.func.inputs[i] = 0;
-      }
+    for (i = 0; i < graph->num_of_inputs; i++) {
+      func.func.inputs[i] = rt_graph_variable(c, graph->inputs[i]);
     }
   }
 
-  rt_list_t outputs = create_rt_list_from_nn_list(n, function->outputs);
-  func.func.num_of_outputs = outputs.size;
-  func.func.outputs = rt_malloc_func(sizeof(rt_variable_t *) * outputs.size);
+  func.func.num_of_outputs = graph->num_of_outputs;
+  func.func.outputs =
+      rt_context_malloc(c, sizeof(rt_variable_t *) * graph->num_of_outputs);
   if (func.func.outputs) {
-    for (i = 0; i < outputs.size; i++) {
-      int index = *(outputs.data + i);
-      if (index < c->num_of_variables) {
-        func.func.outputs[i] = &(c->variables[index]);
-      } else {
-        func.func.outputs[i] = 0;
-      }
+    for (i = 0; i < graph->num_of_outputs; i++) {
+      func.func.outputs[i] = rt_graph_variable(c, graph->outputs[i]);
     }
   }
 
   return func;
 }
+
+void *rt_context_malloc(rt_context_t *c, size_t size) {
+  if (!c->use_memory_block) {
+    return rt_malloc_func(size);
+  }
+  uint8_t *p = c->memory_block + c->memory_block_used;
+  size = RT_MEMORY_ALIGN(size);
+  if (size > c->memory_block_size - c->memory_block_used) {
+    return 0;
+  }
+  c->memory_block_used += size;
+  return p;
+}
+
+void rt_context_free(rt_context_t *c, void *ptr) {
+  if (!rt_context_in_memory_block(c, ptr)) {
+    rt_free_func(ptr);
+  }
+}
+
+int rt_context_in_memory_block(rt_context_t *c, void *ptr) {
+  return c->memory_block != 0 && (uint8_t *)ptr >= c->memory_block &&
+         (uint8_t *)ptr <= c->memory_block + c->memory_block_size;
+}
@@ -16,6 +16,7 @@
 #define H_RUNTIME_INTERNAL_H_171220111925_
 
 #include "context.h"
+#include "graph.h"
 
 /// @brief Calculate index size.
 /// @note It is intended to internal use, and not assumed to use from the
@@ -51,12 +52,34 @@
   (NN_NETWORK_DATA_POINTER(xNetwork) +                                         \
    NN_NETWORK_INDEX_POINTER(xNetwork)[xIndex])
 
+/// @brief Alignment of activations and data carved from the memory block.
+#define RT_MEMORY_ALIGNMENT (64)
+
+/// @brief Round size up to RT_MEMORY_ALIGNMENT.
+#define RT_MEMORY_ALIGN(xSize)                                                 \
+  (((xSize) + RT_MEMORY_ALIGNMENT - 1) & ~((size_t)RT_MEMORY_ALIGNMENT - 1))
+
 rt_list_t create_rt_list_from_nn_list(nn_network_t *n, nn_list_t list);
 
-rt_function_context_t allocate_function_io(nn_network_t *n, rt_context_t *c,
-                                           nn_function_t *function);
+/// @brief Function of context with inputs and outputs of graph.
+rt_function_context_t allocate_function_io(rt_context_t *c,
+                                           nn_function_t *function,
+                                           const rt_graph_function_t *graph);
+
+/// @brief Allocate runtime data of context.
+/// Data is carved from the memory block if context uses it.
+void *rt_context_malloc(rt_context_t *c, size_t size);
+
+/// @brief Free data allocated by rt_context_malloc.
+void rt_context_free(rt_context_t *c, void *ptr);
+
+/// @brief Whether ptr is inside the memory block of context.
+int rt_context_in_memory_block(rt_context_t *c, void *ptr);
 
-void allocate_function_context(nn_network_t *n, nn_function_t *function,
+/// @brief Allocate the local context of function from c and let its
+/// allocate function fill it.
+void allocate_function_context(rt_context_t *c, nn_network_t *n,
+                               nn_function_t *function,
                                rt_function_context_t *function_context);
 
 #endif // H_RUNTIME_INTERNAL_H_171220111925_
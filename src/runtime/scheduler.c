@@ -0,0 +1,169 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "memory_planner.h"
+#include "runtime_internal.h"
+#include "scheduler.h"
+
+// Variables whose data overlap share storage, either through a buffer of the
+// network or through the arena of the memory planner.
+static int overlap(const rt_variable_t *a, const rt_variable_t *b) {
+  const uint8_t *a0 = (const uint8_t *)a->data;
+  const uint8_t *b0 = (const uint8_t *)b->data;
+  if (a == b) {
+    return 1;
+  }
+  return a0 < b0 + rt_variable_size(b) && b0 < a0 + rt_variable_size(a);
+}
+
+// Latest stage among last_write (and last_read if non 0) of variables
+// sharing storage with variable index.
+static int last_access(rt_context_t *c, int index, const int *last_write,
+                       const int *last_read) {
+  int s = -1;
+  int i;
+  for (i = 0; i < c->num_of_variables; i++) {
+    if ((last_write[i] > s || (last_read && last_read[i] > s)) &&
+        overlap(c->variables + index, c->variables + i)) {
+      s = last_write[i] > s ? last_write[i] : s;
+      if (last_read) {
+        s = last_read[i] > s ? last_read[i] : s;
+      }
+    }
+  }
+  return s;
+}
+
+// Index of variable of network, or -1 for derived parameters which are
+// never written.
+static int variable_index(rt_context_t *c, const rt_variable_t *v) {
+  if (v == 0 || v < c->variables || v >= c->variables + c->num_of_variables) {
+    return -1;
+  }
+  return (int)(v - c->variables);
+}
+
+rt_return_value_t rt_build_schedule(rt_context_t *c) {
+  int *last_write = rt_malloc_func(sizeof(int) * (c->num_of_variables + 1));
+  int *last_read = rt_malloc_func(sizeof(int) * (c->num_of_variables + 1));
+  int *stage = rt_malloc_func(sizeof(int) * (c->num_of_functions + 1));
+  int i, j;
+
+  c->num_of_stages = 0;
+  c->stage_offsets =
+      rt_context_malloc(c, sizeof(int) * (c->num_of_functions + 1));
+  c->stage_functions =
+      rt_context_malloc(c, sizeof(int) * (c->num_of_functions + 1));
+  c->stage_results = rt_context_malloc(
+      c, sizeof(rt_function_error_t) * (c->num_of_functions + 1));
+  if (last_write == 0 || last_read == 0 || stage == 0 ||
+      c->stage_offsets == 0 || c->stage_functions == 0 ||
+      c->stage_results == 0) {
+    if (last_write) {
+      rt_free_func(last_write);
+    }
+    if (last_read) {
+      rt_free_func(last_read);
+    }
+    if (stage) {
+      rt_free_func(stage);
+    }
+    rt_free_schedule(c);
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+
+  for (i = 0; i < c->num_of_variables; i++) {
+    last_write[i] = -1;
+    last_read[i] = -1;
+  }
+
+  for (i = 0; i < c->num_of_functions; i++) {
+    rt_function_t *f = &(c->functions[i].func);
+    int s = -1;
+
+    for (j = 0; j < f->num_of_inputs; j++) {
+      int k = variable_index(c, f->inputs[j]);
+      if (k >= 0) {
+        k = last_access(c, k, last_write, 0);
+        s = k > s ? k : s;
+      }
+    }
+    for (j = 0; j < f->num_of_outputs; j++) {
+      int k = variable_index(c, f->outputs[j]);
+      if (k >= 0) {
+        k = last_access(c, k, last_write, last_read);
+        s = k > s ? k : s;
+      }
+    }
+    stage[i] = s + 1;
+
+    for (j = 0; j < f->num_of_inputs; j++) {
+      int k = variable_index(c, f->inputs[j]);
+      if (k >= 0) {
+        last_read[k] = stage[i] > last_read[k] ? stage[i] : last_read[k];
+      }
+    }
+    for (j = 0; j < f->num_of_outputs; j++) {
+      int k = variable_index(c, f->outputs[j]);
+      if (k >= 0) {
+        last_write[k] = stage[i];
+      }
+    }
+    if (stage[i] + 1 > c->num_of_stages) {
+      c->num_of_stages = stage[i] + 1;
+    }
+  }
+
+  // Counting sort by stage keeps network order inside each stage.
+  for (i = 0; i <= c->num_of_stages; i++) {
+    c->stage_offsets[i] = 0;
+  }
+  for (i = 0; i < c->num_of_functions; i++) {
+    c->stage_offsets[stage[i] + 1]++;
+  }
+  for (i = 0; i < c->num_of_stages; i++) {
+    c->stage_offsets[i + 1] += c->stage_offsets[i];
+  }
+  for (i = 0; i < c->num_of_functions; i++) {
+    c->stage_functions[c->stage_offsets[stage[i]]++] = i;
+  }
+  for (i = c->num_of_stages; i > 0; i--) {
+    c->stage_offsets[i] = c->stage_offsets[i - 1];
+  }
+  c->stage_offsets[0] = 0;
+
+  rt_free_func(last_write);
+  rt_free_func(last_read);
+  rt_free_func(stage);
+  return RT_RET_NOERROR;
+}
+
+void rt_free_schedule(rt_context_t *c) {
+  if (c->stage_offsets) {
+    rt_context_free(c, c->stage_offsets);
+  }
+  if (c->stage_functions) {
+    rt_context_free(c, c->stage_functions);
+  }
+  if (c->stage_results) {
+    rt_context_free(c, c->stage_results);
+  }
+  c->stage_offsets = 0;
+  c->stage_functions = 0;
+  c->stage_results = 0;
+  c->num_of_stages = 0;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_SCHEDULER_H_180917113042_
+#define H_SCHEDULER_H_180917113042_
+
+#include "context.h"
+
+/// @brief Group functions into stages from the dataflow graph.
+/// Every function is placed in the first stage after all functions it
+/// depends on. Dependencies are tracked per variable, and variables whose
+/// data overlap, e.g. sharing the same buffer, are ordered as well (read
+/// after write, write after read and write after write).
+/// Functions in the same stage can be executed concurrently.
+rt_return_value_t rt_build_schedule(rt_context_t *c);
+
+/// @brief Free stages built with rt_build_schedule.
+void rt_free_schedule(rt_context_t *c);
+
+#endif // H_SCHEDULER_H_180917113042_
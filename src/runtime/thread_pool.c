@@ -0,0 +1,160 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <nnablart/functions.h>
+
+#include "thread_pool.h"
+
+#ifdef NNABLART_USE_PTHREAD
+
+#include <pthread.h>
+
+typedef struct {
+  pthread_t *threads;
+  int num_of_workers;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned int generation;
+  int shutdown;
+
+  void (*task)(void *arg, int index);
+  void *arg;
+  int num_of_tasks;
+  int next_task;
+  int remaining_tasks;
+} rt_thread_pool_t;
+
+// Must be called with mutex locked, returns with mutex locked.
+static void run_pending_tasks(rt_thread_pool_t *pool) {
+  while (pool->next_task < pool->num_of_tasks) {
+    int index = pool->next_task++;
+    pthread_mutex_unlock(&pool->mutex);
+    pool->task(pool->arg, index);
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->remaining_tasks == 0) {
+      pthread_cond_broadcast(&pool->done);
+    }
+  }
+}
+
+static void *worker(void *arg) {
+  rt_thread_pool_t *pool = (rt_thread_pool_t *)arg;
+  unsigned int generation = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (!pool->shutdown && pool->generation == generation) {
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+    if (pool->shutdown) {
+      break;
+    }
+    generation = pool->generation;
+    run_pending_tasks(pool);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return 0;
+}
+
+void *rt_thread_pool_create(int num_of_workers) {
+  int i;
+  rt_thread_pool_t *pool = rt_malloc_func(sizeof(rt_thread_pool_t));
+  if (pool == 0) {
+    return 0;
+  }
+  pool->threads = rt_malloc_func(sizeof(pthread_t) * num_of_workers);
+  if (pool->threads == 0) {
+    rt_free_func(pool);
+    return 0;
+  }
+  pool->num_of_workers = 0;
+  pool->generation = 0;
+  pool->shutdown = 0;
+  pool->task = 0;
+  pool->arg = 0;
+  pool->num_of_tasks = 0;
+  pool->next_task = 0;
+  pool->remaining_tasks = 0;
+  pthread_mutex_init(&pool->mutex, 0);
+  pthread_cond_init(&pool->start, 0);
+  pthread_cond_init(&pool->done, 0);
+
+  for (i = 0; i < num_of_workers; i++) {
+    if (pthread_create(&pool->threads[i], 0, worker, pool) != 0) {
+      rt_thread_pool_destroy(pool);
+      return 0;
+    }
+    pool->num_of_workers++;
+  }
+  return pool;
+}
+
+void rt_thread_pool_destroy(void *p) {
+  rt_thread_pool_t *pool = (rt_thread_pool_t *)p;
+  int i;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+  for (i = 0; i < pool->num_of_workers; i++) {
+    pthread_join(pool->threads[i], 0);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->start);
+  pthread_mutex_destroy(&pool->mutex);
+  rt_free_func(pool->threads);
+  rt_free_func(pool);
+}
+
+void rt_thread_pool_run_tasks(void *p, int num_of_tasks,
+                              void (*task)(void *arg, int index), void *arg) {
+  rt_thread_pool_t *pool = (rt_thread_pool_t *)p;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->arg = arg;
+  pool->num_of_tasks = num_of_tasks;
+  pool->next_task = 0;
+  pool->remaining_tasks = num_of_tasks;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+
+  run_pending_tasks(pool);
+  while (pool->remaining_tasks > 0) {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+#else /* NNABLART_USE_PTHREAD */
+
+void *rt_thread_pool_create(int num_of_workers) { return 0; }
+
+void rt_thread_pool_destroy(void *pool) {}
+
+void rt_thread_pool_run_tasks(void *pool, int num_of_tasks,
+                              void (*task)(void *arg, int index), void *arg) {
+  int i;
+  for (i = 0; i < num_of_tasks; i++) {
+    task(arg, i);
+  }
+}
+
+#endif /* NNABLART_USE_PTHREAD */
@@ -0,0 +1,31 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_THREAD_POOL_H_180912151204_
+#define H_THREAD_POOL_H_180912151204_
+
+/// @brief Create worker pool with num_of_workers threads.
+/// The thread calling rt_thread_pool_run_tasks works as an extra worker.
+/// @return Pool, or 0 if threads are not available or creation failed.
+void *rt_thread_pool_create(int num_of_workers);
+
+/// @brief Stop all workers and free pool.
+void rt_thread_pool_destroy(void *pool);
+
+/// @brief Run task(arg, index) for index in [0, num_of_tasks) on the pool and
+/// wait for completion. Signature matches rt_parallel_t.run_tasks.
+void rt_thread_pool_run_tasks(void *pool, int num_of_tasks,
+                              void (*task)(void *arg, int index), void *arg);
+
+#endif // H_THREAD_POOL_H_180912151204_
@@ -0,0 +1,199 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "context.h"
+#include "profiler.h"
+#include "trace.h"
+
+rt_return_value_t rt_enable_trace(rt_context_pointer context, int enable) {
+  rt_context_t *c = context;
+
+  if (c->trace) {
+    rt_free_func(c->trace->spans);
+    rt_free_func(c->trace);
+    c->trace = 0;
+  }
+  if (!enable) {
+    return RT_RET_NOERROR;
+  }
+
+  c->trace = rt_malloc_func(sizeof(rt_trace_t));
+  if (c->trace == 0) {
+    return RT_RET_ERROR_ALLOCATE_CONTEXT;
+  }
+  c->trace->num_of_forwards = 0;
+  c->trace->capacity = 0;
+  c->trace->spans = 0;
+  c->trace->current = 0;
+  return RT_RET_NOERROR;
+}
+
+void rt_trace_begin_forward(rt_trace_t *trace, int num_of_functions) {
+  int spans_per_forward = num_of_functions + 1;
+  int i;
+
+  if (trace->num_of_forwards == trace->capacity) {
+    int capacity = trace->capacity ? trace->capacity * 2 : 16;
+    rt_trace_span_t *spans = rt_malloc_func(sizeof(rt_trace_span_t) *
+                                            spans_per_forward * capacity);
+    if (spans == 0) {
+      trace->current = 0;
+      return;
+    }
+    if (trace->spans) {
+      memcpy(spans, trace->spans, sizeof(rt_trace_span_t) *
+                                      spans_per_forward *
+                                      trace->num_of_forwards);
+      rt_free_func(trace->spans);
+    }
+    trace->spans = spans;
+    trace->capacity = capacity;
+  }
+
+  trace->current =
+      trace->spans + spans_per_forward * trace->num_of_forwards++;
+  for (i = 0; i < num_of_functions; i++) {
+    trace->current[i].begin = -1;
+  }
+  trace->current[num_of_functions].thread = rt_profiler_thread();
+  trace->current[num_of_functions].begin = rt_profiler_time();
+}
+
+void rt_trace_end_forward(rt_trace_t *trace, int num_of_functions) {
+  if (trace->current) {
+    trace->current[num_of_functions].end = rt_profiler_time();
+    trace->current = 0;
+  }
+}
+
+static void write_shapes(FILE *fp, rt_variable_t **variables,
+                         int num_of_variables) {
+  int i, j;
+  fputc('[', fp);
+  for (i = 0; i < num_of_variables; i++) {
+    fputs(i ? ",[" : "[", fp);
+    if (variables[i]) {
+      for (j = 0; j < variables[i]->shape.size; j++) {
+        fprintf(fp, j ? ",%d" : "%d", variables[i]->shape.data[j]);
+      }
+    }
+    fputc(']', fp);
+  }
+  fputc(']', fp);
+}
+
+// Small sequential thread ids in order of first appearance.
+static int thread_index(uintptr_t *threads, int *num_of_threads,
+                        uintptr_t thread) {
+  int i;
+  for (i = 0; i < *num_of_threads; i++) {
+    if (threads[i] == thread) {
+      return i;
+    }
+  }
+  threads[*num_of_threads] = thread;
+  return (*num_of_threads)++;
+}
+
+rt_return_value_t
+rt_write_trace(rt_context_pointer context, const char *filename,
+               const char *(*function_name)(nn_function_type_t type)) {
+  rt_context_t *c = context;
+  rt_trace_t *trace = c->trace;
+  int spans_per_forward = c->num_of_functions + 1;
+  uintptr_t *threads = 0;
+  int num_of_threads = 0;
+  double origin;
+  int n, i;
+  FILE *fp = 0;
+
+  if (trace == 0) {
+    return RT_RET_ERROR_WRITE_TRACE;
+  }
+  if (trace->num_of_forwards > 0) {
+    threads = rt_malloc_func(sizeof(uintptr_t) * spans_per_forward *
+                             trace->num_of_forwards);
+    if (threads == 0) {
+      return RT_RET_ERROR_WRITE_TRACE;
+    }
+  }
+
+#ifdef _MSC_VER
+  fopen_s(&fp, filename, "w");
+#else
+  fp = fopen(filename, "w");
+#endif
+  if (fp == 0) {
+    rt_free_func(threads);
+    return RT_RET_ERROR_WRITE_TRACE;
+  }
+
+  // Timestamps are microseconds from the first rt_forward().
+  origin = trace->num_of_forwards > 0 ? trace->spans[c->num_of_functions].begin
+                                      : 0;
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (n = 0; n < trace->num_of_forwards; n++) {
+    rt_trace_span_t *spans = trace->spans + spans_per_forward * n;
+    for (i = 0; i <= c->num_of_functions; i++) {
+      rt_trace_span_t *s = spans + i;
+      if (s->begin < 0) {
+        continue;
+      }
+      fprintf(fp,
+              "{\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,",
+              thread_index(threads, &num_of_threads, s->thread),
+              (s->begin - origin) * 1e6, (s->end - s->begin) * 1e6);
+      if (i == c->num_of_functions) {
+        fprintf(fp, "\"cat\":\"forward\",\"name\":\"rt_forward\","
+                    "\"args\":{\"iteration\":%d}},\n",
+                n);
+        continue;
+      }
+      rt_function_t *f = &(c->functions[i].func);
+      nn_function_type_t type = c->functions[i].info->type;
+      if (function_name) {
+        fprintf(fp, "\"cat\":\"function\",\"name\":\"%s\",",
+                function_name(type));
+      } else {
+        fprintf(fp, "\"cat\":\"function\",\"name\":\"Function%d\",",
+                (int)type);
+      }
+      fprintf(fp, "\"args\":{\"index\":%d,\"iteration\":%d,\"inputs\":", i, n);
+      write_shapes(fp, f->inputs, f->num_of_inputs);
+      fprintf(fp, ",\"outputs\":");
+      write_shapes(fp, f->outputs, f->num_of_outputs);
+      fprintf(fp, "}},\n");
+    }
+  }
+  for (i = 0; i < num_of_threads; i++) {
+    fprintf(fp,
+            "{\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"name\":\"thread_name\","
+            "\"args\":{\"name\":\"thread %d\"}},\n",
+            i, i);
+  }
+  fprintf(fp, "{\"ph\":\"M\",\"pid\":0,\"name\":\"process_name\","
+              "\"args\":{\"name\":\"nnablart\"}}\n]}\n");
+
+  rt_free_func(threads);
+  if (fclose(fp) != 0) {
+    return RT_RET_ERROR_WRITE_TRACE;
+  }
+  return RT_RET_NOERROR;
+}
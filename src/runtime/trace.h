@@ -0,0 +1,44 @@
+// Copyright (c) 2018 Sony Corporation. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef H_TRACE_H_181004112233_
+#define H_TRACE_H_181004112233_
+
+#include <stdint.h>
+
+typedef struct {
+  uintptr_t thread; // See rt_profiler_thread()
+  double begin;     // Seconds, negative if function did not run
+  double end;
+} rt_trace_span_t;
+
+/// Spans recorded by rt_enable_trace().
+/// Every rt_forward() appends (num_of_functions + 1) spans, one per function
+/// indexed by function and the last for rt_forward() itself, so functions
+/// running concurrently write distinct spans without locking.
+typedef struct {
+  int num_of_forwards;
+  int capacity; // In forwards
+  rt_trace_span_t *spans;
+  rt_trace_span_t *current; // Spans of running rt_forward(), 0 otherwise
+} rt_trace_t;
+
+/// @brief Prepare spans of new rt_forward().
+/// On allocation failure the forward is not recorded.
+void rt_trace_begin_forward(rt_trace_t *trace, int num_of_functions);
+
+/// @brief Close spans of rt_forward().
+void rt_trace_end_forward(rt_trace_t *trace, int num_of_functions);
+
+#endif // H_TRACE_H_181004112233_